@@ -0,0 +1,287 @@
+"""
+Base Review Agent - Shared model client, agent creation and cached review calls
+"""
+
+from autogen_agentchat.agents import AssistantAgent
+from autogen_ext.models.openai import OpenAIChatCompletionClient
+import os
+from typing import Dict, List, Any, Optional, Tuple, Callable
+import time
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.logger import get_logger, api_tracker, perf_monitor
+from utils.cache_manager import CacheManager
+from utils.token_budget import count_tokens
+from utils.tracing import start_span
+from utils.review_schema import (
+    ReviewFindings, STRUCTURED_OUTPUT_INSTRUCTIONS, parse_review_findings, render_findings, finding_to_issue,
+    empty_response, response_format
+)
+
+# Initialize logger
+logger = get_logger(__name__)
+
+# Model clients by (API key, model), shared by every agent of the process so
+# that warm containers keep reusing their keep-alive connections to the model API
+_model_client_pool: Dict[Tuple[str, str], OpenAIChatCompletionClient] = {}
+
+
+class BaseReviewAgent:
+    """Common plumbing for the specialized review agents
+
+    Subclasses provide the agent name and system message. Review prompts are
+    sent through _run_review, which consults the per-agent result cache first.
+    """
+
+    agent_name = "review_agent"
+
+    # "type" of this agent's findings in the consensus
+    finding_type = "issue"
+
+    # Schema of structured-output responses
+    response_model = ReviewFindings
+
+    # Bump when the system message or prompt template changes so that cached
+    # responses produced by the old prompt are no longer used
+    prompt_version = "2"
+
+    def __init__(self, api_key: str = None, model: str = "gpt-4o",
+                 cache_manager: Optional[CacheManager] = None,
+                 structured_output: bool = False):
+        """Initialize the agent
+
+        Args:
+            api_key: OpenAI API key (defaults to env var OPENAI_API_KEY)
+            model: OpenAI model used for reviews
+            cache_manager: Optional cache for agent responses keyed by code content
+            structured_output: Ask for JSON matching ReviewFindings (OpenAI
+                structured outputs) instead of free text
+        """
+        self.api_key = api_key or os.getenv("OPENAI_API_KEY")
+        if not self.api_key:
+            raise ValueError("OpenAI API key is required")
+
+        self.model = model
+        self.cache_manager = cache_manager
+        self.structured_output = structured_output
+        self.model_client = self._get_model_client(model)
+        # Set by batch audits: collects the requests instead of sending them
+        self.request_recorder: Optional[Callable[[str, "BaseReviewAgent", Dict[str, Any]], Any]] = None
+
+    def _get_system_message(self) -> str:
+        """Define the system message for the agent"""
+        raise NotImplementedError
+
+    def _get_model_client(self, model: str) -> OpenAIChatCompletionClient:
+        """Model client for a model, created on first use and shared process-wide afterwards"""
+        key = (self.api_key, model)
+        if key not in _model_client_pool:
+            _model_client_pool[key] = OpenAIChatCompletionClient(
+                model=model,
+                temperature=0.1,
+                api_key=self.api_key
+            )
+        return _model_client_pool[key]
+
+    def _review_model(self, context: Optional[Dict[str, Any]]) -> str:
+        """Model for a review (the context's 'review_model' overrides the default)"""
+        return (context or {}).get("review_model") or self.model
+
+    def _full_system_message(self, structured: bool) -> str:
+        """System message as sent to the model"""
+        if structured:
+            return f"{self._get_system_message()}\n\n{STRUCTURED_OUTPUT_INSTRUCTIONS}"
+        return self._get_system_message()
+
+    def _create_agent(self, model: Optional[str] = None, structured: Optional[bool] = None) -> AssistantAgent:
+        """Create an assistant agent sharing the pooled model client
+
+        AssistantAgent keeps its conversation history between runs, so each
+        task gets a fresh agent to keep tasks independent and safe to run
+        concurrently. The model client (and its connection pool) is shared.
+
+        Args:
+            model: Model to use instead of the agent's default
+            structured: Override of structured_output for this agent
+        """
+        model_client = self._get_model_client(model or self.model)
+        if self.structured_output if structured is None else structured:
+            return AssistantAgent(
+                name=self.agent_name,
+                model_client=model_client,
+                system_message=self._full_system_message(True),
+                output_content_type=self.response_model
+            )
+        return AssistantAgent(
+            name=self.agent_name,
+            model_client=model_client,
+            system_message=self._full_system_message(False)
+        )
+
+    @staticmethod
+    def _extract_text(result: Any) -> str:
+        """Extract the message content from an AutoGen response"""
+        if hasattr(result, 'messages') and len(result.messages) > 0:
+            # Get the last assistant message
+            return result.messages[-1].content
+        elif hasattr(result, 'content'):
+            return result.content
+        elif isinstance(result, str):
+            return result
+        return str(result)
+
+    @staticmethod
+    def _response_usage(result: Any) -> Optional[Dict[str, int]]:
+        """Token usage reported for a run, summed over its messages
+
+        AutoGen's RequestUsage has no count of the prompt tokens served from
+        OpenAI's prompt cache, so these calls are tracked as uncached (the
+        Batch API results of utils.batch_audit do report them).
+
+        Returns:
+            Dict with 'prompt_tokens' and 'completion_tokens', or None if no
+            message carries usage
+        """
+        usage = None
+        for message in getattr(result, "messages", None) or []:
+            message_usage = getattr(message, "models_usage", None)
+            if message_usage is None:
+                continue
+            usage = usage or {"prompt_tokens": 0, "completion_tokens": 0}
+            usage["prompt_tokens"] += getattr(message_usage, "prompt_tokens", 0) or 0
+            usage["completion_tokens"] += getattr(message_usage, "completion_tokens", 0) or 0
+        return usage
+
+    def _cache_context(self, context: Dict[str, Any]) -> Dict[str, Any]:
+        """Prompt inputs besides the code that change the agent's answer"""
+        return {"language": context.get("language", "auto-detect")}
+
+    def cache_key(self, code: str, context: Dict[str, Any] = None) -> Optional[str]:
+        """Cache key analyze_code would use for this code and context
+
+        Lets callers prefetch cached responses before reviewing.
+        """
+        if self.cache_manager is None:
+            return None
+        extra = self._cache_context(context or {})
+        if self.structured_output:
+            extra["output"] = "structured"
+        return self.cache_manager.generate_agent_cache_key(
+            code, self.agent_name, self.prompt_version, self._review_model(context), extra
+        )
+
+    def _decode_structured(self, content: Any) -> Optional[Tuple[str, Any]]:
+        """Rendered text and findings of a structured response
+        (None if it does not match the schema)"""
+        parsed = parse_review_findings(content, self.response_model)
+        if parsed is None:
+            return None
+        return render_findings(parsed), [finding.model_dump() for finding in parsed.findings]
+
+    def _structured_issues(self, call_info: Dict[str, Any]) -> Optional[List[Dict[str, Any]]]:
+        """Findings of a structured response in consensus format (None for text responses)"""
+        if call_info.get("findings") is None:
+            return None
+        return [finding_to_issue(f, self.agent_name, self.finding_type) for f in call_info["findings"]]
+
+    def batch_request(self, prompt: str, model: Optional[str] = None) -> Dict[str, Any]:
+        """Chat completions request body of a review prompt (as sent by _run_review)"""
+        body = {
+            "model": model or self.model,
+            "temperature": 0.1,
+            "messages": [
+                {"role": "system", "content": self._full_system_message(self.structured_output)},
+                {"role": "user", "content": prompt}
+            ]
+        }
+        if self.structured_output:
+            body["response_format"] = response_format(self.response_model)
+        return body
+
+    def cache_entry(self, content: str) -> Dict[str, Any]:
+        """Cache entry of a response to a review prompt (see _run_review)"""
+        decoded = self._decode_structured(content) if self.structured_output else None
+        if decoded is None:
+            return {"text": content}
+        text, findings = decoded
+        return {"text": text, "findings": findings}
+
+    async def _run_task(self, prompt: str) -> Any:
+        """Run a free-text task (not a cached review) on a fresh agent"""
+        with start_span("llm_call", agent=self.agent_name, model=self.model):
+            return await self._create_agent(structured=False).run(task=prompt)
+
+    async def _run_review(self, prompt: str, code: str,
+                          context: Dict[str, Any] = None) -> Tuple[str, Dict[str, Any]]:
+        """Run a review prompt, reusing the cached response for unchanged code
+
+        Args:
+            prompt: Full prompt sent to the model
+            code: Code unit the prompt reviews (used for the cache key)
+            context: Review context (see _cache_context for the parts that matter)
+
+        Returns:
+            Tuple of (response text, call info with 'from_cache', 'api_call_time'
+            and 'findings': the decoded findings (see _decode_structured) in
+            structured-output mode, otherwise None). With a request_recorder
+            set, cache misses are recorded and answered with an empty
+            response marked 'deferred'
+        """
+        cache_key = self.cache_key(code, context)
+        if cache_key is not None:
+            cached = await self.cache_manager.get_by_key_async(cache_key)
+            if cached and cached.get("text"):
+                perf_monitor.record_metric("agent_cache_hit", 1, {"agent": self.agent_name})
+                logger.info("Agent cache hit", agent=self.agent_name)
+                return cached["text"], {"from_cache": True, "api_call_time": 0.0,
+                                        "findings": cached.get("findings")}
+            perf_monitor.record_metric("agent_cache_miss", 1, {"agent": self.agent_name})
+
+        model = self._review_model(context)
+        if self.request_recorder is not None and cache_key is not None:
+            # Deferred to the Batch API; the answer lands in the cache under cache_key
+            self.request_recorder(cache_key, self, self.batch_request(prompt, model))
+            text, findings = "", None
+            if self.structured_output:
+                text, findings = self._decode_structured(empty_response(self.response_model))
+            return text, {"from_cache": False, "api_call_time": 0.0, "findings": findings, "deferred": True}
+
+        with start_span("llm_call", agent=self.agent_name, model=model) as span:
+            api_start = time.time()
+            result = await self._create_agent(model).run(task=prompt)
+            api_duration = time.time() - api_start
+
+            findings = None
+            decoded = None
+            if self.structured_output:
+                content = result.messages[-1].content if getattr(result, "messages", None) else result
+                decoded = self._decode_structured(content)
+                if decoded is None:
+                    logger.warning("Structured response did not match the schema, using text parsing",
+                                   agent=self.agent_name)
+            if decoded is not None:
+                text, findings = decoded
+            else:
+                text = self._extract_text(result)
+
+            # Token counts from the response usage; counted with the tokenizer if
+            # the client reports none
+            usage = self._response_usage(result) or {
+                "prompt_tokens": count_tokens(self._get_system_message(), model) + count_tokens(prompt, model),
+                "completion_tokens": count_tokens(str(text), model)
+            }
+            api_tracker.track_call(
+                api_name="openai",
+                model=model,
+                input_tokens=usage["prompt_tokens"],
+                output_tokens=usage["completion_tokens"],
+                duration=api_duration
+            )
+            span.set_attribute("input_tokens", usage["prompt_tokens"])
+            span.set_attribute("output_tokens", usage["completion_tokens"])
+
+        if cache_key is not None and text:
+            entry = {"text": text} if findings is None else {"text": text, "findings": findings}
+            await self.cache_manager.set_by_key_async(cache_key, entry, self.agent_name)
+
+        return text, {"from_cache": False, "api_call_time": api_duration, "findings": findings}
@@ -2,45 +2,46 @@
 Code Reviewer Agent - Focuses on clean code principles, best practices, and documentation
 """
 
-from autogen_agentchat.agents import AssistantAgent
-from autogen_ext.models.openai import OpenAIChatCompletionClient
 import os
 from typing import Dict, List, Any
 import time
 import sys
 sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
-from utils.logger import get_logger, track_performance, api_tracker
+from agents.base_agent import BaseReviewAgent
+from utils.cache_manager import CacheManager
+from utils.logger import get_logger, track_performance
+from utils.diff_scoper import SCOPED_REVIEW_NOTE
+from utils.review_schema import severity_counts
+from utils.prompt_templates import ReviewPromptTemplate
 
 # Initialize logger
 logger = get_logger(__name__)
 
+REVIEW_PROMPT = ReviewPromptTemplate(
+    """Provide a comprehensive code review of the code at the end of this message, following the
+guidelines in your system message.""",
+    shared_fields=("PR Description",)
+)
 
-class CodeReviewerAgent:
+
+class CodeReviewerAgent(BaseReviewAgent):
     """Agent specialized in code quality, best practices, and maintainability"""
     
-    def __init__(self, api_key: str = None):
+    agent_name = "code_reviewer"
+    finding_type = "code_quality"
+    
+    def __init__(self, api_key: str = None, cache_manager: CacheManager = None,
+                 structured_output: bool = False):
         """Initialize the Code Reviewer Agent
         
         Args:
             api_key: OpenAI API key (defaults to env var OPENAI_API_KEY)
+            cache_manager: Optional cache for responses to unchanged code
+            structured_output: Request JSON findings instead of free text
         """
-        self.api_key = api_key or os.getenv("OPENAI_API_KEY")
-        if not self.api_key:
-            raise ValueError("OpenAI API key is required")
-        
         logger.info("Initializing CodeReviewerAgent")
-            
-        self.model_client = OpenAIChatCompletionClient(
-            model="gpt-4o",  # Using full model for better analysis
-            temperature=0.1,
-            api_key=self.api_key
-        )
-        
-        self.agent = AssistantAgent(
-            name="code_reviewer",
-            model_client=self.model_client,
-            system_message=self._get_system_message()
-        )
+        super().__init__(api_key=api_key, model="gpt-4o", cache_manager=cache_manager,
+                         structured_output=structured_output)
     
     def _get_system_message(self) -> str:
         """Define the system message for the code reviewer agent"""
@@ -97,47 +98,26 @@ class CodeReviewerAgent:
                    code_length=len(code),
                    language=language)
         
-        prompt = f"""Please review the following code from file '{filename}':
-
-```{language}
-{code}
-```
-
-PR Description: {pr_description if pr_description else 'Not provided'}
-
-Provide a comprehensive code review following the guidelines in your system message."""
+        prompt = REVIEW_PROMPT.render(
+            code, filename, language,
+            shared={"PR Description": pr_description},
+            details=[SCOPED_REVIEW_NOTE if context.get("review_scope") else ""]
+        )
 
         try:
-            # Track API call
-            api_start = time.time()
-            result = await self.agent.run(task=prompt)
-            api_duration = time.time() - api_start
-            
-            # Estimate tokens (rough approximation)
-            input_tokens = len(prompt.split()) * 1.3
-            output_tokens = 500  # Estimated average response
+            review_text, call_info = await self._run_review(prompt, code, context)
             
-            # Extract the actual message content from AutoGen response
-            if hasattr(result, 'messages') and len(result.messages) > 0:
-                # Get the last assistant message
-                review_text = result.messages[-1].content
-            elif hasattr(result, 'content'):
-                review_text = result.content
-            elif isinstance(result, str):
-                review_text = result
+            issues = self._structured_issues(call_info)
+            if issues is not None:
+                counts = severity_counts(issues)
+                issues_found = {
+                    "high": counts["critical"] + counts["high"],
+                    "medium": counts["medium"],
+                    "low": counts["low"]
+                }
             else:
-                review_text = str(result)
-            
-            # Track API usage
-            api_tracker.track_call(
-                api_name="openai",
-                model="gpt-4o",
-                input_tokens=int(input_tokens),
-                output_tokens=int(output_tokens),
-                duration=api_duration
-            )
-            
-            issues_found = self._extract_issue_count(review_text)
+                issues_found = self._extract_issue_count(review_text)
+                issues = self._extract_issues(review_text)
             total_issues = sum(issues_found.values())
             
             logger.info("Code review analysis completed",
@@ -152,10 +132,12 @@ Provide a comprehensive code review following the guidelines in your system mess
                 "status": "success",
                 "review": review_text,
                 "issues_found": issues_found,
-                "issues": self._extract_issues(review_text),
+                "issues": issues,
+                "from_cache": call_info["from_cache"],
+                "deferred": call_info.get("deferred", False),
                 "metrics": {
                     "analysis_time": time.time() - start_time,
-                    "api_call_time": api_duration
+                    "api_call_time": call_info["api_call_time"]
                 }
             }
         except Exception as e:
@@ -0,0 +1,244 @@
+"""
+Fused Reviewer Agent - Code quality, security and performance review in a single model call
+
+The three specialized agents each send the full code with their own system
+message. For small files most of those input tokens are the same code sent
+three times, so this agent sends it once and asks for one structured response
+with a section per role. The sections are split back into the result dicts
+the specialized agents return, so the consensus works unchanged.
+"""
+
+import os
+from typing import Dict, List, Any, Optional, Tuple
+import time
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from agents.base_agent import BaseReviewAgent
+from agents.code_reviewer import CodeReviewerAgent
+from agents.security_checker import SecurityCheckerAgent
+from agents.performance_analyzer import PerformanceAnalyzerAgent
+from utils.analysis_context import AnalysisContext
+from utils.cache_manager import CacheManager
+from utils.logger import get_logger, track_performance
+from utils.diff_scoper import SCOPED_REVIEW_NOTE
+from utils.review_schema import (
+    ReviewFindings, FusedReviewFindings, FUSED_SECTIONS,
+    parse_review_findings, render_findings, finding_to_issue, severity_counts
+)
+from utils.prompt_templates import ReviewPromptTemplate
+
+# Initialize logger
+logger = get_logger(__name__)
+
+# Consensus "type" of each role's findings
+FINDING_TYPES = {
+    "code_reviewer": CodeReviewerAgent.finding_type,
+    "security_checker": SecurityCheckerAgent.finding_type,
+    "performance_analyzer": PerformanceAnalyzerAgent.finding_type
+}
+
+REVIEW_PROMPT = ReviewPromptTemplate(
+    """Perform the code quality, security and performance reviews of the code at the end of this
+message, following the guidelines in your system message. If static analysis results are provided,
+verify them and include the real issues in the security section; use the AST data to inform the
+performance section.""",
+    shared_fields=("PR Description",)
+)
+
+SECTION_TITLES = {
+    "code_quality": "Code Quality",
+    "security": "Security",
+    "performance": "Performance"
+}
+
+
+class FusedReviewerAgent(BaseReviewAgent):
+    """Agent covering all three review roles with one structured response"""
+
+    agent_name = "fused_reviewer"
+    response_model = FusedReviewFindings
+
+    def __init__(self, api_key: str = None, cache_manager: CacheManager = None):
+        """Initialize the Fused Reviewer Agent
+
+        Args:
+            api_key: OpenAI API key (defaults to env var OPENAI_API_KEY)
+            cache_manager: Optional cache for responses to unchanged code
+        """
+        logger.info("Initializing FusedReviewerAgent")
+        # The response has to be split by role, so it is always structured
+        super().__init__(api_key=api_key, model="gpt-4o", cache_manager=cache_manager,
+                         structured_output=True)
+
+    def _cache_context(self, context: Dict[str, Any]) -> Dict[str, Any]:
+        """Prompt inputs besides the code that change the agent's answer"""
+        return {
+            "language": context.get("language", "auto-detect"),
+            "framework": context.get("framework", "unknown"),
+            "expected_load": context.get("expected_load", "unknown")
+        }
+
+    def _get_system_message(self) -> str:
+        """Define the system message for the fused reviewer agent"""
+        return """You are a team of three expert reviewers examining the same code. Review it once
+        from each point of view and report each reviewer's findings in its own section.
+
+        **code_quality** - a code reviewer focusing on clean code and best practices:
+        readability, maintainability, SOLID principles, naming, documentation, error handling,
+        testability. Look especially for functions with too many parameters (>5), global state
+        mutation, missing validation, hardcoded values, duplication, SRP violations and debug code.
+
+        **security** - a security engineer: injection (SQL, command, template), XSS, hardcoded
+        secrets, eval()/exec() with user input, weak hashing (MD5, SHA1), unsafe deserialization,
+        authentication and authorization flaws, and the rest of the OWASP Top 10.
+
+        **performance** - a performance engineer: time and space complexity (give the Big O in the
+        complexity field), nested loops, quadratic algorithms where linear is possible, N+1 queries,
+        memory leaks, repeated calculations, missing caching and recursion without memoization.
+
+        Each issue belongs to exactly one section. Report ALL real issues; missing
+        vulnerabilities or bottlenecks is unacceptable, but do not invent issues."""
+
+    def _decode_structured(self, content: Any) -> Optional[Tuple[str, Any]]:
+        """Rendered text and per-section findings of a fused response"""
+        parsed = parse_review_findings(content, FusedReviewFindings)
+        if parsed is None:
+            return None
+        sections = parsed.model_dump()
+        text = "\n\n".join(
+            f"## {SECTION_TITLES[section]}\n\n{render_findings(getattr(parsed, section))}"
+            for section in FUSED_SECTIONS.values()
+        )
+        return text, sections
+
+    @track_performance("fused_reviewer_analyze")
+    async def analyze_code(self, code: str, filename: str = "unknown", context: Dict[str, Any] = None) -> Dict[str, Any]:
+        """Review code for all three roles in one call
+
+        Args:
+            code: The code to review
+            filename: Name of the file being reviewed
+            context: Additional context (e.g., PR description, language, framework)
+
+        Returns:
+            Dictionary with 'results': the code_reviewer, security_checker and
+            performance_analyzer result dicts (status 'error' if the response
+            could not be split by role)
+        """
+        start_time = time.time()
+        context = context or {}
+        language = context.get("language", "auto-detect")
+        pr_description = context.get("pr_description", "")
+        framework = context.get("framework", "unknown")
+        expected_load = context.get("expected_load", "unknown")
+
+        logger.info("Starting fused review", filename=filename, code_length=len(code))
+
+        # Static analysis and AST metrics need the full file, and come from the
+        # analysis context shared with the rest of the review
+        review_scope = context.get("review_scope")
+        analysis_code = review_scope.full_code if review_scope else code
+        analysis = context.get("analysis") or AnalysisContext(
+            analysis_code, filename, language, static_analysis=context.get("static_analysis")
+        )
+
+        static_results = {}
+        if analysis.is_python:
+            static_results = await analysis.static_analysis()
+        ast_results = analysis.ast_results() if analysis.supports_structure else {}
+
+        prompt = REVIEW_PROMPT.render(
+            code, filename, language,
+            shared={"PR Description": pr_description},
+            details=[
+                f"Framework/Library: {framework if framework != 'unknown' else 'Auto-detect'}",
+                f"Expected Load: {expected_load if expected_load != 'unknown' else 'Not specified'}",
+                SCOPED_REVIEW_NOTE if review_scope else "",
+                SecurityCheckerAgent.format_bandit_summary(static_results, review_scope),
+                PerformanceAnalyzerAgent.format_ast_summary(ast_results)
+            ]
+        )
+
+        try:
+            text, call_info = await self._run_review(prompt, code, context)
+            sections = call_info["findings"]
+            if sections is None:
+                raise ValueError("Response could not be split by role")
+
+            results = {}
+            for agent_name, section in FUSED_SECTIONS.items():
+                parsed = ReviewFindings.model_validate(sections[section])
+                issues = [
+                    finding_to_issue(finding, agent_name, FINDING_TYPES[agent_name])
+                    for finding in sections[section]["findings"]
+                ]
+                results[agent_name] = self._agent_result(
+                    agent_name, filename, render_findings(parsed), issues, call_info, start_time
+                )
+
+            SecurityCheckerAgent.merge_static_analysis(results["security_checker"], static_results)
+            if ast_results:
+                results["performance_analyzer"]["ast_analysis"] = ast_results.get("ast_analysis", {})
+
+            logger.info("Fused review completed",
+                       filename=filename,
+                       issues_found={name: len(result["issues"]) for name, result in results.items()},
+                       duration=time.time() - start_time)
+
+            return {
+                "agent": "fused_reviewer",
+                "filename": filename,
+                "status": "success",
+                "results": results,
+                "from_cache": call_info["from_cache"]
+            }
+        except Exception as e:
+            logger.error("Fused review failed",
+                        exception=e,
+                        filename=filename)
+
+            return {
+                "agent": "fused_reviewer",
+                "filename": filename,
+                "status": "error",
+                "error": str(e)
+            }
+
+    @staticmethod
+    def _agent_result(agent_name: str,
+                      filename: str,
+                      text: str,
+                      issues: List[Dict[str, Any]],
+                      call_info: Dict[str, Any],
+                      start_time: float) -> Dict[str, Any]:
+        """Result dict in the format of the specialized agent"""
+        counts = severity_counts(issues)
+        result = {
+            "agent": agent_name,
+            "filename": filename,
+            "status": "success",
+            "issues": issues,
+            "from_cache": call_info["from_cache"],
+            "deferred": call_info.get("deferred", False),
+            "fused": True
+        }
+        if agent_name == "code_reviewer":
+            result["review"] = text
+            result["issues_found"] = {
+                "high": counts["critical"] + counts["high"],
+                "medium": counts["medium"],
+                "low": counts["low"]
+            }
+            result["metrics"] = {
+                "analysis_time": time.time() - start_time,
+                "api_call_time": call_info["api_call_time"]
+            }
+        elif agent_name == "security_checker":
+            result["analysis"] = text
+            result["vulnerabilities"] = counts
+        else:
+            result["analysis"] = text
+            result["performance_issues"] = dict(
+                counts, complexity_issues=PerformanceAnalyzerAgent.count_complexity_issues(issues)
+            )
+        return result
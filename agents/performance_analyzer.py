@@ -2,43 +2,66 @@
 Performance Analyzer Agent - Focuses on code performance, complexity, and optimization
 """
 
-from autogen_agentchat.agents import AssistantAgent
-from autogen_ext.models.openai import OpenAIChatCompletionClient
 import os
+import re
 from typing import Dict, List, Any
 import sys
 sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
-from utils.ast_analyzer import analyze_python_code
+from agents.base_agent import BaseReviewAgent
+from utils.cache_manager import CacheManager
+from utils.analysis_context import AnalysisContext
+from utils.diff_scoper import SCOPED_REVIEW_NOTE
+from utils.review_schema import severity_counts
+from utils.prompt_templates import ReviewPromptTemplate
 from utils.logger import get_logger, track_performance
 
 # Initialize logger
 logger = get_logger(__name__)
 
+REVIEW_PROMPT = ReviewPromptTemplate(
+    """Perform a comprehensive performance review of the code at the end of this message, following
+the guidelines in your system message.
 
-class PerformanceAnalyzerAgent:
+CRITICAL: You must find and report ALL performance issues.
+
+Specifically look for:
+- Triple nested loops (like in find_duplicate_users)
+- Memory leaks (like objects added to cache but never removed)
+- N+1 query patterns in database operations
+- Recursive functions without proper base cases
+- Any O(n²) or worse algorithms
+
+Use the AST analysis data to inform your review if provided."""
+)
+
+# Complexities worse than O(n log n), e.g. O(n^2), O(n³), O(n*m), O(2^n)
+SUPERLINEAR_PATTERN = re.compile(r"O\(\s*(?:n\s*(?:\^|\*\*)\s*\d|n[²³]|n\s*\*\s*\w|\d\s*\^\s*n|n!)", re.IGNORECASE)
+
+
+class PerformanceAnalyzerAgent(BaseReviewAgent):
     """Agent specialized in performance analysis and optimization recommendations"""
     
-    def __init__(self, api_key: str = None):
+    agent_name = "performance_analyzer"
+    finding_type = "performance"
+    
+    def __init__(self, api_key: str = None, cache_manager: CacheManager = None,
+                 structured_output: bool = False):
         """Initialize the Performance Analyzer Agent
         
         Args:
             api_key: OpenAI API key (defaults to env var OPENAI_API_KEY)
+            cache_manager: Optional cache for responses to unchanged code
+            structured_output: Request JSON findings instead of free text
         """
-        self.api_key = api_key or os.getenv("OPENAI_API_KEY")
-        if not self.api_key:
-            raise ValueError("OpenAI API key is required")
-            
-        self.model_client = OpenAIChatCompletionClient(
-            model="gpt-4o",  # Using full model for better analysis
-            temperature=0.1,
-            api_key=self.api_key
-        )
-        
-        self.agent = AssistantAgent(
-            name="performance_analyzer",
-            model_client=self.model_client,
-            system_message=self._get_system_message()
-        )
+        super().__init__(api_key=api_key, model="gpt-4o", cache_manager=cache_manager,
+                         structured_output=structured_output)
+    
+    def _cache_context(self, context: Dict[str, Any]) -> Dict[str, Any]:
+        """Prompt inputs besides the code that change the agent's answer"""
+        return {
+            "language": context.get("language", "auto-detect"),
+            "expected_load": context.get("expected_load", "unknown")
+        }
     
     def _get_system_message(self) -> str:
         """Define the system message for the performance analyzer agent"""
@@ -94,11 +117,18 @@ class PerformanceAnalyzerAgent:
         language = context.get("language", "auto-detect")
         expected_load = context.get("expected_load", "unknown")
         
-        # Run AST analysis for Python code
+        # Diff-scoped reviews pass an excerpt; the AST needs the full, parseable file
+        review_scope = context.get("review_scope")
+        analysis_code = review_scope.full_code if review_scope else code
+        
+        # The orchestrator shares one analysis context (and AST parse) per file
+        analysis = context.get("analysis") or AnalysisContext(analysis_code, filename, language)
+        
+        # Run AST analysis for Python code (tree-sitter for other languages)
         ast_results = {}
-        if language.lower() in ["python", "py", "auto-detect"]:
-            logger.info("Running AST analysis for Python code")
-            ast_results = analyze_python_code(code)
+        if analysis.supports_structure:
+            logger.info("Running AST analysis", language=language)
+            ast_results = analysis.ast_results()
             
             # Enhance context with AST insights
             if "ast_analysis" in ast_results and "error" not in ast_results["ast_analysis"]:
@@ -107,71 +137,28 @@ class PerformanceAnalyzerAgent:
                 context["complexity_scores"] = ast_data.get("complexity", {})
         
         # Build enhanced prompt with AST insights
-        ast_summary = ""
-        if ast_results and "ast_analysis" in ast_results and "error" not in ast_results["ast_analysis"]:
-            ast_data = ast_results["ast_analysis"]
-            metrics = ast_data.get("metrics", {})
-            
-            if metrics:
-                ast_summary = f"""
-
-AST Analysis Results:
-- Total Functions: {metrics.get('total_functions', 0)}
-- Average Complexity: {metrics.get('avg_complexity', 0)}
-- Max Complexity: {metrics.get('max_complexity', 0)}
-- High Complexity Functions: {', '.join(metrics.get('high_complexity_functions', []))}
-- Security Issues Found: {metrics.get('security_issues', 0)}
-- Code Smells: {metrics.get('code_smell_count', 0)}
-
-Complexity Scores by Function:
-"""
-                for func, score in ast_data.get("complexity", {}).items():
-                    ast_summary += f"- {func}: {score}\n"
+        ast_summary = self.format_ast_summary(ast_results)
         
-        prompt = f"""Please perform a performance analysis of the following code from file '{filename}':
-
-```{language}
-{code}
-```
-
-Expected Load: {expected_load if expected_load != 'unknown' else 'Not specified'}
-{ast_summary}
-
-Perform a comprehensive performance review following the guidelines in your system message.
-
-CRITICAL: You must find and report ALL performance issues using the exact format specified:
-ISSUE: [Name]
-SEVERITY: [Critical/High/Medium/Low]
-LOCATION: [Function and lines]
-COMPLEXITY: [e.g., O(n³)]
-IMPACT: [Description]
-SOLUTION: [Fix]
-
-Specifically look for:
-- Triple nested loops (like in find_duplicate_users)
-- Memory leaks (like objects added to cache but never removed)
-- N+1 query patterns in database operations
-- Recursive functions without proper base cases
-- Any O(n²) or worse algorithms
-
-Use the AST analysis data to inform your review if provided."""
+        prompt = REVIEW_PROMPT.render(
+            code, filename, language,
+            details=[
+                f"Expected Load: {expected_load if expected_load != 'unknown' else 'Not specified'}",
+                SCOPED_REVIEW_NOTE if review_scope else "",
+                ast_summary
+            ]
+        )
 
         try:
-            result = await self.agent.run(task=prompt)
-            
-            # Extract the actual message content from AutoGen response
-            if hasattr(result, 'messages') and len(result.messages) > 0:
-                # Get the last assistant message
-                analysis_text = result.messages[-1].content
-            elif hasattr(result, 'content'):
-                analysis_text = result.content
-            elif isinstance(result, str):
-                analysis_text = result
-            else:
-                analysis_text = str(result)
+            analysis_text, call_info = await self._run_review(prompt, code, context)
             
             # Merge AST findings with agent analysis
-            performance_issues = self._extract_performance_issues(analysis_text)
+            issues = self._structured_issues(call_info)
+            if issues is not None:
+                performance_issues = severity_counts(issues)
+                performance_issues["complexity_issues"] = self.count_complexity_issues(issues)
+            else:
+                performance_issues = self._extract_performance_issues(analysis_text)
+                issues = self._extract_structured_issues(analysis_text)
             
             result = {
                 "agent": "performance_analyzer",
@@ -179,7 +166,9 @@ Use the AST analysis data to inform your review if provided."""
                 "status": "success",
                 "analysis": analysis_text,
                 "performance_issues": performance_issues,
-                "issues": self._extract_structured_issues(analysis_text)
+                "issues": issues,
+                "from_cache": call_info["from_cache"],
+                "deferred": call_info.get("deferred", False)
             }
             
             # Add AST analysis if available
@@ -206,6 +195,35 @@ Use the AST analysis data to inform your review if provided."""
                 "ast_analysis": ast_results.get("ast_analysis", {}) if ast_results else {}
             }
     
+    @staticmethod
+    def format_ast_summary(ast_results: Dict[str, Any]) -> str:
+        """AST metrics and complexity scores as a prompt section (empty if unavailable)"""
+        ast_data = (ast_results or {}).get("ast_analysis", {})
+        metrics = ast_data.get("metrics", {})
+        if "error" in ast_data or not metrics:
+            return ""
+        
+        ast_summary = f"""
+
+AST Analysis Results:
+- Total Functions: {metrics.get('total_functions', 0)}
+- Average Complexity: {metrics.get('avg_complexity', 0)}
+- Max Complexity: {metrics.get('max_complexity', 0)}
+- High Complexity Functions: {', '.join(metrics.get('high_complexity_functions', []))}
+- Security Issues Found: {metrics.get('security_issues', 0)}
+- Code Smells: {metrics.get('code_smell_count', 0)}
+
+Complexity Scores by Function:
+"""
+        for func, score in ast_data.get("complexity", {}).items():
+            ast_summary += f"- {func}: {score}\n"
+        return ast_summary
+    
+    @staticmethod
+    def count_complexity_issues(issues: List[Dict[str, Any]]) -> int:
+        """Number of structured issues with a worse than O(n log n) complexity"""
+        return sum(1 for issue in issues if SUPERLINEAR_PATTERN.search(issue.get("complexity", "")))
+    
     def _extract_performance_issues(self, analysis_text: str) -> Dict[str, Any]:
         """Extract performance issue summary from analysis text"""
         analysis_lower = analysis_text.lower()
@@ -282,7 +300,7 @@ For each function/method:
 5. Provide the improved code if applicable"""
 
         try:
-            result = await self.agent.run(task=prompt)
+            result = await self._run_task(prompt)
             return {
                 "agent": "performance_analyzer",
                 "analysis_type": "complexity",
@@ -324,7 +342,7 @@ For each optimization:
 5. Consider maintainability impact"""
 
         try:
-            result = await self.agent.run(task=prompt)
+            result = await self._run_task(prompt)
             return {
                 "agent": "performance_analyzer",
                 "analysis_type": "optimizations",
@@ -372,7 +390,7 @@ Provide:
 5. Benchmark estimates for different input sizes"""
 
         try:
-            result = await self.agent.run(task=prompt)
+            result = await self._run_task(prompt)
             return {
                 "agent": "performance_analyzer",
                 "analysis_type": "benchmark_comparison",
@@ -2,43 +2,54 @@
 Security Checker Agent - Focuses on vulnerability detection and security best practices
 """
 
-from autogen_agentchat.agents import AssistantAgent
-from autogen_ext.models.openai import OpenAIChatCompletionClient
 import os
 from typing import Dict, List, Any
 import sys
 sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
-from utils.static_analyzer import run_static_analysis
+from agents.base_agent import BaseReviewAgent
+from utils.cache_manager import CacheManager
+from utils.analysis_context import AnalysisContext
+from utils.diff_scoper import SCOPED_REVIEW_NOTE
+from utils.review_schema import severity_counts
+from utils.prompt_templates import ReviewPromptTemplate
 from utils.logger import get_logger, track_performance
 
 # Initialize logger
 logger = get_logger(__name__)
 
+REVIEW_PROMPT = ReviewPromptTemplate(
+    """Perform a comprehensive security review of the code at the end of this message, following the
+guidelines in your system message. Focus on identifying real vulnerabilities, not just theoretical issues.
 
-class SecurityCheckerAgent:
+If static analysis results are provided, incorporate them into your analysis and verify the findings."""
+)
+
+
+class SecurityCheckerAgent(BaseReviewAgent):
     """Agent specialized in security vulnerability detection and prevention"""
     
-    def __init__(self, api_key: str = None):
+    agent_name = "security_checker"
+    finding_type = "security"
+    
+    def __init__(self, api_key: str = None, cache_manager: CacheManager = None,
+                 structured_output: bool = False):
         """Initialize the Security Checker Agent
         
         Args:
             api_key: OpenAI API key (defaults to env var OPENAI_API_KEY)
+            cache_manager: Optional cache for responses to unchanged code
+            structured_output: Request JSON findings instead of free text
         """
-        self.api_key = api_key or os.getenv("OPENAI_API_KEY")
-        if not self.api_key:
-            raise ValueError("OpenAI API key is required")
-            
-        self.model_client = OpenAIChatCompletionClient(
-            model="gpt-4o",  # Using full model for better security detection
-            temperature=0.1,
-            api_key=self.api_key
-        )
-        
-        self.agent = AssistantAgent(
-            name="security_checker",
-            model_client=self.model_client,
-            system_message=self._get_system_message()
-        )
+        super().__init__(api_key=api_key, model="gpt-4o", cache_manager=cache_manager,
+                         structured_output=structured_output)
+    
+    def _cache_context(self, context: Dict[str, Any]) -> Dict[str, Any]:
+        """Prompt inputs besides the code that change the agent's answer"""
+        # The bandit summary is derived from the code itself, so it is not needed here
+        return {
+            "language": context.get("language", "auto-detect"),
+            "framework": context.get("framework", "unknown")
+        }
     
     def _get_system_message(self) -> str:
         """Define the system message for the security checker agent"""
@@ -92,79 +103,56 @@ class SecurityCheckerAgent:
         language = context.get("language", "auto-detect")
         framework = context.get("framework", "unknown")
         
+        # Diff-scoped reviews pass an excerpt; bandit needs the full, parseable file
+        review_scope = context.get("review_scope")
+        analysis_code = review_scope.full_code if review_scope else code
+        
+        # The orchestrator shares one analysis context per file (and may have
+        # started or batch-computed the static analysis already)
+        analysis = context.get("analysis") or AnalysisContext(
+            analysis_code, filename, language, static_analysis=context.get("static_analysis")
+        )
+        
         # Run static security analysis for Python code
         static_results = {}
         if language.lower() in ["python", "py", "auto-detect"]:
             logger.info("Running static security analysis with bandit")
-            static_results = run_static_analysis(code, filename)
-            
-            # Extract bandit findings if available
-            bandit_summary = ""
-            if ("analyses" in static_results and 
-                "bandit" in static_results["analyses"] and 
-                static_results["analyses"]["bandit"]["status"] == "success"):
-                
-                bandit_data = static_results["analyses"]["bandit"]
-                bandit_issues = bandit_data.get("security_issues", [])
-                
-                if bandit_issues:
-                    bandit_summary = "\n\nStatic Security Analysis (Bandit) Results:\n"
-                    for issue in bandit_issues:
-                        bandit_summary += f"- Line {issue['line']}: {issue['test_name']} "
-                        bandit_summary += f"(Severity: {issue['severity']}, Confidence: {issue['confidence']})\n"
-                        bandit_summary += f"  {issue['text']}\n"
+            static_results = await analysis.static_analysis()
         
-        prompt = f"""Please perform a security analysis of the following code from file '{filename}':
-
-```{language}
-{code}
-```
-
-Framework/Library: {framework if framework != 'unknown' else 'Auto-detect'}
-{bandit_summary if 'bandit_summary' in locals() else ''}
-
-Perform a comprehensive security review following the guidelines in your system message. 
-Focus on identifying real vulnerabilities, not just theoretical issues.
-
-If static analysis results are provided, incorporate them into your analysis and verify the findings."""
+        bandit_summary = self.format_bandit_summary(static_results, review_scope)
+        
+        prompt = REVIEW_PROMPT.render(
+            code, filename, language,
+            details=[
+                f"Framework/Library: {framework if framework != 'unknown' else 'Auto-detect'}",
+                SCOPED_REVIEW_NOTE if review_scope else "",
+                bandit_summary
+            ]
+        )
 
         try:
-            result = await self.agent.run(task=prompt)
+            analysis_text, call_info = await self._run_review(prompt, code, context)
             
-            # Extract the actual message content from AutoGen response
-            if hasattr(result, 'messages') and len(result.messages) > 0:
-                # Get the last assistant message
-                analysis_text = result.messages[-1].content
-            elif hasattr(result, 'content'):
-                analysis_text = result.content
-            elif isinstance(result, str):
-                analysis_text = result
+            issues = self._structured_issues(call_info)
+            if issues is not None:
+                vulnerabilities = severity_counts(issues)
             else:
-                analysis_text = str(result)
-            
-            vulnerabilities = self._extract_vulnerability_summary(analysis_text)
+                vulnerabilities = self._extract_vulnerability_summary(analysis_text)
             
             result = {
                 "agent": "security_checker",
                 "filename": filename,
                 "status": "success",
                 "analysis": analysis_text,
-                "vulnerabilities": vulnerabilities
+                "vulnerabilities": vulnerabilities,
+                "from_cache": call_info["from_cache"],
+                "deferred": call_info.get("deferred", False)
             }
+            if issues is not None:
+                result["issues"] = issues
             
             # Add static analysis results if available
-            if static_results:
-                result["static_analysis"] = static_results
-                
-                # Merge static analysis findings
-                if ("analyses" in static_results and 
-                    "bandit" in static_results["analyses"] and 
-                    static_results["analyses"]["bandit"]["status"] == "success"):
-                    
-                    bandit_metrics = static_results["analyses"]["bandit"]["metrics"]
-                    result["vulnerabilities"]["static_high"] = bandit_metrics.get("severity_high", 0)
-                    result["vulnerabilities"]["static_medium"] = bandit_metrics.get("severity_medium", 0)
-                    result["vulnerabilities"]["static_low"] = bandit_metrics.get("severity_low", 0)
+            self.merge_static_analysis(result, static_results)
             
             logger.info("Security analysis completed",
                        filename=filename,
@@ -186,6 +174,50 @@ If static analysis results are provided, incorporate them into your analysis and
                 "static_analysis": static_results if 'static_results' in locals() else {}
             }
     
+    @staticmethod
+    def format_bandit_summary(static_results: Dict[str, Any], review_scope: Any = None) -> str:
+        """Bandit findings as a prompt section (empty if there are none)
+        
+        Args:
+            static_results: run_static_analysis() output
+            review_scope: ScopedCode of a diff-scoped review; only issues inside
+                the excerpt are listed, with excerpt line numbers
+        """
+        bandit_data = (static_results or {}).get("analyses", {}).get("bandit", {})
+        if bandit_data.get("status") != "success":
+            return ""
+        
+        bandit_issues = bandit_data.get("security_issues", [])
+        if review_scope:
+            bandit_issues = [
+                dict(issue, line=review_scope.to_excerpt_line(issue['line']))
+                for issue in bandit_issues
+                if review_scope.to_excerpt_line(issue['line'])
+            ]
+        if not bandit_issues:
+            return ""
+        
+        bandit_summary = "\n\nStatic Security Analysis (Bandit) Results:\n"
+        for issue in bandit_issues:
+            bandit_summary += f"- Line {issue['line']}: {issue['test_name']} "
+            bandit_summary += f"(Severity: {issue['severity']}, Confidence: {issue['confidence']})\n"
+            bandit_summary += f"  {issue['text']}\n"
+        return bandit_summary
+    
+    @staticmethod
+    def merge_static_analysis(result: Dict[str, Any], static_results: Dict[str, Any]):
+        """Attach static analysis output and bandit counts to a security result"""
+        if not static_results:
+            return
+        result["static_analysis"] = static_results
+        
+        bandit_data = static_results.get("analyses", {}).get("bandit", {})
+        if bandit_data.get("status") == "success":
+            bandit_metrics = bandit_data["metrics"]
+            result["vulnerabilities"]["static_high"] = bandit_metrics.get("severity_high", 0)
+            result["vulnerabilities"]["static_medium"] = bandit_metrics.get("severity_medium", 0)
+            result["vulnerabilities"]["static_low"] = bandit_metrics.get("severity_low", 0)
+    
     def _extract_vulnerability_summary(self, analysis_text: str) -> Dict[str, int]:
         """Extract vulnerability counts from analysis text
         
@@ -224,7 +256,7 @@ Check for:
 Provide specific version recommendations for any vulnerable dependencies."""
 
         try:
-            result = await self.agent.run(task=prompt)
+            result = await self._run_task(prompt)
             return {
                 "agent": "security_checker",
                 "analysis_type": "dependencies",
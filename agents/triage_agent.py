@@ -0,0 +1,89 @@
+"""
+Triage Agent - Cheap first pass deciding how much review a piece of code needs
+"""
+
+import os
+from typing import Dict, Any
+import re
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from agents.base_agent import BaseReviewAgent
+from utils.cache_manager import CacheManager
+from utils.logger import get_logger
+from utils.prompt_templates import ReviewPromptTemplate
+
+# Initialize logger
+logger = get_logger(__name__)
+
+REVIEW_TIERS = ("skip", "light", "deep")
+
+# Only the start of long inputs is shown to the triage model
+TRIAGE_MAX_LINES = 200
+
+TRIAGE_PROMPT = ReviewPromptTemplate(
+    "Classify the code at the end of this message: SKIP, LIGHT or DEEP?"
+)
+
+TIER_PATTERN = re.compile(r"\b(skip|light|deep)\b", re.IGNORECASE)
+
+
+class TriageAgent(BaseReviewAgent):
+    """Agent classifying review inputs as skip, light or deep review"""
+
+    agent_name = "review_triage"
+
+    def __init__(self, api_key: str = None, cache_manager: CacheManager = None,
+                 model: str = "gpt-4o-mini"):
+        """Initialize the Triage Agent
+
+        Args:
+            api_key: OpenAI API key (defaults to env var OPENAI_API_KEY)
+            cache_manager: Optional cache for decisions on unchanged code
+            model: Fast, cheap model used for triage
+        """
+        logger.info("Initializing TriageAgent", model=model)
+        super().__init__(api_key=api_key, model=model, cache_manager=cache_manager)
+
+    def _get_system_message(self) -> str:
+        """Define the system message for the triage agent"""
+        return """You triage code changes before an expensive multi-agent review
+        (code quality, security and performance). Classify the code as:
+
+        SKIP - nothing a reviewer could find: configuration values, constants, renames,
+        re-exports, generated code, test fixtures and data without logic
+        LIGHT - simple logic where a quick review is enough: small helpers, straightforward
+        glue code, tests with plain assertions
+        DEEP - anything that handles user input, authentication, secrets, SQL, files,
+        processes, network, serialization or concurrency, and any non-trivial algorithm
+
+        When in doubt, answer DEEP. Answer with exactly one word: SKIP, LIGHT or DEEP."""
+
+    async def classify(self, code: str, filename: str, signals: str = "",
+                       context: Dict[str, Any] = None) -> str:
+        """Classify a review input
+
+        Args:
+            code: Code that would be reviewed (file, excerpt or changed units)
+            filename: Name of the file
+            signals: Summary of local analysis results shown to the model
+            context: Review context (language)
+
+        Returns:
+            "skip", "light" or "deep" ("deep" if the answer cannot be understood)
+        """
+        context = context or {}
+        language = context.get("language", "auto-detect")
+        lines = code.split("\n")
+        shown = "\n".join(lines[:TRIAGE_MAX_LINES])
+        truncated = f"\n... ({len(lines) - TRIAGE_MAX_LINES} more lines)" if len(lines) > TRIAGE_MAX_LINES else ""
+
+        prompt = TRIAGE_PROMPT.render(shown + truncated, filename, language, details=[signals])
+
+        answer, _ = await self._run_review(prompt, code, context)
+        match = TIER_PATTERN.search(str(answer))
+        if not match:
+            logger.warning("Unrecognized triage answer, using deep review",
+                           filename=filename,
+                           answer=str(answer)[:100])
+            return "deep"
+        return match.group(1).lower()
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+Compare two benchmark result files (from benchmarks/run_benchmarks.py)
+
+Prints the change of each metric per scenario and concurrency level, and
+exits with status 1 when a metric got worse by more than --threshold
+percent (for use in CI).
+
+Usage:
+    python -m benchmarks.compare baseline.json results.json --threshold 10
+"""
+
+import argparse
+import json
+import sys
+from typing import Dict, List, Any, Optional, Tuple
+
+# (label, path in a result entry, True if higher is better)
+METRICS = (
+    ("throughput PRs/min", ("throughput_prs_per_minute",), True),
+    ("latency p50 s", ("latency_seconds", "p50"), False),
+    ("latency p99 s", ("latency_seconds", "p99"), False),
+    ("first feedback p50 s", ("first_feedback_seconds", "p50"), False),
+    ("input tokens/PR", ("tokens_per_pr", "input"), False),
+    ("output tokens/PR", ("tokens_per_pr", "output"), False),
+    ("cost/PR $", ("cost_per_pr_usd",), False),
+    ("model calls/PR", ("model_calls_per_pr",), False),
+    ("GitHub requests/PR", ("github_requests_per_pr",), False)
+)
+
+
+def _value(result: Dict[str, Any], path: Tuple[str, ...]) -> Optional[float]:
+    for key in path:
+        result = result.get(key) if isinstance(result, dict) else None
+    return result
+
+
+def compare(baseline: Dict[str, Any], current: Dict[str, Any], threshold: float) -> Tuple[List[str], List[str]]:
+    """Report lines and regressions beyond threshold percent"""
+    lines, regressions = [], []
+    baseline_results = {(r["scenario"], r["concurrency"]): r for r in baseline["results"]}
+    for result in current["results"]:
+        key = (result["scenario"], result["concurrency"])
+        old = baseline_results.get(key)
+        if old is None:
+            continue
+        lines.append(f"{key[0]} x{key[1]}")
+        for label, path, higher_is_better in METRICS:
+            before, after = _value(old, path), _value(result, path)
+            if before is None or after is None:
+                continue
+            change = (after - before) / before * 100 if before else (0.0 if after == before else float("inf"))
+            worse = -change if higher_is_better else change
+            flag = ""
+            if worse > threshold:
+                flag = "  REGRESSION"
+                regressions.append(f"{key[0]} x{key[1]} {label}: {before} -> {after}")
+            lines.append(f"  {label:<20} {before:>12} -> {after:<12} {change:+.1f}%{flag}")
+    return lines, regressions
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Compare two benchmark result files")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="Percent by which a metric may get worse before it counts as a regression")
+    args = parser.parse_args(argv)
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    with open(args.current) as f:
+        current = json.load(f)
+
+    if baseline.get("config", {}).get("corpus") != current.get("config", {}).get("corpus"):
+        print("Warning: the results are from different corpora", file=sys.stderr)
+    print(f"{baseline.get('git_commit', '?')[:12]} -> {current.get('git_commit', '?')[:12]}")
+    lines, regressions = compare(baseline, current, args.threshold)
+    print("\n".join(lines))
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) beyond {args.threshold}%:")
+        print("\n".join(regressions))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
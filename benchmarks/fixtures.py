@@ -0,0 +1,402 @@
+"""
+Record/replay fixtures for the OpenAI and GitHub calls of a review
+
+A FixtureStore is a JSON file with recorded model responses (keyed by
+agent, model, output mode and prompt) and GitHub HTTP responses (keyed by
+method, path and query). In record mode the real services are called and
+their responses saved; in replay mode responses come from the store after
+an injected delay, so reviews run offline and reproducibly.
+
+Requests missing from the store fail in strict mode. Otherwise a
+deterministic stand-in response is served and counted as a miss; the
+synthetic corpus relies on this (see synthetic_pr).
+
+Review posts are never sent to GitHub, not even when recording.
+"""
+
+import asyncio
+import hashlib
+import json
+import os
+import random
+import time
+from contextlib import contextmanager
+from typing import Dict, List, Any, Optional
+from urllib.parse import urlencode
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+import httpx
+from pydantic import BaseModel
+
+from agents.base_agent import BaseReviewAgent
+from agents.triage_agent import TriageAgent
+from utils.github_integration import PAGE_SIZE
+from utils.token_budget import count_tokens
+
+REPLAY = "replay"
+RECORD = "record"
+FIXTURE_MODES = (REPLAY, RECORD)
+
+FIXTURE_VERSION = 1
+
+
+def fixture_key(*parts: Any) -> str:
+    """Stable key of a request"""
+    return hashlib.sha256(json.dumps(parts, sort_keys=True, default=str).encode("utf-8")).hexdigest()
+
+
+class LatencyModel:
+    """Injected service latency: a fixed delay, or the recorded one, with seeded jitter"""
+
+    def __init__(self, seconds: Optional[float] = None, default: float = 0.0,
+                 jitter: float = 0.0, seed: int = 0):
+        """Initialize the latency model
+
+        Args:
+            seconds: Delay of every response; None replays the recorded durations
+            default: Delay of responses without a recorded duration (stand-ins)
+            jitter: Relative random variation of the delay (0.2 = +/-20%)
+            seed: Seed of the jitter, so runs are repeatable
+        """
+        self.seconds = seconds
+        self.default = default
+        self.jitter = jitter
+        self._random = random.Random(seed)
+
+    def delay(self, recorded: Optional[float] = None) -> float:
+        if self.seconds is not None:
+            base = self.seconds
+        else:
+            base = recorded if recorded is not None else self.default
+        if self.jitter:
+            base *= 1 + self._random.uniform(-self.jitter, self.jitter)
+        return max(0.0, base)
+
+    async def wait(self, recorded: Optional[float] = None):
+        delay = self.delay(recorded)
+        if delay:
+            await asyncio.sleep(delay)
+
+
+class FixtureStore:
+    """Recorded responses of one corpus"""
+
+    def __init__(self, path: Optional[str] = None, strict: bool = False):
+        """Initialize the store
+
+        Args:
+            path: JSON file of the fixtures (loaded if it exists); None keeps
+                them in memory only
+            strict: Fail on requests without a recorded response instead of
+                serving a stand-in
+        """
+        self.path = path
+        self.strict = strict
+        self.llm: Dict[str, Dict[str, Any]] = {}
+        self.http: Dict[str, Dict[str, Any]] = {}
+        self.misses = {"llm": 0, "http": 0}
+        if path and os.path.exists(path):
+            with open(path) as f:
+                data = json.load(f)
+            self.llm = data.get("llm", {})
+            self.http = data.get("http", {})
+
+    def save(self):
+        """Write the fixtures to the store's file"""
+        if not self.path:
+            return
+        os.makedirs(os.path.dirname(os.path.abspath(self.path)), exist_ok=True)
+        with open(self.path, "w") as f:
+            json.dump({"version": FIXTURE_VERSION, "llm": self.llm, "http": self.http}, f, indent=1, sort_keys=True)
+
+    def miss(self, kind: str, description: str):
+        """Count a request without a fixture (an error in strict mode)"""
+        if self.strict:
+            raise KeyError(f"No recorded {kind} response for {description}")
+        self.misses[kind] += 1
+
+
+# Model responses
+
+class ReplayUsage:
+    """Token usage in the shape of AutoGen's RequestUsage"""
+
+    def __init__(self, prompt_tokens: int, completion_tokens: int):
+        self.prompt_tokens = prompt_tokens
+        self.completion_tokens = completion_tokens
+
+
+class ReplayMessage:
+    def __init__(self, content: Any, models_usage: Optional[ReplayUsage]):
+        self.content = content
+        self.models_usage = models_usage
+
+
+class ReplayResult:
+    """Replayed run in the shape of AutoGen's TaskResult"""
+
+    def __init__(self, content: Any, usage: Optional[ReplayUsage]):
+        self.messages = [ReplayMessage(content, usage)]
+
+
+def _empty_response(model: type) -> Dict[str, Any]:
+    """Valid instance data of a response schema without findings"""
+    data = {}
+    for name, field in model.model_fields.items():
+        annotation = field.annotation
+        if isinstance(annotation, type) and issubclass(annotation, BaseModel):
+            data[name] = _empty_response(annotation)
+        else:
+            data[name] = "No issues found." if annotation is str else []
+    return data
+
+
+def _stand_in_response(agent: BaseReviewAgent, structured: bool) -> str:
+    """Response served for prompts without a fixture: no findings, deep triage"""
+    if isinstance(agent, TriageAgent):
+        return "DEEP"
+    if structured:
+        return json.dumps(_empty_response(agent.response_model))
+    return "No significant issues found."
+
+
+class FixtureAgent:
+    """Stands in for an AssistantAgent, replaying or recording its runs"""
+
+    def __init__(self,
+                 agent: BaseReviewAgent,
+                 model: str,
+                 structured: bool,
+                 store: FixtureStore,
+                 mode: str,
+                 latency: LatencyModel,
+                 create_real_agent=None):
+        self.agent = agent
+        self.model = model
+        self.structured = structured
+        self.store = store
+        self.mode = mode
+        self.latency = latency
+        self.create_real_agent = create_real_agent
+
+    async def run(self, task: str) -> Any:
+        key = fixture_key(self.agent.agent_name, self.model, self.structured, task)
+        if self.mode == RECORD:
+            return await self._record(key, task)
+
+        fixture = self.store.llm.get(key)
+        if fixture is None:
+            self.store.miss("llm", f"{self.agent.agent_name} ({self.model})")
+            content = _stand_in_response(self.agent, self.structured)
+            fixture = {
+                "content": content,
+                "prompt_tokens": count_tokens(self.agent._get_system_message(), self.model) + count_tokens(task, self.model),
+                "completion_tokens": count_tokens(content, self.model),
+                "duration": None
+            }
+        await self.latency.wait(fixture.get("duration"))
+        usage = ReplayUsage(fixture["prompt_tokens"], fixture["completion_tokens"])
+        return ReplayResult(fixture["content"], usage)
+
+    async def _record(self, key: str, task: str) -> Any:
+        start = time.time()
+        result = await self.create_real_agent().run(task=task)
+        duration = time.time() - start
+
+        content = result.messages[-1].content if getattr(result, "messages", None) else result
+        if hasattr(content, "model_dump_json"):
+            content = content.model_dump_json()
+        usage = BaseReviewAgent._response_usage(result) or {
+            "prompt_tokens": 0, "completion_tokens": 0
+        }
+        self.store.llm[key] = {
+            "agent": self.agent.agent_name,
+            "model": self.model,
+            "content": content if isinstance(content, str) else str(content),
+            "duration": round(duration, 3),
+            **usage
+        }
+        return result
+
+
+@contextmanager
+def llm_fixtures(store: FixtureStore, mode: str = REPLAY, latency: Optional[LatencyModel] = None):
+    """Route every agent's model calls through the fixtures while active"""
+    if mode not in FIXTURE_MODES:
+        raise ValueError(f"Unknown fixture mode: {mode}")
+    latency = latency or LatencyModel()
+    original = BaseReviewAgent._create_agent
+
+    def create_agent(agent: BaseReviewAgent, model: Optional[str] = None, structured: Optional[bool] = None):
+        model = model or agent.model
+        structured = agent.structured_output if structured is None else structured
+        return FixtureAgent(agent, model, structured, store, mode, latency,
+                            create_real_agent=lambda: original(agent, model, structured))
+
+    BaseReviewAgent._create_agent = create_agent
+    try:
+        yield store
+    finally:
+        BaseReviewAgent._create_agent = original
+
+
+# GitHub responses
+
+def http_key(method: str, url: httpx.URL) -> str:
+    query = urlencode(sorted(url.params.multi_items()))
+    return fixture_key(method.upper(), url.path, query if method.upper() == "GET" else "")
+
+
+class FixtureTransport(httpx.AsyncBaseTransport):
+    """httpx transport replaying (or recording) GitHub responses
+
+    Requests other than GET are answered locally in both modes and counted
+    in `posted`, so benchmarks never write to GitHub.
+    """
+
+    def __init__(self, store: FixtureStore, mode: str = REPLAY, latency: Optional[LatencyModel] = None):
+        self.store = store
+        self.mode = mode
+        self.latency = latency or LatencyModel()
+        self.posted: List[Dict[str, Any]] = []
+        self.requests = 0
+        self._upstream = httpx.AsyncHTTPTransport() if mode == RECORD else None
+
+    async def handle_async_request(self, request: httpx.Request) -> httpx.Response:
+        self.requests += 1
+        if request.method != "GET":
+            await self.latency.wait()
+            body = await request.aread()
+            self.posted.append({"method": request.method, "path": request.url.path, "bytes": len(body)})
+            return httpx.Response(201, json={"id": len(self.posted), "html_url": f"https://github.com{request.url.path}"},
+                                  request=request)
+
+        key = http_key(request.method, request.url)
+        if self.mode == RECORD:
+            start = time.time()
+            response = await self._upstream.handle_async_request(request)
+            content = await response.aread()
+            self.store.http[key] = {
+                "path": request.url.path,
+                "status": response.status_code,
+                "content_type": response.headers.get("content-type", ""),
+                "body": content.decode("utf-8", errors="replace"),
+                "duration": round(time.time() - start, 3)
+            }
+            return httpx.Response(response.status_code, headers={"content-type": self.store.http[key]["content_type"]},
+                                  content=content, request=request)
+
+        fixture = self.store.http.get(key)
+        if fixture is None:
+            self.store.miss("http", f"GET {request.url.path}")
+            await self.latency.wait()
+            return httpx.Response(404, json={"message": "Not Found"}, request=request)
+        await self.latency.wait(fixture.get("duration"))
+        return httpx.Response(fixture["status"], headers={"content-type": fixture["content_type"]},
+                              content=fixture["body"].encode("utf-8"), request=request)
+
+    async def aclose(self):
+        # Shared by the clients of all reviews; closed by shutdown() at the end
+        pass
+
+    async def shutdown(self):
+        if self._upstream is not None:
+            await self._upstream.aclose()
+
+
+def fixture_client(transport: FixtureTransport) -> httpx.AsyncClient:
+    """HTTP client for GitHubIntegration._client that goes through the fixtures"""
+    return httpx.AsyncClient(transport=transport, timeout=30.0)
+
+
+# Synthetic corpus
+
+_SNIPPETS = (
+    "def {name}(items):\n    result = []\n    for item in items:\n        if item not in result:\n"
+    "            result.append(item)\n    return result\n",
+    "def {name}(user_id, cursor):\n    query = f\"SELECT * FROM users WHERE id = {{user_id}}\"\n"
+    "    cursor.execute(query)\n    return cursor.fetchall()\n",
+    "def {name}(values):\n    total = 0\n    for i in range(len(values)):\n        for j in range(len(values)):\n"
+    "            if i != j and values[i] == values[j]:\n                total += 1\n    return total\n",
+    "def {name}(path):\n    with open(path) as f:\n        return [line.strip() for line in f if line.strip()]\n",
+    "class {cls}:\n    def __init__(self, config):\n        self.config = config\n        self.password = \"admin123\"\n\n"
+    "    def load(self, data):\n        import pickle\n        return pickle.loads(data)\n",
+    "def {name}(expression):\n    return eval(expression)\n",
+)
+
+
+def synthetic_file(seed: int, lines: int) -> str:
+    """Deterministic Python module of about `lines` lines mixing clean and problematic code"""
+    generator = random.Random(seed)
+    parts = [f'"""Synthetic module {seed}"""\n']
+    count = 0
+    while sum(part.count("\n") for part in parts) < lines:
+        snippet = generator.choice(_SNIPPETS)
+        parts.append(snippet.format(name=f"function_{seed}_{count}", cls=f"Service{seed}_{count}"))
+        count += 1
+    return "\n\n".join(parts)
+
+
+def synthetic_pr(store: FixtureStore, owner: str, repo: str, number: int,
+                 files: int, lines_per_file: int, seed: int = 0) -> Dict[str, Any]:
+    """Add the GitHub responses of a generated PR to the store
+
+    The model calls of synthetic PRs have no fixtures and get stand-in
+    responses, so they measure the pipeline with the given injected latency.
+
+    Returns:
+        The PR's corpus entry
+    """
+    head_sha = hashlib.sha1(f"{owner}/{repo}#{number}:{seed}".encode()).hexdigest()
+    base = f"/repos/{owner}/{repo}"
+
+    def put(path: str, body: Any, query: Dict[str, Any] = None, content_type: str = "application/json"):
+        url = httpx.URL(f"https://api.github.com{path}", params=query or {})
+        store.http[http_key("GET", url)] = {
+            "path": path,
+            "status": 200,
+            "content_type": content_type,
+            "body": body if isinstance(body, str) else json.dumps(body),
+            "duration": None
+        }
+
+    listing = []
+    total_lines = 0
+    for index in range(files):
+        filename = f"src/module_{number}_{index}.py"
+        content = synthetic_file(seed * 1000 + number * 100 + index, lines_per_file)
+        line_count = content.count("\n") + 1
+        total_lines += line_count
+        patch = f"@@ -0,0 +1,{line_count} @@\n" + "\n".join("+" + line for line in content.split("\n"))
+        listing.append({
+            "filename": filename,
+            "status": "added",
+            "additions": line_count,
+            "deletions": 0,
+            "changes": line_count,
+            "patch": patch,
+            "sha": hashlib.sha1(content.encode()).hexdigest()
+        })
+        put(f"{base}/contents/{filename}", content, {"ref": head_sha}, "application/vnd.github.raw")
+
+    pr_data = {
+        "number": number,
+        "title": f"Synthetic PR {number}: {files} files",
+        "body": "Generated benchmark pull request",
+        "state": "open",
+        "user": {"login": "benchmark-author"},
+        "created_at": "2025-01-01T00:00:00Z",
+        "updated_at": "2025-01-01T00:00:00Z",
+        "base": {"ref": "main", "sha": "0" * 40},
+        "head": {"ref": f"synthetic-{number}", "sha": head_sha},
+        "mergeable": True,
+        "additions": total_lines,
+        "deletions": 0,
+        "changed_files": files
+    }
+    put(f"{base}/pulls/{number}", pr_data)
+    put(f"{base}/pulls/{number}/files", listing, {"per_page": PAGE_SIZE})
+    put("/user", {"login": "review-bot"})
+
+    return {"owner": owner, "repo": repo, "number": number, "files": files, "lines": total_lines}
@@ -0,0 +1,445 @@
+#!/usr/bin/env python3
+"""
+PR review benchmarks at several concurrency levels
+
+Replays a corpus of pull requests against recorded OpenAI and GitHub
+responses (see benchmarks/fixtures.py) with injected latency, and measures
+two scenarios per concurrency level:
+
+- review_pull_request: the orchestrator's PR review of files fetched up front
+- webhook: what process_pr_review does for an event (fetch the PR from
+  GitHub, review it, format and post the review), without the Modal hops
+
+All reviews of a level share one orchestrator, like a warm container. The
+results (throughput, latency percentiles, tokens and dollars per PR, stage
+timings) are written as JSON to compare between commits with
+benchmarks/compare.py, and can be recorded in a review history database
+(utils/review_history.py) whose trends benchmarks/trends.py shows.
+
+Usage:
+    # Synthetic corpus, no credentials needed
+    python -m benchmarks.run_benchmarks --output results.json
+
+    # Record fixtures of real PRs once (needs OPENAI_API_KEY and GITHUB_TOKEN) ...
+    python -m benchmarks.run_benchmarks --corpus my_corpus.json --record
+    # ... and replay them
+    python -m benchmarks.run_benchmarks --corpus my_corpus.json --strict --output results.json
+
+    # Keep every run for the trends of benchmarks/trends.py
+    python -m benchmarks.run_benchmarks --history benchmark_history
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import math
+import platform
+import subprocess
+import time
+from datetime import datetime, timezone
+from typing import Dict, List, Any, Optional, Callable, Awaitable
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from benchmarks.fixtures import (
+    FixtureStore, FixtureTransport, LatencyModel, llm_fixtures, fixture_client, synthetic_pr, REPLAY, RECORD
+)
+from orchestrator import SimpleMultiAgentOrchestrator
+from utils.cache_manager import CacheManager
+from utils.github_integration import GitHubIntegration, review_comments
+from utils.logger import api_tracker, perf_monitor
+from utils.review_history import ReviewHistory
+from utils.review_progress import ReviewProgress
+
+RESULTS_VERSION = 1
+
+SCENARIOS = ("review_pull_request", "webhook")
+
+DEFAULT_LEVELS = (1, 5, 10, 20)
+
+# Orchestrator settings of the deployed apps (modal_app/common.py defaults)
+DEFAULT_OPTIONS = {
+    "diff_scoped_review": True,
+    "incremental_review": True,
+    "structured_output": True,
+    "fused_review": False,
+    "model_routing": True,
+    "max_request_tokens": 20000,
+    "max_pr_tokens": 1000000
+}
+
+# Files process_pr_review reviews
+CODE_EXTENSIONS = {'.py', '.js', '.jsx', '.ts', '.tsx', '.java', '.cpp', '.c', '.go', '.rs', '.rb', '.php'}
+
+# (files, lines per file) of the synthetic PRs, cycled; from one-file fixes to large PRs
+SYNTHETIC_SIZES = ((1, 40), (2, 100), (4, 150), (1, 600), (8, 80), (3, 300))
+
+
+def percentile(values: List[float], q: float) -> Optional[float]:
+    """Nearest-rank percentile (exact, for the small samples of a benchmark)"""
+    if not values:
+        return None
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, max(0, math.ceil(q * len(ordered)) - 1))
+    return round(ordered[index], 4)
+
+
+def git_commit() -> Optional[str]:
+    """Commit of the working tree being benchmarked"""
+    try:
+        return subprocess.run(["git", "rev-parse", "HEAD"], capture_output=True, text=True,
+                              cwd=os.path.dirname(os.path.abspath(__file__)), check=True).stdout.strip()
+    except Exception:
+        return None
+
+
+def load_corpus(path: Optional[str], store_path: Optional[str], strict: bool,
+                synthetic_prs: int, seed: int) -> Dict[str, Any]:
+    """Corpus PRs and their fixture store
+
+    Args:
+        path: Corpus file ({"name", "fixtures", "prs": [{"owner", "repo", "number"}]},
+            where fixtures defaults to <corpus>.fixtures.json); None generates synthetic PRs
+        store_path: Fixture file overriding the corpus' own
+        strict: Fail on requests without fixtures
+        synthetic_prs: Number of synthetic PRs to generate
+        seed: Seed of the synthetic PRs
+    """
+    if path is None:
+        store = FixtureStore(store_path, strict=strict)
+        prs = [
+            synthetic_pr(store, "benchmark", "synthetic", number, files, lines, seed)
+            for number, (files, lines) in enumerate(
+                (SYNTHETIC_SIZES[i % len(SYNTHETIC_SIZES)] for i in range(synthetic_prs)), start=1
+            )
+        ]
+        return {"name": "synthetic", "prs": prs, "store": store}
+
+    with open(path) as f:
+        corpus = json.load(f)
+    if store_path:
+        fixtures = store_path
+    elif corpus.get("fixtures"):
+        fixtures = os.path.join(os.path.dirname(os.path.abspath(path)), corpus["fixtures"])
+    else:
+        fixtures = os.path.splitext(path)[0] + ".fixtures.json"
+    return {"name": corpus.get("name", os.path.basename(path)), "prs": corpus["prs"],
+            "store": FixtureStore(fixtures, strict=strict)}
+
+
+def reviewable_files(pr_files: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
+    """Code files of a PR in the shape process_pr_review passes to the orchestrator"""
+    return [
+        {
+            'filename': file['filename'],
+            'content': file['content'],
+            'language': file['language'],
+            'patch': file.get('patch', '')
+        }
+        for file in pr_files if os.path.splitext(file['filename'])[1] in CODE_EXTENSIONS
+    ]
+
+
+def agent_errors(result: Dict[str, Any]) -> List[str]:
+    """Errors of the agents in a PR review (file reviews still succeed without them)"""
+    errors = []
+    for review in result.get("file_reviews", []):
+        agent_results = review.get("orchestrator_results", {}).get("agent_results", {})
+        for agent, agent_result in agent_results.items():
+            if isinstance(agent_result, dict) and agent_result.get("status") == "error":
+                errors.append(f"{agent}: {agent_result.get('error')}")
+    return errors
+
+
+class BenchmarkRunner:
+    """Runs the scenarios of a corpus at the configured concurrency levels"""
+
+    def __init__(self,
+                 corpus: Dict[str, Any],
+                 mode: str = REPLAY,
+                 options: Optional[Dict[str, Any]] = None,
+                 llm_latency: Optional[LatencyModel] = None,
+                 github_latency: Optional[LatencyModel] = None,
+                 fetch_backend: str = "rest",
+                 repeats: int = 1):
+        """Initialize the runner
+
+        Args:
+            corpus: Corpus from load_corpus
+            mode: REPLAY, or RECORD to call the real services and save their responses
+            options: SimpleMultiAgentOrchestrator settings
+            llm_latency: Injected delay of model responses
+            github_latency: Injected delay of GitHub responses
+            fetch_backend: GitHubIntegration fetch backend (the fixtures hold its requests)
+            repeats: PRs per level are max(concurrency, corpus size) x repeats
+        """
+        self.corpus = corpus
+        self.store: FixtureStore = corpus["store"]
+        self.mode = mode
+        self.options = dict(DEFAULT_OPTIONS, **(options or {}))
+        self.llm_latency = llm_latency or LatencyModel()
+        self.github_latency = github_latency or LatencyModel()
+        self.fetch_backend = fetch_backend
+        self.repeats = max(1, repeats)
+        self.transport = FixtureTransport(self.store, mode, self.github_latency)
+        self.github_token = os.environ.get("GITHUB_TOKEN") if mode == RECORD else "replay"
+        self.api_key = os.environ.get("OPENAI_API_KEY") if mode == RECORD else "replay"
+
+    def _github(self) -> GitHubIntegration:
+        """GitHub client of one review (as process_pr_review creates one per event)"""
+        github = GitHubIntegration(github_token=self.github_token, fetch_backend=self.fetch_backend)
+        github._client = fixture_client(self.transport)
+        return github
+
+    def _orchestrator(self) -> SimpleMultiAgentOrchestrator:
+        # A fresh cache per level, so levels do not see each other's reviews
+        return SimpleMultiAgentOrchestrator(api_key=self.api_key, cache_manager=CacheManager(ttl=None), **self.options)
+
+    async def _fetch_files(self, pr: Dict[str, Any]) -> List[Dict[str, Any]]:
+        github = self._github()
+        try:
+            return reviewable_files(await github.get_pr_files(pr["owner"], pr["repo"], pr["number"]))
+        finally:
+            await github.aclose()
+
+    async def _webhook_review(self, orchestrator: SimpleMultiAgentOrchestrator, pr: Dict[str, Any],
+                              feedback: List[float]) -> Dict[str, Any]:
+        """Fetch, review and post one PR like process_pr_review
+
+        Appends the seconds until the progress comment was posted to feedback.
+        """
+        owner, repo, number = pr["owner"], pr["repo"], pr["number"]
+        github = self._github()
+        progress = ReviewProgress(github, owner, repo, number)
+        try:
+            pr_files = await github.get_pr_files(owner, repo, number)
+            pr_info = await github.get_pr_info(owner, repo, number)
+            result = await orchestrator.review_pull_request(pr_files=reviewable_files(pr_files),
+                                                            pr_description=pr_info.get("description") or "",
+                                                            progress=progress)
+            if result.get("markdown_report"):
+                body = github.format_review_comment(result["markdown_report"], pr_info)
+                comments = review_comments(result.get("file_reviews", []), pr_files, min_severity="medium")
+                await github.post_review_comment(owner, repo, number, body, "COMMENT", comments=comments)
+            return result
+        finally:
+            await progress.finish()
+            if progress.first_feedback_seconds is not None:
+                feedback.append(progress.first_feedback_seconds)
+            await github.aclose()
+
+    def _jobs(self, concurrency: int) -> List[Dict[str, Any]]:
+        prs = self.corpus["prs"]
+        return [prs[i % len(prs)] for i in range(max(concurrency, len(prs)) * self.repeats)] if prs else []
+
+    async def run_level(self, scenario: str, concurrency: int) -> Dict[str, Any]:
+        """Review the corpus with `concurrency` PRs in flight
+
+        Returns:
+            Result entry of the level
+        """
+        jobs = self._jobs(concurrency)
+        orchestrator = self._orchestrator()
+
+        feedback: List[float] = []
+        review: Callable[[Dict[str, Any]], Awaitable[Dict[str, Any]]]
+        if scenario == "webhook":
+            review = lambda pr: self._webhook_review(orchestrator, pr, feedback)
+        else:
+            # Files are fetched before timing: this scenario measures the review alone
+            files = {}
+            for pr in {(pr["owner"], pr["repo"], pr["number"]): pr for pr in jobs}.values():
+                files[(pr["owner"], pr["repo"], pr["number"])] = await self._fetch_files(pr)
+            review = lambda pr: orchestrator.review_pull_request(
+                pr_files=files[(pr["owner"], pr["repo"], pr["number"])], pr_description=""
+            )
+
+        api_tracker.reset()
+        perf_monitor.reset()
+        misses = dict(self.store.misses)
+        requests = self.transport.requests
+        semaphore = asyncio.Semaphore(concurrency)
+        latencies: List[float] = []
+        failures: List[str] = []
+        degraded: List[str] = []
+
+        async def run_job(pr: Dict[str, Any]):
+            async with semaphore:
+                start = time.perf_counter()
+                try:
+                    result = await review(pr)
+                    if result.get("status") == "error":
+                        failures.append(str(result.get("error")))
+                    degraded.extend(agent_errors(result))
+                except Exception as e:
+                    failures.append(f"{type(e).__name__}: {e}")
+                latencies.append(time.perf_counter() - start)
+
+        start = time.perf_counter()
+        await asyncio.gather(*(run_job(pr) for pr in jobs))
+        wall_seconds = time.perf_counter() - start
+
+        usage = api_tracker.get_summary()
+        count = max(1, len(jobs))
+        stages = {
+            name[:-len("_duration")]: {"count": stats["count"], "p50": round(stats["p50"], 4), "p99": round(stats["p99"], 4)}
+            for name, stats in sorted(perf_monitor.get_all_stats().items())
+            if name.endswith("_duration") and stats
+        }
+        return {
+            "scenario": scenario,
+            "concurrency": concurrency,
+            "prs": len(jobs),
+            "failed": len(failures),
+            "agent_errors": len(degraded),
+            "errors": sorted(set(failures + degraded))[:5],
+            "wall_seconds": round(wall_seconds, 4),
+            "throughput_prs_per_minute": round(len(jobs) / wall_seconds * 60, 3) if wall_seconds else None,
+            "latency_seconds": {
+                "p50": percentile(latencies, 0.5),
+                "p90": percentile(latencies, 0.9),
+                "p99": percentile(latencies, 0.99),
+                "max": round(max(latencies), 4) if latencies else None
+            },
+            # Until the progress comment with the static check findings is up (webhook only)
+            "first_feedback_seconds": {
+                "p50": percentile(feedback, 0.5),
+                "p99": percentile(feedback, 0.99)
+            } if feedback else None,
+            "model_calls_per_pr": round(usage["total_calls"] / count, 3),
+            "tokens_per_pr": {
+                "input": round(usage.get("total_input_tokens", 0) / count, 1),
+                "cached_input": round(usage.get("total_cached_input_tokens", 0) / count, 1),
+                "output": round(usage.get("total_output_tokens", 0) / count, 1)
+            },
+            "cost_per_pr_usd": round(usage["total_cost"] / count, 6),
+            "github_requests_per_pr": round((self.transport.requests - requests) / count, 2),
+            "fixture_misses": {kind: self.store.misses[kind] - misses[kind] for kind in misses},
+            "stages": stages
+        }
+
+    async def run(self, scenarios: List[str], levels: List[int]) -> List[Dict[str, Any]]:
+        results = []
+        with llm_fixtures(self.store, self.mode, self.llm_latency):
+            for scenario in scenarios:
+                for concurrency in levels:
+                    result = await self.run_level(scenario, concurrency)
+                    print(f"{scenario} x{concurrency}: {result['prs']} PRs, "
+                          f"{result['throughput_prs_per_minute']} PRs/min, "
+                          f"p50 {result['latency_seconds']['p50']}s, p99 {result['latency_seconds']['p99']}s, "
+                          f"${result['cost_per_pr_usd']}/PR", file=sys.stderr)
+                    results.append(result)
+        await self.transport.shutdown()
+        return results
+
+    async def record(self):
+        """Review each corpus PR once through the webhook path against the real services"""
+        with llm_fixtures(self.store, RECORD):
+            orchestrator = self._orchestrator()
+            for pr in self.corpus["prs"]:
+                print(f"Recording {pr['owner']}/{pr['repo']}#{pr['number']}", file=sys.stderr)
+                await self._webhook_review(orchestrator, pr)
+        await self.transport.shutdown()
+        self.store.save()
+
+
+def parse_options(values: List[str]) -> Dict[str, Any]:
+    """key=value orchestrator settings (values are JSON, e.g. fused_review=true)"""
+    options = {}
+    for value in values:
+        key, _, raw = value.partition("=")
+        try:
+            options[key] = json.loads(raw)
+        except json.JSONDecodeError:
+            options[key] = raw
+    return options
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="PR review load and latency benchmarks")
+    parser.add_argument("--corpus", help="Corpus file of recorded PRs (default: synthetic PRs)")
+    parser.add_argument("--fixtures", help="Fixture file (default: the corpus' own)")
+    parser.add_argument("--record", action="store_true", help="Record fixtures from the real services")
+    parser.add_argument("--strict", action="store_true", help="Fail on requests without fixtures")
+    parser.add_argument("--scenario", choices=SCENARIOS + ("all",), default="all")
+    parser.add_argument("--levels", default=",".join(str(level) for level in DEFAULT_LEVELS),
+                        help="Comma-separated concurrency levels")
+    parser.add_argument("--repeats", type=int, default=1)
+    parser.add_argument("--synthetic-prs", type=int, default=20,
+                        help="Synthetic PRs to generate (each job of a level is a distinct PR up to this many)")
+    parser.add_argument("--llm-latency", type=float, help="Fixed model latency in seconds (default: recorded)")
+    parser.add_argument("--llm-default-latency", type=float, default=1.5,
+                        help="Model latency of responses without a recorded duration")
+    parser.add_argument("--github-latency", type=float, help="Fixed GitHub latency in seconds (default: recorded)")
+    parser.add_argument("--github-default-latency", type=float, default=0.05)
+    parser.add_argument("--jitter", type=float, default=0.0, help="Relative latency jitter, e.g. 0.2")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--fetch-backend", default="rest", choices=("rest", "graphql", "git", "auto"))
+    parser.add_argument("--option", action="append", default=[], metavar="KEY=VALUE",
+                        help="Orchestrator setting, e.g. --option fused_review=true")
+    parser.add_argument("--output", help="Write the JSON results here (default: stdout)")
+    parser.add_argument("--history", metavar="DIR", help="Also record the results in this review history")
+    args = parser.parse_args(argv)
+
+    corpus = load_corpus(args.corpus, args.fixtures, args.strict, args.synthetic_prs, args.seed)
+    options = parse_options(args.option)
+    runner = BenchmarkRunner(
+        corpus,
+        mode=RECORD if args.record else REPLAY,
+        options=options,
+        llm_latency=LatencyModel(args.llm_latency, args.llm_default_latency, args.jitter, args.seed),
+        github_latency=LatencyModel(args.github_latency, args.github_default_latency, args.jitter, args.seed + 1),
+        fetch_backend=args.fetch_backend,
+        repeats=args.repeats
+    )
+
+    if args.record:
+        if args.corpus is None:
+            parser.error("--record needs a --corpus of real PRs")
+        asyncio.run(runner.record())
+        print(f"Recorded {len(runner.store.llm)} model and {len(runner.store.http)} GitHub responses "
+              f"to {runner.store.path}", file=sys.stderr)
+        return 0
+
+    scenarios = list(SCENARIOS) if args.scenario == "all" else [args.scenario]
+    levels = [int(level) for level in args.levels.split(",") if level.strip()]
+    results = asyncio.run(runner.run(scenarios, levels))
+
+    report = {
+        "version": RESULTS_VERSION,
+        "git_commit": git_commit(),
+        "timestamp": datetime.now(timezone.utc).isoformat(),
+        "python": platform.python_version(),
+        "config": {
+            "corpus": corpus["name"],
+            "corpus_prs": len(corpus["prs"]),
+            "scenarios": scenarios,
+            "levels": levels,
+            "repeats": args.repeats,
+            "llm_latency": args.llm_latency,
+            "llm_default_latency": args.llm_default_latency,
+            "github_latency": args.github_latency,
+            "github_default_latency": args.github_default_latency,
+            "jitter": args.jitter,
+            "seed": args.seed,
+            "fetch_backend": args.fetch_backend,
+            "options": runner.options
+        },
+        "results": results
+    }
+    text = json.dumps(report, indent=2)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text + "\n")
+    else:
+        print(text)
+    if args.history:
+        history = ReviewHistory(args.history)
+        history.record_benchmark(report)
+        history.compact()
+    return 1 if any(result["failed"] or result["agent_errors"] for result in results) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""
+Latency and cost trends from a review history (utils/review_history.py)
+
+Shows the benchmark runs recorded with `run_benchmarks --history DIR` per
+scenario and concurrency level, oldest first, with the change of each metric
+against the previous run. With --reviews it shows the daily trends of the
+production reviews instead (e.g. of a copy of the Volume's /history
+directory, `modal volume get code-review-cache /history ./history`).
+
+Usage:
+    python -m benchmarks.trends benchmark_history --scenario webhook --last 10
+    python -m benchmarks.trends ./history --reviews --repo owner/name --days 30
+"""
+
+import argparse
+import os
+import sys
+from typing import Dict, List, Any, Optional
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from benchmarks.compare import METRICS, _value
+from utils.review_history import ReviewHistory
+
+REVIEW_COLUMNS = (
+    ("day", "day"),
+    ("reviews", "reviews"),
+    ("files", "files"),
+    ("reused", "reuse_rate"),
+    ("p50 s", "duration_p50"),
+    ("p90 s", "duration_p90"),
+    ("input tok", "input_tokens"),
+    ("output tok", "output_tokens"),
+    ("cost $", "cost"),
+    ("$/review", "cost_per_review")
+)
+
+
+def benchmark_lines(entries: List[Dict[str, Any]]) -> List[str]:
+    """One block per level: each run's metrics and their change since the previous run"""
+    lines = []
+    previous: Optional[Dict[str, Any]] = None
+    level = None
+    for entry in entries:
+        result = entry["result"]
+        if (result["scenario"], result["concurrency"]) != level:
+            level = (result["scenario"], result["concurrency"])
+            previous = None
+            lines.append(f"{level[0]} x{level[1]}")
+        lines.append(f"  {(entry['git_commit'] or '?')[:12]} ({entry['corpus']})")
+        for label, path, _ in METRICS:
+            value = _value(result, path)
+            if value is None:
+                continue
+            before = _value(previous, path) if previous is not None else None
+            change = f" {(value - before) / before * 100:+.1f}%" if before else ""
+            lines.append(f"    {label:<20} {value:>12}{change}")
+        previous = result
+    return lines
+
+
+def review_lines(trends: List[Dict[str, Any]]) -> List[str]:
+    """Table of the daily review trends"""
+    lines = ["  ".join(f"{label:>10}" for label, _ in REVIEW_COLUMNS)]
+    for day in trends:
+        lines.append("  ".join(f"{str(day[key]):>10}" for _, key in REVIEW_COLUMNS))
+    return lines
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Latency and cost trends from a review history")
+    parser.add_argument("history", help="Review history directory")
+    parser.add_argument("--reviews", action="store_true", help="Show the recorded PR reviews, not benchmarks")
+    parser.add_argument("--scenario")
+    parser.add_argument("--concurrency", type=int)
+    parser.add_argument("--corpus")
+    parser.add_argument("--last", type=int, default=20, help="Runs shown per level")
+    parser.add_argument("--repo", help="Only reviews of this repository (owner/name)")
+    parser.add_argument("--days", type=int, default=30, help="Days of reviews shown")
+    args = parser.parse_args(argv)
+
+    history = ReviewHistory(args.history)
+    if args.reviews:
+        trends = history.review_trends(repo=args.repo, days=args.days)
+        if not trends:
+            print("No reviews recorded in this period", file=sys.stderr)
+            return 1
+        print("\n".join(review_lines(trends)))
+        return 0
+
+    entries = history.benchmark_trends(args.scenario, args.concurrency, args.corpus, limit=args.last)
+    if not entries:
+        print("No benchmark runs recorded", file=sys.stderr)
+        return 1
+    print("\n".join(benchmark_lines(entries)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
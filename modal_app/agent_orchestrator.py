@@ -4,170 +4,169 @@ This file packages all agents and utilities for Modal deployment
 """
 
 import modal
-import os
+import asyncio
 from typing import Dict, List, Any
 import time
 import logging
 
+from common import (
+    image, volume, openai_secret, tracing_secrets, orchestrator_options, openai_api_key, review_history_options,
+    WORKER_MIN_CONTAINERS, MEMORY_SNAPSHOT, DIFF_SCOPED_REVIEW, INCREMENTAL_REVIEW
+)
+
 # Create Modal app
 app = modal.App("multi-agent-orchestrator")
 
-# Define the image with dependencies
-image = (
-    modal.Image.debian_slim(python_version="3.11")
-    .pip_install(
-        "autogen-agentchat==0.7.1",
-        "autogen-ext[openai]==0.7.1", 
-        "openai>=1.93",
-        "python-dotenv"
-    )
-)
-
-# Mount local code
-code_mount = modal.Mount.from_local_dir(
-    "../",  # Mount parent directory to get all code
-    remote_path="/app",
-    condition=lambda pth: not any(
-        part.startswith('.') or part == '__pycache__' or part == 'venv'
-        for part in pth.parts
-    )
-)
+# Imported once per container (and kept in its memory snapshot), not per request
+with image.imports():
+    from orchestrator import get_orchestrator
+    from agents.performance_analyzer import PerformanceAnalyzerAgent
+    from utils.cache_manager import get_cache_manager
+    from utils.tracing import configure_tracing, flush_tracing, start_span
+    from utils.metrics_export import MetricsStore
 
 
-@app.function(
+@app.cls(
     image=image,
-    secret=modal.Secret.from_name("openai-secret"),
-    mounts=[code_mount],
+    secrets=[openai_secret] + tracing_secrets,
     timeout=600,
     memory=2048,
     cpu=1.0,
-    volumes={"/cache": modal.Volume.from_name("code-review-cache", create_if_missing=True)}
+    volumes={"/cache": volume},
+    min_containers=WORKER_MIN_CONTAINERS,
+    enable_memory_snapshot=MEMORY_SNAPSHOT
 )
-async def review_code(
-    code: str,
-    filename: str = "unknown",
-    pr_description: str = "",
-    context: Dict[str, Any] = None
-) -> Dict[str, Any]:
-    """Review code using the multi-agent orchestrator
-    
-    This is a Modal function that can be called remotely
-    """
-    import sys
-    sys.path.append("/app")
-    
-    from orchestrator import SimpleMultiAgentOrchestrator
-    from utils.cache_manager import get_cache_manager
-    
-    # Set up logging
-    logging.basicConfig(level=logging.INFO)
-    logger = logging.getLogger(__name__)
-    
-    start_time = time.time()
-    
-    # Initialize cache
-    cache_manager = get_cache_manager(use_modal=True)
-    
-    # Check cache first
-    cache_key_context = {"filename": filename, "pr_description": pr_description}
-    cached_result = await cache_manager.get_async(code, "full_review", cache_key_context)
-    
-    if cached_result:
-        logger.info(f"Cache hit for file: {filename}")
-        cached_result["from_cache"] = True
-        cached_result["processing_time"] = time.time() - start_time
-        return cached_result
-    
-    logger.info(f"Cache miss for file: {filename}, performing review")
-    
-    # Initialize orchestrator
-    openai_key = os.environ.get("OPENAI_API_KEY")
-    orchestrator = SimpleMultiAgentOrchestrator(api_key=openai_key)
-    
-    # Perform review
-    result = await orchestrator.review_code(
-        code=code,
-        filename=filename,
-        pr_description=pr_description,
-        context=context
-    )
-    
-    # Cache the result
-    if result.get("status") == "success":
-        await cache_manager.set_async(code, "full_review", result, cache_key_context)
-        logger.info(f"Cached review result for: {filename}")
-    
-    # Add performance metrics
-    result["processing_time"] = time.time() - start_time
-    result["cache_stats"] = cache_manager.get_stats()
-    
-    return result
+class FileReviewService:
+    """Per-file reviews; agents and model clients are set up once per container"""
+    
+    @modal.enter()
+    def setup(self):
+        """Build the pooled orchestrator when the container starts"""
+        # Agent responses are cached per code unit in the shared Modal Dict, so
+        # files a re-push did not touch are answered without API calls; unit
+        # findings evicted from it are looked up in the review history
+        self.cache_manager = get_cache_manager(use_modal=True)
+        self.orchestrator = get_orchestrator(**orchestrator_options(
+            diff_scoped_review=DIFF_SCOPED_REVIEW,
+            incremental_review=INCREMENTAL_REVIEW,
+            cache_manager=self.cache_manager,
+            **review_history_options()
+        ))
+        configure_tracing("code-review-file-worker")
+        self.metrics_store = MetricsStore()
+    
+    @modal.exit()
+    def shutdown(self):
+        """Export the spans still buffered when the container stops"""
+        flush_tracing()
+    
+    @modal.method()
+    async def review_code(
+        self,
+        code: str,
+        filename: str = "unknown",
+        pr_description: str = "",
+        context: Dict[str, Any] = None,
+        trace_context: Dict[str, str] = None
+    ) -> Dict[str, Any]:
+        """Review code using the multi-agent orchestrator
+        
+        This is a Modal method that can be called remotely; trace_context
+        continues the caller's trace (see utils.tracing)
+        """
+        # Set up logging
+        logging.basicConfig(level=logging.INFO)
+        logger = logging.getLogger(__name__)
+        
+        start_time = time.time()
+        
+        # Perform review
+        with start_span("review_file", parent=trace_context, filename=filename):
+            result = await self.orchestrator.review_code(
+                code=code,
+                filename=filename,
+                pr_description=pr_description,
+                context=context
+            )
+        
+        logger.info(f"Reviewed {filename}, cached agents: {result.get('cached_agents', [])}")
+        
+        # Cache writes are buffered; make sure they land before the container goes idle
+        await self.cache_manager.flush()
+        if self.orchestrator.history is not None:
+            await asyncio.to_thread(self.orchestrator.history.sync)
+        await self.metrics_store.publish()
+        
+        # Add performance metrics
+        result["processing_time"] = time.time() - start_time
+        result["cache_stats"] = self.cache_manager.get_stats()
+        
+        return result
 
 
-@app.function(
+@app.cls(
     image=image,
-    secret=modal.Secret.from_name("openai-secret"),
-    mounts=[code_mount],
+    secrets=[openai_secret],
     timeout=900,
     memory=4096,
     cpu=2.0,
-    retries=1
+    retries=1,
+    enable_memory_snapshot=MEMORY_SNAPSHOT
 )
-async def review_pull_request(
-    pr_files: List[Dict[str, str]],
-    pr_description: str = ""
-) -> Dict[str, Any]:
-    """Review an entire pull request
-    
-    This function handles multiple files with higher resource allocation
-    """
-    import sys
-    sys.path.append("/app")
-    
-    from orchestrator import SimpleMultiAgentOrchestrator
-    
-    # Initialize orchestrator
-    openai_key = os.environ.get("OPENAI_API_KEY")
-    orchestrator = SimpleMultiAgentOrchestrator(api_key=openai_key)
-    
-    # Perform PR review
-    result = await orchestrator.review_pull_request(
-        pr_files=pr_files,
-        pr_description=pr_description
-    )
+class PullRequestReviewService:
+    """Whole-PR reviews with higher resource allocation"""
+    
+    @modal.enter()
+    def setup(self):
+        """Build the pooled orchestrator when the container starts"""
+        self.orchestrator = get_orchestrator(**orchestrator_options(
+            cache_manager=get_cache_manager(use_modal=True)
+        ))
     
-    return result
+    @modal.method()
+    async def review_pull_request(
+        self,
+        pr_files: List[Dict[str, str]],
+        pr_description: str = ""
+    ) -> Dict[str, Any]:
+        """Review an entire pull request
+        
+        This method handles multiple files with higher resource allocation
+        """
+        return await self.orchestrator.review_pull_request(
+            pr_files=pr_files,
+            pr_description=pr_description
+        )
 
 
-@app.function(
+@app.cls(
     image=image,
-    secret=modal.Secret.from_name("openai-secret"),
-    mounts=[code_mount],
+    secrets=[openai_secret],
     gpu="T4",  # Add GPU for performance-intensive analysis
     timeout=300,
     memory=8192
 )
-async def analyze_performance(code: str, context: Dict[str, Any] = None) -> Dict[str, Any]:
+class PerformanceService:
     """Specialized performance analysis with GPU support
     
     This demonstrates GPU allocation for compute-intensive tasks
     """
-    import sys
-    sys.path.append("/app")
-    
-    from agents.performance_analyzer import PerformanceAnalyzerAgent
-    
-    # Initialize agent
-    openai_key = os.environ.get("OPENAI_API_KEY")
-    agent = PerformanceAnalyzerAgent(api_key=openai_key)
-    
-    # Perform analysis
-    result = await agent.analyze_code(code=code, context=context)
     
-    # Additional GPU-accelerated analysis could go here
-    # For example: AST parsing, complexity calculations, etc.
+    @modal.enter()
+    def setup(self):
+        """Create the agent (and its pooled model client) once per container"""
+        self.agent = PerformanceAnalyzerAgent(api_key=openai_api_key())
     
-    return result
+    @modal.method()
+    async def analyze_performance(self, code: str, context: Dict[str, Any] = None) -> Dict[str, Any]:
+        """Analyze the performance of code"""
+        # Perform analysis
+        result = await self.agent.analyze_code(code=code, context=context)
+        
+        # Additional GPU-accelerated analysis could go here
+        # For example: AST parsing, complexity calculations, etc.
+        
+        return result
 
 
 @app.local_entrypoint()
@@ -198,7 +197,7 @@ def process_data(user_id):
     
     # Test single file review
     with app.run():
-        result = asyncio.run(review_code.remote(
+        result = asyncio.run(FileReviewService().review_code.remote.aio(
             code=test_code,
             filename="test.py",
             pr_description="Test review on Modal"
@@ -0,0 +1,127 @@
+"""
+Shared Modal configuration of the webhook and orchestrator apps
+
+Both apps run on one image with the dependencies installed and the project
+baked in, so containers start without uploading code, and import the heavy
+modules (autogen, openai) once per container via image.imports() rather than
+in the request path. Functions opt into memory snapshots, which restore the
+imported modules instead of importing them again on a cold start.
+"""
+
+import modal
+import os
+from pathlib import Path
+from typing import Dict, Any
+
+project_root = Path(__file__).parent.parent  # Go up to project root
+
+# Project location in the container; modal_app is on the path as well so
+# the apps can import this module when deployed as scripts
+REMOTE_PROJECT_DIR = "/project"
+
+
+def should_ignore(path):
+    """Ignore unnecessary files and folders"""
+    path_str = str(path)
+    ignore_patterns = ['venv', '__pycache__', '.git', '.pytest_cache', '*.pyc', '.env']
+    return any(pattern in path_str for pattern in ignore_patterns)
+
+
+# Define the image with all dependencies
+image = (
+    modal.Image.debian_slim(python_version="3.11")
+    .pip_install(
+        "autogen-agentchat==0.7.1",
+        "autogen-ext[openai]==0.7.1",
+        "openai>=1.93",
+        "httpx[http2]",
+        "tiktoken",
+        "tree-sitter-language-pack",
+        "fastapi[standard]",
+        "python-dotenv",
+        "cryptography",
+        "opentelemetry-sdk",
+        "opentelemetry-exporter-otlp-proto-http"
+    )
+    .env({"PYTHONPATH": f"{REMOTE_PROJECT_DIR}:{REMOTE_PROJECT_DIR}/modal_app"})
+    # copy=True bakes the project into an image layer instead of adding it at container start
+    .add_local_dir(project_root, remote_path=REMOTE_PROJECT_DIR, ignore=should_ignore, copy=True)
+)
+
+# Create volume for caching
+volume = modal.Volume.from_name("code-review-cache", create_if_missing=True)
+
+# Import secrets
+openai_secret = modal.Secret.from_name("openaisecret")
+github_secret = modal.Secret.from_name("githubsecret")
+
+# Optional secret with the OTLP exporter settings (OTEL_EXPORTER_OTLP_ENDPOINT,
+# OTEL_EXPORTER_OTLP_HEADERS); spans are exported only when it is configured
+OTEL_SECRET = os.environ.get("OTEL_SECRET", "")
+tracing_secrets = [modal.Secret.from_name(OTEL_SECRET)] if OTEL_SECRET else []
+
+# Warm containers kept running for the webhook, the PR review function and the
+# per-file review workers; each one costs idle compute (a PR review container
+# has 4 GB and 2 CPUs) but removes the cold start of the first review
+WEBHOOK_MIN_CONTAINERS = int(os.environ.get("WEBHOOK_MIN_CONTAINERS", "1"))
+PR_REVIEW_MIN_CONTAINERS = int(os.environ.get("PR_REVIEW_MIN_CONTAINERS", "0"))
+WORKER_MIN_CONTAINERS = int(os.environ.get("WORKER_MIN_CONTAINERS", "0"))
+
+# Restore containers from a memory snapshot taken after the imports
+MEMORY_SNAPSHOT = os.environ.get("MEMORY_SNAPSHOT", "true").lower() == "true"
+
+# Send only the changed hunks (plus enclosing function/class) to the agents
+DIFF_SCOPED_REVIEW = os.environ.get("DIFF_SCOPED_REVIEW", "true").lower() == "true"
+
+# Re-review only the Python functions/classes that changed since their last
+# review, reusing cached findings for the rest (takes precedence over diff scoping)
+INCREMENTAL_REVIEW = os.environ.get("INCREMENTAL_REVIEW", "true").lower() == "true"
+
+# Agents answer with JSON findings (structured outputs) instead of free text
+STRUCTURED_OUTPUT = os.environ.get("STRUCTURED_OUTPUT", "true").lower() == "true"
+
+# Review small files with one model call covering all three agents' roles
+FUSED_REVIEW = os.environ.get("FUSED_REVIEW", "false").lower() == "true"
+
+# Triage each file with gpt-4o-mini and local signals; only files that need a
+# deep review go to gpt-4o, simple ones get a gpt-4o-mini review, trivial ones none
+MODEL_ROUTING = os.environ.get("MODEL_ROUTING", "true").lower() == "true"
+
+# Token budgets: code per model request (larger inputs are reviewed in chunks)
+# and input tokens per PR (files beyond it are skipped and listed in the report)
+MAX_REQUEST_TOKENS = int(os.environ.get("MAX_REQUEST_TOKENS", "20000"))
+MAX_PR_TOKENS = int(os.environ.get("MAX_PR_TOKENS", "1000000"))
+
+# Keep every review in a SQLite history on the Volume: PR files reviewed before
+# with the same content are taken from it, and unit findings outlive the cache.
+# A scheduled function merges the containers' segments and drops old entries
+REVIEW_HISTORY = os.environ.get("REVIEW_HISTORY", "true").lower() == "true"
+HISTORY_DIR = "/cache/history"
+HISTORY_RETENTION_DAYS = float(os.environ.get("HISTORY_RETENTION_DAYS", "90"))
+
+
+def openai_api_key() -> str:
+    """OpenAI API key from the secret (Modal may expose it under the secret's name)"""
+    return os.environ.get("OPENAI_API_KEY") or os.environ.get("openaisecret") or os.environ.get("OPENAISECRET")
+
+
+def orchestrator_options(**overrides) -> Dict[str, Any]:
+    """Orchestrator settings of the apps (from the environment)"""
+    options = {
+        "api_key": openai_api_key(),
+        "structured_output": STRUCTURED_OUTPUT,
+        "fused_review": FUSED_REVIEW,
+        "model_routing": MODEL_ROUTING,
+        "max_request_tokens": MAX_REQUEST_TOKENS,
+        "max_pr_tokens": MAX_PR_TOKENS
+    }
+    options.update(overrides)
+    return options
+
+
+def review_history_options() -> Dict[str, Any]:
+    """Orchestrator option with the Volume's review history (none when disabled)"""
+    if not REVIEW_HISTORY:
+        return {}
+    from utils.review_history import get_review_history
+    return {"history": get_review_history(HISTORY_DIR, commit=volume.commit, reload=volume.reload)}
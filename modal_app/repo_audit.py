@@ -0,0 +1,133 @@
+"""
+Modal deployment of whole-repository audits through the OpenAI Batch API
+
+Audits run in steps: the first step lists the snapshot and submits the
+batches, and a scheduled function advances every unfinished audit until its
+report is written. State and results are kept on the cache Volume under
+/cache/audits/<audit_id>; the batch answers are loaded into a Modal Dict of
+the audit's own (never expiring, so kept apart from the PR review cache),
+which is deleted once the report is written.
+"""
+
+import modal
+import json
+import os
+import time
+from typing import Dict, Any, Optional
+
+from common import image, volume, openai_secret, tracing_secrets, orchestrator_options, INCREMENTAL_REVIEW
+
+# Create Modal app
+app = modal.App("code-review-audit")
+
+# Imported once per container, not per request
+with image.imports():
+    from orchestrator import SimpleMultiAgentOrchestrator
+    from utils.batch_audit import BatchAudit, DONE_PHASE, FAILED_PHASE, STATE_FILE
+    from utils.cache_manager import ModalCacheManager
+
+# Audit directories on the Volume; snapshots are uploaded next to them, e.g.
+# `modal volume put code-review-cache ./my-repo /snapshots/my-repo`
+AUDIT_ROOT = "/cache/audits"
+SNAPSHOT_ROOT = "/cache/snapshots"
+
+# Files planned and reviewed together, and the unit of resumption
+AUDIT_GROUP_SIZE = int(os.environ.get("AUDIT_GROUP_SIZE", "50"))
+
+# Orchestrator of the audit last advanced in this container, as (audit_id, orchestrator)
+_orchestrator = None
+
+
+def audit_cache_name(audit_id: str) -> str:
+    """Name of the Modal Dict holding an audit's cache"""
+    return f"code-review-audit-{audit_id}"
+
+
+def audit_orchestrator(audit_id: str) -> "SimpleMultiAgentOrchestrator":
+    """Orchestrator of an audit: no triage routing, no PR token budget, and
+    a cache of its own that keeps entries for the whole audit (batches take
+    up to a day)"""
+    global _orchestrator
+    if _orchestrator is None or _orchestrator[0] != audit_id:
+        _orchestrator = (audit_id, SimpleMultiAgentOrchestrator(**orchestrator_options(
+            incremental_review=INCREMENTAL_REVIEW,
+            model_routing=False,
+            max_pr_tokens=None,
+            cache_manager=ModalCacheManager(cache_name=audit_cache_name(audit_id), ttl=None)
+        )))
+    return _orchestrator[1]
+
+
+def open_audit(audit_id: str) -> "BatchAudit":
+    return BatchAudit(
+        audit_orchestrator(audit_id),
+        os.path.join(AUDIT_ROOT, audit_id),
+        description=f"Repository audit {audit_id}",
+        group_size=AUDIT_GROUP_SIZE,
+        commit=volume.commit
+    )
+
+
+@app.function(
+    image=image,
+    secrets=[openai_secret] + tracing_secrets,
+    volumes={"/cache": volume},
+    timeout=3600,
+    memory=4096,
+    cpu=2.0,
+    max_containers=1  # steps of an audit never run concurrently
+)
+async def advance_audit(audit_id: str, snapshot: Optional[str] = None) -> Dict[str, Any]:
+    """Run one step of an audit (starting it if it is new)
+
+    Args:
+        audit_id: Name of the audit directory
+        snapshot: Snapshot directory under /cache/snapshots (first step only)
+
+    Returns:
+        The audit state
+    """
+    volume.reload()
+    audit = open_audit(audit_id)
+    state = await audit.step(os.path.join(SNAPSHOT_ROOT, snapshot) if snapshot else None)
+    if state["phase"] in (DONE_PHASE, FAILED_PHASE):
+        # The audit's cache entries never expire; drop them with the audit
+        await audit.orchestrator.cache_manager.flush()
+        await modal.Dict.delete.aio(audit_cache_name(audit_id))
+    print(f"Audit {audit_id}: {state['phase']} ({state['prepared_files']}/{state['files']} files prepared, "
+          f"{state['requests']} requests, {state['reported_files']} files reported)")
+    return state
+
+
+@app.function(
+    image=image,
+    volumes={"/cache": volume},
+    timeout=300,
+    schedule=modal.Period(minutes=10)  # picks up finished batches and interrupted steps
+)
+async def advance_audits():
+    """Advance every unfinished audit on the Volume"""
+    volume.reload()
+    if not os.path.isdir(AUDIT_ROOT):
+        return
+    for audit_id in sorted(os.listdir(AUDIT_ROOT)):
+        state_path = os.path.join(AUDIT_ROOT, audit_id, STATE_FILE)
+        if not os.path.exists(state_path):
+            continue
+        with open(state_path) as f:
+            phase = json.load(f).get("phase")
+        if phase not in (DONE_PHASE, FAILED_PHASE):
+            await advance_audit.spawn.aio(audit_id)
+
+
+@app.local_entrypoint()
+def audit(snapshot: str, audit_id: str = ""):
+    """Start an audit of a snapshot uploaded to the Volume
+
+    modal run modal_app/repo_audit.py --snapshot my-repo
+    """
+    audit_id = audit_id or f"{snapshot}-{time.strftime('%Y%m%d-%H%M%S')}"
+    state = advance_audit.remote(audit_id, snapshot)
+    print(f"Audit {audit_id} is in phase '{state['phase']}'. The report is written to "
+          f"{AUDIT_ROOT}/{audit_id}/report.md once the batches finish "
+          f"(`modal volume get code-review-cache /audits/{audit_id}/report.md`).")
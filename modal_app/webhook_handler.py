@@ -5,46 +5,70 @@ Modal deployment of the GitHub webhook handler
 import modal
 import os
 import json
+import asyncio
 import hmac
 import hashlib
 from datetime import datetime
 
+from common import (
+    image, volume, openai_secret, github_secret, tracing_secrets, orchestrator_options, review_history_options,
+    WEBHOOK_MIN_CONTAINERS, PR_REVIEW_MIN_CONTAINERS, MEMORY_SNAPSHOT, DIFF_SCOPED_REVIEW, INCREMENTAL_REVIEW,
+    REVIEW_HISTORY, HISTORY_DIR, HISTORY_RETENTION_DAYS
+)
+
 # Create Modal app
 app = modal.App("multi-agent-code-review")
 
-# Define the image with all dependencies
-from pathlib import Path
-
-project_root = Path(__file__).parent.parent  # Go up to project root
-
-def should_ignore(path):
-    """Ignore unnecessary files and folders"""
-    path_str = str(path)
-    ignore_patterns = ['venv', '__pycache__', '.git', '.pytest_cache', '*.pyc', '.env']
-    return any(pattern in path_str for pattern in ignore_patterns)
-
-image = (
-    modal.Image.debian_slim(python_version="3.11")
-    .pip_install(
-        "autogen-agentchat==0.7.1",
-        "autogen-ext[openai]==0.7.1",
-        "openai>=1.93",
-        "httpx",
-        "fastapi[standard]",
-        "python-dotenv",
-        "cryptography"
+# Imported once per container (and kept in its memory snapshot), not per request
+with image.imports():
+    from orchestrator import get_orchestrator
+    from utils.github_integration import GitHubIntegration, review_comments
+    from utils.cache_manager import get_cache_manager
+    from utils.analysis_context import AnalysisContext
+    from utils.review_progress import ReviewProgress, ast_findings, bandit_findings
+    from utils.job_registry import PRJobRegistry, job_key, floor_review_event
+    from utils.review_queue import (
+        ReviewQueue, ReviewDispatcher, classify_priority, make_job, DISPATCHER_NAME
     )
-    .add_local_dir(project_root, remote_path="/project", ignore=should_ignore)
-)
-
-# Create volume for caching (optional)
-volume = modal.Volume.from_name("code-review-cache", create_if_missing=True)
+    from utils.logger import perf_monitor, api_tracker
+    from utils.tracing import configure_tracing, flush_tracing, start_span, inject_context
+    from utils.metrics_export import MetricsStore, render_prometheus, merge_api_totals, metrics_source
+    from utils.review_history import ReviewHistory
 
 # Import secrets
-secrets = [
-    modal.Secret.from_name("openaisecret"),
-    modal.Secret.from_name("githubsecret")
-]
+secrets = [openai_secret, github_secret] + tracing_secrets
+
+# Distributed PR mode: fan files out to the FileReviewService.review_code method of the
+# orchestrator app (one container per file) instead of reviewing them all here
+DISTRIBUTED_REVIEW = os.environ.get("DISTRIBUTED_PR_REVIEW", "true").lower() == "true"
+DISTRIBUTED_MIN_FILES = int(os.environ.get("DISTRIBUTED_MIN_FILES", "3"))
+ORCHESTRATOR_APP_NAME = os.environ.get("ORCHESTRATOR_APP_NAME", "multi-agent-orchestrator")
+
+# How PR file contents are fetched: "rest", "graphql", "git" or "auto"
+GITHUB_FETCH_BACKEND = os.environ.get("GITHUB_FETCH_BACKEND", "auto")
+
+# Pushes to a PR within this many seconds are reviewed once, at the last head
+PR_DEBOUNCE_SECONDS = float(os.environ.get("PR_DEBOUNCE_SECONDS", "30"))
+
+# On synchronize events, review only the files changed since the last reviewed head
+DELTA_REVIEW = os.environ.get("DELTA_REVIEW", "true").lower() == "true"
+
+# Queue webhook events and let one dispatcher start reviews by priority lane,
+# round-robin across repositories, with at most MAX_CONCURRENT_REVIEWS running.
+# Each review makes up to 3 x 4 concurrent model calls; size the cap to the OpenAI quota
+REVIEW_QUEUE = os.environ.get("REVIEW_QUEUE", "true").lower() == "true"
+MAX_CONCURRENT_REVIEWS = int(os.environ.get("MAX_CONCURRENT_REVIEWS", "8"))
+
+# Post findings as inline comments on their diff lines, submitted in one review
+# together with the summary (findings below the severity stay in the summary)
+INLINE_REVIEW_COMMENTS = os.environ.get("INLINE_REVIEW_COMMENTS", "true").lower() == "true"
+INLINE_COMMENT_MIN_SEVERITY = os.environ.get("INLINE_COMMENT_MIN_SEVERITY", "medium")
+
+# Post a progress comment with the static check findings right away and edit it
+# as files are reviewed (at most every PROGRESS_UPDATE_SECONDS); the final
+# review replaces it (off by default: it adds GitHub requests to every review)
+PROGRESS_COMMENT = os.environ.get("PROGRESS_COMMENT", "false").lower() == "true"
+PROGRESS_UPDATE_SECONDS = float(os.environ.get("PROGRESS_UPDATE_SECONDS", "5"))
 
 
 
@@ -54,13 +78,19 @@ secrets = [
     volumes={"/cache": volume},
     timeout=600,  # 10 minutes max per review
     memory=2048,  # 2GB RAM
+    min_containers=WEBHOOK_MIN_CONTAINERS,
+    enable_memory_snapshot=MEMORY_SNAPSHOT
 )
 @modal.asgi_app()
 def create_app():
     from fastapi import FastAPI, Request, Header, HTTPException
-    from fastapi.responses import JSONResponse
+    from fastapi.responses import JSONResponse, PlainTextResponse
     
+    configure_tracing("code-review-webhook")
     app = FastAPI()
+    registry = PRJobRegistry(debounce_seconds=PR_DEBOUNCE_SECONDS)
+    review_queue = ReviewQueue() if REVIEW_QUEUE else None
+    metrics_store = MetricsStore()
     
     @app.post("/webhook")
     async def webhook(request: Request, x_hub_signature_256: str = Header(None), x_github_event: str = Header(None)):
@@ -72,12 +102,11 @@ def create_app():
         Returns:
             Response dict
         """
-        import sys
-        sys.path.append("/project")
-        
-        from orchestrator import SimpleMultiAgentOrchestrator
-        from utils.github_integration import GitHubIntegration
-        
+        # Root span of the review's trace (continues a caller's traceparent, if any)
+        with start_span("webhook", parent=dict(request.headers), event=x_github_event or ""):
+            return await handle_webhook(request, x_hub_signature_256, x_github_event)
+    
+    async def handle_webhook(request: Request, x_hub_signature_256: str, x_github_event: str):
         # Get request body
         body = await request.body()
         
@@ -112,11 +141,34 @@ def create_app():
         # Handle pull request events
         if event_type == "pull_request":
             action = payload.get("action", "")
-            if action not in ["opened", "synchronize", "reopened"]:
+            if action not in ["opened", "synchronize", "reopened", "ready_for_review"]:
                 return JSONResponse(content={"message": f"Ignoring action: {action}"})
             
-            # Process in background using Modal's spawn
-            process_pr_review.spawn(payload)
+            # A newer head makes the review in flight for the old one obsolete
+            repo_data = payload["repository"]
+            pr_key = job_key(repo_data["owner"]["login"], repo_data["name"], payload["pull_request"]["number"])
+            head_sha = payload["pull_request"]["head"]["sha"]
+            superseded_call = await registry.record_event(pr_key, head_sha)
+            if superseded_call:
+                print(f"Cancelling superseded review of {pr_key}")
+                try:
+                    await modal.FunctionCall.from_id(superseded_call).cancel.aio()
+                except Exception as e:
+                    print(f"Could not cancel review {superseded_call}: {e}")
+            
+            if review_queue is not None:
+                lane = classify_priority(payload)
+                await review_queue.put(make_job(payload, pr_key, lane, trace_context=inject_context()))
+                if not await registry.is_alive(DISPATCHER_NAME, max_age=10):
+                    await dispatch_reviews.spawn.aio()
+                return JSONResponse(content={
+                    "message": f"Review queued for PR #{payload['pull_request']['number']} ({lane} priority)"
+                })
+            
+            # Process in background using Modal's spawn; the review waits out
+            # the debounce window and exits if another push arrives meanwhile
+            call = await process_pr_review.spawn.aio(payload, inject_context())
+            await registry.set_call(pr_key, head_sha, call.object_id)
             
             return JSONResponse(content={
                 "message": f"Review initiated for PR #{payload['pull_request']['number']}"
@@ -126,12 +178,33 @@ def create_app():
     
     @app.get("/")
     async def health_check():
-        return {
+        health = {
             "status": "healthy",
             "service": "Multi-Agent Code Review (Modal)",
             "version": "1.0.0",
             "timestamp": datetime.now().isoformat()
         }
+        if review_queue is not None:
+            health["queue_depth"] = await review_queue.depths()
+        return health
+    
+    @app.get("/metrics")
+    async def metrics():
+        """Prometheus metrics of this container and the published ones of the workers"""
+        histograms, api_totals = await metrics_store.collect(exclude=metrics_source())
+        for key, histogram in perf_monitor.snapshot().items():
+            if key in histograms:
+                histograms[key].merge(histogram)
+            else:
+                histograms[key] = histogram
+        merge_api_totals(api_totals, api_tracker.model_totals())
+        
+        gauges = []
+        if review_queue is not None:
+            for lane, depth in (await review_queue.depths()).items():
+                gauges.append(("review_queue_pending", {"lane": lane}, depth))
+        return PlainTextResponse(render_prometheus(histograms, api_totals, gauges),
+                                 media_type="text/plain; version=0.0.4")
     
     return app
 
@@ -157,18 +230,35 @@ def verify_signature(payload: bytes, signature: str, secret: str) -> bool:
     timeout=1200,  # 20 minutes for full PR review
     memory=4096,   # 4GB RAM
     cpu=2.0,       # 2 CPU cores
+    min_containers=PR_REVIEW_MIN_CONTAINERS,
+    enable_memory_snapshot=MEMORY_SNAPSHOT
 )
-async def process_pr_review(webhook_payload: dict):
+async def process_pr_review(webhook_payload: dict, trace_context: dict = None):
     """Process a pull request review
     
-    This runs as a separate Modal function to handle long-running reviews
+    This runs as a separate Modal function to handle long-running reviews.
+    trace_context continues the trace of the webhook event that spawned it.
     """
-    import sys
-    sys.path.append("/project")
-    
-    from orchestrator import SimpleMultiAgentOrchestrator
-    from utils.github_integration import GitHubIntegration
-    
+    configure_tracing("code-review-worker")
+    pr_data = webhook_payload["pull_request"]
+    repo_data = webhook_payload["repository"]
+    try:
+        with start_span("pr_review",
+                        parent=trace_context,
+                        pr=job_key(repo_data["owner"]["login"], repo_data["name"], pr_data["number"]),
+                        head_sha=pr_data["head"]["sha"],
+                        action=webhook_payload.get("action")):
+            await review_pull_request_event(webhook_payload)
+    finally:
+        # The webhook's /metrics endpoint serves the published worker metrics
+        await MetricsStore().publish()
+        await asyncio.to_thread(flush_tracing)
+
+
+async def review_pull_request_event(webhook_payload: dict):
+    """Review the pull request of a webhook event and post the review"""
+    github = None
+    progress = None
     try:
         # Extract PR information
         pr_data = webhook_payload["pull_request"]
@@ -183,6 +273,14 @@ async def process_pr_review(webhook_payload: dict):
         print(f"Processing PR #{pr_number}: {pr_title}")
         print(f"Repository: {owner}/{repo}")
         
+        # Coalesce bursts of pushes: only the review of the latest head runs
+        head_sha = pr_data["head"]["sha"]
+        pr_key = job_key(owner, repo, pr_number)
+        registry = PRJobRegistry(debounce_seconds=PR_DEBOUNCE_SECONDS)
+        if not await registry.wait_for_quiet(pr_key, head_sha):
+            print(f"Skipping review of {head_sha[:7]}: superseded by a newer push")
+            return
+        
         # Initialize GitHub integration
         # Try different possible environment variable names Modal might use
         github_token = os.environ.get("GITHUB_TOKEN") or os.environ.get("githubsecret") or os.environ.get("GITHUBSECRET")
@@ -190,10 +288,12 @@ async def process_pr_review(webhook_payload: dict):
             print("ERROR: GitHub token not found. Available env vars:")
             print([k for k in os.environ.keys() if 'github' in k.lower() or 'token' in k.lower()])
             raise ValueError("GitHub token is required")
-        github = GitHubIntegration(github_token=github_token)
+        github = GitHubIntegration(github_token=github_token, fetch_backend=GITHUB_FETCH_BACKEND)
         
         # Get PR files
-        pr_files = await github.get_pr_files(owner, repo, pr_number)
+        with start_span("github_fetch", backend=GITHUB_FETCH_BACKEND) as span:
+            pr_files = await github.get_pr_files(owner, repo, pr_number)
+            span.set_attribute("files", len(pr_files))
         
         if not pr_files:
             await github.post_review_comment(
@@ -204,7 +304,7 @@ async def process_pr_review(webhook_payload: dict):
             return
         
         # Filter for code files
-        code_extensions = {'.py', '.js', '.ts', '.java', '.cpp', '.c', '.go', '.rs', '.rb', '.php'}
+        code_extensions = {'.py', '.js', '.jsx', '.ts', '.tsx', '.java', '.cpp', '.c', '.go', '.rs', '.rb', '.php'}
         reviewable_files = []
         
         for file in pr_files:
@@ -213,9 +313,28 @@ async def process_pr_review(webhook_payload: dict):
                 reviewable_files.append({
                     'filename': file['filename'],
                     'content': file['content'],
-                    'language': file['language']
+                    'language': file['language'],
+                    'patch': file.get('patch', '')
                 })
         
+        # Review only what changed since the last posted review, when the
+        # reviewed commit is still part of the branch
+        delta_base = None
+        if DELTA_REVIEW and webhook_payload.get("action") == "synchronize":
+            reviewed_sha = await registry.last_reviewed_sha(pr_key)
+            if reviewed_sha and reviewed_sha != head_sha:
+                changes = await github.get_changes_since(owner, repo, reviewed_sha, head_sha)
+                if changes is not None:
+                    delta_base = reviewed_sha
+                    reviewable_files = [
+                        dict(file, patch=changes[file['filename']])
+                        for file in reviewable_files if file['filename'] in changes
+                    ]
+                    if not reviewable_files:
+                        print(f"No code changes since {reviewed_sha[:7]}")
+                        await registry.mark_reviewed(pr_key, head_sha)
+                        return
+        
         if not reviewable_files:
             await github.post_review_comment(
                 owner, repo, pr_number,
@@ -226,21 +345,52 @@ async def process_pr_review(webhook_payload: dict):
         
         print(f"Reviewing {len(reviewable_files)} code files...")
         
-        # Initialize orchestrator
-        openai_key = os.environ.get("OPENAI_API_KEY") or os.environ.get("openaisecret") or os.environ.get("OPENAISECRET")
-        orchestrator = SimpleMultiAgentOrchestrator(api_key=openai_key)
+        # Pooled orchestrator: warm containers reuse its agents and model connections
+        orchestrator = get_orchestrator(**orchestrator_options(
+            diff_scoped_review=DIFF_SCOPED_REVIEW,
+            incremental_review=INCREMENTAL_REVIEW,
+            cache_manager=get_cache_manager(use_modal=True),
+            **review_history_options()
+        ))
+        pr_ref = {"repo": f"{owner}/{repo}", "pr_number": pr_number, "head_sha": head_sha}
         
         # Get PR metadata
         pr_info = await github.get_pr_info(owner, repo, pr_number)
         
+        if PROGRESS_COMMENT:
+            progress = ReviewProgress(github, owner, repo, pr_number, min_interval=PROGRESS_UPDATE_SECONDS)
+        
         # Perform review
-        review_result = await orchestrator.review_pull_request(
-            pr_files=reviewable_files,
-            pr_description=pr_description
-        )
+        distributed = DISTRIBUTED_REVIEW and len(reviewable_files) >= DISTRIBUTED_MIN_FILES
+        with start_span("review", files=len(reviewable_files), distributed=distributed):
+            if distributed:
+                review_result = await review_files_distributed(
+                    orchestrator,
+                    reviewable_files,
+                    pr_description,
+                    progress=progress,
+                    pr_ref=pr_ref
+                )
+            else:
+                review_result = await orchestrator.review_pull_request(
+                    pr_files=reviewable_files,
+                    pr_description=pr_description,
+                    progress=progress,
+                    pr_ref=pr_ref
+                )
+        
+        # A push during the review makes it obsolete (its own review follows)
+        if not await registry.is_current(pr_key, head_sha):
+            print(f"Discarding review of {head_sha[:7]}: superseded by a newer push")
+            return
         
         # Format and post review
         if review_result.get('markdown_report'):
+            if delta_base:
+                review_result['markdown_report'] = (
+                    f"_Incremental review: {len(reviewable_files)} file(s) changed since "
+                    f"{delta_base[:7]}._\n\n" + review_result['markdown_report']
+                )
             formatted_comment = github.format_review_comment(
                 review_result['markdown_report'],
                 pr_info
@@ -256,15 +406,30 @@ async def process_pr_review(webhook_payload: dict):
                 event = "COMMENT"
             else:
                 event = "APPROVE"
+            if delta_base:
+                event = floor_review_event(event, await registry.last_review_event(pr_key))
+            
+            # Inline comments are anchored to the PR's own diff (not a delta)
+            comments = []
+            if INLINE_REVIEW_COMMENTS:
+                comments = review_comments(
+                    review_result.get('file_reviews', []),
+                    pr_files,
+                    min_severity=INLINE_COMMENT_MIN_SEVERITY
+                )
             
             # Post the review
-            review_response = await github.post_review_comment(
-                owner, repo, pr_number,
-                formatted_comment,
-                event
-            )
+            with start_span("post_review", event=event, inline_comments=len(comments)):
+                review_response = await github.post_review_comment(
+                    owner, repo, pr_number,
+                    formatted_comment,
+                    event,
+                    comments=comments,
+                    commit_id=head_sha
+                )
             
             print(f"Review posted successfully: {review_response.get('html_url', 'No URL')}")
+            await registry.mark_reviewed(pr_key, head_sha, event)
             
             # Save to cache volume for debugging
             cache_path = f"/cache/reviews/pr_{pr_number}_{datetime.now().isoformat()}.md"
@@ -277,16 +442,165 @@ async def process_pr_review(webhook_payload: dict):
         import traceback
         traceback.print_exc()
         
-        # Try to post error comment
+        # Try to post error comment (in place of the progress comment, if any)
         try:
-            github = GitHubIntegration(github_token=os.environ.get("GITHUB_TOKEN") or os.environ.get("githubsecret") or os.environ.get("GITHUBSECRET"))
-            await github.post_review_comment(
-                owner, repo, pr_number,
-                f"An error occurred while reviewing this pull request. Please check the logs.",
-                "COMMENT"
-            )
+            error_message = "An error occurred while reviewing this pull request. Please check the logs."
+            if progress is None or not await progress.fail(error_message):
+                github = github or GitHubIntegration(github_token=os.environ.get("GITHUB_TOKEN") or os.environ.get("githubsecret") or os.environ.get("GITHUBSECRET"))
+                await github.post_review_comment(
+                    owner, repo, pr_number,
+                    error_message,
+                    "COMMENT"
+                )
         except:
             pass
+    finally:
+        # The posted review replaces the progress comment
+        if progress is not None:
+            await progress.finish()
+        # Release the pooled GitHub connections
+        if github is not None:
+            await github.aclose()
+
+
+async def review_finished(call) -> bool:
+    """Whether a spawned review has finished (including failed and cancelled ones)"""
+    try:
+        await call.get.aio(timeout=0)
+    except (TimeoutError, modal.exception.TimeoutError):
+        return False
+    except Exception:
+        pass
+    return True
+
+
+@app.function(
+    image=image,
+    secrets=secrets,
+    timeout=3600,
+    max_containers=1,  # a single dispatcher enforces the global cap
+    schedule=modal.Period(minutes=5)  # picks up jobs left behind by an exiting dispatcher
+)
+async def dispatch_reviews():
+    """Start queued PR reviews by priority under the concurrency cap
+    
+    Spawned by the webhook when no dispatcher is running; exits after a
+    minute without work.
+    """
+    dispatcher = ReviewDispatcher(
+        queue=ReviewQueue(),
+        registry=PRJobRegistry(debounce_seconds=PR_DEBOUNCE_SECONDS),
+        # Called inside the dispatch span, which the review continues
+        spawn=lambda payload: process_pr_review.spawn.aio(payload, inject_context()),
+        is_done=review_finished,
+        max_concurrency=MAX_CONCURRENT_REVIEWS,
+        load_call=modal.FunctionCall.from_id
+    )
+    configure_tracing("code-review-dispatcher")
+    stats = await dispatcher.run(idle_exit_seconds=60, max_runtime=3300)
+    print(f"Dispatcher exiting: {stats}")
+    await MetricsStore().publish()
+    await asyncio.to_thread(flush_tracing)
+
+
+async def review_files_distributed(orchestrator, reviewable_files: list, pr_description: str,
+                                   progress=None, pr_ref=None) -> dict:
+    """Review PR files across containers and reduce them into one PR review
+    
+    Each file is dispatched to the orchestrator app's FileReviewService via
+    starmap, so large PRs scale out instead of being capped by one container's
+    timeout. The reduce step (PR-level consensus and report) runs here.
+    progress (a ReviewProgress) is updated as the file results arrive. With
+    the review history, files reviewed before are not dispatched at all.
+    """
+    review_code = modal.Cls.from_name(ORCHESTRATOR_APP_NAME, "FileReviewService")().review_code
+    start_time = datetime.now()
+    
+    history_keys, stored = await orchestrator.find_stored_reviews(reviewable_files, pr_ref)
+    all_files = reviewable_files
+    reviewable_files = [file for file in reviewable_files if file['filename'] not in stored]
+    
+    # The PR token budget is enforced here, before anything is dispatched;
+    # cached responses cost no tokens, so they are looked up first
+    if orchestrator.max_pr_tokens is not None:
+        await orchestrator.prefetch_cache(reviewable_files)
+    reviewable_files, skipped_files = orchestrator.plan_token_budget(reviewable_files)
+    
+    print(f"Dispatching {len(reviewable_files)} files to {ORCHESTRATOR_APP_NAME}.FileReviewService "
+          f"({len(stored)} taken from the review history)")
+    
+    if progress is not None:
+        for file in reviewable_files:
+            analysis = AnalysisContext(file['content'] or "", file['filename'], file['language'])
+            progress.add_findings(file['filename'], ast_findings(analysis))
+        reviewed_files = orchestrator.merge_stored_reviews(all_files, reviewable_files, [], stored)[0]
+        await progress.start([file['filename'] for file in reviewed_files])
+        for filename, review in stored.items():
+            progress.file_reviewed(filename, review)
+    
+    # Static analysis runs once for the whole PR here rather than once per container
+    static_results = await orchestrator.precompute_static_analysis(reviewable_files)
+    if progress is not None:
+        for filename, results in static_results.items():
+            progress.add_findings(filename, bandit_findings(results))
+        progress.schedule_update()
+    
+    file_args = []
+    for file in reviewable_files:
+        context = {"language": file['language'], "patch": file.get('patch', '')}
+        if file['filename'] in static_results:
+            context["static_analysis"] = static_results[file['filename']]
+        file_args.append((file['content'], file['filename'], pr_description, context, inject_context()))
+    
+    # order_outputs keeps results aligned with reviewable_files so the consensus
+    # is deterministic; failed files come back as exceptions instead of aborting the map
+    file_reviews = []
+    index = 0
+    async for result in review_code.starmap.aio(file_args, order_outputs=True, return_exceptions=True):
+        filename = reviewable_files[index]['filename']
+        if isinstance(result, BaseException):
+            print(f"Review of {filename} failed: {result}")
+            result = {
+                "status": "error",
+                "filename": filename,
+                "error": str(result),
+                "timestamp": datetime.now().isoformat()
+            }
+        file_reviews.append(result)
+        if progress is not None:
+            progress.file_reviewed(filename, result)
+        index += 1
+    
+    reviewable_files, file_reviews = orchestrator.merge_stored_reviews(
+        all_files, reviewable_files, file_reviews, stored
+    )
+    duration = (datetime.now() - start_time).total_seconds()
+    
+    result = orchestrator.aggregate_pr_reviews(
+        file_reviews,
+        reviewable_files,
+        pr_description,
+        duration,
+        skipped_files
+    )
+    await orchestrator.record_review(pr_ref, result, history_keys, stored)
+    return result
+
+
+@app.function(
+    image=image,
+    volumes={"/cache": volume},
+    timeout=900,
+    max_containers=1,  # the only writer of the main history database
+    schedule=modal.Period(hours=1)
+)
+def compact_review_history():
+    """Merge the review history segments of the containers into the main database"""
+    if not REVIEW_HISTORY:
+        return
+    volume.reload()
+    merged = ReviewHistory(HISTORY_DIR, commit=volume.commit).compact(max_age_days=HISTORY_RETENTION_DAYS)
+    print(f"Merged {merged} review history segments")
 
 
 # Health check is now part of the FastAPI app above
@@ -303,6 +617,6 @@ def deploy_info():
     print("- Health: https://[your-modal-username]--multi-agent-code-review-health-check.modal.run")
     print("\nTo deploy: modal deploy modal_app/webhook_handler.py")
     print("\nRequired secrets in Modal:")
-    print("- openai-secret: OPENAI_API_KEY")
-    print("- github-secret: GITHUB_TOKEN, GITHUB_WEBHOOK_SECRET (optional)")
+    print("- openaisecret: OPENAI_API_KEY")
+    print("- githubsecret: GITHUB_TOKEN, GITHUB_WEBHOOK_SECRET (optional)")
     print("="*60)
\ No newline at end of file
@@ -4,7 +4,7 @@ Simplified Multi-Agent Orchestrator that directly calls each agent
 
 import asyncio
 import os
-from typing import Dict, List, Any
+from typing import Dict, List, Any, Optional, Tuple, Callable
 from datetime import datetime
 from dotenv import load_dotenv
 import time
@@ -12,9 +12,25 @@ import time
 from agents.code_reviewer import CodeReviewerAgent
 from agents.security_checker import SecurityCheckerAgent
 from agents.performance_analyzer import PerformanceAnalyzerAgent
+from agents.fused_reviewer import FusedReviewerAgent
+from agents.triage_agent import TriageAgent
 from utils.consensus_mechanism import WeightedConsensus
 from utils.report_generator import ReportGenerator
+from utils.review_scheduler import ReviewScheduler
+from utils.diff_scoper import DiffScoper, ScopedCode, merge_ranges
+from utils.code_units import (
+    CodeUnit, MODULE_UNIT, assign_findings_to_units,
+    to_unit_relative, from_unit_relative
+)
+from utils.cache_manager import CacheManager, get_cache_manager
+from utils.review_history import ReviewHistory, file_review_key
+from utils.static_analyzer import run_static_analysis_batch
+from utils.analysis_context import AnalysisContext
+from utils.review_progress import ReviewProgress, ast_findings, bandit_findings
+from utils.review_router import ReviewRouter, SKIP_TIER, LIGHT_TIER, DEEP_TIER, summarize_routes
+from utils.token_budget import TokenBudget, count_tokens, chunk_ranges, context_window
 from utils.logger import get_logger, log_performance, track_performance, api_tracker, perf_monitor
+from utils.tracing import start_span
 
 # Load environment variables
 load_dotenv()
@@ -26,26 +42,139 @@ logger = get_logger(__name__)
 class SimpleMultiAgentOrchestrator:
     """Orchestrates multiple specialized agents for comprehensive code review"""
     
-    def __init__(self, api_key: str = None):
-        """Initialize the orchestrator with all specialized agents"""
+    def __init__(self,
+                 api_key: str = None,
+                 concurrent_agents: bool = True,
+                 max_file_concurrency: int = 4,
+                 diff_scoped_review: bool = False,
+                 diff_context_lines: int = 5,
+                 cache_manager: Optional[CacheManager] = None,
+                 enable_cache: bool = True,
+                 incremental_review: bool = False,
+                 structured_output: bool = False,
+                 fused_review: bool = False,
+                 fused_review_max_lines: int = 300,
+                 model_routing: bool = False,
+                 light_model: str = "gpt-4o-mini",
+                 max_request_tokens: Optional[int] = 20000,
+                 max_pr_tokens: Optional[int] = None,
+                 history: Optional[ReviewHistory] = None):
+        """Initialize the orchestrator with all specialized agents
+        
+        Args:
+            api_key: OpenAI API key (defaults to env var OPENAI_API_KEY)
+            concurrent_agents: Run the three agents concurrently for each file
+                instead of one after another
+            max_file_concurrency: Maximum number of files reviewed at the same
+                time by review_pull_request
+            diff_scoped_review: When a file's diff patch is provided in the
+                context, send only the changed hunks (plus context) to the agents
+            diff_context_lines: Lines of context around each change in
+                diff-scoped mode (Python changes expand to the enclosing function/class)
+            cache_manager: Cache for per-agent responses, keyed by code content.
+                Defaults to the process-wide local cache; pass a ModalCacheManager
+                to share results across containers
+            enable_cache: Set to False to always call the model
+            incremental_review: Split files into function/class units (Python, and
+                other languages when tree-sitter is installed) and only send
+                units whose syntax tree changed since they were last reviewed;
+                cached findings are reused for the rest (requires the cache)
+            structured_output: Have the agents answer with JSON findings
+                (ReviewFindings schema) instead of text parsed with heuristics
+            fused_review: Review code with one model call covering all three
+                roles (the code is sent once) instead of one call per agent
+            fused_review_max_lines: Longest review input (file or excerpt) sent
+                as a fused review; longer inputs get the three separate calls
+            model_routing: Triage each review input first (local signals plus
+                a call to light_model) and skip it, review it with light_model
+                or give it the full gpt-4o review
+            light_model: Cheap model used for triage and light reviews
+            max_request_tokens: Most code tokens sent in one model request;
+                larger review inputs are split into chunks (None for no limit
+                besides the model's context window)
+            max_pr_tokens: Estimated input tokens a PR review may use; files
+                that do not fit are skipped and listed in the report (None for
+                no limit)
+            history: Review history (utils.review_history); PR reviews given a
+                pr_ref take files whose content and settings match an earlier
+                review of the repository from it and are recorded in it, and
+                incremental reviews fall back to it for unit findings the cache
+                no longer has
+        """
         self.api_key = api_key or os.getenv("OPENAI_API_KEY")
         if not self.api_key:
             raise ValueError("OpenAI API key is required")
         
+        self.concurrent_agents = concurrent_agents
+        self.diff_scoped_review = diff_scoped_review
+        self.diff_scoper = DiffScoper(context_lines=diff_context_lines)
+        self.cache_manager = None
+        if enable_cache:
+            self.cache_manager = cache_manager or get_cache_manager(use_modal=False)
+        self.incremental_review = incremental_review and self.cache_manager is not None
+        self.fused_review_max_lines = fused_review_max_lines
+        self.max_pr_tokens = max_pr_tokens
+        self.history = history
+        self._prompt_overhead_tokens = None
+        self.request_recorder = None
+        
         logger.info("Initializing SimpleMultiAgentOrchestrator", 
-                   api_key_provided=bool(api_key))
+                   api_key_provided=bool(api_key),
+                   concurrent_agents=concurrent_agents,
+                   cache_enabled=self.cache_manager is not None,
+                   structured_output=structured_output,
+                   fused_review=fused_review,
+                   model_routing=model_routing)
         
         # Initialize specialized agents
-        self.code_reviewer = CodeReviewerAgent(api_key=self.api_key)
-        self.security_checker = SecurityCheckerAgent(api_key=self.api_key)
-        self.performance_analyzer = PerformanceAnalyzerAgent(api_key=self.api_key)
+        # Agents consult the cache before each model call, so unchanged files
+        # (and unchanged excerpts) cost no API calls on re-review
+        agent_options = {"api_key": self.api_key, "cache_manager": self.cache_manager,
+                         "structured_output": structured_output}
+        self.code_reviewer = CodeReviewerAgent(**agent_options)
+        self.security_checker = SecurityCheckerAgent(**agent_options)
+        self.performance_analyzer = PerformanceAnalyzerAgent(**agent_options)
+        self.fused_reviewer = None
+        if fused_review:
+            self.fused_reviewer = FusedReviewerAgent(api_key=self.api_key, cache_manager=self.cache_manager)
+        self.router = None
+        if model_routing:
+            self.router = ReviewRouter(
+                triage_agent=TriageAgent(api_key=self.api_key, cache_manager=self.cache_manager,
+                                         model=light_model),
+                deep_model=self.code_reviewer.model,
+                light_model=light_model
+            )
+        
+        # Half the context window is left for the prompt around the code and the response
+        self.max_request_tokens = min(max_request_tokens or context_window(self.code_reviewer.model),
+                                      context_window(self.code_reviewer.model) // 2)
         
         # Initialize utilities
         self.consensus = WeightedConsensus()
         self.report_generator = ReportGenerator()
+        self.scheduler = ReviewScheduler(max_concurrency=max_file_concurrency)
         
         logger.info("Orchestrator initialized successfully")
         
+    def set_request_recorder(self, recorder: Optional[Callable[[str, Any, Dict[str, Any]], Any]]):
+        """Collect the agents' model requests instead of sending them
+        
+        While a recorder is set, every agent call that misses the cache is
+        passed to recorder(cache_key, agent, request_body) and answered with
+        an empty response marked 'deferred', and the units of such reviews
+        are not cached. Batch audits (utils.batch_audit) use this to build
+        their Batch API input and to find the requests no batch answered.
+        
+        Args:
+            recorder: Callback receiving the deferred requests, or None to
+                send requests again
+        """
+        self.request_recorder = recorder
+        for agent in (self.code_reviewer, self.security_checker, self.performance_analyzer, self.fused_reviewer):
+            if agent is not None:
+                agent.request_recorder = recorder
+    
     @track_performance("orchestrator_review_code")
     async def review_code(self, 
                          code: str, 
@@ -61,8 +190,19 @@ class SimpleMultiAgentOrchestrator:
             context: Additional context
             
         Returns:
-            Comprehensive review results
+            Comprehensive review results, with the model calls, tokens and
+            cost of this file under 'usage'
         """
+        with api_tracker.usage_scope() as usage:
+            result = await self._review_code(code, filename, pr_description, context)
+        result["usage"] = usage
+        return result
+    
+    async def _review_code(self,
+                           code: str,
+                           filename: str,
+                           pr_description: str,
+                           context: Optional[Dict[str, Any]]) -> Dict[str, Any]:
         start_time = time.time()
         context = context or {}
         context["pr_description"] = pr_description
@@ -73,68 +213,90 @@ class SimpleMultiAgentOrchestrator:
                    pr_description=pr_description)
         
         try:
+            language = context.get("language", "python")
+            
+            # Local analysis (parse, AST metrics, static analysis) is done once
+            # per file and shared by the planning step and all agents
+            analysis = context.get("analysis")
+            if analysis is None:
+                analysis = AnalysisContext(code, filename, language,
+                                           static_analysis=context.pop("static_analysis", None))
+                context["analysis"] = analysis
+            
+            # In incremental mode only the function/class units that changed are
+            # reviewed; in diff-scoped mode only the changed hunks. Either way the
+            # agents see an excerpt and findings are mapped back to the full file.
+            scope = None
+            unit_plan = None
+            review_input = code
+            if self.incremental_review and analysis.supports_structure:
+                unit_plan = await self._plan_unit_review(analysis, language)
+                if unit_plan:
+                    scope = unit_plan["scope"]
+                    logger.info("Incremental unit review",
+                               filename=filename,
+                               total_units=len(unit_plan["units"]),
+                               changed_units=len(unit_plan["changed"]))
+            if not unit_plan and self.diff_scoped_review and context.get("patch"):
+                scope = self.diff_scoper.scope(code, context["patch"], language,
+                                               analysis.ast_results() if analysis.supports_structure else None)
+                if scope:
+                    logger.info("Reviewing diff-scoped excerpt",
+                               filename=filename,
+                               scoped_lines=scope.scoped_lines,
+                               total_lines=scope.total_lines)
+            if scope:
+                review_input = scope.code
+                context["review_scope"] = scope
+            
             # Run each agent independently with performance tracking
-            with log_performance("code_reviewer_agent", logger):
-                code_review_result = await self.code_reviewer.analyze_code(
-                    code=code,
-                    filename=filename,
-                    context=context
-                )
-                # Count issues based on the agent's response format
-                code_issues_count = 0
-                if "issues" in code_review_result:
-                    code_issues_count = len(code_review_result.get("issues", []))
-                elif "issues_found" in code_review_result:
-                    code_issues_count = sum(code_review_result.get("issues_found", {}).values())
-                
-                logger.info("Code Reviewer completed",
-                           issues_found=code_issues_count)
+            agent_tasks = [
+                ("code_reviewer", self.code_reviewer),
+                ("security_checker", self.security_checker),
+                ("performance_analyzer", self.performance_analyzer)
+            ]
             
-            with log_performance("security_checker_agent", logger):
-                security_result = await self.security_checker.analyze_code(
-                    code=code,
-                    filename=filename,
-                    context=context
-                )
-                # Count vulnerabilities - it's a dict with severity counts
-                vuln_count = 0
-                if "vulnerabilities" in security_result:
-                    vulns = security_result.get("vulnerabilities", {})
-                    if isinstance(vulns, dict):
-                        vuln_count = sum(vulns.values())
-                    else:
-                        vuln_count = len(vulns)
-                
-                logger.info("Security Checker completed",
-                           vulnerabilities_found=vuln_count)
+            agents_needed = not (unit_plan and not unit_plan["changed"])
+            if agents_needed and analysis.is_python:
+                # Let static analysis run in its worker thread while the other
+                # agents are already waiting on the model
+                analysis.start_static_analysis()
             
-            with log_performance("performance_analyzer_agent", logger):
-                performance_result = await self.performance_analyzer.analyze_code(
-                    code=code,
-                    filename=filename,
-                    context=context
-                )
-                # Count performance issues - could be dict or list
-                perf_count = 0
-                if "issues" in performance_result:
-                    perf_count = len(performance_result.get("issues", []))
-                elif "performance_issues" in performance_result:
-                    perf_issues = performance_result.get("performance_issues", {})
-                    if isinstance(perf_issues, dict):
-                        perf_count = sum(perf_issues.values())
-                    else:
-                        perf_count = len(perf_issues)
-                
-                logger.info("Performance Analyzer completed",
-                           issues_found=perf_count)
+            if not agents_needed:
+                # Nothing changed: every finding comes from the unit cache
+                agent_results = [
+                    {"agent": agent_name, "filename": filename, "status": "success", "from_cache": True}
+                    for agent_name, _ in agent_tasks
+                ]
+                agent_findings = self._extract_agent_findings(*agent_results)
+                route = None
+            else:
+                # Inputs over the per-request token budget are reviewed in chunks
+                chunks = self._chunk_review_input(analysis, review_input, scope, language)
+                if chunks:
+                    logger.info("Reviewing in chunks",
+                               filename=filename,
+                               chunks=len(chunks),
+                               max_request_tokens=self.max_request_tokens)
+                    chunk_reviews = await asyncio.gather(*[
+                        self._review_input(chunk.code, chunk, analysis, filename,
+                                           dict(context, review_scope=chunk), agent_tasks)
+                        for chunk in chunks
+                    ])
+                    agent_results, agent_findings, route = self._merge_chunk_reviews(chunk_reviews, agent_tasks)
+                else:
+                    agent_results, agent_findings, route = await self._review_input(
+                        review_input, scope, analysis, filename, context, agent_tasks
+                    )
+            
+            code_review_result, security_result, performance_result = agent_results
             
             # Apply consensus mechanism
             with log_performance("consensus_mechanism", logger):
-                agent_findings = self._extract_agent_findings(
-                    code_review_result,
-                    security_result,
-                    performance_result
-                )
+                if unit_plan:
+                    agent_findings = await self._merge_unit_findings(
+                        unit_plan, agent_findings, agent_results, language
+                    )
                 
                 consensus_results = self.consensus.resolve_conflicts(agent_findings)
                 logger.info("Consensus mechanism completed",
@@ -184,6 +346,14 @@ class SimpleMultiAgentOrchestrator:
                 "status": "success",
                 "filename": filename,
                 "timestamp": datetime.now().isoformat(),
+                "review_scope": scope.to_dict() if scope else {"mode": "full"},
+                "unit_review": self._summarize_unit_review(unit_plan, agent_findings) if unit_plan else None,
+                "review_route": route,
+                # Per-agent findings with full-file line numbers (reused by the PR consensus)
+                "agent_findings": agent_findings,
+                "cached_agents": [
+                    result.get("agent") for result in agent_results if result.get("from_cache")
+                ],
                 "consensus_results": consensus_results,
                 "orchestrator_results": orchestrator_results,
                 "markdown_report": markdown_report,
@@ -211,6 +381,370 @@ class SimpleMultiAgentOrchestrator:
                 }
             }
     
+    async def _run_agent(self,
+                         agent_name: str,
+                         agent: Any,
+                         code: str,
+                         filename: str,
+                         context: Dict[str, Any]) -> Dict[str, Any]:
+        """Run a single agent with performance tracking and per-agent error handling
+        
+        Failures are converted into an error result so that one agent failing
+        does not cancel the other agents running alongside it. Rate limited
+        calls are retried with backoff by the scheduler.
+        """
+        try:
+            with log_performance(f"{agent_name}_agent", logger):
+                result = await self.scheduler.call_with_backoff(
+                    lambda: agent.analyze_code(
+                        code=code,
+                        filename=filename,
+                        context=context
+                    ),
+                    operation=agent_name
+                )
+        except Exception as e:
+            logger.error(f"{agent_name} failed",
+                        exception=e,
+                        filename=filename)
+            return {
+                "agent": agent_name,
+                "filename": filename,
+                "status": "error",
+                "error": str(e)
+            }
+        
+        logger.info(f"{agent_name} completed",
+                   filename=filename,
+                   issues_found=self._count_agent_issues(result))
+        return result
+    
+    async def _review_input(self,
+                            review_input: str,
+                            scope: Optional[ScopedCode],
+                            analysis: AnalysisContext,
+                            filename: str,
+                            context: Dict[str, Any],
+                            agent_tasks: List[Tuple[str, Any]]) -> Tuple[List[Dict[str, Any]],
+                                                                         Dict[str, List[Dict[str, Any]]],
+                                                                         Optional[Dict[str, Any]]]:
+        """Review one input (file, excerpt or chunk) with the agents
+        
+        Returns:
+            Tuple of (agent results, findings with full-file line numbers, route)
+        """
+        # Route the review input to a tier before spending gpt-4o calls on it
+        route = None
+        if self.router is not None:
+            route = await self.router.route(
+                analysis, review_input, context,
+                review_calls=1 if self._use_fused_review(review_input) else len(agent_tasks)
+            )
+            if route["tier"] == LIGHT_TIER:
+                context["review_model"] = route["model"]
+        skipped = route is not None and route["tier"] == SKIP_TIER
+        
+        fused_results = None
+        if not skipped and self._use_fused_review(review_input):
+            fused_results = await self._run_fused_review(review_input, filename, dict(context))
+        
+        if skipped:
+            # Triage found nothing worth a model review
+            agent_results = [
+                {"agent": agent_name, "filename": filename, "status": "success",
+                 "issues": [], "skipped": True, "from_cache": False}
+                for agent_name, _ in agent_tasks
+            ]
+        elif fused_results:
+            agent_results = fused_results
+        elif self.concurrent_agents:
+            # Agents are independent, so fan out and wait for the slowest one.
+            # Each agent gets its own copy of the context since some agents
+            # annotate it with their local analysis results.
+            agent_results = await asyncio.gather(*[
+                self._run_agent(agent_name, agent, review_input, filename, dict(context))
+                for agent_name, agent in agent_tasks
+            ])
+        else:
+            agent_results = []
+            for agent_name, agent in agent_tasks:
+                agent_results.append(
+                    await self._run_agent(agent_name, agent, review_input, filename, context)
+                )
+        
+        agent_findings = self._extract_agent_findings(*agent_results)
+        if scope:
+            agent_findings = self._remap_findings(agent_findings, scope)
+        return list(agent_results), agent_findings, route
+    
+    def _chunk_review_input(self,
+                            analysis: AnalysisContext,
+                            review_input: str,
+                            scope: Optional[ScopedCode],
+                            language: str) -> Optional[List[ScopedCode]]:
+        """Split a review input over the per-request token budget into chunks
+        
+        Chunks start at function/class boundaries where possible and map back
+        to the full file like diff-scoped excerpts.
+        
+        Returns:
+            Chunk excerpts, or None if the input fits into one request
+        """
+        model = self.code_reviewer.model
+        if count_tokens(review_input, model) <= self.max_request_tokens:
+            return None
+        
+        lines = analysis.lines
+        ranges = scope.ranges if scope else [(1, len(lines))]
+        units = analysis.units() if analysis.supports_structure else None
+        boundaries = [unit.ranges[0][0] for unit in units or [] if unit.ranges]
+        
+        return [
+            self.diff_scoper.build_excerpt(lines, chunk, language, analysis.code)
+            for chunk in chunk_ranges(lines, ranges, self.max_request_tokens, model, boundaries)
+        ]
+    
+    def _merge_chunk_reviews(self,
+                             chunk_reviews: List[Tuple[List[Dict[str, Any]],
+                                                       Dict[str, List[Dict[str, Any]]],
+                                                       Optional[Dict[str, Any]]]],
+                             agent_tasks: List[Tuple[str, Any]]) -> Tuple[List[Dict[str, Any]],
+                                                                          Dict[str, List[Dict[str, Any]]],
+                                                                          Optional[Dict[str, Any]]]:
+        """Combine the chunk reviews of one file into one review"""
+        agent_results = [
+            self._merge_agent_results([review[0][index] for review in chunk_reviews])
+            for index in range(len(agent_tasks))
+        ]
+        agent_findings = {
+            agent_name: [finding for review in chunk_reviews for finding in review[1].get(agent_name, [])]
+            for agent_name, _ in agent_tasks
+        }
+        
+        route = None
+        routes = [review[2] for review in chunk_reviews if review[2]]
+        if routes:
+            tiers = (SKIP_TIER, LIGHT_TIER, DEEP_TIER)
+            deepest = max(routes, key=lambda r: tiers.index(r["tier"]))
+            route = dict(deepest, reason="chunked",
+                         estimated_savings=round(sum(r.get("estimated_savings", 0.0) for r in routes), 6))
+        return agent_results, agent_findings, route
+    
+    @staticmethod
+    def _merge_agent_results(results: List[Dict[str, Any]]) -> Dict[str, Any]:
+        """Combine one agent's results for the chunks of a file"""
+        failed = next((result for result in results if result.get("status") != "success"), None)
+        if failed:
+            return dict(failed, chunks=len(results))
+        
+        merged = dict(results[0], chunks=len(results))
+        merged["from_cache"] = all(result.get("from_cache") for result in results)
+        merged["deferred"] = any(result.get("deferred") for result in results)
+        for key in ("review", "analysis"):
+            if key in merged:
+                merged[key] = "\n\n".join(str(result.get(key) or "") for result in results)
+        if all(isinstance(result.get("issues"), list) for result in results):
+            merged["issues"] = [issue for result in results for issue in result["issues"]]
+        for key in ("issues_found", "vulnerabilities", "performance_issues"):
+            if isinstance(merged.get(key), dict):
+                totals = {}
+                for result in results:
+                    for name, value in (result.get(key) or {}).items():
+                        if isinstance(value, (int, float)):
+                            totals[name] = totals.get(name, 0) + value
+                merged[key] = totals
+        return merged
+    
+    def _use_fused_review(self, review_input: str) -> bool:
+        """Whether a review input is small enough for a single fused call"""
+        return (self.fused_reviewer is not None and
+                review_input.count("\n") + 1 <= self.fused_review_max_lines)
+    
+    async def _run_fused_review(self,
+                                code: str,
+                                filename: str,
+                                context: Dict[str, Any]) -> Optional[List[Dict[str, Any]]]:
+        """Run the fused reviewer and split its result into the three agent results
+        
+        Returns:
+            code_reviewer, security_checker and performance_analyzer results, or
+            None if the fused call failed (the caller then runs the agents separately)
+        """
+        fused = await self._run_agent("fused_reviewer", self.fused_reviewer, code, filename, context)
+        if fused.get("status") != "success":
+            logger.warning("Fused review failed, running agents separately",
+                          filename=filename,
+                          error=fused.get("error"))
+            return None
+        results = fused["results"]
+        return [results["code_reviewer"], results["security_checker"], results["performance_analyzer"]]
+    
+    def _count_agent_issues(self, agent_result: Dict[str, Any]) -> int:
+        """Count issues reported by an agent based on its response format"""
+        # Structured issue lists take precedence over severity counts
+        if isinstance(agent_result.get("issues"), list):
+            return len(agent_result["issues"])
+        
+        for key in ("issues_found", "vulnerabilities", "performance_issues"):
+            value = agent_result.get(key)
+            if isinstance(value, dict):
+                return sum(v for v in value.values() if isinstance(v, (int, float)))
+            elif isinstance(value, list):
+                return len(value)
+        
+        return 0
+    
+    def _remap_findings(self,
+                        agent_findings: Dict[str, List[Dict[str, Any]]],
+                        scope: ScopedCode) -> Dict[str, List[Dict[str, Any]]]:
+        """Map line references in findings from a diff-scoped excerpt to the full file"""
+        return {
+            agent_name: [scope.remap_finding(f) for f in findings]
+            for agent_name, findings in agent_findings.items()
+        }
+    
+    def _unit_cache_key(self, unit: CodeUnit, language: str) -> str:
+        """Cache key for the findings of one code unit"""
+        agents = (self.code_reviewer, self.security_checker, self.performance_analyzer)
+        prompt_version = "/".join(f"{agent.agent_name}:{agent.prompt_version}" for agent in agents)
+        return self.cache_manager.generate_agent_cache_key(
+            unit.hash, "unit_findings", prompt_version, self.code_reviewer.model, {"language": language}
+        )
+    
+    async def _plan_unit_review(self, analysis: AnalysisContext, language: str) -> Optional[Dict[str, Any]]:
+        """Split a file into units and work out which ones need reviewing
+        
+        Args:
+            analysis: Analysis context of the file (provides the parsed units)
+            language: Language of the file
+        
+        Returns:
+            Plan with the units, cached (unit-relative) findings by unit id of
+            the unchanged units, the changed units and the excerpt scope to
+            review (None for a full-file review), or None if the file cannot be split
+        """
+        units = analysis.units()
+        if not units:
+            return None
+        code = analysis.code
+        
+        # One batched lookup for all units of the file (by unit id: names repeat)
+        unit_keys = {unit.unit_id: self._unit_cache_key(unit, language) for unit in units if unit.has_code}
+        entries = await self.cache_manager.get_many_async(list(unit_keys.values()))
+        missing = [key for key in unit_keys.values() if key not in entries]
+        if self.history is not None and missing:
+            entries.update(await self._stored_unit_findings(missing))
+        
+        cached = {}
+        changed = []
+        for unit in units:
+            if not unit.has_code:
+                cached[unit.unit_id] = {}
+            elif unit_keys[unit.unit_id] in entries:
+                cached[unit.unit_id] = entries[unit_keys[unit.unit_id]].get("findings", {})
+            else:
+                changed.append(unit)
+        
+        lines = analysis.lines
+        ranges = merge_ranges([r for unit in changed for r in unit.ranges])
+        scoped_lines = sum(end - start + 1 for start, end in ranges)
+        
+        scope = None
+        full_review = bool(changed) and (len(changed) == len(unit_keys) or
+                                         scoped_lines > len(lines) * self.diff_scoper.max_scoped_ratio)
+        if changed and not full_review:
+            scope = self.diff_scoper.build_excerpt(lines, ranges, language, code)
+        
+        return {
+            "units": units,
+            "cached": cached,
+            "changed": units if full_review else changed,
+            "full_review": full_review,
+            "scope": scope
+        }
+    
+    async def _merge_unit_findings(self,
+                                   unit_plan: Dict[str, Any],
+                                   fresh_findings: Dict[str, List[Dict[str, Any]]],
+                                   agent_results: List[Dict[str, Any]],
+                                   language: str) -> Dict[str, List[Dict[str, Any]]]:
+        """Store findings of the reviewed units and add the cached findings of the rest
+        
+        Args:
+            unit_plan: Plan from _plan_unit_review
+            fresh_findings: Findings of this review, with full-file line numbers
+            agent_results: Agent results of this review
+            language: Language of the file
+        """
+        reviewed = unit_plan["changed"]
+        reviewed_ids = {unit.unit_id for unit in reviewed}
+        merged = {agent_name: list(findings) for agent_name, findings in fresh_findings.items()}
+        
+        # Only cache complete reviews, otherwise a failed agent's findings
+        # would be missing until the unit changes again (deferred requests
+        # have no findings yet)
+        if (reviewed and
+                all(result.get("status") == "success" and not result.get("deferred")
+                    for result in agent_results)):
+            fallback = next((unit for unit in reviewed if unit.name == MODULE_UNIT), reviewed[0])
+            per_unit = {unit.unit_id: {} for unit in reviewed}
+            for agent_name, findings in fresh_findings.items():
+                grouped = assign_findings_to_units(findings, reviewed, fallback)
+                for unit in reviewed:
+                    per_unit[unit.unit_id][agent_name] = [
+                        to_unit_relative(f, unit) for f in grouped.get(unit.unit_id, [])
+                    ]
+            
+            entries = {
+                self._unit_cache_key(unit, language): {"unit": unit.name, "findings": per_unit[unit.unit_id]}
+                for unit in reviewed
+            }
+            await self.cache_manager.set_many_async(entries, "unit_findings")
+            if self.history is not None:
+                await self._store_unit_findings(entries, {
+                    self._unit_cache_key(unit, language): unit.hash for unit in reviewed
+                })
+        
+        for unit in unit_plan["units"]:
+            if unit.unit_id in reviewed_ids:
+                continue
+            for agent_name, findings in unit_plan["cached"].get(unit.unit_id, {}).items():
+                merged.setdefault(agent_name, []).extend(
+                    from_unit_relative(f, unit) for f in findings
+                )
+        
+        return merged
+    
+    async def _stored_unit_findings(self, unit_keys: List[str]) -> Dict[str, Dict[str, Any]]:
+        """Unit findings from the review history (cached again for the next lookups)"""
+        try:
+            entries = await asyncio.to_thread(self.history.find_unit_findings, unit_keys)
+        except Exception as e:
+            logger.warning("Review history lookup failed", error=str(e))
+            return {}
+        if entries:
+            await self.cache_manager.set_many_async(entries, "unit_findings")
+        return entries
+    
+    async def _store_unit_findings(self, entries: Dict[str, Dict[str, Any]], unit_hashes: Dict[str, str]):
+        try:
+            await asyncio.to_thread(self.history.record_unit_findings, entries, unit_hashes)
+        except Exception as e:
+            logger.warning("Could not store unit findings in the review history", error=str(e))
+    
+    def _summarize_unit_review(self,
+                               unit_plan: Dict[str, Any],
+                               agent_findings: Dict[str, List[Dict[str, Any]]]) -> Dict[str, Any]:
+        """Describe an incremental review (the findings are reused at PR level)"""
+        reviewed_ids = {unit.unit_id for unit in unit_plan["changed"]}
+        return {
+            "total_units": len(unit_plan["units"]),
+            "reviewed_units": [unit.name for unit in unit_plan["changed"]],
+            "reused_units": [unit.name for unit in unit_plan["units"] if unit.unit_id not in reviewed_ids],
+            "full_review": unit_plan["full_review"],
+            "findings": agent_findings
+        }
+    
     def _extract_agent_findings(self, code_review, security, performance) -> Dict[str, List[Dict[str, Any]]]:
         """Extract structured findings from agent results"""
         findings = {
@@ -237,13 +771,18 @@ class SimpleMultiAgentOrchestrator:
         
         # Parse security findings
         if security.get("status") == "success":
-            # Security vulnerabilities is a dict with counts, need to parse from text
-            analysis_text = str(security.get("analysis", ""))
-            findings["security_checker"] = self._parse_findings_from_text(
-                analysis_text, "security_checker"
-            )
-            logger.info("Security checker: Parsed from text", 
-                      count=len(findings["security_checker"]))
+            # Structured responses carry their issues; text responses only have counts
+            if "issues" in security and isinstance(security["issues"], list):
+                findings["security_checker"] = security["issues"]
+                logger.info("Security checker: Found structured issues",
+                          count=len(security["issues"]))
+            else:
+                analysis_text = str(security.get("analysis", ""))
+                findings["security_checker"] = self._parse_findings_from_text(
+                    analysis_text, "security_checker"
+                )
+                logger.info("Security checker: Parsed from text", 
+                          count=len(findings["security_checker"]))
         
         # Parse performance findings
         if performance.get("status") == "success":
@@ -726,29 +1265,386 @@ class SimpleMultiAgentOrchestrator:
             }
         }
     
-    async def review_pull_request(self, pr_files: List[Dict[str, str]], pr_description: str = "") -> Dict[str, Any]:
-        """Review an entire pull request with multiple files"""
+    async def review_pull_request(self,
+                                  pr_files: List[Dict[str, str]],
+                                  pr_description: str = "",
+                                  max_concurrency: int = None,
+                                  progress: Optional[ReviewProgress] = None,
+                                  pr_ref: Optional[Dict[str, Any]] = None) -> Dict[str, Any]:
+        """Review an entire pull request with multiple files
+        
+        Files are reviewed concurrently (largest first) under the scheduler's
+        concurrency limit. PR-level aggregation always walks the files in their
+        original order, so the consensus does not depend on completion order.
+        
+        Args:
+            pr_files: List of dicts with 'filename', 'content' and optional 'language'
+            pr_description: Description of the pull request
+            max_concurrency: Override the orchestrator's file concurrency limit
+            progress: Progress comment to show early findings and finished files in
+            pr_ref: 'repo' ('owner/name'), 'pr_number' and 'head_sha' of the PR;
+                with a history, unchanged files are taken from it and the
+                review is recorded in it
+        """
         print(f"\nReviewing PR with {len(pr_files)} files")
         print("=" * 60)
         
-        all_reviews = []
         start_time = datetime.now()
         
-        for i, file_info in enumerate(pr_files, 1):
-            print(f"\nReviewing file {i}/{len(pr_files)}: {file_info['filename']}")
-            
-            review = await self.review_code(
-                code=file_info["content"],
-                filename=file_info["filename"],
-                pr_description=pr_description,
-                context={"language": file_info.get("language", "python")}
+        scheduler = self.scheduler
+        if max_concurrency is not None:
+            scheduler = ReviewScheduler(max_concurrency=max_concurrency)
+            scheduler.gate = self.scheduler.gate
+        
+        # Files reviewed before with the same content and settings cost nothing
+        history_keys, stored = await self.find_stored_reviews(pr_files, pr_ref)
+        all_files = pr_files
+        pr_files = [file_info for file_info in pr_files if file_info["filename"] not in stored]
+        
+        completed = len(stored)
+        
+        def on_file_complete(index: int, review: Dict[str, Any]):
+            nonlocal completed
+            completed += 1
+            print(f"\nReviewed file {completed}/{len(all_files)}: {pr_files[index]['filename']} "
+                  f"({review.get('status', 'unknown')})")
+            if progress is not None:
+                progress.file_reviewed(pr_files[index]['filename'], review)
+        
+        # One analysis context per file, shared by the cache prefetch and the review
+        analyses = {
+            file_info["filename"]: AnalysisContext(
+                file_info.get("content") or "", file_info["filename"], self._file_context(file_info)["language"]
             )
-            
-            all_reviews.append(review)
+            for file_info in pr_files
+        }
+        
+        # Files that do not fit into the PR token budget are skipped up front.
+        # Cached responses cost no tokens, so the budget is planned after the
+        # prefetch; static analysis only runs for the files that fit
+        prefetch = asyncio.ensure_future(self.prefetch_cache(pr_files, analyses))
+        if self.max_pr_tokens is not None:
+            await prefetch
+        pr_files, skipped_files = self.plan_token_budget(pr_files, analyses)
+        
+        # The AST pass is shared with the agents, so its findings come for free
+        if progress is not None:
+            for file_info in pr_files:
+                progress.add_findings(file_info["filename"], ast_findings(analyses[file_info["filename"]]))
+            reviewed_files = self.merge_stored_reviews(all_files, pr_files, [], stored)[0]
+            await progress.start([file_info["filename"] for file_info in reviewed_files])
+            for filename, review in stored.items():
+                progress.file_reviewed(filename, review)
+        
+        static_results, _ = await asyncio.gather(self.precompute_static_analysis(pr_files), prefetch)
+        for filename, results in static_results.items():
+            analyses[filename].provide_static_analysis(results)
+        if progress is not None:
+            for filename, results in static_results.items():
+                progress.add_findings(filename, bandit_findings(results))
+            progress.schedule_update()
+        
+        async def review_file(file_info: Dict[str, Any]) -> Dict[str, Any]:
+            context = self._file_context(file_info)
+            context["analysis"] = analyses[file_info["filename"]]
+            with start_span("review_file", filename=file_info["filename"]):
+                return await self.review_code(
+                    code=file_info["content"],
+                    filename=file_info["filename"],
+                    pr_description=pr_description,
+                    context=context
+                )
+        
+        all_reviews = await scheduler.run(pr_files, review_file, on_complete=on_file_complete)
+        pr_files, all_reviews = self.merge_stored_reviews(all_files, pr_files, all_reviews, stored)
+        
+        duration = (datetime.now() - start_time).total_seconds()
+        
+        result = self.aggregate_pr_reviews(all_reviews, pr_files, pr_description, duration, skipped_files)
+        if self.cache_manager is not None:
+            await self.cache_manager.flush()
+        await self.record_review(pr_ref, result, history_keys, stored)
+        return result
+    
+    def history_key(self, file_info: Dict[str, Any]) -> str:
+        """Review history key of a file: its content, its patch when the
+        review is diff-scoped, and every setting that changes the review"""
+        context = self._file_context(file_info)
+        agents = (self.code_reviewer, self.security_checker, self.performance_analyzer)
+        settings = {
+            "language": context["language"],
+            "prompts": [f"{agent.agent_name}:{agent.prompt_version}" for agent in agents],
+            "model": self.code_reviewer.model,
+            "structured_output": self.code_reviewer.structured_output,
+            "fused_review": (self.fused_reviewer.prompt_version, self.fused_review_max_lines)
+            if self.fused_reviewer is not None else None,
+            "light_model": self.router.light_model if self.router is not None else None,
+            "incremental_review": self.incremental_review,
+            "diff_context_lines": self.diff_scoper.context_lines if self.diff_scoped_review else None,
+            "max_request_tokens": self.max_request_tokens
+        }
+        patch = context["patch"] if self.diff_scoped_review else ""
+        return file_review_key(file_info.get("content") or "", settings, patch)
+    
+    async def find_stored_reviews(self,
+                                  pr_files: List[Dict[str, Any]],
+                                  pr_ref: Optional[Dict[str, Any]]) -> Tuple[Dict[str, str],
+                                                                             Dict[str, Dict[str, Any]]]:
+        """Look up the files of a PR in the review history
+        
+        Returns:
+            Tuple of (history key by filename, stored review by filename of
+            the files reviewed before); both empty without a history or pr_ref
+        """
+        if self.history is None or not pr_ref:
+            return {}, {}
+        keys = {file_info["filename"]: self.history_key(file_info) for file_info in pr_files}
         
-        end_time = datetime.now()
-        duration = (end_time - start_time).total_seconds()
+        def lookup():
+            self.history.refresh()
+            return self.history.find_file_reviews(pr_ref["repo"], keys)
         
+        try:
+            with log_performance("review_history_lookup", logger):
+                stored = await asyncio.to_thread(lookup)
+        except Exception as e:
+            logger.warning("Review history lookup failed", error=str(e))
+            stored = {}
+        for filename, review in stored.items():
+            review["filename"] = filename
+        if stored:
+            logger.info("Reusing stored file reviews", stored_files=len(stored), total_files=len(pr_files))
+        return keys, stored
+    
+    @staticmethod
+    def merge_stored_reviews(all_files: List[Dict[str, Any]],
+                             reviewed_files: List[Dict[str, Any]],
+                             reviews: List[Dict[str, Any]],
+                             stored: Dict[str, Dict[str, Any]]) -> Tuple[List[Dict[str, Any]],
+                                                                         List[Dict[str, Any]]]:
+        """Put the stored and the new reviews back into the PR's file order
+        
+        Returns:
+            Tuple of (files, reviews) for aggregate_pr_reviews
+        """
+        by_name = {file_info["filename"]: review for file_info, review in zip(reviewed_files, reviews)}
+        reviewed_names = {file_info["filename"] for file_info in reviewed_files}
+        files = [
+            file_info for file_info in all_files
+            if file_info["filename"] in stored or file_info["filename"] in reviewed_names
+        ]
+        return files, [stored.get(file_info["filename"]) or by_name.get(file_info["filename"]) for file_info in files]
+    
+    async def record_review(self,
+                            pr_ref: Optional[Dict[str, Any]],
+                            result: Dict[str, Any],
+                            history_keys: Dict[str, str],
+                            stored: Dict[str, Dict[str, Any]]):
+        """Record a PR review in the review history (if there is one and a pr_ref)"""
+        if self.history is None or not pr_ref:
+            return
+        try:
+            await asyncio.to_thread(
+                self.history.record_review, pr_ref["repo"], pr_ref.get("pr_number"), pr_ref.get("head_sha"),
+                result, history_keys, reused=stored.keys()
+            )
+        except Exception as e:
+            logger.warning("Could not record the review in the review history", error=str(e))
+    
+    def plan_token_budget(self,
+                          pr_files: List[Dict[str, Any]],
+                          analyses: Optional[Dict[str, AnalysisContext]] = None) -> Tuple[List[Dict[str, Any]],
+                                                                                         List[Dict[str, Any]]]:
+        """Select the files of a PR that fit into the PR token budget
+        
+        Budget is given to the smallest files first, so a single huge (e.g.
+        generated) file cannot crowd out the rest of the PR. Requests already
+        in the local cache are free, so plan after prefetch_cache.
+        
+        Args:
+            pr_files: Files of the PR
+            analyses: Analysis contexts by filename
+        
+        Returns:
+            Tuple of (files to review in their original order, skipped files
+            with 'filename', 'estimated_tokens' and 'reason')
+        """
+        if self.max_pr_tokens is None:
+            return pr_files, []
+        
+        analyses = analyses or {}
+        estimates = {
+            file_info["filename"]: self._estimate_review_tokens(file_info, analyses.get(file_info["filename"]))
+            for file_info in pr_files
+        }
+        budget = TokenBudget(self.max_pr_tokens)
+        selected = set()
+        skipped = []
+        for file_info in sorted(pr_files, key=lambda f: estimates[f["filename"]]):
+            filename = file_info["filename"]
+            if budget.try_reserve(estimates[filename]):
+                selected.add(filename)
+            else:
+                skipped.append({
+                    "filename": filename,
+                    "estimated_tokens": estimates[filename],
+                    "reason": f"PR token budget of {self.max_pr_tokens} tokens exceeded"
+                })
+        
+        if skipped:
+            logger.warning("Skipping files over the PR token budget",
+                          skipped=[entry["filename"] for entry in skipped],
+                          budget=self.max_pr_tokens,
+                          used=budget.used)
+        return [f for f in pr_files if f["filename"] in selected], skipped
+    
+    def _estimate_review_tokens(self, file_info: Dict[str, Any],
+                                analysis: Optional[AnalysisContext] = None) -> int:
+        """Estimated input tokens of the model requests for reviewing a file
+        
+        Requests answered from the local cache are not counted, nor are
+        incremental reviews whose units are all unchanged.
+        """
+        code = file_info.get("content") or ""
+        context = self._file_context(file_info)
+        if self.incremental_review and self.cache_manager is not None:
+            analysis = analysis or AnalysisContext(code, file_info.get("filename", "unknown"), context["language"])
+            units = analysis.units() if analysis.supports_structure else None
+            unit_keys = [self._unit_cache_key(unit, context["language"]) for unit in units or [] if unit.has_code]
+            if unit_keys and all(self._is_cached(key) for key in unit_keys):
+                return 0
+        
+        review_input = code
+        if self.diff_scoped_review and context["patch"]:
+            analysis = analysis or AnalysisContext(code, file_info.get("filename", "unknown"), context["language"])
+            scope = self.diff_scoper.scope(code, context["patch"], context["language"],
+                                           analysis.ast_results() if analysis.supports_structure else None)
+            if scope:
+                review_input = scope.code
+        
+        if self._prompt_overhead_tokens is None:
+            self._prompt_overhead_tokens = {
+                agent.agent_name: count_tokens(agent._get_system_message(), agent.model)
+                for agent in (self.code_reviewer, self.security_checker, self.performance_analyzer,
+                              self.fused_reviewer) if agent is not None
+            }
+        
+        code_tokens = count_tokens(review_input, self.code_reviewer.model)
+        if self._use_fused_review(review_input):
+            agents = [self.fused_reviewer]
+        else:
+            agents = [self.code_reviewer, self.security_checker, self.performance_analyzer]
+        return sum(code_tokens + self._prompt_overhead_tokens[agent.agent_name]
+                   for agent in agents if not self._is_cached(agent.cache_key(review_input, context)))
+    
+    def _is_cached(self, key: Optional[str]) -> bool:
+        """Whether a cache entry is held locally (e.g. after prefetch_cache)"""
+        return key is not None and self.cache_manager is not None and self.cache_manager.contains(key)
+    
+    @staticmethod
+    def _file_context(file_info: Dict[str, Any]) -> Dict[str, Any]:
+        """Review context for a PR file"""
+        return {
+            "language": file_info.get("language", "python"),
+            "patch": file_info.get("patch", "")
+        }
+    
+    def _candidate_cache_keys(self, file_info: Dict[str, Any],
+                              analysis: Optional[AnalysisContext] = None) -> List[str]:
+        """Cache keys a review of this file is likely to look up"""
+        code = file_info.get("content") or ""
+        context = self._file_context(file_info)
+        language = context["language"]
+        analysis = analysis or AnalysisContext(code, file_info.get("filename", "unknown"), language)
+        agents = (self.code_reviewer, self.security_checker, self.performance_analyzer)
+        
+        review_inputs = [code]
+        if self.diff_scoped_review and context["patch"]:
+            scope = self.diff_scoper.scope(code, context["patch"], language,
+                                           analysis.ast_results() if analysis.supports_structure else None)
+            if scope:
+                review_inputs.append(scope.code)
+        
+        keys = [agent.cache_key(review_input, context) for review_input in review_inputs for agent in agents]
+        keys.extend(
+            self.fused_reviewer.cache_key(review_input, context)
+            for review_input in review_inputs if self._use_fused_review(review_input)
+        )
+        if self.router is not None and self.router.triage_agent is not None:
+            keys.extend(self.router.triage_agent.cache_key(review_input, context) for review_input in review_inputs)
+        
+        if self.incremental_review and analysis.supports_structure:
+            keys.extend(
+                self._unit_cache_key(unit, language)
+                for unit in (analysis.units() or []) if unit.has_code
+            )
+        return keys
+    
+    async def prefetch_cache(self, pr_files: List[Dict[str, Any]],
+                             analyses: Optional[Dict[str, AnalysisContext]] = None) -> int:
+        """Load the cache entries for all files of a PR in one batch
+        
+        Args:
+            pr_files: Files of the PR
+            analyses: Analysis contexts by filename, reused for the unit split
+        
+        Returns:
+            Number of candidate entries that are now available locally
+        """
+        if self.cache_manager is None:
+            return 0
+        
+        analyses = analyses or {}
+        keys = [
+            key for file_info in pr_files
+            for key in self._candidate_cache_keys(file_info, analyses.get(file_info["filename"]))
+        ]
+        with log_performance("cache_prefetch", logger):
+            found = await self.cache_manager.prefetch_async(keys)
+        logger.info("Prefetched review cache", candidate_keys=len(keys), found=found)
+        return found
+    
+    async def precompute_static_analysis(self, pr_files: List[Dict[str, Any]]) -> Dict[str, Dict[str, Any]]:
+        """Run static analysis over all Python files of a PR in one batch
+        
+        Runs in a worker thread so the tools do not block other reviews.
+        
+        Returns:
+            Static analysis results keyed by filename (passed to the security
+            checker as context["static_analysis"])
+        """
+        python_files = [
+            {"filename": file_info["filename"], "content": file_info.get("content") or ""}
+            for file_info in pr_files
+            if file_info.get("language", "python") == "python"
+        ]
+        if not python_files:
+            return {}
+        
+        try:
+            with log_performance("static_analysis_batch", logger):
+                return await asyncio.to_thread(run_static_analysis_batch, python_files)
+        except Exception as e:
+            # The security checker falls back to per-file analysis
+            logger.warning("Batched static analysis failed", error=str(e))
+            return {}
+    
+    def aggregate_pr_reviews(self,
+                             all_reviews: List[Dict[str, Any]],
+                             pr_files: List[Dict[str, Any]],
+                             pr_description: str = "",
+                             duration: float = 0.0,
+                             skipped_files: Optional[List[Dict[str, Any]]] = None) -> Dict[str, Any]:
+        """Combine per-file reviews into the PR-level consensus and report
+        
+        Args:
+            all_reviews: File review results, in the same order as pr_files
+            pr_files: The files that were reviewed
+            pr_description: Description of the pull request
+            duration: Wall-clock time spent reviewing the files, in seconds
+            skipped_files: Files left out by plan_token_budget (noted in the report)
+        """
+        skipped_files = skipped_files or []
         # Aggregate all findings for PR-level consensus
         all_agent_findings = {
             "code_reviewer": [],
@@ -757,26 +1653,16 @@ class SimpleMultiAgentOrchestrator:
         }
         
         for review in all_reviews:
-            if review.get("status") == "success":
-                # Get the actual parsed findings from each file review
-                orchestrator_results = review.get("orchestrator_results", {})
-                agent_results = orchestrator_results.get("agent_results", {})
-                
-                # Extract findings from each agent
-                for agent_name in all_agent_findings:
-                    agent_data = agent_results.get(agent_name, {})
-                    if agent_data.get("status") == "success":
-                        # Parse the findings from the agent's analysis
-                        if agent_name == "code_reviewer":
-                            analysis_text = agent_data.get("review", "")
-                        else:
-                            analysis_text = agent_data.get("analysis", "")
-                        
-                        findings = self._parse_findings_from_text(str(analysis_text), agent_name)
-                        all_agent_findings[agent_name].extend(findings)
+            for agent_name, findings in self._collect_pr_findings(review).items():
+                # Line numbers are per file, so the consensus groups by file
+                all_agent_findings[agent_name].extend(
+                    dict(finding, filename=review.get("filename")) if isinstance(finding, dict) else finding
+                    for finding in findings
+                )
         
         # Apply PR-level consensus
-        pr_consensus = self.consensus.resolve_conflicts(all_agent_findings)
+        with log_performance("pr_consensus_mechanism", logger):
+            pr_consensus = self.consensus.resolve_conflicts(all_agent_findings)
         
         # Generate PR-level report
         pr_orchestrator_results = {
@@ -784,6 +1670,7 @@ class SimpleMultiAgentOrchestrator:
             "total_duration_seconds": duration,
             "average_duration_per_file": duration / len(pr_files) if pr_files else 0,
             "file_reviews": all_reviews,
+            "skipped_files": skipped_files,
             "overall_summary": self._generate_pr_summary_from_consensus(pr_consensus, all_reviews)
         }
         
@@ -792,7 +1679,7 @@ class SimpleMultiAgentOrchestrator:
             pr_consensus,
             {
                 "title": pr_description,
-                "files_changed": len(pr_files),
+                "files_changed": len(pr_files) + len(skipped_files),
                 "author": "Test User"
             }
         )
@@ -802,11 +1689,69 @@ class SimpleMultiAgentOrchestrator:
             "files_reviewed": len(pr_files),
             "total_duration_seconds": duration,
             "file_reviews": all_reviews,
+            "skipped_files": skipped_files,
             "pr_consensus": pr_consensus,
             "markdown_report": pr_report,
-            "overall_summary": pr_orchestrator_results["overall_summary"]
+            "overall_summary": pr_orchestrator_results["overall_summary"],
+            "cache_stats": self._summarize_agent_cache(all_reviews),
+            "routing_stats": summarize_routes(
+                [review["review_route"] for review in all_reviews if review.get("review_route")]
+            ) if self.router is not None else None
         }
     
+    def _summarize_agent_cache(self, all_reviews: List[Dict[str, Any]]) -> Dict[str, Any]:
+        """Count agent calls answered from the cache across file reviews"""
+        total = cached = 0
+        for review in all_reviews:
+            if review.get("status") != "success":
+                continue
+            total += len(review.get("orchestrator_results", {}).get("agent_results", {}))
+            cached += len(review.get("cached_agents", []))
+        
+        return {
+            "agent_calls": total,
+            "cached_agent_calls": cached,
+            "hit_rate": cached / total if total else 0
+        }
+    
+    def _collect_pr_findings(self, review: Dict[str, Any]) -> Dict[str, List[Dict[str, Any]]]:
+        """Extract the findings of a single file review for PR-level consensus"""
+        findings = {}
+        if review.get("status") != "success":
+            return findings
+        
+        # The file review's own findings: structured or parsed, remapped from
+        # excerpts and chunks, merged with the cached units
+        if review.get("agent_findings") is not None:
+            return review["agent_findings"]
+        
+        # Results without them (e.g. from workers of an older deployment)
+        if review.get("unit_review"):
+            return review["unit_review"]["findings"]
+        
+        orchestrator_results = review.get("orchestrator_results", {})
+        agent_results = orchestrator_results.get("agent_results", {})
+        
+        for agent_name in ("code_reviewer", "security_checker", "performance_analyzer"):
+            agent_data = agent_results.get(agent_name, {})
+            if agent_data.get("status") == "success":
+                if isinstance(agent_data.get("issues"), list):
+                    findings[agent_name] = agent_data["issues"]
+                    continue
+                if agent_name == "code_reviewer":
+                    analysis_text = agent_data.get("review", "")
+                else:
+                    analysis_text = agent_data.get("analysis", "")
+                
+                findings[agent_name] = self._parse_findings_from_text(str(analysis_text), agent_name)
+        
+        # Diff-scoped reviews report excerpt line numbers
+        review_scope = review.get("review_scope", {})
+        if review_scope.get("mode") == "diff":
+            findings = self._remap_findings(findings, ScopedCode.from_dict(review_scope))
+        
+        return findings
+    
     def _generate_pr_summary_from_consensus(self, pr_consensus: Dict[str, Any], file_reviews: List[Dict[str, Any]]) -> Dict[str, Any]:
         """Generate overall PR summary from consensus results"""
         # Count issues by type from consensus
@@ -899,4 +1844,28 @@ class SimpleMultiAgentOrchestrator:
             "failed_files": failed_files,
             "successful_files": successful_files,
             "success_rate": len(successful_files) / len(file_reviews) if file_reviews else 0
-        }
\ No newline at end of file
+        }
+
+# Orchestrators by their options, reused for every review in the process
+_orchestrator_pool: Dict[Tuple, SimpleMultiAgentOrchestrator] = {}
+
+
+def get_orchestrator(**options) -> SimpleMultiAgentOrchestrator:
+    """Get the pooled orchestrator for a set of options
+    
+    Building an orchestrator creates its agents and model clients; warm
+    workers (e.g. Modal containers) reuse them across requests instead.
+    Reviews do not carry conversation state over, since every model call
+    runs on a fresh AssistantAgent over the pooled model client.
+    
+    Args:
+        **options: SimpleMultiAgentOrchestrator keyword arguments
+    
+    Returns:
+        The orchestrator created for these options on first use
+    """
+    key = tuple(sorted(options.items()))
+    if key not in _orchestrator_pool:
+        logger.info("Creating pooled orchestrator", pool_size=len(_orchestrator_pool) + 1)
+        _orchestrator_pool[key] = SimpleMultiAgentOrchestrator(**options)
+    return _orchestrator_pool[key]
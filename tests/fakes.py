@@ -0,0 +1,176 @@
+"""
+Fakes shared by the test modules: review agents and orchestrators whose
+model calls are counted or scripted instead of sent, and an in-memory
+modal.Dict
+"""
+
+import asyncio
+import json
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from agents.base_agent import BaseReviewAgent
+from agents.triage_agent import TriageAgent
+from orchestrator import SimpleMultiAgentOrchestrator
+from utils.cache_manager import CacheManager
+
+
+FINDINGS_JSON = json.dumps({
+    "summary": "One injection issue.",
+    "findings": [
+        {"title": "SQL injection", "severity": "critical", "location": "load_user",
+         "line_start": 4, "line_end": 6, "description": "Query built with an f-string",
+         "solution": "Use a parameterized query", "complexity": None},
+        {"title": "Broad except", "severity": "low", "location": "main",
+         "line_start": 12, "line_end": 12, "description": "Errors are hidden",
+         "solution": "Catch specific exceptions", "complexity": None}
+    ]
+})
+
+
+def scripted_result(content):
+    """Agent run result whose last message has the given content"""
+
+    class FakeMessage:
+        pass
+
+    class FakeResult:
+        messages = [FakeMessage()]
+
+    FakeMessage.content = content
+    return FakeResult()
+
+
+def scripted_assistant(response, calls):
+    """Assistant stand-in answering every task with the response and recording the tasks"""
+
+    class FakeAssistant:
+        async def run(self, task):
+            calls.append(task)
+            return scripted_result(response)
+
+    return FakeAssistant()
+
+
+class ScriptedAgent(BaseReviewAgent):
+    """Review agent whose model calls are counted instead of sent
+
+    Without a response every call answers with its own text ("response N"),
+    otherwise with a message carrying the response.
+    """
+
+    agent_name = "scripted_agent"
+    finding_type = "security"
+
+    def __init__(self, cache_manager, response=None, structured_output=False):
+        self.calls = 0
+        self.response = response
+        super().__init__(api_key="test-key", cache_manager=cache_manager, structured_output=structured_output)
+
+    def _get_system_message(self):
+        return "Test agent"
+
+    def _create_agent(self, model=None, structured=None):
+        owner = self
+
+        class FakeAssistant:
+            async def run(self, task):
+                owner.calls += 1
+                if owner.response is None:
+                    return f"response {owner.calls}"
+                return scripted_result(owner.response)
+
+        return FakeAssistant()
+
+
+class FakeModalDict:
+    """In-memory stand-in for modal.Dict that counts round trips"""
+
+    class _Method:
+        def __init__(self, func):
+            self.aio = func
+
+    def __init__(self):
+        self.data = {}
+        self.reads = 0
+        self.updates = 0
+
+        async def get(key, default=None):
+            self.reads += 1
+            await asyncio.sleep(0.01)
+            return self.data.get(key, default)
+
+        async def update(**items):
+            self.updates += 1
+            self.data.update(items)
+
+        async def put(key, value):
+            self.updates += 1
+            self.data[key] = value
+
+        async def items():
+            for item in list(self.data.items()):
+                yield item
+
+        self.get = self._Method(get)
+        self.update = self._Method(update)
+        self.put = self._Method(put)
+        self.items = self._Method(items)
+
+
+class AnsweringTriageAgent(TriageAgent):
+    """Triage agent whose model answers with fixed text"""
+
+    def __init__(self, answer):
+        self.answer = answer
+        super().__init__(api_key="test-key")
+
+    def _create_agent(self, model=None):
+        owner = self
+
+        class FakeAssistant:
+            async def run(self, task):
+                return owner.answer
+
+        return FakeAssistant()
+
+
+def consensus_review(filename, *recs):
+    """File review result with the given (severity, line_numbers) recommendations"""
+    return {"status": "success", "filename": filename, "consensus_results": {"recommendations": [
+        {"consensus_severity": severity, "line_numbers": lines, "description": f"Issue at {lines}",
+         "solution": "Fix it", "contributing_agents": ["security_checker"]}
+        for severity, lines in recs
+    ]}}
+
+
+def consensus_finding(description, line=None, filename=None, type="security", severity="high"):
+    """Agent finding as the consensus receives it"""
+    finding = {"type": type, "severity": severity, "description": description, "solution": "Fix it",
+               "location": "", "line_numbers": [line] if line else []}
+    if filename:
+        finding["filename"] = filename
+    return finding
+
+
+def scripted_orchestrator(cache=None, calls=None, **options):
+    """Structured orchestrator whose agents answer with FINDINGS_JSON
+
+    The tasks sent to the model are recorded in `calls`; without a list any
+    model call fails the test.
+    """
+    orchestrator = SimpleMultiAgentOrchestrator(api_key="test-key",
+                                               cache_manager=cache if cache is not None else CacheManager(),
+                                               structured_output=True, **options)
+
+    def create_agent(*args, **kwargs):
+        if calls is None:
+            raise AssertionError("an agent called the model")
+        return scripted_assistant(FINDINGS_JSON, calls)
+
+    for agent in (orchestrator.code_reviewer, orchestrator.security_checker, orchestrator.performance_analyzer):
+        agent._create_agent = create_agent
+    return orchestrator
@@ -0,0 +1,83 @@
+"""
+Test cases for the parse-once analysis context shared by the agents
+"""
+
+import asyncio
+import pytest
+import sys
+import os
+import time
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.analysis_context import AnalysisContext
+from utils.ast_analyzer import analyze_python_code
+
+
+class TestAnalysisContext:
+    """Test the memoized per-file analysis context"""
+
+    CODE = "import os\n\ndef load(path):\n    return open(path).read()\n\nclass Store:\n    def get(self):\n        return 1\n"
+
+    def test_parses_once_for_ast_and_units(self):
+        """Test that AST metrics and code units share a single parse"""
+        import ast
+        original_parse = ast.parse
+        parse_calls = []
+
+        def counting_parse(*args, **kwargs):
+            parse_calls.append(1)
+            return original_parse(*args, **kwargs)
+
+        ast.parse = counting_parse
+        try:
+            analysis = AnalysisContext(self.CODE, "store.py")
+            ast_results = analysis.ast_results()
+            units = analysis.units()
+            assert analysis.ast_results() is ast_results
+        finally:
+            ast.parse = original_parse
+
+        assert len(parse_calls) == 1
+        assert ast_results == analyze_python_code(self.CODE)
+        assert [unit.name for unit in units] == ["load", "Store.get", "Store", "<module>"]
+        assert analysis.line(3) == "def load(path):"
+
+    def test_syntax_error_matches_analyzer(self):
+        """Test that unparseable code reports the same error as analyze_python_code"""
+        analysis = AnalysisContext("def broken(:\n", "broken.py")
+        assert analysis.units() is None
+        assert analysis.ast_results() == analyze_python_code("def broken(:\n")
+
+    @pytest.mark.asyncio
+    async def test_static_analysis_shared_between_callers(self):
+        """Test that concurrent callers share one static analysis run"""
+        from utils import analysis_context
+        original = analysis_context.run_static_analysis
+        runs = []
+
+        def fake_static_analysis(code, filename):
+            runs.append(filename)
+            time.sleep(0.02)
+            return {"filename": filename, "analyses": {}}
+
+        analysis_context.run_static_analysis = fake_static_analysis
+        try:
+            analysis = AnalysisContext(self.CODE, "store.py")
+            analysis.start_static_analysis()
+            first, second = await asyncio.gather(analysis.static_analysis(), analysis.static_analysis())
+
+            provided = AnalysisContext(self.CODE, "other.py")
+            provided.provide_static_analysis({"filename": "other.py", "analyses": {"bandit": {}}})
+            precomputed = await provided.static_analysis()
+        finally:
+            analysis_context.run_static_analysis = original
+
+        assert runs == ["store.py"]
+        assert first is second
+        assert precomputed["analyses"] == {"bandit": {}}
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
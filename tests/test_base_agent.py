@@ -0,0 +1,148 @@
+"""
+Test cases for the shared review agent behaviour:
+- Content-addressed per-agent result cache
+- Structured (JSON schema) agent responses
+- Token usage read from the responses
+- Shared model clients and fresh agents per task
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from agents.base_agent import BaseReviewAgent
+from utils.cache_manager import CacheManager
+from tests.fakes import FINDINGS_JSON, ScriptedAgent
+
+
+class TestAgentCache:
+    """Test content-addressed caching of agent calls"""
+
+    def test_key_ignores_formatting_only_changes(self):
+        """Test that line endings and trailing whitespace do not change the key"""
+        cache = CacheManager()
+        key = cache.generate_agent_cache_key("def foo():\n    pass\n", "code_reviewer", "1", "gpt-4o")
+
+        assert cache.generate_agent_cache_key("def foo():  \r\n    pass", "code_reviewer", "1", "gpt-4o") == key
+        assert cache.generate_agent_cache_key("def foo():\n    return", "code_reviewer", "1", "gpt-4o") != key
+
+    def test_key_depends_on_agent_prompt_and_model(self):
+        """Test that agent type, prompt version and model are part of the key"""
+        cache = CacheManager()
+        key = cache.generate_agent_cache_key("x = 1", "code_reviewer", "1", "gpt-4o")
+
+        assert cache.generate_agent_cache_key("x = 1", "security_checker", "1", "gpt-4o") != key
+        assert cache.generate_agent_cache_key("x = 1", "code_reviewer", "2", "gpt-4o") != key
+        assert cache.generate_agent_cache_key("x = 1", "code_reviewer", "1", "gpt-4o-mini") != key
+
+    @pytest.mark.asyncio
+    async def test_unchanged_code_costs_no_api_calls(self):
+        """Test that a repeated review is answered from the cache"""
+        agent = ScriptedAgent(CacheManager())
+
+        # Prompts differ (e.g. a new PR description) but the code unit is the same
+        text, info = await agent._run_review("prompt with description A", "x = 1")
+        assert info["from_cache"] is False
+
+        cached_text, cached_info = await agent._run_review("prompt with description B", "x = 1")
+        assert cached_info["from_cache"] is True
+        assert cached_text == text
+        assert agent.calls == 1
+
+        await agent._run_review("prompt", "x = 2")
+        assert agent.calls == 2
+
+
+class TestStructuredOutput:
+    """Test schema-validated agent responses"""
+
+    @pytest.mark.asyncio
+    async def test_structured_findings_are_cached(self):
+        """Test that findings come back from the cache and text-mode entries are not reused"""
+        cache = CacheManager()
+        agent = ScriptedAgent(cache, FINDINGS_JSON, structured_output=True)
+        structured_key = agent.cache_key("x = 1")
+        agent.structured_output = False
+        assert agent.cache_key("x = 1") != structured_key
+        agent.structured_output = True
+
+        text, info = await agent._run_review("prompt", "x = 1")
+        assert "SQL injection" in text
+        assert [i["severity"] for i in agent._structured_issues(info)] == ["critical", "low"]
+
+        _, cached_info = await agent._run_review("prompt", "x = 1")
+        assert cached_info["from_cache"] is True
+        assert cached_info["findings"] == info["findings"]
+        assert agent.calls == 1
+
+    @pytest.mark.asyncio
+    async def test_invalid_response_falls_back_to_text(self):
+        """Test that a response that does not match the schema is kept as text"""
+        agent = ScriptedAgent(None, "ISSUE: not json", structured_output=True)
+        text, info = await agent._run_review("prompt", "x = 1")
+        assert text == "ISSUE: not json"
+        assert info["findings"] is None
+        assert agent._structured_issues(info) is None
+
+
+class TestResponseUsage:
+    """Test reading token usage from agent responses"""
+
+    def test_usage_is_read_from_the_response(self):
+        """Test that token counts come from the messages' models_usage when present"""
+
+        class Usage:
+            prompt_tokens = 1500
+            completion_tokens = 320
+
+        class Message:
+            models_usage = Usage()
+
+        class Result:
+            messages = [type("UserMessage", (), {"models_usage": None})(), Message()]
+
+        assert BaseReviewAgent._response_usage(Result()) == {
+            "prompt_tokens": 1500, "completion_tokens": 320
+        }
+        assert BaseReviewAgent._response_usage("plain text") is None
+
+
+class TestAgentPool:
+    """Test reuse of model clients across agents and fresh agents per task"""
+
+    def test_model_clients_are_shared_across_agents(self):
+        """Test that agents with the same key and model share one client"""
+        first = ScriptedAgent(CacheManager())
+        second = ScriptedAgent(CacheManager())
+        assert first.model_client is second.model_client
+        assert first._get_model_client("gpt-4o-mini") is second._get_model_client("gpt-4o-mini")
+
+    @pytest.mark.asyncio
+    async def test_tasks_do_not_share_conversation_state(self, monkeypatch):
+        """Test that every task runs on a fresh free-text agent"""
+        agent = ScriptedAgent(CacheManager(), structured_output=True)
+        runs = []
+
+        def create_agent(model=None, structured=None):
+            history = []
+
+            class RememberingAssistant:
+                async def run(self, task):
+                    history.append(task)
+                    runs.append((structured, list(history)))
+                    return task
+
+            return RememberingAssistant()
+
+        monkeypatch.setattr(agent, "_create_agent", create_agent)
+
+        await agent._run_task("first task")
+        await agent._run_task("second task")
+        assert runs == [(False, ["first task"]), (False, ["second task"])]
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
@@ -0,0 +1,160 @@
+"""
+Test cases for resumable repository audits through the Batch API
+"""
+
+import json
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.batch_audit import BatchAudit, walk_snapshot, DONE_PHASE, BATCHES_PHASE
+from utils.cache_manager import CacheManager
+from tests.fakes import FINDINGS_JSON, scripted_orchestrator
+
+
+AUDIT_CODE = {
+    "app/db.py": "def load_user(db, user_id):\n    return db.query(f\"SELECT * FROM users WHERE id = {user_id}\")\n",
+    "app/util.py": "def add(a, b):\n    return a + b\n"
+}
+
+
+class FakeBatchClient:
+    """Batch API answering every request with the same content once finished"""
+
+    def __init__(self, content, drop=0):
+        self.content = content
+        self.batches = {}
+        self.finished = False
+        self.drop = drop
+
+    async def submit(self, name, data, metadata):
+        batch_id = f"batch_{len(self.batches)}"
+        self.batches[batch_id] = [json.loads(line) for line in data.decode().splitlines()]
+        return batch_id
+
+    async def status(self, batch_id):
+        if not self.finished:
+            return {"status": "in_progress"}
+        return {"status": "completed", "output_file_id": batch_id, "error_file_id": None, "errors": []}
+
+    async def download(self, file_id):
+        requests = self.batches[file_id]
+        # The first `drop` requests of the first batch get no answer
+        if file_id == "batch_0":
+            requests = requests[self.drop:]
+        return "\n".join(json.dumps({
+            "custom_id": request["custom_id"],
+            "response": {"status_code": 200, "body": {
+                "model": request["body"]["model"],
+                "choices": [{"message": {"content": self.content}}],
+                "usage": {"prompt_tokens": 1000, "completion_tokens": 100}
+            }}
+        }) for request in requests)
+
+
+async def no_sleep(seconds):
+    pass
+
+
+def write_snapshot(root):
+    for filename, code in AUDIT_CODE.items():
+        os.makedirs(os.path.dirname(os.path.join(root, filename)), exist_ok=True)
+        with open(os.path.join(root, filename), "w") as f:
+            f.write(code)
+    os.makedirs(os.path.join(root, "node_modules"))
+    with open(os.path.join(root, "node_modules", "lib.js"), "w") as f:
+        f.write("var x = 1;")
+    with open(os.path.join(root, "app", "blob.py"), "wb") as f:
+        f.write(b"\xff\xfe\x00")
+
+
+class TestBatchAudit:
+    """Test resumable audits through the Batch API"""
+
+    def test_snapshot_walk(self, tmp_path):
+        """Test that dependencies are excluded and binary files skipped"""
+        write_snapshot(str(tmp_path))
+        snapshot = walk_snapshot(str(tmp_path))
+        assert [f["filename"] for f in snapshot["files"]] == ["app/db.py", "app/util.py"]
+        assert snapshot["skipped"] == [{"filename": "app/blob.py", "reason": "not UTF-8 text"}]
+
+    @pytest.mark.asyncio
+    async def test_audit_resumes_and_reports_from_the_batch(self, tmp_path):
+        """Test that recorded requests are batched, collected after a restart and reported"""
+        snapshot_dir = str(tmp_path / "repo")
+        write_snapshot(snapshot_dir)
+        cache = CacheManager(ttl=None)
+        client = FakeBatchClient(FINDINGS_JSON, drop=1)
+        audit_dir = str(tmp_path / "audit")
+
+        first = BatchAudit(scripted_orchestrator(cache, incremental_review=True), audit_dir, client,
+                           group_size=1, max_batch_requests=4)
+        state = await first.step(snapshot_dir)
+        assert state["phase"] == BATCHES_PHASE
+        assert state["requests"] == 6
+        assert [part["requests"] for part in state["parts"]] == [4, 2]
+        assert all(part["status"] == "submitted" for part in state["parts"])
+
+        # A new process picks the audit up from its state file
+        client.finished = True
+        resumed = BatchAudit(scripted_orchestrator(cache, incremental_review=True), audit_dir, client, group_size=1)
+        state = await resumed.step()
+        # The unanswered request is submitted again
+        assert state["phase"] == BATCHES_PHASE
+        assert [part["requests"] for part in state["parts"]] == [4, 2, 1]
+        assert state["parts"][2]["attempt"] == 2
+
+        state = await resumed.step()
+        assert state["phase"] == DONE_PHASE
+        assert state["usage"]["answered"] == 6
+        assert state["usage"]["cost"] == pytest.approx(6 * 0.0035 * 0.5)
+
+        with open(os.path.join(audit_dir, "report.json")) as f:
+            summary = json.load(f)
+        assert summary["files_reviewed"] == 2
+        assert summary["skipped_files"][0]["filename"] == "app/blob.py"
+        assert {rec["filename"] for rec in summary["recommendations"]} == {"app/db.py", "app/util.py"}
+        with open(os.path.join(audit_dir, "report.md")) as f:
+            assert "SQL injection" in f.read()
+
+    @pytest.mark.asyncio
+    async def test_reviewed_units_are_not_requested_again(self, tmp_path):
+        """Test that a second audit of unchanged code needs no batch"""
+        snapshot_dir = str(tmp_path / "repo")
+        write_snapshot(snapshot_dir)
+        cache = CacheManager(ttl=None)
+        client = FakeBatchClient(FINDINGS_JSON)
+        client.finished = True
+        await BatchAudit(scripted_orchestrator(cache, incremental_review=True), str(tmp_path / "first"), client).run(
+            snapshot_dir, sleep=no_sleep)
+
+        state = await BatchAudit(scripted_orchestrator(cache, incremental_review=True), str(tmp_path / "second"),
+                                 client).step(snapshot_dir)
+        assert state["phase"] == DONE_PHASE
+        assert state["requests"] == 0 and state["parts"] == []
+
+    @pytest.mark.asyncio
+    async def test_unanswered_requests_are_reported_not_sent(self, tmp_path):
+        """Test that the report phase lists requests no batch answered instead of sending them"""
+        snapshot_dir = str(tmp_path / "repo")
+        write_snapshot(snapshot_dir)
+        client = FakeBatchClient(FINDINGS_JSON, drop=1)
+        client.finished = True
+        calls = []
+        audit_dir = str(tmp_path / "audit")
+        state = await BatchAudit(scripted_orchestrator(CacheManager(ttl=None), calls, incremental_review=True),
+                                 audit_dir, client, max_attempts=1).run(snapshot_dir, sleep=no_sleep)
+        assert state["phase"] == DONE_PHASE
+        assert calls == []
+
+        with open(os.path.join(audit_dir, "report.json")) as f:
+            summary = json.load(f)
+        first_request = client.batches["batch_0"][0]["custom_id"]
+        assert [request["id"] for request in summary["unanswered_requests"]] == [first_request]
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
@@ -0,0 +1,102 @@
+"""
+Test cases for the record/replay benchmark fixtures and load harness
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from agents.base_agent import BaseReviewAgent
+from benchmarks.fixtures import (FixtureStore, FixtureAgent, FixtureTransport, LatencyModel, REPLAY,
+                                 fixture_client, fixture_key, llm_fixtures, synthetic_pr)
+from benchmarks.run_benchmarks import percentile
+from utils.github_integration import GitHubIntegration
+from utils.review_schema import parse_review_findings
+from tests.fakes import AnsweringTriageAgent, FINDINGS_JSON, ScriptedAgent
+
+
+class TestBenchmarkFixtures:
+    """Test the recorded fixtures and helpers of the benchmark harness"""
+
+    def test_latency_model(self):
+        """Test fixed, recorded and default delays and repeatable jitter"""
+        assert LatencyModel(seconds=0.5).delay(2.0) == 0.5
+        assert LatencyModel(default=0.1).delay(2.0) == 2.0
+        assert LatencyModel(default=0.1).delay() == 0.1
+
+        first = [LatencyModel(seconds=1.0, jitter=0.2, seed=7).delay() for _ in range(2)]
+        assert first[0] == first[1]
+        assert 0.8 <= first[0] <= 1.2
+
+    def test_store_round_trip(self, tmp_path):
+        """Test that saved fixtures load back and strict stores fail on misses"""
+        path = str(tmp_path / "fixtures.json")
+        store = FixtureStore(path)
+        store.llm["k"] = {"content": "ok", "prompt_tokens": 3, "completion_tokens": 1}
+        store.save()
+        assert FixtureStore(path).llm == store.llm
+
+        store.miss("llm", "agent")
+        assert store.misses["llm"] == 1
+        with pytest.raises(KeyError):
+            FixtureStore(strict=True).miss("http", "GET /x")
+
+    def test_percentile(self):
+        """Test nearest-rank percentiles"""
+        values = list(range(1, 101))
+        assert percentile(values, 0.5) == 50
+        assert percentile(values, 0.99) == 99
+        assert percentile([3.0], 0.9) == 3.0
+        assert percentile([], 0.5) is None
+
+    @pytest.mark.asyncio
+    async def test_replayed_and_stand_in_responses(self):
+        """Test that recorded runs replay with their usage and others get valid stand-ins"""
+        agent = ScriptedAgent(None, "unused", structured_output=True)
+        store = FixtureStore()
+        store.llm[fixture_key(agent.agent_name, "gpt-4o", True, "task")] = {
+            "content": FINDINGS_JSON, "prompt_tokens": 120, "completion_tokens": 40,
+            "duration": None
+        }
+        replay = FixtureAgent(agent, "gpt-4o", True, store, REPLAY, LatencyModel())
+
+        result = await replay.run("task")
+        assert result.messages[-1].content == FINDINGS_JSON
+        assert BaseReviewAgent._response_usage(result) == {"prompt_tokens": 120, "completion_tokens": 40}
+
+        result = await replay.run("another task")
+        assert parse_review_findings(result.messages[-1].content).findings == []
+        assert store.misses["llm"] == 1
+
+        triage = FixtureAgent(AnsweringTriageAgent("LIGHT"), "gpt-4o-mini", False, store, REPLAY, LatencyModel())
+        assert (await triage.run("task")).messages[-1].content == "DEEP"
+
+    def test_llm_fixtures_restores_agents(self):
+        """Test that agents create fixture agents only while the fixtures are active"""
+        original = BaseReviewAgent._create_agent
+        with llm_fixtures(FixtureStore()):
+            assert isinstance(BaseReviewAgent._create_agent(ScriptedAgent(None, "", structured_output=True)), FixtureAgent)
+        assert BaseReviewAgent._create_agent is original
+
+    @pytest.mark.asyncio
+    async def test_synthetic_pr_is_served_and_posts_stay_local(self):
+        """Test that a synthetic PR is fetched from the fixtures and reviews are not sent"""
+        store = FixtureStore()
+        synthetic_pr(store, "acme", "api", 7, files=2, lines_per_file=30)
+        transport = FixtureTransport(store)
+        github = GitHubIntegration(github_token="test-token")
+        github._client = fixture_client(transport)
+
+        files = await github.get_pr_files("acme", "api", 7)
+        assert len(files) == 2
+        assert store.misses["http"] == 0
+
+        await github.post_review_comment("acme", "api", 7, "Review")
+        assert transport.posted and transport.posted[0]["method"] == "POST"
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
@@ -0,0 +1,156 @@
+"""
+Test cases for the local and distributed review caches
+"""
+
+import pytest
+import sys
+import os
+import time
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.cache_manager import CacheManager, ModalCacheManager, CacheEntry, serialize_entry, deserialize_entry
+from tests.fakes import FakeModalDict
+
+
+class TestCacheLRU:
+    """Test LRU eviction and the memory budget of the local cache"""
+
+    def test_get_refreshes_recency(self):
+        """Test that recently read entries survive eviction"""
+        cache = CacheManager(max_entries=2)
+        cache.set_by_key("a", {"v": 1})
+        cache.set_by_key("b", {"v": 2})
+
+        assert cache.get_by_key("a") == {"v": 1}
+        cache.set_by_key("c", {"v": 3})
+
+        assert cache.get_by_key("b") is None
+        assert cache.get_by_key("a") == {"v": 1}
+        assert cache.stats["evictions"] == 1
+
+    def test_byte_budget(self):
+        """Test that the cache stays within its memory budget"""
+        cache = CacheManager(max_bytes=1000)
+        for i in range(10):
+            cache.set_by_key(f"key{i}", {"text": "x" * 300})
+
+        stats = cache.get_stats()
+        assert stats["cache_bytes"] <= 1000
+        assert stats["cache_size"] == 3
+        assert cache.get_by_key("key9") is not None
+
+        # Entries larger than the whole budget are not cached
+        cache.set_by_key("huge", {"text": "x" * 2000})
+        assert cache.get_by_key("huge") is None
+
+        # An oversized update does not leave the old value cached
+        cache.set_by_key("key9", {"text": "x" * 2000})
+        assert cache.get_by_key("key9") is None
+        assert cache.local_bytes == sum(entry.size for entry in cache.local_cache.values())
+
+    def test_overwrite_keeps_size_accounting(self):
+        """Test that replacing an entry does not double count its size"""
+        cache = CacheManager()
+        cache.set_by_key("a", {"text": "x" * 100})
+        cache.set_by_key("a", {"text": "x" * 100})
+
+        assert cache.get_stats()["cache_size"] == 1
+        assert cache.local_bytes == cache.local_cache["a"].size
+
+        cache.clear()
+        assert cache.local_bytes == 0
+        assert cache.stats["evictions"] == 1
+
+    def test_ttl_can_be_disabled(self):
+        """Test that entries never expire without a TTL"""
+        cache = CacheManager(ttl=None)
+        cache.set_by_key("a", {"v": 1})
+        cache.local_cache["a"].timestamp -= 10 ** 6
+
+        assert cache.get_by_key("a") == {"v": 1}
+
+
+class TestDistributedCache:
+    """Test batched reads and write-behind writes of the Modal Dict cache"""
+
+    def make_cache(self, modal_dict, **kwargs):
+        cache = ModalCacheManager(**kwargs)
+        cache.modal_dict = modal_dict
+        return cache
+
+    def test_compact_serialization_roundtrip(self):
+        """Test the compressed entry format and the older asdict() format"""
+        entry = CacheEntry(key="k", result={"text": "x" * 1000}, timestamp=123.0, agent_type="code_reviewer")
+        data = serialize_entry(entry)
+
+        assert len(data) < 200
+        restored = deserialize_entry("k", data)
+        assert restored.result == entry.result
+        assert restored.agent_type == "code_reviewer"
+
+        # Sized like a local entry, not by the compressed bytes
+        assert restored.size > 1000
+
+        legacy = {"key": "k", "result": {"v": 1}, "timestamp": 1.0, "hit_count": 0, "agent_type": ""}
+        assert deserialize_entry("k", legacy).result == {"v": 1}
+
+    @pytest.mark.asyncio
+    async def test_write_behind_batches_writes(self):
+        """Test that buffered writes are flushed with a single update"""
+        cache = self.make_cache(FakeModalDict(), flush_interval=10)
+        for i in range(5):
+            await cache.set_by_key_async(f"key{i}", {"v": i})
+
+        # Still buffered, but readable
+        assert cache.modal_dict.updates == 0
+        await cache.flush()
+        assert cache.modal_dict.updates == 1
+        assert len(cache.modal_dict.data) == 5
+
+    @pytest.mark.asyncio
+    async def test_get_many_pipelines_remote_reads(self):
+        """Test that batch lookups read remote keys concurrently"""
+        writer = self.make_cache(FakeModalDict(), write_behind=False)
+        await writer.set_many_async({f"key{i}": {"v": i} for i in range(10)})
+
+        reader = ModalCacheManager()
+        reader.modal_dict = writer.modal_dict
+
+        start = time.time()
+        results = await reader.get_many_async([f"key{i}" for i in range(10)] + ["missing"])
+        assert time.time() - start < 0.05
+        assert len(results) == 10
+        assert reader.stats["hits"] == 10
+        assert reader.stats["misses"] == 1
+
+        # Prefetched entries are served locally afterwards
+        reads = reader.modal_dict.reads
+        assert await reader.get_by_key_async("key3") == {"v": 3}
+        assert reader.modal_dict.reads == reads
+
+    @pytest.mark.asyncio
+    async def test_failed_flush_is_retried(self):
+        """Test that a failed update keeps its writes (bounded) for the next flush"""
+        modal_dict = FakeModalDict()
+        update = modal_dict.update.aio
+
+        async def failing_update(**items):
+            raise ConnectionError("Modal unavailable")
+
+        modal_dict.update.aio = failing_update
+        cache = self.make_cache(modal_dict, write_behind=False, max_retained_writes=3)
+        await cache.set_many_async({f"key{i}": {"v": i} for i in range(2)})
+        await cache.set_many_async({f"key{i}": {"v": i * 10} for i in range(1, 4)})
+        assert list(cache._pending_writes) == ["key1", "key2", "key3"]
+        assert cache.stats["dropped_writes"] == 1
+
+        modal_dict.update.aio = update
+        await cache.flush()
+        assert sorted(modal_dict.data) == ["key1", "key2", "key3"]
+        assert deserialize_entry("key1", modal_dict.data["key1"]).result == {"v": 10}
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
@@ -0,0 +1,93 @@
+"""
+Test cases for function-level code units used by incremental reviews
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.code_units import split_into_units, assign_findings_to_units, to_unit_relative, from_unit_relative
+
+
+class TestCodeUnits:
+    """Test splitting files into function/class units for incremental reviews"""
+
+    CODE = (
+        "import os\n"
+        "\n"
+        "def first(x):\n"
+        "    return x + 1\n"
+        "\n"
+        "class Service:\n"
+        "    retries = 3\n"
+        "\n"
+        "    def run(self):\n"
+        "        return os.getcwd()\n"
+    )
+
+    def test_units_cover_functions_methods_and_module(self):
+        """Test that classes are split into methods plus a class header unit"""
+        units = {unit.name: unit for unit in split_into_units(self.CODE)}
+
+        assert set(units) == {"first", "Service.run", "Service", "<module>"}
+        assert units["first"].ranges == [(3, 4)]
+        assert units["Service.run"].ranges == [(9, 10)]
+        assert units["Service"].ranges == [(6, 8)]
+        assert units["<module>"].contains(1)
+        assert split_into_units("def broken(:") is None
+
+    def test_hash_ignores_formatting_and_comments(self):
+        """Test that only real code changes change a unit's hash"""
+        before = {unit.name: unit.hash for unit in split_into_units(self.CODE)}
+
+        reformatted = self.CODE.replace("return x + 1", "return x+1  # add one")
+        after = {unit.name: unit.hash for unit in split_into_units(reformatted)}
+        assert after == before
+
+        edited = self.CODE.replace("return x + 1", "return x + 2")
+        after = {unit.name: unit.hash for unit in split_into_units(edited)}
+        assert after["first"] != before["first"]
+        assert after["Service.run"] == before["Service.run"]
+
+    def test_findings_follow_moved_units(self):
+        """Test that unit-relative findings map to the unit's new position"""
+        units = {unit.name: unit for unit in split_into_units(self.CODE)}
+        finding = {"location": "Line 10", "description": "Uses cwd on line 10"}
+
+        grouped = assign_findings_to_units([finding], list(units.values()), units["<module>"])
+        assert grouped[units["Service.run"].unit_id] == [finding]
+
+        relative = to_unit_relative(finding, units["Service.run"])
+        assert relative["location"] == "Line 2"
+
+        # Two new lines above the method move it down
+        moved = {unit.name: unit for unit in split_into_units("# header\n# more\n" + self.CODE)}
+        assert from_unit_relative(relative, moved["Service.run"])["location"] == "Line 12"
+
+    def test_units_with_repeated_names_keep_apart(self):
+        """Test that a property getter and setter get distinct ids and their own findings"""
+        code = (
+            "class Box:\n"
+            "    @property\n"
+            "    def size(self):\n"
+            "        return self._size\n"
+            "\n"
+            "    @size.setter\n"
+            "    def size(self, value):\n"
+            "        self._size = value\n"
+        )
+        units = split_into_units(code)
+        getter, setter = [unit for unit in units if unit.name == "Box.size"]
+        assert len({unit.unit_id for unit in units}) == len(units)
+
+        finding = {"description": "Unchecked value", "location": "Line 8"}
+        grouped = assign_findings_to_units([finding], units, units[-1])
+        assert grouped[setter.unit_id] == [finding]
+        assert grouped.get(getter.unit_id, []) == []
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
@@ -0,0 +1,66 @@
+"""
+Test cases for the file-aware, near-duplicate consensus grouping
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.consensus_mechanism import WeightedConsensus
+from tests.fakes import consensus_finding
+
+
+class TestConsensusGrouping:
+    """Test file-aware, near-duplicate grouping of agent findings"""
+
+    def test_same_line_in_different_files_is_not_merged(self):
+        """Test that PR-level findings are grouped per file"""
+        consensus = WeightedConsensus()
+        result = consensus.resolve_conflicts({
+            "security_checker": [consensus_finding("Unsafe query", 12, "a.py"),
+                                 consensus_finding("Unsafe query", 12, "b.py")],
+            "code_reviewer": [consensus_finding("Unsafe query here", 12, "a.py")]
+        })
+        groups = {rec["issue_key"]: rec["agent_agreement"] for rec in result["recommendations"]}
+        assert groups == {"a.py:security_12": 2, "b.py:security_12": 1}
+        assert {rec["filename"] for rec in result["recommendations"]} == {"a.py", "b.py"}
+
+    def test_near_duplicates_are_merged(self):
+        """Test that similar descriptions on nearby lines form one group, distant ones do not"""
+        consensus = WeightedConsensus()
+        result = consensus.resolve_conflicts({
+            "security_checker": [consensus_finding("User input reaches the shell command unescaped", 20)],
+            "code_reviewer": [consensus_finding("Unescaped user input reaches the shell command", 22, type="quality"),
+                              consensus_finding("Unescaped user input reaches the shell command", 90, type="quality")],
+            "performance_analyzer": [consensus_finding("Uploaded file names lack input sanitization"),
+                                     consensus_finding("Missing input sanitization for uploaded file names")]
+        })
+        agreement = sorted(rec["agent_agreement"] for rec in result["recommendations"])
+        assert agreement == [1, 2, 2]
+        merged = next(rec for rec in result["recommendations"] if rec["line_numbers"] == [20, 22])
+        assert set(merged["contributing_agents"]) == {"security_checker", "code_reviewer"}
+
+    def test_groups_do_not_chain_across_the_file(self):
+        """Test that findings a few lines apart each do not merge into one file-wide group"""
+        consensus = WeightedConsensus()
+        result = consensus.resolve_conflicts({
+            "security_checker": [consensus_finding("User input reaches the shell command unescaped", line)
+                                 for line in (10, 13, 16, 19, 22)]
+        })
+        spans = sorted(rec["line_numbers"] for rec in result["recommendations"])
+        assert spans == [[10, 13], [16, 19], [22]]
+
+    def test_issue_categories(self):
+        """Test that the precompiled patterns keep their priority"""
+        consensus = WeightedConsensus()
+        assert consensus._get_issue_key("Possible SQL  injection via eval(") == "sql_injection"
+        assert consensus._get_issue_key("Uses MD5 for passwords") == "weak_hashing"
+        assert consensus._get_issue_key("Issue: Variable names are unclear") == "variable_names_unclear"
+        assert consensus._match_issue("Nothing matches here") is None
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
@@ -0,0 +1,82 @@
+"""
+Test cases for diff-scoped review excerpts
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.diff_scoper import DiffScoper, ScopedCode, parse_changed_lines, commentable_lines
+
+
+class TestDiffScoper:
+    """Test diff-hunk-scoped review excerpts"""
+
+    CODE = "\n".join(
+        [f"a{i} = {i}" for i in range(1, 31)] +
+        ["def changed(x):", "    y = x * 2", "    return y"] +
+        [f"b{i} = {i}" for i in range(1, 31)]
+    )
+    PATCH = "@@ -31,3 +31,3 @@\n def changed(x):\n-    y = x\n+    y = x * 2\n     return y"
+
+    def test_parse_changed_lines(self):
+        """Test extraction of changed new-file lines from a patch"""
+        assert parse_changed_lines(self.PATCH) == [32]
+
+        deletion_only = "@@ -10,3 +10,2 @@\n keep\n-removed\n keep"
+        assert parse_changed_lines(deletion_only) == [11]
+
+        assert parse_changed_lines("") == []
+
+    def test_excerpt_covers_enclosing_function(self):
+        """Test that the excerpt contains the whole enclosing function plus context"""
+        scope = DiffScoper(context_lines=1).scope(self.CODE, self.PATCH, "python")
+
+        assert scope is not None
+        assert scope.ranges == [(31, 33)]
+        assert "def changed(x):" in scope.code
+        assert "return y" in scope.code
+        assert "a1 = 1" not in scope.code
+        assert scope.scoped_lines < scope.total_lines
+
+    def test_line_numbers_map_back(self):
+        """Test that excerpt line references are mapped to full-file lines"""
+        scope = DiffScoper(context_lines=1).scope(self.CODE, self.PATCH, "python")
+
+        # Excerpt line 1 is the "omitted" marker, line 2 is original line 31
+        assert scope.to_original_line(1) is None
+        assert scope.to_original_line(2) == 31
+        assert scope.to_excerpt_line(32) == 3
+        assert scope.to_excerpt_line(1) is None
+
+        finding = scope.remap_finding({"location": "Lines 3-4", "description": "Bug on line 4"})
+        assert finding["location"] == "Lines 32-33"
+        assert finding["description"] == "Bug on line 33"
+
+        # The serialized scope remaps the same way
+        restored = ScopedCode.from_dict(scope.to_dict())
+        assert restored.remap_text("line 3") == "line 32"
+
+    def test_whole_file_when_excerpt_is_not_smaller(self):
+        """Test that large changes fall back to reviewing the whole file"""
+        code = "x = 1\ny = 2\nz = 3"
+        patch = "@@ -1,3 +1,3 @@\n-x = 0\n+x = 1\n y = 2\n z = 3"
+        assert DiffScoper().scope(code, patch, "python") is None
+
+
+class TestCommentableLines:
+    """Test the diff lines inline review comments can be attached to"""
+
+    REVIEW_PATCH = "@@ -1,3 +1,4 @@\n a = 1\n-b = 2\n+b = 3\n+c = 4\n d = 5\n@@ -20,2 +21,2 @@\n x = 1\n+y = 2"
+
+    def test_commentable_lines(self):
+        """Test that added and context lines of the hunks can be commented on"""
+        assert commentable_lines(self.REVIEW_PATCH) == [1, 2, 3, 4, 21, 22]
+        assert commentable_lines("") == []
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
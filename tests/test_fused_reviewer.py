@@ -0,0 +1,79 @@
+"""
+Test cases for the fused single-call review split into per-agent results
+"""
+
+import json
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from agents.fused_reviewer import FusedReviewerAgent
+from utils.analysis_context import AnalysisContext
+from utils.cache_manager import CacheManager
+from tests.fakes import FINDINGS_JSON, scripted_assistant
+
+
+def script_model(agent, response):
+    """Makes the agent's model answer every task with the response; returns the list of tasks sent"""
+    calls = []
+    agent._create_agent = lambda *args, **kwargs: scripted_assistant(response, calls)
+    return calls
+
+
+def fused_response():
+    """Fused response with one finding per role"""
+    def section(title, severity, complexity=None):
+        return {"summary": f"{title} found.", "findings": [
+            {"title": title, "severity": severity, "location": "load", "line_start": 2,
+             "line_end": 2, "description": "d", "solution": "s", "complexity": complexity}
+        ]}
+    return json.dumps({
+        "code_quality": section("Long function", "medium"),
+        "security": section("SQL injection", "critical"),
+        "performance": section("Nested loop", "high", "O(n^2)")
+    })
+
+
+class TestFusedReview:
+    """Test the single-call review covering all three roles"""
+
+    @pytest.mark.asyncio
+    async def test_response_is_split_into_agent_results(self):
+        """Test that one call yields the three per-agent result dicts"""
+        agent = FusedReviewerAgent(api_key="test-key", cache_manager=CacheManager())
+        calls = script_model(agent, fused_response())
+        code = "def load(db, name):\n    return db.query(name)\n"
+        analysis = AnalysisContext(code, "db.py", "python", static_analysis={})
+        result = await agent.analyze_code(code, "db.py", {"language": "python", "analysis": analysis})
+
+        assert result["status"] == "success"
+        assert len(calls) == 1
+        results = result["results"]
+        assert results["code_reviewer"]["issues_found"] == {"high": 0, "medium": 1, "low": 0}
+        assert results["code_reviewer"]["issues"][0]["type"] == "code_quality"
+        assert results["security_checker"]["vulnerabilities"]["critical"] == 1
+        assert results["security_checker"]["issues"][0]["agent"] == "security_checker"
+        assert results["performance_analyzer"]["performance_issues"]["complexity_issues"] == 1
+        assert "Nested loop" in results["performance_analyzer"]["analysis"]
+        assert "ast_analysis" in results["performance_analyzer"]
+
+        again = await agent.analyze_code(code, "db.py", {"language": "python", "analysis": analysis})
+        assert again["from_cache"] is True
+        assert again["results"]["security_checker"]["issues"] == results["security_checker"]["issues"]
+        assert len(calls) == 1
+
+    @pytest.mark.asyncio
+    async def test_unsplittable_response_is_an_error(self):
+        """Test that a response without the role sections fails so the agents run separately"""
+        agent = FusedReviewerAgent(api_key="test-key", cache_manager=CacheManager())
+        script_model(agent, FINDINGS_JSON)
+        analysis = AnalysisContext("x = 1", "a.py", "python", static_analysis={})
+        result = await agent.analyze_code("x = 1", "a.py", {"language": "python", "analysis": analysis})
+        assert result["status"] == "error"
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
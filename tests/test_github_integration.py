@@ -1,12 +1,21 @@
 #!/usr/bin/env python3
 """
 Test script for GitHub Integration
+
+The async functions run against the real GitHub API (python tests/test_github_integration.py);
+the Test* classes are offline pytest cases with a fake HTTP client.
 """
 
 import asyncio
+import json
 import os
+import pytest
+import time
 from dotenv import load_dotenv
-from utils.github_integration import GitHubIntegration
+from utils import github_integration
+from utils.github_integration import GitHubIntegration, ResponseCache, review_comments
+from utils.review_scheduler import ReviewScheduler
+from tests.fakes import consensus_review
 
 # Load environment variables
 load_dotenv()
@@ -179,5 +188,391 @@ async def main():
         print("\n⚠️  Some tests failed. Please check your configuration.")
 
 
+class FakeResponse:
+    """Minimal httpx.Response stand-in"""
+
+    def __init__(self, data=None, content=b"", links=None, content_type="application/json"):
+        self._data = data
+        self.content = content
+        self.links = links or {}
+        self.headers = {"content-type": content_type}
+        self.status_code = 200
+
+    def json(self):
+        return self._data
+
+    def raise_for_status(self):
+        pass
+
+
+class FakeGitHubClient:
+    """Serves a PR with two pages of files and raw file contents"""
+
+    is_closed = False
+
+    def __init__(self, file_count):
+        self.file_count = file_count
+        self.in_flight = 0
+        self.peak_in_flight = 0
+
+    async def get(self, url, headers=None, params=None):
+        if url.endswith("/pulls/7"):
+            return FakeResponse({"head": {"sha": "abc123"}})
+        if "/pulls/7/files" in url:
+            page = 2 if "page=2" in url else 1
+            names = range(100) if page == 1 else range(100, self.file_count)
+            links = {"next": {"url": url + "?per_page=100&page=2"}} if page == 1 else {}
+            return FakeResponse([
+                {"filename": f"file{i}.py", "status": "modified", "additions": 1,
+                 "deletions": 0, "changes": 1, "patch": ""}
+                for i in names
+            ], links=links)
+
+        assert headers["Accept"] == "application/vnd.github.raw+json"
+        assert params == {"ref": "abc123"}
+        self.in_flight += 1
+        self.peak_in_flight = max(self.peak_in_flight, self.in_flight)
+        await asyncio.sleep(0.01)
+        self.in_flight -= 1
+        name = url.rsplit("/", 1)[1]
+        return FakeResponse(content=f"# {name}".encode(), content_type="application/vnd.github.raw+json")
+
+
+class TestGitHubFetching:
+    """Test paginated, concurrent PR file fetching"""
+
+    @pytest.mark.asyncio
+    async def test_get_pr_files_paginates_and_fetches_concurrently(self):
+        """Test that all pages are listed and contents are fetched in parallel, in order"""
+        github = GitHubIntegration(github_token="test-token", max_concurrent_fetches=5)
+        client = FakeGitHubClient(file_count=130)
+        github._client = client
+
+        start = time.time()
+        files = await github.get_pr_files("owner", "repo", 7)
+
+        assert len(files) == 130
+        assert [f["filename"] for f in files] == [f"file{i}.py" for i in range(130)]
+        assert files[42]["content"] == "# file42.py"
+        assert files[0]["language"] == "python"
+        assert client.peak_in_flight == 5
+        # 130 sequential fetches would take at least 1.3s
+        assert time.time() - start < 1.0
+
+
+class FakeBatchGitHubClient:
+    """Serves a PR listing with blob SHAs, GraphQL blob queries and git blobs"""
+
+    is_closed = False
+
+    def __init__(self, file_count, binary=()):
+        self.file_count = file_count
+        self.binary = set(binary)
+        self.requests = []
+
+    async def get(self, url, headers=None, params=None):
+        self.requests.append(url)
+        if url.endswith("/pulls/7"):
+            return FakeResponse({"head": {"sha": "abc123"}})
+        if url.endswith("/pulls/7/files"):
+            response = FakeResponse([
+                {"filename": f"file{i}.py", "status": "modified", "sha": f"blob{i}",
+                 "additions": 1, "deletions": 0, "changes": 1, "patch": ""}
+                for i in range(self.file_count)
+            ])
+            response.headers["etag"] = '"listing-v1"'
+            if headers.get("If-None-Match") == '"listing-v1"':
+                response.status_code = 304
+            return response
+        if "/git/blobs/" in url:
+            blob_sha = url.rsplit("/", 1)[1]
+            return FakeResponse(content=f"# {blob_sha}".encode(), content_type="application/vnd.github.raw+json")
+        # Contents API (REST fallback)
+        name = url.rsplit("/", 1)[1]
+        return FakeResponse(content=f"# rest {name}".encode(), content_type="application/vnd.github.raw+json")
+
+    async def post(self, url, headers=None, json=None):
+        assert url.endswith("/graphql")
+        self.requests.append(url)
+        variables = json["variables"]
+        repository = {}
+        for key, expression in variables.items():
+            if not key.startswith("e"):
+                continue
+            filename = expression.split(":", 1)[1]
+            if filename in self.binary:
+                repository["f" + key[1:]] = {"text": None, "isBinary": True, "isTruncated": False}
+            else:
+                repository["f" + key[1:]] = {"text": f"# gql {filename}", "isBinary": False, "isTruncated": False}
+        return FakeResponse({"data": {"repository": repository}})
+
+
+class TestGitHubFetchBackends:
+    """Test the GraphQL and git blob content backends"""
+
+    @pytest.mark.asyncio
+    async def test_graphql_batches_and_falls_back_for_binary_files(self):
+        """Test that contents come from batched GraphQL queries, with REST for binary blobs"""
+        github = GitHubIntegration(github_token="test-token", fetch_backend="graphql")
+        client = FakeBatchGitHubClient(file_count=120, binary={"file3.py"})
+        github._client = client
+
+        files = await github.get_pr_files("owner", "repo", 7)
+
+        assert len(files) == 120
+        assert files[0]["content"] == "# gql file0.py"
+        assert files[3]["content"] == "# rest file3.py"
+        # 120 files in batches of 50: three queries instead of 120 requests
+        assert sum(1 for url in client.requests if url.endswith("/graphql")) == 3
+        assert sum(1 for url in client.requests if "/contents/" in url) == 1
+
+    @pytest.mark.asyncio
+    async def test_git_backend_reuses_unchanged_blobs(self):
+        """Test that a second fetch of the same PR costs no blob requests"""
+        github = GitHubIntegration(github_token="test-token", fetch_backend="git")
+        github.response_cache = ResponseCache()
+        client = FakeBatchGitHubClient(file_count=5)
+        github._client = client
+
+        first = await github.get_pr_files("owner", "repo", 7)
+        blob_requests = sum(1 for url in client.requests if "/git/blobs/" in url)
+        second = await github.get_pr_files("owner", "repo", 7)
+
+        assert blob_requests == 5
+        assert sum(1 for url in client.requests if "/git/blobs/" in url) == 5
+        assert [f["content"] for f in first] == [f["content"] for f in second]
+        assert second[2]["content"] == "# blob2"
+
+    def test_unknown_backend_rejected(self):
+        """Test that an unknown fetch backend raises"""
+        with pytest.raises(ValueError):
+            GitHubIntegration(github_token="test-token", fetch_backend="svn")
+
+
+class SecondaryLimitClient(FakeBatchGitHubClient):
+    """Answers the first request to each endpoint with a secondary rate limit"""
+
+    def __init__(self, file_count):
+        super().__init__(file_count)
+        self.limited = set()
+
+    def limit(self, url):
+        endpoint = url.rsplit("/", 1)[0] if "/git/blobs/" in url else url
+        if endpoint in self.limited:
+            return None
+        self.limited.add(endpoint)
+        response = FakeResponse({"message": "You have exceeded a secondary rate limit."})
+        response.status_code = 403
+        response.text = "You have exceeded a secondary rate limit. Please wait a few minutes."
+        response.headers["retry-after"] = "1"
+        return response
+
+    async def get(self, url, headers=None, params=None):
+        self.requests.append(url)
+        return self.limit(url) or await super().get(url, headers, params)
+
+    async def post(self, url, headers=None, json=None):
+        return self.limit(url) or await super().post(url, headers, json)
+
+
+class TestGitHubRateLimits:
+    """Test backoff on GitHub rate limits"""
+
+    @pytest.mark.asyncio
+    async def test_secondary_limits_are_retried(self):
+        """Test that 403 secondary limits of the listing, blob and GraphQL requests are retried"""
+        contents = {"git": "# blob{}", "graphql": "# gql file{}.py"}
+        for backend, content in contents.items():
+            github = GitHubIntegration(github_token="test-token", fetch_backend=backend,
+                                       scheduler=ReviewScheduler(base_delay=0.01, max_delay=0.05))
+            github.response_cache = ResponseCache()
+            client = SecondaryLimitClient(file_count=3)
+            github._client = client
+
+            files = await github.get_pr_files("owner", "repo", 7)
+            assert [f["content"] for f in files] == [content.format(i) for i in range(3)]
+            assert len(client.limited) == 3
+
+
+class CompareClient:
+    """Serves one compare API response"""
+
+    is_closed = False
+
+    def __init__(self, comparison):
+        self.comparison = comparison
+        self.urls = []
+
+    async def get(self, url, headers=None, params=None):
+        self.urls.append(url)
+        return FakeResponse(self.comparison)
+
+
+class TestPRDelta:
+    """Test the changes of a PR since its last reviewed head"""
+
+    @pytest.mark.asyncio
+    async def test_changes_since_last_review(self):
+        """Test that the compare API gives the delta, and force pushes give none"""
+        github = GitHubIntegration(github_token="test-token")
+        github._client = CompareClient({"status": "ahead", "files": [
+            {"filename": "a.py", "status": "modified", "patch": "@@ -1 +1 @@\n-x\n+y"},
+            {"filename": "old.py", "status": "removed"}
+        ]})
+        assert await github.get_changes_since("owner", "repo", "sha1", "sha2") == {"a.py": "@@ -1 +1 @@\n-x\n+y"}
+        assert github._client.urls[0].endswith("/repos/owner/repo/compare/sha1...sha2")
+
+        github._client = CompareClient({"status": "diverged", "files": []})
+        assert await github.get_changes_since("owner", "repo", "sha1", "sha2") is None
+
+
+class FakeReviewClient:
+    """Serves an open PR and records the posted reviews"""
+
+    is_closed = False
+
+    def __init__(self, statuses=(), state="open", author="author"):
+        self.gets = []
+        self.posts = []
+        self.statuses = list(statuses)
+        self.pr = {"title": "Add c", "body": "", "state": state, "user": {"login": author},
+                   "created_at": "2024-01-01T00:00:00Z", "updated_at": "2024-01-01T00:00:00Z",
+                   "base": {"ref": "main"}, "head": {"ref": "feature", "sha": "newer"},
+                   "additions": 2, "deletions": 1, "changed_files": 1}
+
+    async def get(self, url, headers=None, params=None):
+        self.gets.append(url)
+        if url.endswith("/user"):
+            return FakeResponse({"login": "review-bot"})
+        return FakeResponse(self.pr)
+
+    async def post(self, url, headers=None, json=None):
+        self.posts.append((url, json))
+        response = FakeResponse({"id": len(self.posts), "html_url": url})
+        response.status_code = self.statuses.pop(0) if self.statuses else 201
+        response.text = ""
+        return response
+
+
+REVIEW_PATCH = "@@ -1,3 +1,4 @@\n a = 1\n-b = 2\n+b = 3\n+c = 4\n d = 5\n@@ -20,2 +21,2 @@\n x = 1\n+y = 2"
+
+
+class TestBatchedReviewComments:
+    """Test submitting the summary and inline comments as one review"""
+
+    def test_findings_anchor_to_diff_lines(self):
+        """Test that findings land on a diff line of their range and others are left out"""
+        reviews = [
+            consensus_review("app.py", ("critical", [3]), ("high", [10, 21]), ("medium", [40]), ("low", [2])),
+            {"status": "error", "filename": "other.py"}
+        ]
+        comments = review_comments(reviews, [{"filename": "app.py", "patch": REVIEW_PATCH}], min_severity="medium")
+        assert [(c["path"], c["line"]) for c in comments] == [("app.py", 3), ("app.py", 21)]
+        assert comments[0]["body"].startswith("**Critical:**")
+        assert "**Suggestion:** Fix it" in comments[0]["body"]
+
+    @pytest.mark.asyncio
+    async def test_summary_and_comments_in_one_request(self):
+        """Test that one review POST carries the comments at the reviewed head"""
+        github = GitHubIntegration(github_token="test-token")
+        github._client = FakeReviewClient()
+        github.head_shas[("acme", "api", 7)] = "reviewed"
+        comments = [{"path": "app.py", "line": i, "body": f"c{i}"} for i in range(1, 6)]
+
+        await github.post_review_comment("acme", "api", 7, "Summary", "REQUEST_CHANGES", comments=comments)
+        (url, payload), = github._client.posts
+        assert url.endswith("/pulls/7/reviews")
+        assert payload["event"] == "REQUEST_CHANGES" and payload["body"] == "Summary"
+        assert payload["commit_id"] == "reviewed"
+        assert [c["line"] for c in payload["comments"]] == [1, 2, 3, 4, 5]
+        assert all(c["side"] == "RIGHT" for c in payload["comments"])
+
+    @pytest.mark.asyncio
+    async def test_large_reviews_are_split(self, monkeypatch):
+        """Test that only comments beyond the request size limit follow in further reviews"""
+        github = GitHubIntegration(github_token="test-token")
+        github._client = FakeReviewClient()
+        comments = [{"path": "app.py", "line": i, "body": "x" * 100} for i in range(1, 301)]
+
+        # Hundreds of comments fit in one review
+        await github.post_review_comment("acme", "api", 7, "Summary", "APPROVE", comments=comments, commit_id="sha")
+        assert [len(p["comments"]) for _, p in github._client.posts] == [300]
+
+        monkeypatch.setattr(github_integration, "MAX_REVIEW_PAYLOAD_BYTES", 15000)
+        github._client = FakeReviewClient()
+        await github.post_review_comment("acme", "api", 7, "Summary", "APPROVE", comments=comments, commit_id="sha")
+        payloads = [payload for _, payload in github._client.posts]
+        assert len(payloads) > 2 and sum(len(p["comments"]) for p in payloads) == 300
+        assert all(sum(len(json.dumps(c)) for c in p["comments"]) <= 15000 for p in payloads)
+        assert [p["event"] for p in payloads] == ["APPROVE"] + ["COMMENT"] * (len(payloads) - 1)
+
+    @pytest.mark.asyncio
+    async def test_rejected_comments_fall_back_to_summary(self):
+        """Test that a 422 for the inline comments still posts the summary review"""
+        github = GitHubIntegration(github_token="test-token")
+        github._client = FakeReviewClient(statuses=[422])
+        await github.post_review_comment("acme", "api", 7, "Summary", "COMMENT",
+                                         comments=[{"path": "app.py", "line": 99, "body": "c"}], commit_id="sha")
+        payloads = [payload for _, payload in github._client.posts]
+        assert len(payloads) == 2
+        assert payloads[1] == {"body": "Summary", "event": "COMMENT"}
+
+    @pytest.mark.asyncio
+    async def test_comments_off_the_diff_are_dropped_on_422(self):
+        """Test that a rejected review is retried once with the comments on diff lines"""
+        github = GitHubIntegration(github_token="test-token")
+        github._client = FakeReviewClient(statuses=[422])
+        github.pr_patches[("acme", "api", 7)] = {"app.py": REVIEW_PATCH}
+        comments = [{"path": "app.py", "line": line, "body": "c"} for line in (3, 99, 21)]
+
+        await github.post_review_comment("acme", "api", 7, "Summary", "REQUEST_CHANGES",
+                                         comments=comments, commit_id="sha")
+        payloads = [payload for _, payload in github._client.posts]
+        assert [[c["line"] for c in p["comments"]] for p in payloads] == [[3, 99, 21], [3, 21]]
+        assert payloads[1]["event"] == "REQUEST_CHANGES"
+
+    @pytest.mark.asyncio
+    async def test_posting_reuses_the_fetched_pr(self):
+        """Test that reviews are posted without fetching the PR again and the login is looked up once"""
+        github = GitHubIntegration(github_token="test-token")
+        github._client = FakeReviewClient()
+        await github.get_pr_info("acme", "api", 7)
+        for _ in range(2):
+            await github.post_review_comment("acme", "api", 7, "Summary", "REQUEST_CHANGES",
+                                             comments=[{"path": "app.py", "line": 3, "body": "c"}])
+
+        assert [url.rsplit("/", 2)[-2:] for url in github._client.gets] == [["pulls", "7"], ["api.github.com", "user"]]
+        assert [payload["commit_id"] for _, payload in github._client.posts] == ["newer", "newer"]
+
+    @pytest.mark.asyncio
+    async def test_own_and_closed_prs(self):
+        """Test that own PRs get a COMMENT review with the inline comments and closed PRs the summary"""
+        comments = [{"path": "app.py", "line": i, "body": f"c{i}"} for i in (3, 21)]
+        github = GitHubIntegration(github_token="test-token")
+        github._client = FakeReviewClient(author="review-bot")
+        await github.post_review_comment("acme", "api", 7, "Summary", "APPROVE", comments=comments)
+        (url, payload), = github._client.posts
+        assert url.endswith("/pulls/7/reviews")
+        assert payload["event"] == "COMMENT" and len(payload["comments"]) == 2
+
+        github = GitHubIntegration(github_token="test-token")
+        github._client = FakeReviewClient(state="closed")
+        await github.post_review_comment("acme", "api", 7, "Summary", "APPROVE", comments=comments)
+        assert github._client.posts == [(github.base_url + "/repos/acme/api/issues/7/comments", {"body": "Summary"})]
+
+    @pytest.mark.asyncio
+    async def test_inline_comments_reuse_head_sha(self):
+        """Test that batched inline comments need no PR fetch once the head SHA is known"""
+        github = GitHubIntegration(github_token="test-token")
+        github._client = FakeReviewClient()
+        github.head_shas[("acme", "api", 7)] = "reviewed"
+        comments = [{"path": "app.py", "line": i, "body": f"c{i}"} for i in range(1, 4)]
+
+        created = await github.post_inline_comments("acme", "api", 7, comments)
+        assert github._client.gets == []
+        assert len(created) == 1 and len(github._client.posts) == 1
+        assert github._client.posts[0][1]["commit_id"] == "reviewed"
+
+
 if __name__ == "__main__":
     asyncio.run(main())
\ No newline at end of file
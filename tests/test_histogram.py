@@ -0,0 +1,57 @@
+"""
+Test cases for the fixed-size streaming histograms
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.histogram import StreamingHistogram
+
+
+class TestStreamingHistogram:
+    """Test fixed-size histograms and their percentiles"""
+
+    def test_percentiles_within_relative_accuracy(self):
+        """Test that percentiles are within 1% and memory does not grow with samples"""
+        histogram = StreamingHistogram()
+        for value in range(1, 100001):
+            histogram.add(value / 1000)
+
+        stats = histogram.stats()
+        assert stats["count"] == 100000
+        assert stats["min"] == 0.001 and stats["max"] == 100.0
+        for key, expected in (("p50", 50.0), ("p90", 90.0), ("p99", 99.0)):
+            assert abs(stats[key] - expected) / expected <= 0.01
+        assert len(histogram.buckets) < 600
+
+    def test_collapsing_keeps_high_percentiles(self):
+        """Test that the bucket cap merges low buckets only"""
+        histogram = StreamingHistogram(max_buckets=50)
+        for exponent in range(-300, 300):
+            histogram.add(1.05 ** exponent)
+        assert len(histogram.buckets) <= 50
+        assert abs(histogram.quantile(0.99) - 1.05 ** 293) / 1.05 ** 293 <= 0.01
+
+    def test_merged_shards_match_one_histogram(self):
+        """Test that merging histograms gives the combined distribution"""
+        first, second, combined = StreamingHistogram(), StreamingHistogram(), StreamingHistogram()
+        for value in range(1, 1001):
+            (first if value % 2 else second).add(value)
+            combined.add(value)
+        first.merge(second)
+        assert first.stats() == combined.stats()
+
+    def test_histogram_round_trip(self):
+        """Test that published histograms keep their distribution"""
+        histogram = StreamingHistogram()
+        for value in range(1, 501):
+            histogram.add(value)
+        assert StreamingHistogram.from_dict(histogram.to_dict()).stats() == histogram.stats()
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
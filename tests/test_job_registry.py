@@ -0,0 +1,84 @@
+"""
+Test cases for debounced, superseding per-PR review jobs
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.job_registry import PRJobRegistry, job_key, floor_review_event
+from tests.fakes import FakeModalDict
+
+
+class TestJobRegistry:
+    """Test debouncing and superseding of per-PR review jobs"""
+
+    @pytest.mark.asyncio
+    async def test_new_head_supersedes_the_review_in_flight(self):
+        """Test that only an event for a new head SHA returns the call to cancel"""
+        registry = PRJobRegistry(store=FakeModalDict())
+        key = job_key("owner", "repo", 7)
+        assert key == "owner/repo#7"
+
+        assert await registry.record_event(key, "sha1") is None
+        await registry.set_call(key, "sha1", "call-1")
+        assert await registry.record_event(key, "sha1") is None
+        assert await registry.record_event(key, "sha2") == "call-1"
+        assert await registry.is_current(key, "sha2") and not await registry.is_current(key, "sha1")
+
+    @pytest.mark.asyncio
+    async def test_bursts_of_events_are_debounced(self):
+        """Test that a review waits for quiet and yields to a newer push"""
+        registry = PRJobRegistry(store=FakeModalDict(), debounce_seconds=30)
+        key = job_key("owner", "repo", 7)
+        now = [1000.0]
+        await registry.record_event(key, "sha1", now=now[0])
+
+        async def sleep_with_push(seconds):
+            now[0] += seconds / 2
+            await registry.record_event(key, "sha2", now=now[0])
+
+        assert not await registry.wait_for_quiet(key, "sha1", sleep=sleep_with_push, clock=lambda: now[0])
+
+        slept = []
+
+        async def sleep(seconds):
+            slept.append(seconds)
+            now[0] += seconds
+
+        assert await registry.wait_for_quiet(key, "sha2", sleep=sleep, clock=lambda: now[0])
+        assert slept == [30.0]
+
+    @pytest.mark.asyncio
+    async def test_reviewed_head_is_remembered(self):
+        """Test that the last reviewed head SHA is kept for delta reviews"""
+        registry = PRJobRegistry(store=FakeModalDict())
+        key = job_key("owner", "repo", 7)
+        await registry.record_event(key, "sha1")
+        await registry.set_call(key, "sha1", "call-1")
+        await registry.mark_reviewed(key, "sha1")
+
+        assert await registry.last_reviewed_sha(key) == "sha1"
+        assert await registry.record_event(key, "sha2") is None
+
+    @pytest.mark.asyncio
+    async def test_delta_reviews_keep_the_last_review_event(self):
+        """Test that a clean delta review does not APPROVE over an earlier REQUEST_CHANGES"""
+        registry = PRJobRegistry(store=FakeModalDict())
+        key = job_key("owner", "repo", 7)
+        await registry.mark_reviewed(key, "sha1", "REQUEST_CHANGES")
+        # A push without code changes keeps the posted event
+        await registry.mark_reviewed(key, "sha2")
+
+        previous = await registry.last_review_event(key)
+        assert previous == "REQUEST_CHANGES"
+        assert floor_review_event("APPROVE", previous) == "REQUEST_CHANGES"
+        assert floor_review_event("COMMENT", "APPROVE") == "COMMENT"
+        assert floor_review_event("APPROVE", None) == "APPROVE"
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
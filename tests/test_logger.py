@@ -0,0 +1,100 @@
+"""
+Test cases for API usage tracking and performance monitoring
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.logger import APICallTracker, PerformanceMonitor
+
+
+class TestAPICallTracker:
+    """Test token, cost and latency accounting of API calls"""
+
+    def test_cached_input_tokens_are_tracked_and_cheaper(self):
+        """Test that cached prompt tokens are reported and billed at the cached rate"""
+        tracker = APICallTracker()
+        tracker.track_call("openai", "gpt-4o", input_tokens=2000, output_tokens=100, duration=1.0,
+                           cached_input_tokens=1024)
+        summary = tracker.get_summary()
+        assert summary["total_cached_input_tokens"] == 1024
+        assert summary["by_model"]["gpt-4o"]["cached_input_tokens"] == 1024
+        assert summary["cached_input_ratio"] == 0.512
+        assert tracker._estimate_cost("gpt-4o", 2000, 100, 1024) < tracker._estimate_cost("gpt-4o", 2000, 100)
+
+    def test_api_tracker_keeps_totals_only(self):
+        """Test that the API usage summary comes from running totals"""
+        tracker = APICallTracker()
+        for _ in range(1000):
+            tracker.track_call("openai", "gpt-4o-mini", input_tokens=100, output_tokens=10, duration=0.5)
+        tracker.track_call("openai", "gpt-4o", input_tokens=1000, output_tokens=100, duration=4.0)
+
+        summary = tracker.get_summary()
+        assert summary["total_calls"] == 1001
+        assert summary["by_model"]["gpt-4o-mini"]["input_tokens"] == 100000
+        assert summary["total_tokens"] == 111100
+        assert abs(summary["latency"]["p50"] - 0.5) <= 0.005 and summary["latency"]["p99"] <= 4.0
+        assert not hasattr(tracker, "calls")
+
+    def test_usage_scope(self):
+        """Test that calls count towards every open usage scope and nothing else"""
+        tracker = APICallTracker()
+        tracker.track_call("openai", "gpt-4o", 1000, 100, 0.1)
+        with tracker.usage_scope() as outer:
+            tracker.track_call("openai", "gpt-4o", 1000, 100, 0.1)
+            with tracker.usage_scope() as inner:
+                tracker.track_call("openai", "gpt-4o-mini", 500, 50, 0.1, cached_input_tokens=100)
+        assert outer["calls"] == 2 and outer["input_tokens"] == 1500
+        assert (inner["calls"], inner["input_tokens"], inner["cached_input_tokens"], inner["output_tokens"]) == (
+            1, 500, 100, 50
+        )
+        assert inner["cost"] == tracker._estimate_cost("gpt-4o-mini", 500, 50, 100)
+
+
+class TestPerformanceMonitor:
+    """Test sharded, bounded recording of performance metrics"""
+
+    def test_monitor_records_from_threads(self):
+        """Test concurrent recording, per-tag statistics and reset"""
+        import threading
+
+        monitor = PerformanceMonitor(shards=4)
+
+        def record():
+            for i in range(1000):
+                monitor.record_metric("review_duration", 1.0 + i % 10, {"agent": "security"})
+
+        threads = [threading.Thread(target=record) for _ in range(8)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        monitor.record_metric("review_duration", 100.0, {"agent": "code"})
+
+        stats = monitor.get_stats("review_duration")
+        assert stats["count"] == 8001 and stats["max"] == 100.0 and stats["latest"] == 100.0
+        assert [entry["tags"] for entry in monitor.get_tagged_stats("review_duration")] == [
+            {"agent": "code"}, {"agent": "security"}
+        ]
+        assert set(monitor.get_all_stats()) == {"review_duration"}
+
+        monitor.reset()
+        assert monitor.get_stats("review_duration") == {}
+
+    def test_tag_sets_are_bounded(self):
+        """Test that unbounded tag values do not grow the monitor"""
+        monitor = PerformanceMonitor(shards=1, max_series=10)
+        for i in range(100):
+            monitor.record_metric("fetch", 1.0, {"url": f"/files/{i}"})
+        tagged = monitor.get_tagged_stats("fetch")
+        assert len(tagged) == 11
+        overflow = [entry for entry in tagged if entry["tags"] == {"overflow": "true"}]
+        assert len(overflow) == 1 and overflow[0]["count"] == 90
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
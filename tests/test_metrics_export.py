@@ -0,0 +1,64 @@
+"""
+Test cases for the Prometheus metrics export
+"""
+
+import pytest
+import sys
+import os
+import time
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.logger import APICallTracker, PerformanceMonitor
+from utils.metrics_export import MetricsStore, render_prometheus
+from tests.fakes import FakeModalDict
+
+
+class TestMetricsExport:
+    """Test the Prometheus rendering and the merging of published metrics"""
+
+    def test_prometheus_rendering(self):
+        """Test summaries per tag set, API counters and gauges"""
+        monitor = PerformanceMonitor(shards=1)
+        for value in (1.0, 2.0, 3.0):
+            monitor.record_metric("agent-duration", value, {"agent": "security"})
+        tracker = APICallTracker()
+        tracker.track_call("openai", "gpt-4o", input_tokens=100, output_tokens=20, duration=1.0,
+                           cached_input_tokens=40)
+
+        text = render_prometheus(monitor.snapshot(), tracker.model_totals(),
+                                 [("review_queue_pending", {"lane": "high"}, 3)])
+        lines = text.splitlines()
+        assert "# TYPE code_review_agent_duration summary" in lines
+        median = [line for line in lines if line.startswith('code_review_agent_duration{agent="security",quantile="0.5"} ')]
+        assert len(median) == 1 and abs(float(median[0].split()[-1]) - 2.0) <= 0.02
+        assert 'code_review_agent_duration_sum{agent="security"} 6.0' in lines
+        assert 'code_review_agent_duration_count{agent="security"} 3' in lines
+        assert 'code_review_api_tokens_total{kind="cached_input",model="gpt-4o"} 40' in lines
+        assert lines.count("# TYPE code_review_api_tokens_total counter") == 1
+        assert 'code_review_review_queue_pending{lane="high"} 3' in lines
+
+    @pytest.mark.asyncio
+    async def test_published_metrics_are_merged(self):
+        """Test that worker metrics published to the store are merged and expire"""
+        store = MetricsStore(store=FakeModalDict(), max_age=60)
+        for source, values in (("worker-1", (1.0, 2.0)), ("worker-2", (3.0,)), ("webhook", (9.0,))):
+            monitor = PerformanceMonitor(shards=1)
+            tracker = APICallTracker()
+            for value in values:
+                monitor.record_metric("review_file_duration", value, {"agent": "code"})
+                tracker.track_call("openai", "gpt-4o-mini", input_tokens=10, output_tokens=1, duration=value)
+            await store.publish(monitor, tracker, source=source)
+
+        histograms, api_totals = await store.collect(exclude="webhook")
+        histogram = histograms[("review_file_duration", (("agent", "code"),))]
+        assert histogram.count == 3 and histogram.max == 3.0
+        assert api_totals["gpt-4o-mini"]["calls"] == 3
+
+        histograms, _ = await store.collect(now=time.time() + 120)
+        assert histograms == {}
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
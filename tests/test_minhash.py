@@ -0,0 +1,35 @@
+"""
+Test cases for MinHash signatures and the LSH index of the consensus grouping
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.minhash import MinHasher, LSHIndex, tokenize, jaccard
+
+
+class TestMinHash:
+    """Test signatures, similarity and bounded LSH lookups"""
+
+    def test_lsh_lookups_are_bounded(self):
+        """Test that signatures are stable and buckets cap the candidates per lookup"""
+        hasher = MinHasher(num_perm=16)
+        tokens = tokenize("Nested loop over orders gives quadratic time")
+        assert hasher.signature(tokens) == MinHasher(num_perm=16).signature(set(tokens))
+        assert hasher.signature(frozenset()) == ()
+        assert jaccard(tokens, tokenize("Nested loop over orders gives quadratic runtime")) == 6 / 8
+
+        index = LSHIndex(bands=8, rows=2, bucket_size=4)
+        signature = hasher.signature(tokens)
+        for item in range(100):
+            index.add(item, signature, "a.py")
+        assert index.candidates(signature, ["a.py"]) == [0, 1, 2, 3]
+        assert index.candidates(signature, ["b.py"]) == []
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
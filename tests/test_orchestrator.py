@@ -1,12 +1,18 @@
 #!/usr/bin/env python3
 """
 Test script for the Simplified Multi-Agent Orchestrator
+
+main() reviews the sample code with the real agents (python tests/test_orchestrator.py);
+the Test* classes are offline pytest cases.
 """
 
 import asyncio
 import os
+import pytest
 from dotenv import load_dotenv
-from orchestrator import SimpleMultiAgentOrchestrator
+from orchestrator import SimpleMultiAgentOrchestrator, get_orchestrator
+from utils.cache_manager import CacheManager
+from tests.fakes import FINDINGS_JSON, consensus_finding, scripted_assistant, scripted_orchestrator
 
 # Load environment variables
 load_dotenv()
@@ -134,5 +140,210 @@ async def main():
         traceback.print_exc()
 
 
+class TestChunkedReviews:
+    """Test reviews of files split into several requests"""
+
+    def test_chunk_results_are_merged(self):
+        """Test that per-chunk agent results combine into one result"""
+        merged = SimpleMultiAgentOrchestrator._merge_agent_results([
+            {"agent": "security_checker", "status": "success", "analysis": "A",
+             "issues": [{"line": 3}], "vulnerabilities": {"high": 1, "low": 0}},
+            {"agent": "security_checker", "status": "success", "analysis": "B",
+             "issues": [{"line": 90}], "vulnerabilities": {"high": 0, "low": 2}}
+        ])
+        assert merged["issues"] == [{"line": 3}, {"line": 90}]
+        assert merged["vulnerabilities"] == {"high": 1, "low": 2}
+        assert "A" in merged["analysis"] and "B" in merged["analysis"]
+
+    @pytest.mark.asyncio
+    async def test_chunk_findings_keep_full_file_lines(self):
+        """Test that findings of later chunks reach the file and PR consensus with full-file lines"""
+        orchestrator = scripted_orchestrator(calls=[], max_request_tokens=150)
+        code = "".join(
+            f"def step_{i}(value):\n" + "".join(f"    value = value * {j} + {i}\n" for j in range(8)) +
+            "    return value\n\n"
+            for i in range(6)
+        )
+        review = await orchestrator.review_code(code, "steps.py", context={"language": "python"})
+        result = orchestrator.aggregate_pr_reviews([review], [{"filename": "steps.py"}])
+
+        def lines(recommendations):
+            return sorted(rec["line_numbers"] for rec in recommendations if rec["consensus_severity"] == "critical")
+
+        # Every chunk answers with lines 4-6 of its own excerpt
+        file_lines = lines(review["consensus_results"]["recommendations"])
+        assert len(file_lines) > 1 and file_lines[0] == [4, 6]
+        assert len({start for start, _ in file_lines}) == len(file_lines)
+        assert all(end <= len(code.splitlines()) for _, end in file_lines)
+        assert lines(result["pr_consensus"]["recommendations"]) == file_lines
+
+
+class TestAgentFanOut:
+    """Test the concurrent and sequential runs of the three agents"""
+
+    async def review(self, concurrent_agents):
+        """Review with agents that overlap only when run concurrently and a failing security checker"""
+        orchestrator = scripted_orchestrator(calls=[], concurrent_agents=concurrent_agents)
+        running = {"now": 0, "peak": 0}
+
+        def slow_agent(*args, **kwargs):
+            assistant = scripted_assistant(FINDINGS_JSON, [])
+
+            class SlowAssistant:
+                async def run(self, task):
+                    running["now"] += 1
+                    running["peak"] = max(running["peak"], running["now"])
+                    await asyncio.sleep(0.01)
+                    running["now"] -= 1
+                    return await assistant.run(task)
+
+            return SlowAssistant()
+
+        async def failing_review(**kwargs):
+            raise RuntimeError("connection reset")
+
+        orchestrator.code_reviewer._create_agent = slow_agent
+        orchestrator.performance_analyzer._create_agent = slow_agent
+        orchestrator.security_checker.analyze_code = failing_review
+        code = "".join(f"value_{i} = {i}\n" for i in range(20))
+        result = await orchestrator.review_code(code, "db.py", context={"language": "python"})
+        return result, running["peak"]
+
+    @pytest.mark.asyncio
+    async def test_failed_agent_does_not_cancel_the_others(self):
+        """Test that both modes merge the same results when one agent raises"""
+        concurrent, concurrent_peak = await self.review(concurrent_agents=True)
+        sequential, sequential_peak = await self.review(concurrent_agents=False)
+        assert (concurrent_peak, sequential_peak) == (2, 1)
+
+        for result in (concurrent, sequential):
+            agent_results = result["orchestrator_results"]["agent_results"]
+            assert result["status"] == "success"
+            assert agent_results["security_checker"] == {
+                "agent": "security_checker", "filename": "db.py", "status": "error", "error": "connection reset"
+            }
+            assert agent_results["code_reviewer"]["status"] == "success"
+            assert agent_results["performance_analyzer"]["status"] == "success"
+
+        def summary(result):
+            return sorted((rec["consensus_severity"], rec["line_numbers"], rec["contributing_agents"])
+                          for rec in result["consensus_results"]["recommendations"])
+
+        assert summary(concurrent) == summary(sequential)
+        assert len(summary(concurrent)) == 2
+        assert all("security_checker" not in agents for _, _, agents in summary(concurrent))
+
+
+class TestPRTokenBudget:
+    """Test the selection of PR files within the token budget"""
+
+    @pytest.mark.asyncio
+    async def test_cached_files_do_not_use_the_budget(self):
+        """Test that a file answered from the cache leaves the budget to the changed file"""
+        def files(b_value):
+            return [
+                {"filename": "a.py", "language": "python",
+                 "content": "".join(f"def step_{i}(value):\n    return value * {i}\n\n" for i in range(30))},
+                {"filename": "b.py", "language": "python", "content": f"limit = {b_value}\n"}
+            ]
+
+        estimates = [scripted_orchestrator()._estimate_review_tokens(f) for f in files(2)]
+        budget = max(estimates) + 1
+        assert sum(estimates) > budget
+
+        cache = CacheManager()
+        calls = []
+        await scripted_orchestrator(cache, calls).review_pull_request(files(1))
+        assert len(calls) == 6
+
+        calls.clear()
+        result = await scripted_orchestrator(cache, calls, max_pr_tokens=budget).review_pull_request(files(2))
+        assert result["skipped_files"] == []
+        assert [review["filename"] for review in result["file_reviews"]] == ["a.py", "b.py"]
+        assert len(calls) == 3
+
+        # Without the cache the same budget covers one file only
+        result = await scripted_orchestrator(calls=[], max_pr_tokens=budget).review_pull_request(files(2))
+        assert [entry["filename"] for entry in result["skipped_files"]] == ["a.py"]
+
+
+class TestOrchestratorPool:
+    """Test reuse of orchestrators across requests"""
+
+    def test_orchestrators_are_pooled_by_options(self):
+        """Test that the same options return the same orchestrator"""
+        options = {"api_key": "test-key", "fused_review": True, "max_pr_tokens": 1000}
+        assert get_orchestrator(**options) is get_orchestrator(**options)
+        assert get_orchestrator(**dict(options, fused_review=False)) is not get_orchestrator(**options)
+
+
+class TestPRConsensus:
+    """Test the PR-level consensus over the file reviews"""
+
+    def test_pr_consensus_keeps_files_apart(self):
+        """Test that the PR-level consensus of two files does not merge their findings"""
+        orchestrator = SimpleMultiAgentOrchestrator(api_key="test-key", cache_manager=CacheManager())
+        reviews = [
+            {"status": "success", "filename": name, "consensus_results": {"recommendations": []},
+             "unit_review": {"findings": {"security_checker": [consensus_finding("Unsafe query", 12)]}}}
+            for name in ("a.py", "b.py")
+        ]
+        result = orchestrator.aggregate_pr_reviews(reviews, [{"filename": "a.py"}, {"filename": "b.py"}])
+        assert len(result["pr_consensus"]["recommendations"]) == 2
+
+    @pytest.mark.asyncio
+    async def test_structured_findings_reach_the_pr_consensus(self):
+        """Test that the PR consensus uses the file review's structured findings, not re-parsed text"""
+        orchestrator = scripted_orchestrator(calls=[])
+        code = "".join(f"value_{i} = {i}\n" for i in range(20))
+        review = await orchestrator.review_code(code, "db.py", context={"language": "python"})
+        result = orchestrator.aggregate_pr_reviews([review], [{"filename": "db.py"}])
+
+        def summary(recommendations):
+            return sorted((rec["consensus_severity"], rec["line_numbers"], rec["agent_agreement"])
+                          for rec in recommendations)
+
+        recommendations = result["pr_consensus"]["recommendations"]
+        assert summary(recommendations) == [("critical", [4, 6], 3), ("low", [12], 3)]
+        assert summary(recommendations) == summary(review["consensus_results"]["recommendations"])
+        assert {rec["filename"] for rec in recommendations} == {"db.py"}
+
+        # Reviews without the per-file findings fall back to the agents' structured issues
+        legacy = {key: value for key, value in review.items() if key != "agent_findings"}
+        result = orchestrator.aggregate_pr_reviews([legacy], [{"filename": "db.py"}])
+        assert summary(result["pr_consensus"]["recommendations"]) == summary(recommendations)
+
+class TestIncrementalReviews:
+    """Test reviews that reuse the findings of unchanged code units"""
+
+    @pytest.mark.asyncio
+    async def test_units_with_repeated_names_are_cached_apart(self):
+        """Test that changing a property setter reviews only the setter, not its same-named getter"""
+        cache = CacheManager()
+        code = (
+            "import os\n\n\n"
+            "class Box:\n"
+            "    @property\n"
+            "    def size(self):\n"
+            "        return self._size\n\n"
+            "    @size.setter\n"
+            "    def size(self, value):\n"
+            "        self._size = value\n\n\n"
+            "def load(path):\n"
+            "    return open(path).read()\n"
+        )
+        calls = []
+        await scripted_orchestrator(cache, calls, incremental_review=True).review_code(
+            code, "box.py", context={"language": "python"})
+
+        calls.clear()
+        result = await scripted_orchestrator(cache, calls, incremental_review=True).review_code(
+            code.replace("self._size = value", "self._size = int(value)"), "box.py", context={"language": "python"})
+        assert len(calls) == 3
+        assert result["unit_review"]["reviewed_units"] == ["Box.size"]
+        assert result["unit_review"]["reused_units"].count("Box.size") == 1
+        assert "def size(self):" not in calls[0]
+
+
 if __name__ == "__main__":
     asyncio.run(main())
\ No newline at end of file
@@ -0,0 +1,46 @@
+"""
+Test cases for the prompt layout used for provider-side prefix caching
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from agents.code_reviewer import REVIEW_PROMPT as CODE_REVIEW_PROMPT
+from agents.performance_analyzer import REVIEW_PROMPT as PERFORMANCE_REVIEW_PROMPT
+from agents.security_checker import REVIEW_PROMPT as SECURITY_REVIEW_PROMPT
+from utils.prompt_templates import ReviewPromptTemplate
+
+
+class TestPromptPrefix:
+    """Test prompt layout for provider-side prefix caching"""
+
+    def test_files_of_a_pr_share_the_prompt_prefix(self):
+        """Test that static and PR-level content comes first and the code last"""
+        shared = {"PR Description": "Add user lookup"}
+        first = CODE_REVIEW_PROMPT.render("x = 1", "a.py", "python", shared, ["note A"])
+        second = CODE_REVIEW_PROMPT.render("y = 2", "b.py", "python", shared)
+
+        prefix = CODE_REVIEW_PROMPT.static_prefix(shared)
+        assert first.startswith(prefix) and second.startswith(prefix)
+        assert "Add user lookup" in prefix and "a.py" not in prefix
+        assert first.endswith("```python\nx = 1\n```")
+        assert first.index("note A") > first.index("File: a.py")
+
+    def test_shared_prefix_has_no_response_format(self):
+        """Test that the text response format is left to the system message (replaced in structured mode)"""
+        for template in (CODE_REVIEW_PROMPT, SECURITY_REVIEW_PROMPT, PERFORMANCE_REVIEW_PROMPT):
+            assert "SEVERITY:" not in template.static_prefix()
+
+    def test_empty_details_are_left_out(self):
+        """Test that optional sections do not add blank blocks that shift the layout"""
+        template = ReviewPromptTemplate("Review it.")
+        assert template.render("x", "a.py", "python", details=["", "  "]) == \
+            "Review it.\n\nFile: a.py\n\n```python\nx\n```"
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
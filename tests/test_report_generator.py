@@ -0,0 +1,29 @@
+"""
+Test cases for the markdown review report
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.report_generator import ReportGenerator
+
+
+class TestReportGenerator:
+    """Test the sections of the review report"""
+
+    def test_skipped_files_are_noted_in_the_report(self):
+        """Test that files over the PR budget are listed in the report"""
+        lines = ReportGenerator()._generate_skipped_files({"skipped_files": [
+            {"filename": "huge.py", "estimated_tokens": 250000, "reason": "PR token budget exceeded"}
+        ]})
+        assert "## Files Not Reviewed\n" in lines
+        assert any("huge.py" in line and "250,000" in line for line in lines)
+        assert ReportGenerator()._generate_skipped_files({}) == []
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
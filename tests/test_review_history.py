@@ -0,0 +1,171 @@
+"""
+Test cases for the review history store and the reuse of unchanged files
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from benchmarks.trends import benchmark_lines
+from utils.review_history import ReviewHistory, file_review_key
+from tests.fakes import scripted_orchestrator
+
+
+HISTORY_CODE = {
+    "app/db.py": "def load_user(db, user_id):\n    return db.query(f\"SELECT * FROM users WHERE id = {user_id}\")\n",
+    "app/util.py": "def add(a, b):\n    return a + b\n\n\ndef sub(a, b):\n    return a - b\n"
+}
+
+
+HISTORY_PR = {"repo": "octo/app", "pr_number": 7, "head_sha": "abc123"}
+
+
+def history_files(**changes):
+    code = dict(HISTORY_CODE, **changes)
+    return [{"filename": name, "content": content, "language": "python"} for name, content in code.items()]
+
+
+class TestReviewHistory:
+    """Test the review history store and the reuse of stored reviews"""
+
+    def test_review_key(self):
+        """Test that the key changes with the content, the patch and the settings"""
+        key = file_review_key("a = 1\n", {"model": "gpt-4o"})
+        assert key == file_review_key("a = 1\n", {"model": "gpt-4o"})
+        assert key != file_review_key("a = 2\n", {"model": "gpt-4o"})
+        assert key != file_review_key("a = 1\n", {"model": "gpt-4o-mini"})
+        assert key != file_review_key("a = 1\n", {"model": "gpt-4o"}, patch="@@ -1 +1 @@")
+
+    @pytest.mark.asyncio
+    async def test_repeated_review_is_taken_from_the_history(self, tmp_path):
+        """Test that a second review of the same PR makes no model calls"""
+        history = ReviewHistory(str(tmp_path))
+        calls = []
+        first = await scripted_orchestrator(calls=calls, history=history).review_pull_request(
+            history_files(), pr_ref=HISTORY_PR
+        )
+        assert len(calls) == 6
+        assert all(review["usage"]["calls"] == 3 for review in first["file_reviews"])
+
+        # A new container: empty cache, same history
+        calls.clear()
+        second = await scripted_orchestrator(calls=calls, history=history).review_pull_request(
+            history_files(), pr_ref=dict(HISTORY_PR, head_sha="def456")
+        )
+        assert calls == []
+        assert [review["filename"] for review in second["file_reviews"]] == list(HISTORY_CODE)
+        assert all(review["from_history"] for review in second["file_reviews"])
+        assert second["cache_stats"]["hit_rate"] == 1.0
+        assert (len(second["pr_consensus"]["recommendations"]) ==
+                len(first["pr_consensus"]["recommendations"]))
+
+        reviews = history.pr_reviews("octo/app", 7)
+        assert [(row["head_sha"], row["reused_files"], row["calls"]) for row in reviews] == [
+            ("abc123", 0, 6), ("def456", 2, 0)
+        ]
+        # Only the changed file is reviewed; reuse is per repository
+        calls.clear()
+        await scripted_orchestrator(calls=calls, history=history).review_pull_request(
+            history_files(**{"app/util.py": "def add(a, b):\n    return b + a\n"}), pr_ref=HISTORY_PR
+        )
+        assert len(calls) == 3
+        calls.clear()
+        await scripted_orchestrator(calls=calls, history=history).review_pull_request(
+            history_files(), pr_ref=dict(HISTORY_PR, repo="octo/other")
+        )
+        assert len(calls) == 6
+
+    @pytest.mark.asyncio
+    async def test_reviews_with_a_failed_agent_are_not_reused(self, tmp_path):
+        """Test that a review missing an agent's findings is reviewed again"""
+        history = ReviewHistory(str(tmp_path))
+        orchestrator = scripted_orchestrator(calls=[], history=history)
+
+        def failing_agent(*args, **kwargs):
+            raise RuntimeError("invalid api key")
+
+        orchestrator.security_checker._create_agent = failing_agent
+        first = await orchestrator.review_pull_request(history_files(), pr_ref=HISTORY_PR)
+        assert all(review["status"] == "success" for review in first["file_reviews"])
+        assert all(review["orchestrator_results"]["agent_results"]["security_checker"]["status"] == "error"
+                   for review in first["file_reviews"])
+
+        assert [row["calls"] for row in history.pr_reviews("octo/app", 7)] == [4]
+
+        # A new container: the recorded reviews are not reused
+        calls = []
+        second = await scripted_orchestrator(calls=calls, history=history).review_pull_request(
+            history_files(), pr_ref=HISTORY_PR
+        )
+        assert len(calls) == 6
+        assert not any(review.get("from_history") for review in second["file_reviews"])
+
+    @pytest.mark.asyncio
+    async def test_unit_findings_outlive_the_cache(self, tmp_path):
+        """Test that incremental reviews find unit findings in the history after a cache loss"""
+        history = ReviewHistory(str(tmp_path))
+        calls = []
+        code = HISTORY_CODE["app/util.py"]
+        await scripted_orchestrator(calls=calls, history=history, incremental_review=True).review_code(
+            code, "app/util.py", context={"language": "python"}
+        )
+        assert len(calls) == 3
+
+        calls.clear()
+        changed = code.replace("return a - b", "return b - a")
+        result = await scripted_orchestrator(calls=calls, history=history, incremental_review=True).review_code(
+            changed, "app/util.py", context={"language": "python"}
+        )
+        assert len(calls) == 3
+        assert result["unit_review"]["reviewed_units"] == ["sub"]
+        assert "add" in result["unit_review"]["reused_units"]
+
+    def test_segments_are_compacted(self, tmp_path):
+        """Test that every writer's segment is readable and merged by compact()"""
+        directory = str(tmp_path)
+        result = {"file_reviews": [{"filename": "a.py", "status": "success", "consensus_results": {},
+                                    "usage": {"calls": 3, "cost": 0.01}, "markdown_report": "# a"}],
+                  "pr_consensus": {"recommendations": []}, "total_duration_seconds": 2.0}
+        writers = [ReviewHistory(directory), ReviewHistory(directory)]
+        for number, writer in enumerate(writers):
+            writer.record_review("octo/app", number, "sha", result, {"a.py": f"key{number}"})
+        writers[0].record_unit_findings({"unit-key": {"unit": "f", "findings": {"code_reviewer": []}}},
+                                        {"unit-key": "hash"})
+        assert len(os.listdir(os.path.join(directory, "segments"))) == 2
+
+        reader = ReviewHistory(directory)
+        assert set(reader.find_file_reviews("octo/app", {"a.py": "key1"})) == {"a.py"}
+        assert "markdown_report" not in reader.find_file_reviews("octo/app", {"a.py": "key1"})["a.py"]
+        assert reader.compact() == 2
+        assert os.listdir(os.path.join(directory, "segments")) == []
+
+        assert reader.find_file_reviews("octo/app", {"a.py": "key0"})["a.py"]["from_history"] is True
+        assert reader.find_unit_findings(["unit-key", "other"]) == {
+            "unit-key": {"unit": "f", "findings": {"code_reviewer": []}}
+        }
+        # A writer keeps appending to a segment after it was merged
+        writers[0].record_review("octo/app", 0, "sha2", result, {"a.py": "key0"})
+        assert reader.compact() == 1
+        assert [row["head_sha"] for row in reader.pr_reviews("octo/app", 0)] == ["sha", "sha2"]
+        trends = reader.review_trends()
+        assert trends[0]["reviews"] == 3 and trends[0]["cost"] == pytest.approx(0.03)
+
+    def test_benchmark_trends(self, tmp_path):
+        """Test that recorded benchmark runs are shown per level with their change"""
+        history = ReviewHistory(str(tmp_path))
+        for commit, latency in (("aaa", 2.0), ("bbb", 1.0)):
+            history.record_benchmark({"git_commit": commit, "config": {"corpus": "synthetic"}, "results": [
+                {"scenario": "webhook", "concurrency": 5, "latency_seconds": {"p50": latency}}
+            ]})
+        entries = history.benchmark_trends("webhook", 5)
+        assert [entry["git_commit"] for entry in entries] == ["aaa", "bbb"]
+        lines = benchmark_lines(entries)
+        assert lines[0] == "webhook x5"
+        assert lines[-1].split() == ["latency", "p50", "s", "1.0", "-50.0%"]
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
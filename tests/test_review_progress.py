@@ -0,0 +1,111 @@
+"""
+Test cases for the progress comment with early findings, updated per file
+"""
+
+import asyncio
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from benchmarks.fixtures import FixtureStore, llm_fixtures
+from orchestrator import SimpleMultiAgentOrchestrator
+from utils.analysis_context import AnalysisContext
+from utils.cache_manager import CacheManager
+from utils.review_progress import ReviewProgress, ast_findings, bandit_findings
+from tests.fakes import consensus_review
+
+
+class FakeCommentGitHub:
+    """Records the progress comment's create, update and delete calls"""
+
+    def __init__(self):
+        self.calls = []
+
+    async def create_issue_comment(self, owner, repo, pr_number, body):
+        self.calls.append(("create", body))
+        return {"id": 42}
+
+    async def update_issue_comment(self, owner, repo, comment_id, body):
+        self.calls.append(("update", body))
+        return {"id": comment_id}
+
+    async def delete_issue_comment(self, owner, repo, comment_id):
+        self.calls.append(("delete", comment_id))
+
+
+class TestReviewProgress:
+    """Test the progress comment of a running review"""
+
+    def test_early_findings(self):
+        """Test that dangerous calls and high-severity bandit hits are picked up"""
+        analysis = AnalysisContext("import os\n\ndef run(cmd):\n    os.system(cmd)\n    return eval(cmd)\n", "run.py")
+        assert [(f["line"], f["source"]) for f in ast_findings(analysis)] == [(4, "ast"), (5, "ast")]
+
+        static = {"analyses": {"bandit": {"security_issues": [
+            {"line": 3, "test_id": "B602", "severity": "HIGH", "text": "shell=True"},
+            {"line": 8, "test_id": "B101", "severity": "LOW", "text": "assert used"}
+        ]}}}
+        assert [f["line"] for f in bandit_findings(static)] == [3]
+        assert bandit_findings({}) == []
+
+    @pytest.mark.asyncio
+    async def test_updates_are_throttled_and_comment_is_replaced(self):
+        """Test that file results coalesce into one edit and the comment is deleted at the end"""
+        github = FakeCommentGitHub()
+        progress = ReviewProgress(github, "acme", "api", 7, min_interval=0.05)
+        progress.add_findings("a.py", [{"line": 4, "severity": "high", "message": "eval", "source": "ast"}])
+        await progress.start(["a.py", "b.py", "c.py"])
+        assert github.calls[0][0] == "create"
+        assert "`a.py` line 4: eval (ast)" in github.calls[0][1]
+        assert progress.first_feedback_seconds is not None
+
+        progress.file_reviewed("a.py", consensus_review("a.py", ("critical", [4])))
+        progress.file_reviewed("b.py", {"status": "error", "filename": "b.py"})
+        await asyncio.sleep(0.1)
+        updates = [body for kind, body in github.calls if kind == "update"]
+        assert len(updates) == 1
+        assert "Reviewed **2 of 3** files" in updates[0]
+        assert "| `a.py` | ✅ reviewed | 1 (1 critical) |" in updates[0]
+        assert "| `b.py` | ❌ failed | |" in updates[0]
+
+        progress.file_reviewed("c.py", consensus_review("c.py"))
+        await progress.finish()
+        assert github.calls[-1] == ("delete", 42)
+        assert [kind for kind, _ in github.calls].count("update") == 1
+
+    @pytest.mark.asyncio
+    async def test_failure_replaces_the_comment(self):
+        """Test that an error message takes the place of the progress comment"""
+        github = FakeCommentGitHub()
+        progress = ReviewProgress(github, "acme", "api", 7)
+        assert await progress.fail("Review failed") is False
+
+        await progress.start(["a.py"])
+        assert await progress.fail("Review failed") is True
+        await progress.finish()
+        assert github.calls[-1] == ("update", "Review failed")
+
+    @pytest.mark.asyncio
+    async def test_review_reports_progress(self):
+        """Test that a PR review posts its early findings before reporting each file"""
+        github = FakeCommentGitHub()
+        progress = ReviewProgress(github, "acme", "api", 7, min_interval=0)
+        orchestrator = SimpleMultiAgentOrchestrator(api_key="test-key", cache_manager=CacheManager())
+        files = [
+            {"filename": "a.py", "content": "def run(cmd):\n    return eval(cmd)\n", "language": "python"},
+            {"filename": "b.py", "content": "x = 1\n", "language": "python"}
+        ]
+        with llm_fixtures(FixtureStore()):
+            await orchestrator.review_pull_request(files, progress=progress)
+        await progress.finish()
+
+        assert github.calls[0][0] == "create" and "eval" in github.calls[0][1]
+        assert progress.reviewed == 2
+        assert github.calls[-1] == ("delete", 42)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
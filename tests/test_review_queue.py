@@ -0,0 +1,202 @@
+"""
+Test cases for the priority review queue with per-repo fairness and a concurrency cap
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.job_registry import PRJobRegistry, job_key
+from utils.review_queue import ReviewQueue, ReviewDispatcher, FairScheduler, classify_priority, make_job
+from tests.fakes import FakeModalDict
+
+
+class FakeModalQueue:
+    """In-memory stand-in for a partitioned modal.Queue"""
+
+    class _Method:
+        def __init__(self, func):
+            self.aio = func
+
+    def __init__(self):
+        self.partitions = {}
+
+        async def put(value, partition=None):
+            self.partitions.setdefault(partition, []).append(value)
+
+        async def get_many(n, block=True, partition=None):
+            items = self.partitions.get(partition, [])
+            batch, self.partitions[partition] = items[:n], items[n:]
+            return batch
+
+        async def length(partition=None):
+            return len(self.partitions.get(partition, []))
+
+        self.put = self._Method(put)
+        self.get_many = self._Method(get_many)
+        self.len = self._Method(length)
+
+
+def pr_event(repo, number, sha="sha1", changed_files=3, action="synchronize", additions=10):
+    """Minimal pull_request webhook payload"""
+    return {
+        "action": action,
+        "repository": {"full_name": repo},
+        "pull_request": {"number": number, "head": {"sha": sha}, "changed_files": changed_files,
+                         "additions": additions, "deletions": 0}
+    }
+
+
+class TestReviewQueue:
+    """Test priority lanes, fairness and admission control of queued reviews"""
+
+    def test_priority_lanes(self):
+        """Test that small and ready-for-review PRs go first and huge PRs last"""
+        assert classify_priority(pr_event("o/r", 1, changed_files=3)) == "high"
+        assert classify_priority(pr_event("o/r", 1, changed_files=40)) == "normal"
+        assert classify_priority(pr_event("o/r", 1, changed_files=40, action="ready_for_review")) == "high"
+        assert classify_priority(pr_event("o/r", 1, changed_files=300)) == "low"
+        assert classify_priority(pr_event("o/r", 1, changed_files=3, additions=20000)) == "low"
+
+    def test_repositories_take_turns_within_a_lane(self):
+        """Test that a burst from one repository does not starve the others"""
+        scheduler = FairScheduler()
+        for number in range(3):
+            scheduler.add(make_job(pr_event("mono/repo", number), f"mono/repo#{number}", "normal", number))
+        scheduler.add(make_job(pr_event("other/repo", 9), "other/repo#9", "normal", 10))
+        scheduler.add(make_job(pr_event("small/repo", 5), "small/repo#5", "high", 20))
+
+        assert [job["key"] for job in scheduler.ordered()] == [
+            "small/repo#5", "mono/repo#0", "other/repo#9", "mono/repo#1", "mono/repo#2"
+        ]
+        assert scheduler.depths() == {"high": 1, "normal": 4, "low": 0}
+
+        scheduler.add(make_job(pr_event("mono/repo", 0, sha="sha2"), "mono/repo#0", "normal", 30))
+        assert len(scheduler) == 5
+        assert [job for job in scheduler.ordered() if job["key"] == "mono/repo#0"][0]["enqueued_at"] == 0
+
+    @pytest.mark.asyncio
+    async def test_dispatcher_respects_cap_debounce_and_superseded_heads(self):
+        """Test that only quiet, current jobs start, and never more than the cap"""
+        now = [1000.0]
+        registry = PRJobRegistry(store=FakeModalDict(), debounce_seconds=30)
+        queue = ReviewQueue(queue=FakeModalQueue())
+        spawned = []
+        finished = set()
+
+        class Call:
+            def __init__(self, payload):
+                self.payload = payload
+                self.object_id = f"call-{payload['pull_request']['number']}"
+
+        async def spawn(payload):
+            spawned.append(payload["pull_request"]["number"])
+            return Call(payload)
+
+        async def is_done(call):
+            return call.payload["pull_request"]["number"] in finished
+
+        for number in range(4):
+            key = job_key("o", "r", number)
+            await registry.record_event(key, "sha1", now=now[0] - 60)
+            await queue.put(make_job(pr_event("o/r", number), key, "normal", now[0] - 60))
+        await registry.record_event(job_key("o", "r", 3), "sha2", now=now[0] - 60)
+        await registry.record_event(job_key("o", "r", 9), "sha1", now=now[0])
+        await queue.put(make_job(pr_event("o/r", 9), job_key("o", "r", 9), "high", now[0]))
+
+        dispatcher = ReviewDispatcher(queue, registry, spawn, is_done, max_concurrency=2, clock=lambda: now[0])
+        assert await dispatcher.dispatch_once() == 2
+        assert spawned == [0, 1]
+        assert dispatcher.stats["superseded"] == 0
+
+        finished.update({0, 1})
+        now[0] += 31
+        await dispatcher.dispatch_once()
+        assert spawned == [0, 1, 9, 2]
+        assert (await registry.get(job_key("o", "r", 9)))["call_id"] == "call-9"
+
+        finished.update({9, 2})
+        assert await dispatcher.dispatch_once() == 0
+        assert dispatcher.stats["superseded"] == 1 and len(dispatcher.scheduler) == 0
+
+    def test_jobs_carry_trace_context(self):
+        """Test that queued jobs keep the webhook's trace context for the dispatcher"""
+        job = make_job(pr_event("acme/api", 1, "a" * 40), "acme/api#1", "high",
+                       trace_context={"traceparent": "00-abc-def-01"})
+        assert job["trace_context"] == {"traceparent": "00-abc-def-01"}
+        assert make_job(pr_event("acme/api", 1, "a" * 40), "acme/api#1", "high")["trace_context"] == {}
+
+    @pytest.mark.asyncio
+    async def test_dispatcher_hands_work_on(self):
+        """Test that running reviews, failed spawns and late jobs survive the dispatcher"""
+
+        class LateRegistry(PRJobRegistry):
+            """Registry that sees a job queued just before the heartbeat stops"""
+            late_job = None
+
+            async def stop_heartbeat(self, name):
+                if self.late_job:
+                    await queue.put(self.late_job)
+                    self.late_job = None
+                await super().stop_heartbeat(name)
+
+        registry = LateRegistry(store=FakeModalDict(), debounce_seconds=0)
+        queue = ReviewQueue(queue=FakeModalQueue())
+        running = set()
+        spawned = []
+        hold = [True]
+
+        class Call:
+            def __init__(self, object_id):
+                self.object_id = object_id
+
+        async def spawn(payload):
+            number = payload["pull_request"]["number"]
+            if number == 2:
+                raise ConnectionError("spawn failed")
+            spawned.append(number)
+            if hold[0]:
+                running.add(f"call-{number}")
+            return Call(f"call-{number}")
+
+        async def is_done(call):
+            return call.object_id not in running
+
+        async def no_sleep(seconds):
+            pass
+
+        def dispatcher(**options):
+            return ReviewDispatcher(queue, registry, spawn, is_done, load_call=Call,
+                                    poll_interval=0, sleep=no_sleep, **options)
+
+        def job(number):
+            return make_job(pr_event("o/r", number), job_key("o", "r", number), "high", 0)
+
+        # A failed spawn puts the jobs not started back in the queue
+        await queue.put(job(1))
+        await queue.put(job(2))
+        with pytest.raises(ConnectionError):
+            await dispatcher().run(idle_exit_seconds=0)
+        assert [queued["key"] for queued in await queue.drain()] == [job_key("o", "r", 2)]
+
+        # The next dispatcher counts the review still running against the cap
+        await queue.put(job(3))
+        ticks = iter(range(1000))
+        successor = dispatcher(max_concurrency=1, clock=lambda: next(ticks))
+        stats = await successor.run(max_runtime=10)
+        assert stats["dispatched"] == 0 and stats["requeued"] == 1
+        assert list(successor.running) == [job_key("o", "r", 1)]
+
+        # A job queued just before the heartbeat stopped is still dispatched
+        running.clear()
+        hold[0] = False
+        registry.late_job = job(4)
+        stats = await dispatcher(max_concurrency=1).run(idle_exit_seconds=0)
+        assert stats["dispatched"] == 2 and stats["requeued"] == 0
+        assert spawned == [1, 3, 4]
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
@@ -0,0 +1,81 @@
+"""
+Test cases for tiered model routing with a cheap triage pass
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.analysis_context import AnalysisContext
+from utils.cache_manager import CacheManager
+from utils.review_router import ReviewRouter, summarize_routes
+from tests.fakes import AnsweringTriageAgent, ScriptedAgent
+
+
+class FakeTriage:
+    """Triage agent with a fixed answer"""
+
+    def __init__(self, tier):
+        self.tier = tier
+        self.calls = 0
+
+    async def classify(self, code, filename, signals="", context=None):
+        self.calls += 1
+        return self.tier
+
+
+class TestReviewRouter:
+    """Test tiered routing of review inputs"""
+
+    @pytest.mark.asyncio
+    async def test_local_signals_decide_clear_cases(self):
+        """Test that code-free inputs are skipped and security patterns go deep without triage"""
+        triage = FakeTriage("skip")
+        router = ReviewRouter(triage_agent=triage)
+
+        comments = "# Settings moved to config.yaml\n\n"
+        route = await router.route(AnalysisContext(comments, "a.py", "python", static_analysis={}), comments)
+        assert route["tier"] == "skip" and route["model"] is None
+
+        # In C a "#" line is a preprocessor directive, not a comment
+        includes = "#include <stdio.h>\n#define LIMIT 10\n"
+        assert router.local_signals(AnalysisContext(includes, "a.c", "c"), includes)["code_lines"] == 2
+
+        risky = "import os\ndef run(cmd):\n    return eval(cmd)\n"
+        route = await router.route(AnalysisContext(risky, "b.py", "python", static_analysis={}), risky)
+        assert (route["tier"], route["reason"], route["model"]) == ("deep", "security signals", "gpt-4o")
+        assert triage.calls == 0
+
+    @pytest.mark.asyncio
+    async def test_triage_routes_remaining_inputs(self):
+        """Test that the triage answer picks the tier and savings are estimated"""
+        router = ReviewRouter(triage_agent=FakeTriage("light"))
+        code = "def add(a, b):\n    return a + b\n"
+        route = await router.route(AnalysisContext(code, "m.py", "python", static_analysis={}), code)
+
+        assert (route["tier"], route["model"]) == ("light", "gpt-4o-mini")
+        assert route["estimated_savings"] > 0
+        assert router.get_stats()["decisions"]["light"] == 1
+        assert summarize_routes([route, {"tier": "deep", "estimated_savings": 0.0}])["decisions"] == {
+            "skip": 0, "light": 1, "deep": 1
+        }
+
+    @pytest.mark.asyncio
+    async def test_triage_answer_parsing(self):
+        """Test that triage answers are read leniently and default to deep"""
+        assert await AnsweringTriageAgent("Answer: LIGHT.").classify("x = 1", "a.py") == "light"
+        assert await AnsweringTriageAgent("not sure").classify("x = 1", "a.py") == "deep"
+
+    def test_review_model_selects_client_and_cache_key(self):
+        """Test that light reviews use their own model client and cache entries"""
+        agent = ScriptedAgent(CacheManager())
+        assert agent.cache_key("x = 1", {"review_model": "gpt-4o-mini"}) != agent.cache_key("x = 1")
+        assert agent._get_model_client("gpt-4o-mini") is agent._get_model_client("gpt-4o-mini")
+        assert agent._get_model_client("gpt-4o-mini") is not agent.model_client
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
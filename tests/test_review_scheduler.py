@@ -0,0 +1,110 @@
+"""
+Test cases for the bounded-parallel review scheduler
+"""
+
+import asyncio
+import pytest
+import sys
+import os
+import time
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.review_scheduler import ReviewScheduler, get_rate_limit_delay
+
+
+class TestReviewScheduler:
+    """Test bounded-parallel file review scheduling"""
+
+    def test_largest_files_first(self):
+        """Test that files are ordered largest-first with stable ties"""
+        files = [
+            {"filename": "small.py", "content": "x = 1"},
+            {"filename": "large.py", "content": "x = 1\n" * 100},
+            {"filename": "medium.py", "content": "x = 1\n" * 10},
+            {"filename": "small2.py", "content": "y = 2"}
+        ]
+
+        order = ReviewScheduler.order_by_size(files)
+        assert [files[i]["filename"] for i in order] == ["large.py", "medium.py", "small.py", "small2.py"]
+
+    def test_rate_limit_detection(self):
+        """Test classification of OpenAI and GitHub rate limit errors"""
+        tpm_error = Exception("Rate limit reached for gpt-4o on tokens per min (TPM). Please try again in 1.5s.")
+        assert get_rate_limit_delay(tpm_error) == 1.5
+
+        rpm_result = {"status": "error", "error": "requests per min (RPM): Please try again in 20ms."}
+        assert get_rate_limit_delay(rpm_result) == pytest.approx(0.02)
+
+        secondary = {"status": "error", "error": "You have exceeded a secondary rate limit"}
+        assert get_rate_limit_delay(secondary) >= 60
+
+        assert get_rate_limit_delay(Exception("Connection reset")) is None
+        assert get_rate_limit_delay({"status": "success"}) is None
+
+    @pytest.mark.asyncio
+    async def test_results_keep_input_order(self):
+        """Test that results are returned in input order regardless of completion order"""
+        scheduler = ReviewScheduler(max_concurrency=2)
+        files = [{"filename": f"file{i}.py", "content": "x\n" * (i + 1)} for i in range(5)]
+
+        async def review_file(file_info):
+            # Smaller files finish first
+            await asyncio.sleep(0.01 * len(file_info["content"]))
+            return {"status": "success", "filename": file_info["filename"]}
+
+        results = await scheduler.run(files, review_file)
+        assert [r["filename"] for r in results] == [f["filename"] for f in files]
+
+    @pytest.mark.asyncio
+    async def test_concurrency_limit(self):
+        """Test that no more than max_concurrency reviews run at once"""
+        scheduler = ReviewScheduler(max_concurrency=3)
+        running = 0
+        peak = 0
+
+        async def review_file(file_info):
+            nonlocal running, peak
+            running += 1
+            peak = max(peak, running)
+            await asyncio.sleep(0.02)
+            running -= 1
+            return {"status": "success"}
+
+        await scheduler.run([{"filename": f"f{i}.py", "content": ""} for i in range(10)], review_file)
+        assert peak == 3
+
+    @pytest.mark.asyncio
+    async def test_backoff_retries_rate_limited_calls(self):
+        """Test that rate limited results are retried until they succeed"""
+        scheduler = ReviewScheduler(base_delay=0.01, max_delay=0.05)
+        attempts = 0
+
+        async def call():
+            nonlocal attempts
+            attempts += 1
+            if attempts < 3:
+                return {"status": "error", "error": "Rate limit reached. Please try again in 10ms."}
+            return {"status": "success"}
+
+        start = time.time()
+        result = await scheduler.call_with_backoff(call)
+        assert result["status"] == "success"
+        assert attempts == 3
+        assert time.time() - start >= 0.02
+
+    @pytest.mark.asyncio
+    async def test_backoff_gives_up_after_max_retries(self):
+        """Test that the last error is returned once retries are exhausted"""
+        scheduler = ReviewScheduler(max_retries=1, base_delay=0.01)
+
+        async def call():
+            return {"status": "error", "error": "429 Too Many Requests"}
+
+        result = await scheduler.call_with_backoff(call)
+        assert result["status"] == "error"
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
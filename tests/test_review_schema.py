@@ -0,0 +1,41 @@
+"""
+Test cases for the structured (JSON schema) review findings
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.review_schema import (ReviewFindings, parse_review_findings, finding_to_issue, severity_counts,
+                                 response_format)
+from tests.fakes import FINDINGS_JSON
+
+
+class TestReviewSchema:
+    """Test decoding of structured findings into consensus issues"""
+
+    def test_findings_convert_to_consensus_issues(self):
+        """Test that decoded findings carry exact lines, location and severity"""
+        parsed = parse_review_findings(FINDINGS_JSON)
+        assert isinstance(parsed, ReviewFindings)
+
+        issues = [finding_to_issue(f.model_dump(), "security_checker", "security") for f in parsed.findings]
+        assert issues[0]["line_numbers"] == [4, 6]
+        assert issues[0]["location"] == "load_user (lines 4-6)"
+        assert issues[1]["line_numbers"] == [12]
+        assert issues[1]["type"] == "security"
+        assert severity_counts(issues) == {"critical": 1, "high": 0, "medium": 0, "low": 1}
+
+    def test_strict_response_format(self):
+        """Test that every object of the batch response schema is closed"""
+        schema = response_format()["json_schema"]["schema"]
+        finding = schema["$defs"]["ReviewFinding"]
+        assert schema["additionalProperties"] is False and finding["additionalProperties"] is False
+        assert set(finding["required"]) == set(finding["properties"])
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
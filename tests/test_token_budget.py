@@ -0,0 +1,45 @@
+"""
+Test cases for token counting, chunked requests and the PR token budget
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils.token_budget import TokenBudget, count_tokens, chunk_ranges
+
+
+class TestTokenBudget:
+    """Test token counting, request chunking and the PR token budget"""
+
+    def test_count_tokens(self):
+        """Test that token counts grow with the text and are zero for no text"""
+        assert count_tokens("") == 0
+        assert 0 < count_tokens("x = 1") < count_tokens("x = 1\n" * 50)
+
+    def test_chunks_fit_the_budget_and_start_at_boundaries(self):
+        """Test that long inputs are split under the budget at unit starts"""
+        lines = [f"def f{i}():" if i % 10 == 0 else f"    value_{i} = compute({i})" for i in range(60)]
+        chunks = chunk_ranges(lines, [(1, 60)], 120, boundaries=range(1, 61, 10))
+
+        assert len(chunks) > 1
+        assert [number for chunk in chunks for start, end in chunk for number in range(start, end + 1)] == \
+            list(range(1, 61))
+        for chunk in chunks:
+            code = "".join(lines[n - 1] + "\n" for start, end in chunk for n in range(start, end + 1))
+            assert count_tokens(code) <= 120
+            assert chunk[0][0] % 10 == 1
+
+    def test_budget_reservation(self):
+        """Test that reservations beyond the remaining budget are refused"""
+        budget = TokenBudget(100)
+        assert budget.try_reserve(60)
+        assert not budget.try_reserve(50)
+        assert budget.try_reserve(40) and budget.remaining == 0
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
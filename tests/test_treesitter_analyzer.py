@@ -0,0 +1,180 @@
+"""
+Test cases for tree-sitter structural analysis and units of non-Python files
+"""
+
+import pytest
+import sys
+import os
+
+# Add parent directory to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+
+from utils import treesitter_analyzer
+from utils.treesitter_analyzer import TreeSitterAnalyzer, split_units
+from utils.analysis_context import AnalysisContext
+from utils.ast_analyzer import analyze_python_code
+
+
+class FakeNode:
+    """Minimal tree-sitter Node stand-in"""
+
+    _next_id = 0
+
+    def __init__(self, type, start, end, children=(), fields=None, text="", named=True):
+        FakeNode._next_id += 1
+        self.id = FakeNode._next_id
+        self.type = type
+        self.start_point = (start, 0)
+        self.end_point = (end, 1)
+        self.children = list(children)
+        self.fields = fields or {}
+        self.is_named = named
+        self.has_error = False
+        self.parent = None
+        self._text = text.encode()
+        for child in self.children:
+            child.parent = self
+
+    @property
+    def named_children(self):
+        return [child for child in self.children if child.is_named]
+
+    @property
+    def child_count(self):
+        return len(self.children)
+
+    @property
+    def text(self):
+        if not self.children:
+            return self._text
+        return b" ".join(child.text for child in self.children)
+
+    @property
+    def prev_named_sibling(self):
+        if self.parent is None:
+            return None
+        siblings = self.parent.named_children
+        index = siblings.index(self)
+        return siblings[index - 1] if index > 0 else None
+
+    def child_by_field_name(self, name):
+        return self.fields.get(name)
+
+
+def build_js_tree(callee="eval"):
+    """Tree for:
+
+    import x from "y";
+    function load(a, b) {
+      if (a && b) { return eval(a); }
+      return 1;
+    }
+    class Store {
+      get(k) {
+        return fetch(k);
+      }
+    }
+    """
+    def leaf(type, row, text, named=True):
+        return FakeNode(type, row, row, text=text, named=named)
+
+    def call(row, name, arg):
+        function = leaf("identifier", row, name)
+        return FakeNode("call_expression", row, row,
+                        [function, FakeNode("arguments", row, row, [leaf("identifier", row, arg)])],
+                        fields={"function": function})
+
+    source = leaf("string", 0, '"y"')
+    imports = FakeNode("import_statement", 0, 0, [leaf("import", 0, "import", False), leaf("identifier", 0, "x"),
+                                                  leaf("from", 0, "from", False), source], fields={"source": source})
+
+    name = leaf("identifier", 1, "load")
+    params = FakeNode("formal_parameters", 1, 1, [leaf("identifier", 1, "a"), leaf("identifier", 1, "b")])
+    condition = FakeNode("binary_expression", 2, 2, [leaf("identifier", 2, "a"), leaf("&&", 2, "&&", False),
+                                                     leaf("identifier", 2, "b")])
+    branch = FakeNode("if_statement", 2, 2, [condition, FakeNode("statement_block", 2, 2, [
+        FakeNode("return_statement", 2, 2, [call(2, callee, "a")])
+    ])])
+    body = FakeNode("statement_block", 1, 4, [branch, FakeNode("return_statement", 3, 3, [leaf("number", 3, "1")])])
+    function = FakeNode("function_declaration", 1, 4, [leaf("function", 1, "function", False), name, params, body],
+                        fields={"name": name, "parameters": params, "body": body})
+
+    method_name = leaf("property_identifier", 6, "get")
+    method_params = FakeNode("formal_parameters", 6, 6, [leaf("identifier", 6, "k")])
+    method_body = FakeNode("statement_block", 6, 8, [FakeNode("return_statement", 7, 7, [call(7, "fetch", "k")])])
+    method = FakeNode("method_definition", 6, 8, [method_name, method_params, method_body],
+                      fields={"name": method_name, "parameters": method_params, "body": method_body})
+    class_body = FakeNode("class_body", 5, 9, [leaf("{", 5, "{", False), method, leaf("}", 9, "}", False)])
+    class_name = leaf("identifier", 5, "Store")
+    cls = FakeNode("class_declaration", 5, 9, [leaf("class", 5, "class", False), class_name, class_body],
+                   fields={"name": class_name, "body": class_body})
+
+    root = FakeNode("program", 0, 9, [imports, function, cls])
+
+    class Tree:
+        root_node = root
+
+    return Tree()
+
+
+JS_CODE = "\n".join(["import x from \"y\";", "function load(a, b) {", "  if (a && b) { return eval(a); }",
+                     "  return 1;", "}", "class Store {", "  get(k) {", "    return fetch(k);", "  }", "}"])
+
+
+class TestTreeSitterAnalyzer:
+    """Test tree-sitter structural analysis on a hand-built syntax tree"""
+
+    def test_schema_matches_ast_analyzer(self):
+        """Test that functions, complexity, calls and metrics follow the ASTAnalyzer schema"""
+        results = TreeSitterAnalyzer("javascript").analyze_tree(build_js_tree())
+        data = results["ast_analysis"]
+
+        assert set(analyze_python_code("x = 1")["ast_analysis"]) <= set(data)
+        assert [f["name"] for f in data["functions"]] == ["load", "get"]
+        assert data["functions"][0]["parameters"] == ["a", "b"]
+        assert (data["functions"][0]["line"], data["functions"][0]["end_line"]) == (2, 5)
+        assert data["complexity"] == {"load": 3, "get": 1}
+        assert data["function_calls"] == {"eval": 1, "fetch": 1}
+        assert data["security_patterns"][0]["function"] == "eval"
+        assert data["security_patterns"][0]["line"] == 3
+        assert data["classes"][0]["methods"] == ["get"]
+        assert data["imports"][0]["module"] == "y"
+        assert data["metrics"]["total_functions"] == 2
+
+    def test_units_hash_per_function(self):
+        """Test that units split like Python's and only the edited function's hash changes"""
+        units = split_units(build_js_tree(), JS_CODE, "javascript")
+        edited = split_units(build_js_tree(callee="safeEval"), JS_CODE, "javascript")
+
+        assert [u.name for u in units] == ["load", "Store.get", "Store", "<module>"]
+        assert units[0].ranges == [(2, 5)]
+        assert units[2].ranges == [(6, 6), (10, 10)]
+        assert units[0].hash != edited[0].hash
+        assert [u.hash for u in units[1:]] == [u.hash for u in edited[1:]]
+
+    def test_analysis_context_uses_treesitter_parser(self):
+        """Test that non-Python files get AST results and units through the shared context"""
+
+        class FakeParser:
+            def parse(self, source):
+                return build_js_tree()
+
+        treesitter_analyzer._parsers["javascript"] = FakeParser()
+        try:
+            analysis = AnalysisContext(JS_CODE, "store.js", "javascript")
+            assert analysis.supports_structure
+            assert analysis.ast_results()["ast_analysis"]["complexity"]["load"] == 3
+            assert [u.name for u in analysis.units()] == ["load", "Store.get", "Store", "<module>"]
+        finally:
+            treesitter_analyzer._parsers.pop("javascript", None)
+
+    def test_unavailable_language_reports_error(self):
+        """Test that languages without a grammar report an error instead of raising"""
+        analysis = AnalysisContext("some text", "notes.txt", "text")
+        assert not analysis.supports_structure
+        assert "error" in analysis.ast_results()["ast_analysis"]
+        assert analysis.units() is None
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
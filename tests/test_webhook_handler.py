@@ -0,0 +1,95 @@
+"""
+Test cases for the distributed PR review of the webhook handler
+"""
+
+import asyncio
+import pytest
+import sys
+import os
+
+# Add parent directory (and modal_app, as when deployed) to path
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), "modal_app"))
+
+modal = pytest.importorskip("modal")
+
+import webhook_handler
+from utils.review_history import ReviewHistory
+from tests.fakes import scripted_orchestrator
+
+
+PR_CODE = {name: f"def {name[0]}():\n    return {i}\n" for i, name in enumerate(("a.py", "b.py", "c.py", "d.py"))}
+
+
+def pr_files():
+    return [{"filename": name, "content": content, "language": "python", "patch": ""}
+            for name, content in PR_CODE.items()]
+
+
+class FakeStarmap:
+    """FileReviewService.review_code.starmap whose later files finish first
+
+    Files are reviewed with a scripted orchestrator, as in the service's
+    containers; the failing files raise instead.
+    """
+
+    def __init__(self, failing=()):
+        self.failing = set(failing)
+        self.dispatched = []
+        self.orchestrator = scripted_orchestrator(calls=[])
+
+    async def aio(self, file_args, order_outputs=False, return_exceptions=False):
+        file_args = list(file_args)
+        self.dispatched = [args[1] for args in file_args]
+
+        async def review(position, code, filename, pr_description, context, trace_context):
+            await asyncio.sleep(0.01 * (len(file_args) - position))
+            if filename in self.failing:
+                raise RuntimeError("container lost")
+            return await self.orchestrator.review_code(code, filename, pr_description, context)
+
+        tasks = [asyncio.ensure_future(review(i, *args)) for i, args in enumerate(file_args)]
+        for task in (tasks if order_outputs else asyncio.as_completed(tasks)):
+            try:
+                yield await task
+            except Exception as e:
+                if not return_exceptions:
+                    raise
+                yield e
+
+
+class TestDistributedReview:
+    """Test the reduce of file reviews dispatched to the FileReviewService"""
+
+    @pytest.mark.asyncio
+    async def test_reviews_come_back_in_file_order(self, tmp_path, monkeypatch):
+        """Test that out-of-order results, a failed file and stored reviews merge in the PR's file order"""
+        history = ReviewHistory(str(tmp_path))
+        pr_ref = {"repo": "octo/app", "pr_number": 7, "head_sha": "abc123"}
+        await scripted_orchestrator(calls=[], history=history).review_pull_request(pr_files()[:1], pr_ref=pr_ref)
+
+        starmap = FakeStarmap(failing={"c.py"})
+
+        class FakeReviewService:
+            class review_code:
+                pass
+
+        FakeReviewService.review_code.starmap = starmap
+        monkeypatch.setattr(modal.Cls, "from_name", lambda app_name, name: FakeReviewService)
+
+        result = await webhook_handler.review_files_distributed(
+            scripted_orchestrator(history=history), pr_files(), "PR", pr_ref=pr_ref
+        )
+        reviews = result["file_reviews"]
+        assert starmap.dispatched == ["b.py", "c.py", "d.py"]
+        assert [review["filename"] for review in reviews] == list(PR_CODE)
+        assert reviews[0]["from_history"] is True
+        assert [review["status"] for review in reviews] == ["success", "success", "error", "success"]
+        assert reviews[2]["error"] == "container lost"
+
+        recommendations = result["pr_consensus"]["recommendations"]
+        assert {rec["filename"] for rec in recommendations} == {"a.py", "b.py", "d.py"}
+
+
+if __name__ == "__main__":
+    pytest.main([__file__, "-v"])
@@ -0,0 +1,144 @@
+"""
+Analysis Context shared by the orchestrator and the agents
+
+Holds the local (non-LLM) analysis of one file: the line index, the parsed
+AST (ast for Python, tree-sitter for other languages), structural metrics,
+code units and static analysis output. Each part is
+computed on first use and memoized, so the file is parsed once no matter how
+many agents look at it. Static analysis runs in a worker thread and can be
+started ahead of the agents so it overlaps with their LLM calls.
+"""
+
+import ast
+import asyncio
+from typing import Dict, List, Any, Optional
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.ast_analyzer import ASTAnalyzer
+from utils.code_units import CodeUnit, split_into_units
+from utils.static_analyzer import run_static_analysis
+from utils import treesitter_analyzer
+
+PYTHON_LANGUAGES = ("python", "py", "auto-detect")
+
+
+class AnalysisContext:
+    """Memoized local analysis of one file"""
+
+    def __init__(self, code: str, filename: str = "unknown", language: str = "python",
+                 static_analysis: Optional[Dict[str, Any]] = None):
+        """Initialize the context
+
+        Args:
+            code: Full file content
+            filename: Name of the file
+            language: Language of the file
+            static_analysis: Precomputed static analysis results (e.g. from a
+                PR-wide batch run); computed on demand otherwise
+        """
+        self.code = code
+        self.filename = filename
+        self.language = language
+        self._lines: Optional[List[str]] = None
+        self._tree: Optional[ast.Module] = None
+        self._syntax_error: Optional[SyntaxError] = None
+        self._parsed = False
+        self._ast_results: Optional[Dict[str, Any]] = None
+        self._units: Optional[List[CodeUnit]] = None
+        self._units_computed = False
+        self._static_results = static_analysis
+        self._static_task: Optional[asyncio.Future] = None
+
+    @property
+    def is_python(self) -> bool:
+        return (self.language or "").lower() in PYTHON_LANGUAGES
+
+    @property
+    def supports_structure(self) -> bool:
+        """Whether AST results and code units are available for this language"""
+        return self.is_python or treesitter_analyzer.supports_language(self.language)
+
+    @property
+    def lines(self) -> List[str]:
+        """Lines of the file (index 0 is line 1)"""
+        if self._lines is None:
+            self._lines = self.code.split("\n")
+        return self._lines
+
+    def line(self, number: int) -> Optional[str]:
+        """Text of a 1-based line number"""
+        if 1 <= number <= len(self.lines):
+            return self.lines[number - 1]
+        return None
+
+    @property
+    def tree(self) -> Optional[Any]:
+        """Parsed module (an ast.Module for Python, a tree-sitter tree otherwise),
+        or None if the code does not parse or the language is not supported"""
+        if not self._parsed:
+            self._parsed = True
+            if self.is_python:
+                try:
+                    self._tree = ast.parse(self.code)
+                except SyntaxError as e:
+                    self._syntax_error = e
+            else:
+                self._tree = treesitter_analyzer.parse_code(self.code, self.language)
+        return self._tree
+
+    def ast_results(self) -> Dict[str, Any]:
+        """analyze_code_structure() output, computed from the shared parse"""
+        if self._ast_results is None:
+            tree = self.tree
+            if self.is_python:
+                if tree is None:
+                    self._ast_results = ASTAnalyzer.syntax_error_result(self._syntax_error)
+                else:
+                    self._ast_results = ASTAnalyzer().analyze_tree(tree)
+            elif tree is None:
+                self._ast_results = treesitter_analyzer.unsupported_result(self.language)
+            else:
+                self._ast_results = treesitter_analyzer.TreeSitterAnalyzer(self.language).analyze_tree(tree)
+        return self._ast_results
+
+    def units(self) -> Optional[List[CodeUnit]]:
+        """Function/class units of the file, or None if it cannot be split"""
+        if not self._units_computed:
+            self._units_computed = True
+            if self.tree is not None:
+                language = "python" if self.is_python else self.language.lower()
+                self._units = split_into_units(self.code, self.tree, language)
+        return self._units
+
+    def provide_static_analysis(self, results: Dict[str, Any]):
+        """Use results computed elsewhere (e.g. a PR-wide batch)"""
+        if results and self._static_task is None:
+            self._static_results = results
+
+    def start_static_analysis(self) -> asyncio.Future:
+        """Start static analysis in a worker thread (once) without waiting for it"""
+        if self._static_task is None:
+            if self._static_results is not None:
+                self._static_task = asyncio.get_running_loop().create_future()
+                self._static_task.set_result(self._static_results)
+            else:
+                self._static_task = asyncio.ensure_future(
+                    asyncio.to_thread(run_static_analysis, self.code, self.filename)
+                )
+        return self._static_task
+
+    def static_analysis_if_ready(self) -> Optional[Dict[str, Any]]:
+        """Static analysis results if they are already available, without waiting"""
+        if self._static_task is None:
+            return self._static_results
+        if self._static_task.done() and not self._static_task.cancelled() and self._static_task.exception() is None:
+            return self._static_task.result()
+        return None
+
+    async def static_analysis(self) -> Dict[str, Any]:
+        """Static analysis results, shared by every caller"""
+        try:
+            return await asyncio.shield(self.start_static_analysis())
+        except Exception:
+            return {}
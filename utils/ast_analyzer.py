@@ -35,6 +35,13 @@ class ASTAnalyzer(ast.NodeVisitor):
         """
         try:
             tree = ast.parse(code)
+        except SyntaxError as e:
+            return self.syntax_error_result(e)
+        return self.analyze_tree(tree)
+    
+    def analyze_tree(self, tree: ast.AST) -> Dict[str, Any]:
+        """Analyze an already parsed module (see analyze)"""
+        try:
             self.visit(tree)
             
             return {
@@ -50,14 +57,6 @@ class ASTAnalyzer(ast.NodeVisitor):
                     "code_smells": self.code_smells
                 }
             }
-        except SyntaxError as e:
-            return {
-                "ast_analysis": {
-                    "error": f"Syntax error: {str(e)}",
-                    "line": e.lineno,
-                    "offset": e.offset
-                }
-            }
         except Exception as e:
             return {
                 "ast_analysis": {
@@ -65,6 +64,17 @@ class ASTAnalyzer(ast.NodeVisitor):
                 }
             }
     
+    @staticmethod
+    def syntax_error_result(error: SyntaxError) -> Dict[str, Any]:
+        """Analysis result for code that does not parse"""
+        return {
+            "ast_analysis": {
+                "error": f"Syntax error: {str(error)}",
+                "line": error.lineno,
+                "offset": error.offset
+            }
+        }
+    
     def visit_FunctionDef(self, node: ast.FunctionDef):
         """Analyze function definitions"""
         self.current_function = node.name
@@ -96,6 +106,7 @@ class ASTAnalyzer(ast.NodeVisitor):
         self.functions.append({
             "name": node.name,
             "line": node.lineno,
+            "end_line": node.end_lineno,
             "parameters": [arg.arg for arg in node.args.args],
             "complexity": complexity,
             "decorators": [self._get_decorator_name(d) for d in node.decorator_list],
@@ -122,6 +133,7 @@ class ASTAnalyzer(ast.NodeVisitor):
         self.classes.append({
             "name": node.name,
             "line": node.lineno,
+            "end_line": node.end_lineno,
             "methods": methods,
             "bases": [self._get_name(base) for base in node.bases],
             "decorators": [self._get_decorator_name(d) for d in node.decorator_list],
@@ -296,4 +308,16 @@ class ASTAnalyzer(ast.NodeVisitor):
 def analyze_python_code(code: str) -> Dict[str, Any]:
     """Convenience function to analyze Python code"""
     analyzer = ASTAnalyzer()
-    return analyzer.analyze(code)
\ No newline at end of file
+    return analyzer.analyze(code)
+
+
+def analyze_code_structure(code: str, language: str = "python") -> Dict[str, Any]:
+    """Structural analysis for any supported language (same schema as analyze_python_code)
+    
+    Python uses the stdlib ast module; other languages use tree-sitter when
+    it is installed.
+    """
+    if (language or "python").lower() in ("python", "py", "auto-detect"):
+        return analyze_python_code(code)
+    from utils.treesitter_analyzer import analyze_with_treesitter
+    return analyze_with_treesitter(code, language)
@@ -0,0 +1,638 @@
+"""
+Batch Audit - whole-repository reviews through the OpenAI Batch API
+
+An audit reviews every source file of a repository snapshot. Latency does
+not matter there, so the agents' requests go through the Batch API at half
+the price instead of being sent one at a time. An audit has three phases:
+
+1. prepare: the files are reviewed with a request recorder set on the
+   orchestrator. Units and review inputs already in the cache cost nothing;
+   every other agent request is appended to a batch input file
+2. batches: the input files are submitted and polled. The results of
+   finished batches are saved next to their input, and requests a batch did
+   not answer are submitted again in a new batch
+3. report: the results are loaded into the review cache and the files are
+   reviewed again, this time from the cache. The recorder stays set, so a
+   request no batch answered is not sent at full price but left without
+   findings and listed in report.json. The file reviews go through the
+   PR-level WeightedConsensus and ReportGenerator into a single audit report
+
+All state lives in the audit directory (on the Modal Volume) and is saved
+after every group of files and every batch, so an interrupted job continues
+where it stopped.
+"""
+
+import asyncio
+import json
+import os
+import time
+from typing import Dict, List, Any, Optional, Callable
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.analysis_context import AnalysisContext
+from utils.github_integration import LANGUAGE_EXTENSIONS
+from utils.logger import get_logger, api_tracker, perf_monitor
+
+# Initialize logger
+logger = get_logger(__name__)
+
+BATCH_ENDPOINT = "/v1/chat/completions"
+
+# Batch API limits per input file: 50,000 requests and 200 MB
+MAX_BATCH_REQUESTS = 50000
+MAX_BATCH_BYTES = 190 * 1024 * 1024
+
+# Audit phases
+PREPARE_PHASE = "prepare"
+BATCHES_PHASE = "batches"
+REPORT_PHASE = "report"
+DONE_PHASE = "done"
+FAILED_PHASE = "failed"
+
+# Batch statuses after which the batch's results are final
+FINAL_BATCH_STATUSES = ("completed", "expired", "cancelled")
+
+# Directories never audited (dependencies, build output, tool state)
+EXCLUDED_DIRS = frozenset((
+    "node_modules", "vendor", "third_party", "venv", "env", "__pycache__",
+    "dist", "build", "target", "site-packages"
+))
+
+# File review fields not needed for the audit report
+DROPPED_REVIEW_FIELDS = ("markdown_report", "performance_metrics")
+
+STATE_FILE = "state.json"
+FILES_FILE = "files.json"
+INDEX_FILE = "requests.jsonl"
+REVIEWS_FILE = "reviews.jsonl"
+UNANSWERED_FILE = "unanswered.jsonl"
+REPORT_FILE = "report.md"
+SUMMARY_FILE = "report.json"
+BATCH_DIR = "batches"
+
+
+def walk_snapshot(root: str,
+                  max_file_bytes: int = 256 * 1024,
+                  excluded_dirs: frozenset = EXCLUDED_DIRS) -> Dict[str, List[Dict[str, Any]]]:
+    """List the source files of a repository snapshot
+
+    Args:
+        root: Directory with the checked-out repository
+        max_file_bytes: Larger files are skipped (generated or minified code)
+        excluded_dirs: Directory names that are not descended into (hidden
+            directories are skipped as well)
+
+    Returns:
+        Dict with 'files' (filename relative to root and language, sorted by
+        filename) and 'skipped' (filename and reason)
+    """
+    files = []
+    skipped = []
+    for directory, subdirs, filenames in os.walk(root):
+        subdirs[:] = sorted(d for d in subdirs if d not in excluded_dirs and not d.startswith("."))
+        for name in sorted(filenames):
+            language = LANGUAGE_EXTENSIONS.get(os.path.splitext(name)[1])
+            if language is None:
+                continue
+            path = os.path.join(directory, name)
+            filename = os.path.relpath(path, root).replace(os.sep, "/")
+            if os.path.getsize(path) > max_file_bytes:
+                skipped.append({"filename": filename, "reason": f"larger than {max_file_bytes // 1024} KB"})
+            elif read_snapshot_file(root, filename) is None:
+                skipped.append({"filename": filename, "reason": "not UTF-8 text"})
+            else:
+                files.append({"filename": filename, "language": language})
+    files.sort(key=lambda file_info: file_info["filename"])
+    return {"files": files, "skipped": skipped}
+
+
+def read_snapshot_file(root: str, filename: str) -> Optional[str]:
+    """Content of a snapshot file (None if it is not UTF-8 text)"""
+    try:
+        with open(os.path.join(root, filename), encoding="utf-8") as f:
+            return f.read()
+    except (UnicodeDecodeError, OSError):
+        return None
+
+
+def empty_usage() -> Dict[str, Any]:
+    return {"answered": 0, "input_tokens": 0, "cached_input_tokens": 0, "output_tokens": 0, "cost": 0.0}
+
+
+class OpenAIBatchClient:
+    """Batch API calls of an audit, made with the openai package's async client"""
+
+    def __init__(self, api_key: str = None, client: Any = None):
+        if client is None:
+            from openai import AsyncOpenAI
+            client = AsyncOpenAI(api_key=api_key or os.getenv("OPENAI_API_KEY"))
+        self.client = client
+
+    async def submit(self, name: str, data: bytes, metadata: Dict[str, str]) -> str:
+        """Upload a JSONL input file and start a batch over it
+
+        Returns:
+            ID of the batch
+        """
+        input_file = await self.client.files.create(file=(name, data), purpose="batch")
+        batch = await self.client.batches.create(
+            input_file_id=input_file.id,
+            endpoint=BATCH_ENDPOINT,
+            completion_window="24h",
+            metadata=metadata
+        )
+        return batch.id
+
+    async def status(self, batch_id: str) -> Dict[str, Any]:
+        """Status, output and error file IDs and errors of a batch"""
+        batch = await self.client.batches.retrieve(batch_id)
+        errors = (getattr(batch.errors, "data", None) or []) if batch.errors else []
+        return {
+            "status": batch.status,
+            "output_file_id": batch.output_file_id,
+            "error_file_id": batch.error_file_id,
+            "errors": [getattr(error, "message", str(error)) for error in errors]
+        }
+
+    async def download(self, file_id: str) -> str:
+        """Content of an output or error file"""
+        response = await self.client.files.content(file_id)
+        return response.text
+
+
+class BatchAudit:
+    """A resumable whole-repository audit"""
+
+    def __init__(self,
+                 orchestrator: Any,
+                 audit_dir: str,
+                 batch_client: Any = None,
+                 description: str = "Repository audit",
+                 group_size: int = 50,
+                 max_batch_requests: int = MAX_BATCH_REQUESTS,
+                 max_batch_bytes: int = MAX_BATCH_BYTES,
+                 max_attempts: int = 2,
+                 commit: Optional[Callable[[], Any]] = None):
+        """Initialize (or reopen) an audit
+
+        Args:
+            orchestrator: SimpleMultiAgentOrchestrator reviewing the files; it
+                needs a cache and must not route files by triage (a triage
+                answer would change what is reviewed between the phases).
+                Its cache should not expire entries (ttl=None) for an audit,
+                as the phases may be a day apart
+            audit_dir: Directory holding the audit's state and results
+            batch_client: Client with submit/status/download coroutines
+                (defaults to OpenAIBatchClient with the orchestrator's key)
+            description: Title of the audit report
+            group_size: Files planned and reviewed together (and the unit of
+                resumption in the prepare and report phases)
+            max_batch_requests: Most requests per batch input file
+            max_batch_bytes: Largest batch input file in bytes
+            max_attempts: Times a request is submitted before it is reported
+                as unanswered
+            commit: Called after the state is saved (e.g. to commit the
+                Modal Volume)
+        """
+        if orchestrator.cache_manager is None:
+            raise ValueError("Batch audits need the review cache")
+        if orchestrator.router is not None:
+            raise ValueError("Batch audits need model routing turned off")
+
+        self.orchestrator = orchestrator
+        self.audit_dir = audit_dir
+        self._batch_client = batch_client
+        self.description = description
+        self.group_size = group_size
+        self.max_batch_requests = max_batch_requests
+        self.max_batch_bytes = max_batch_bytes
+        self.max_attempts = max_attempts
+        self.commit = commit
+        self.agents = {
+            agent.agent_name: agent
+            for agent in (orchestrator.code_reviewer, orchestrator.security_checker,
+                          orchestrator.performance_analyzer, orchestrator.fused_reviewer)
+            if agent is not None
+        }
+        self._models: Optional[Dict[str, Dict[str, str]]] = None
+
+        os.makedirs(os.path.join(audit_dir, BATCH_DIR), exist_ok=True)
+        self.state = self._read_json(STATE_FILE) or {
+            "audit_id": os.path.basename(os.path.normpath(audit_dir)),
+            "phase": PREPARE_PHASE,
+            "snapshot": None,
+            "files": 0,
+            "prepared_files": 0,
+            "requests": 0,
+            "index_bytes": 0,
+            "open_part": None,
+            "parts": [],
+            "reported_files": 0,
+            "reviews_bytes": 0,
+            "unanswered_bytes": 0,
+            "review_seconds": 0.0,
+            "usage": empty_usage(),
+            "created_at": time.time(),
+            "error": None
+        }
+
+    @property
+    def batch_client(self) -> Any:
+        if self._batch_client is None:
+            self._batch_client = OpenAIBatchClient(api_key=self.orchestrator.api_key)
+        return self._batch_client
+
+    @property
+    def done(self) -> bool:
+        return self.state["phase"] in (DONE_PHASE, FAILED_PHASE)
+
+    def _path(self, name: str) -> str:
+        return os.path.join(self.audit_dir, name)
+
+    def _read_json(self, name: str) -> Optional[Any]:
+        if not os.path.exists(self._path(name)):
+            return None
+        with open(self._path(name)) as f:
+            return json.load(f)
+
+    def _write_json(self, name: str, data: Any):
+        # Written to a temporary file first, so an interrupted write keeps the old state
+        temporary = self._path(name + ".tmp")
+        with open(temporary, "w") as f:
+            json.dump(data, f, default=str)
+        os.replace(temporary, self._path(name))
+
+    def _save_state(self):
+        self.state["updated_at"] = time.time()
+        self._write_json(STATE_FILE, self.state)
+        if self.commit is not None:
+            self.commit()
+
+    def _truncate(self, name: str, size: int):
+        """Cut a file back to the size recorded in the state (drops unsaved progress)"""
+        path = self._path(name)
+        if os.path.exists(path) and os.path.getsize(path) > size:
+            with open(path, "r+b") as f:
+                f.truncate(size)
+
+    def _append(self, name: str, lines: List[str]) -> int:
+        """Append lines to a file and return its new size"""
+        with open(self._path(name), "ab") as f:
+            for line in lines:
+                f.write(line.encode("utf-8") + b"\n")
+            return f.tell()
+
+    def _read_lines(self, name: str) -> List[Dict[str, Any]]:
+        if not os.path.exists(self._path(name)):
+            return []
+        with open(self._path(name)) as f:
+            return [json.loads(line) for line in f if line.strip()]
+
+    async def step(self, snapshot_dir: Optional[str] = None) -> Dict[str, Any]:
+        """Advance the audit as far as it gets without waiting for batches
+
+        Args:
+            snapshot_dir: Repository snapshot (needed by the first step; later
+                steps use the one recorded in the state)
+
+        Returns:
+            The audit state
+        """
+        if self.state["phase"] == PREPARE_PHASE:
+            await self._prepare(snapshot_dir or self.state["snapshot"])
+        if self.state["phase"] == BATCHES_PHASE:
+            await self._advance_batches()
+        if self.state["phase"] == REPORT_PHASE:
+            await self._report()
+        return self.state
+
+    async def run(self,
+                  snapshot_dir: Optional[str] = None,
+                  poll_interval: float = 60.0,
+                  sleep: Callable[[float], Any] = asyncio.sleep) -> Dict[str, Any]:
+        """Run the audit to the end, polling the batches every poll_interval seconds"""
+        await self.step(snapshot_dir)
+        while not self.done:
+            await sleep(poll_interval)
+            await self.step()
+        return self.state
+
+    # Prepare phase
+
+    async def _prepare(self, snapshot_dir: Optional[str]):
+        """Record the requests of all files into batch input files"""
+        snapshot = self._read_json(FILES_FILE)
+        if snapshot is None:
+            if not snapshot_dir:
+                raise ValueError("The first step of an audit needs the snapshot directory")
+            snapshot = walk_snapshot(snapshot_dir)
+            self._write_json(FILES_FILE, snapshot)
+            self.state.update(snapshot=snapshot_dir, files=len(snapshot["files"]))
+            self._save_state()
+            logger.info("Audit snapshot listed", audit_id=self.state["audit_id"],
+                        files=len(snapshot["files"]), skipped=len(snapshot["skipped"]))
+
+        files = snapshot["files"]
+        self._truncate(INDEX_FILE, self.state["index_bytes"])
+        if self.state["open_part"]:
+            self._truncate(self.state["open_part"]["name"], self.state["open_part"]["bytes"])
+        recorded = {entry["id"] for entry in self._read_lines(INDEX_FILE)}
+
+        for start in range(self.state["prepared_files"], len(files), self.group_size):
+            group = files[start:start + self.group_size]
+            requests = []
+            self.orchestrator.set_request_recorder(
+                lambda key, agent, body: requests.append((key, agent.agent_name, body))
+            )
+            try:
+                await self._review_group(group)
+            finally:
+                self.orchestrator.set_request_recorder(None)
+
+            # Identical code in several files (or chunks) is requested once
+            new_requests = []
+            for key, agent_name, body in requests:
+                if key not in recorded:
+                    recorded.add(key)
+                    new_requests.append((key, agent_name, body))
+            self._add_requests(new_requests)
+            self.state["prepared_files"] = start + len(group)
+            self._save_state()
+            logger.info("Audit files prepared", audit_id=self.state["audit_id"],
+                        prepared=self.state["prepared_files"], files=len(files),
+                        requests=self.state["requests"])
+
+        self._close_part()
+        self.state["phase"] = BATCHES_PHASE if self.state["parts"] else REPORT_PHASE
+        self._save_state()
+
+    def _add_requests(self, requests: List[tuple]):
+        """Append requests to the open input file, starting new ones at the batch limits"""
+        index_lines = []
+        group_lines = []
+        for key, agent_name, body in requests:
+            line = json.dumps({"custom_id": key, "method": "POST", "url": BATCH_ENDPOINT, "body": body})
+            size = len(line.encode("utf-8")) + 1
+            part = self.state["open_part"]
+            if part and (part["requests"] >= self.max_batch_requests or
+                         part["bytes"] + size > self.max_batch_bytes):
+                self._flush_part(group_lines)
+                group_lines = []
+                self._close_part()
+                part = None
+            if part is None:
+                name = os.path.join(BATCH_DIR, f"part-{len(self.state['parts']):04d}.jsonl")
+                self._truncate(name, 0)
+                part = self.state["open_part"] = {"name": name, "requests": 0, "bytes": 0}
+            group_lines.append(line)
+            part["requests"] += 1
+            part["bytes"] += size
+            index_lines.append(json.dumps({"id": key, "agent": agent_name, "model": body["model"]}))
+
+        self._flush_part(group_lines)
+        if index_lines:
+            self.state["index_bytes"] = self._append(INDEX_FILE, index_lines)
+            self.state["requests"] += len(index_lines)
+
+    def _flush_part(self, lines: List[str]):
+        if lines:
+            self.state["open_part"]["bytes"] = self._append(self.state["open_part"]["name"], lines)
+
+    def _close_part(self, attempt: int = 1):
+        part = self.state["open_part"]
+        if part and part["requests"]:
+            self.state["parts"].append({
+                "name": part["name"],
+                "requests": part["requests"],
+                "attempt": attempt,
+                "status": "pending",
+                "batch_id": None
+            })
+        self.state["open_part"] = None
+
+    # Batches phase
+
+    async def _advance_batches(self):
+        """Submit pending input files and collect the results of finished batches"""
+        # Retries are appended to the list while it is walked, and submitted right away
+        for part in self.state["parts"]:
+            if part["status"] == "pending":
+                with open(self._path(part["name"]), "rb") as f:
+                    data = f.read()
+                part["batch_id"] = await self.batch_client.submit(
+                    os.path.basename(part["name"]), data,
+                    {"audit": self.state["audit_id"], "part": part["name"]}
+                )
+                part["status"] = "submitted"
+                self._save_state()
+                logger.info("Audit batch submitted", audit_id=self.state["audit_id"],
+                            batch_id=part["batch_id"], requests=part["requests"])
+            elif part["status"] == "submitted":
+                info = await self.batch_client.status(part["batch_id"])
+                part["batch_status"] = info["status"]
+                if info["status"] == "failed":
+                    # Rejected input (validation errors): nothing was processed
+                    self.state.update(phase=FAILED_PHASE,
+                                      error=f"Batch {part['batch_id']} failed: {'; '.join(info['errors'])}")
+                    self._save_state()
+                    logger.error("Audit batch failed", audit_id=self.state["audit_id"],
+                                 batch_id=part["batch_id"], errors=info["errors"])
+                    return
+                if info["status"] in FINAL_BATCH_STATUSES:
+                    await self._collect(part, info)
+                self._save_state()
+
+        if all(part["status"] == "collected" for part in self.state["parts"]):
+            self.state["phase"] = REPORT_PHASE
+            self._save_state()
+
+    def _request_models(self) -> Dict[str, Dict[str, str]]:
+        """Agent and model of every recorded request by custom ID"""
+        if self._models is None:
+            self._models = {entry["id"]: entry for entry in self._read_lines(INDEX_FILE)}
+        return self._models
+
+    async def _collect(self, part: Dict[str, Any], info: Dict[str, Any]):
+        """Save the answered requests of a finished batch and resubmit the rest"""
+        results = []
+        if info.get("output_file_id"):
+            output = await self.batch_client.download(info["output_file_id"])
+            for line in output.splitlines():
+                if not line.strip():
+                    continue
+                record = json.loads(line)
+                response = record.get("response") or {}
+                if response.get("status_code") == 200:
+                    results.append(record)
+
+        models = self._request_models()
+        usage = self.state["usage"]
+        result_lines = []
+        answered = set()
+        for record in results:
+            request = models.get(record["custom_id"], {})
+            body = record["response"]["body"]
+            tokens = body.get("usage") or {}
+            input_tokens = tokens.get("prompt_tokens", 0)
+            output_tokens = tokens.get("completion_tokens", 0)
+            cached_tokens = (tokens.get("prompt_tokens_details") or {}).get("cached_tokens", 0)
+            model = request.get("model", body.get("model", ""))
+            api_tracker.track_call(
+                api_name="openai_batch",
+                model=model,
+                input_tokens=input_tokens,
+                output_tokens=output_tokens,
+                duration=0.0,
+                cached_input_tokens=cached_tokens,
+                batch=True
+            )
+            usage["input_tokens"] += input_tokens
+            usage["cached_input_tokens"] += cached_tokens
+            usage["output_tokens"] += output_tokens
+            usage["cost"] += api_tracker._estimate_cost(model, input_tokens, output_tokens, cached_tokens, batch=True)
+            answered.add(record["custom_id"])
+            result_lines.append(json.dumps({
+                "id": record["custom_id"],
+                "content": body["choices"][0]["message"]["content"]
+            }))
+        usage["answered"] += len(answered)
+
+        part["results"] = part["name"].replace(".jsonl", ".results.jsonl")
+        self._truncate(part["results"], 0)
+        self._append(part["results"], result_lines)
+        part.update(status="collected", answered=len(answered))
+        perf_monitor.record_metric("audit_batch_answered", len(answered), {"status": info["status"]})
+
+        missing = [
+            request for request in self._read_lines(part["name"])
+            if request["custom_id"] not in answered
+        ]
+        part["missing"] = len(missing)
+        logger.info("Audit batch collected", audit_id=self.state["audit_id"], batch_id=part["batch_id"],
+                    status=info["status"], answered=len(answered), missing=len(missing))
+        if missing and part["attempt"] < self.max_attempts:
+            name = os.path.join(BATCH_DIR, f"part-{len(self.state['parts']):04d}.jsonl")
+            self._truncate(name, 0)
+            size = self._append(name, [json.dumps(request) for request in missing])
+            self.state["open_part"] = {"name": name, "requests": len(missing), "bytes": size}
+            self._close_part(attempt=part["attempt"] + 1)
+
+    # Report phase
+
+    async def _load_results(self, chunk_size: int = 500):
+        """Store the batch results in the review cache under their request keys"""
+        models = self._request_models()
+        cache = self.orchestrator.cache_manager
+        loaded = 0
+        for part in self.state["parts"]:
+            if not part.get("results"):
+                continue
+            entries = {}
+            for result in self._read_lines(part["results"]):
+                agent = self.agents.get(models.get(result["id"], {}).get("agent"))
+                if agent is None or not result.get("content"):
+                    continue
+                entries[result["id"]] = (agent.agent_name, agent.cache_entry(result["content"]))
+                if len(entries) >= chunk_size:
+                    loaded += await self._store_entries(cache, entries)
+                    entries = {}
+            loaded += await self._store_entries(cache, entries)
+        await cache.flush()
+        logger.info("Audit results loaded into the cache", audit_id=self.state["audit_id"], entries=loaded)
+
+    @staticmethod
+    async def _store_entries(cache: Any, entries: Dict[str, tuple]) -> int:
+        by_agent: Dict[str, Dict[str, Dict[str, Any]]] = {}
+        for key, (agent_name, entry) in entries.items():
+            by_agent.setdefault(agent_name, {})[key] = entry
+        for agent_name, results in by_agent.items():
+            await cache.set_many_async(results, agent_name)
+        return len(entries)
+
+    async def _report(self):
+        """Review the files from the cache and write the audit report"""
+        snapshot = self._read_json(FILES_FILE)
+        files = snapshot["files"]
+        await self._load_results()
+        self._truncate(REVIEWS_FILE, self.state["reviews_bytes"])
+        self._truncate(UNANSWERED_FILE, self.state.get("unanswered_bytes", 0))
+
+        for start in range(self.state["reported_files"], len(files), self.group_size):
+            group = files[start:start + self.group_size]
+            group_start = time.time()
+            # Requests without a batch answer are deferred again, never sent
+            unanswered = []
+            self.orchestrator.set_request_recorder(
+                lambda key, agent, body: unanswered.append({"id": key, "agent": agent.agent_name})
+            )
+            try:
+                reviews = await self._review_group(group)
+            finally:
+                self.orchestrator.set_request_recorder(None)
+            lines = [
+                json.dumps({key: value for key, value in review.items() if key not in DROPPED_REVIEW_FIELDS},
+                           default=str)
+                for review in reviews
+            ]
+            self.state["reviews_bytes"] = self._append(REVIEWS_FILE, lines)
+            self.state["unanswered_bytes"] = self._append(
+                UNANSWERED_FILE, [json.dumps(request) for request in unanswered]
+            )
+            self.state["reported_files"] = start + len(group)
+            self.state["review_seconds"] += time.time() - group_start
+            self._save_state()
+
+        reviews = self._read_lines(REVIEWS_FILE)
+        unanswered = list({request["id"]: request for request in self._read_lines(UNANSWERED_FILE)}.values())
+        if unanswered:
+            logger.warning("Audit requests left unanswered by the batches", audit_id=self.state["audit_id"],
+                           requests=len(unanswered))
+        result = self.orchestrator.aggregate_pr_reviews(
+            reviews, files, self.description, self.state["review_seconds"], snapshot["skipped"]
+        )
+        with open(self._path(REPORT_FILE), "w") as f:
+            f.write(result["markdown_report"])
+        self._write_json(SUMMARY_FILE, {
+            "audit_id": self.state["audit_id"],
+            "snapshot": self.state["snapshot"],
+            "files_reviewed": result["files_reviewed"],
+            "skipped_files": result["skipped_files"],
+            "overall_summary": result["overall_summary"],
+            "recommendations": result["pr_consensus"].get("recommendations", []),
+            "usage": self.state["usage"],
+            "requests": self.state["requests"],
+            "unanswered_requests": unanswered
+        })
+        self.state["phase"] = DONE_PHASE
+        self._save_state()
+        logger.info("Audit report written", audit_id=self.state["audit_id"], files=len(files),
+                    recommendations=len(result["pr_consensus"].get("recommendations", [])),
+                    cost=round(self.state["usage"]["cost"], 4))
+
+    async def _review_group(self, group: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
+        """Review a group of snapshot files the way review_pull_request reviews a PR"""
+        orchestrator = self.orchestrator
+        files = [
+            dict(file_info, content=read_snapshot_file(self.state["snapshot"], file_info["filename"]) or "")
+            for file_info in group
+        ]
+        analyses = {
+            file_info["filename"]: AnalysisContext(file_info["content"], file_info["filename"], file_info["language"])
+            for file_info in files
+        }
+        _, static_results = await asyncio.gather(
+            orchestrator.prefetch_cache(files, analyses),
+            orchestrator.precompute_static_analysis(files)
+        )
+        for filename, results in static_results.items():
+            analyses[filename].provide_static_analysis(results)
+
+        async def review_file(file_info: Dict[str, Any]) -> Dict[str, Any]:
+            return await orchestrator.review_code(
+                code=file_info["content"],
+                filename=file_info["filename"],
+                pr_description=self.description,
+                context={"language": file_info["language"], "analysis": analyses[file_info["filename"]]}
+            )
+
+        return await orchestrator.scheduler.run(files, review_file)
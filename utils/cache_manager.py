@@ -5,10 +5,13 @@ Implements caching for code analysis results to reduce API calls and improve per
 Uses Modal Dict for distributed caching across serverless functions.
 """
 
+import asyncio
 import hashlib
 import json
 import time
-from typing import Dict, Any, Optional, Tuple
+import zlib
+from collections import OrderedDict
+from typing import Dict, Any, Optional, Tuple, List
 from dataclasses import dataclass, asdict
 
 try:
@@ -25,18 +28,77 @@ class CacheEntry:
     timestamp: float
     hit_count: int = 0
     agent_type: str = ""
+    size: int = 0
     
-    def is_expired(self, ttl: int = 3600) -> bool:
-        """Check if cache entry has expired (default 1 hour TTL)"""
-        return time.time() - self.timestamp > ttl
+    def is_expired(self, ttl: Optional[int] = 3600) -> bool:
+        """Check if cache entry has expired (default 1 hour TTL, None/0 never expires)"""
+        return bool(ttl) and time.time() - self.timestamp > ttl
+
+# Prefix of compact serialized entries (zlib-compressed JSON)
+COMPACT_ENTRY_PREFIX = b"z1"
+
+def serialize_entry(entry: CacheEntry) -> bytes:
+    """Serialize an entry for the distributed cache as compressed JSON"""
+    payload = json.dumps([entry.timestamp, entry.agent_type, entry.hit_count, entry.result],
+                         separators=(",", ":"), default=str)
+    return COMPACT_ENTRY_PREFIX + zlib.compress(payload.encode())
+
+def deserialize_entry(key: str, data: Any) -> Optional[CacheEntry]:
+    """Rebuild an entry from serialize_entry output (or the older asdict() form)"""
+    if isinstance(data, bytes) and data.startswith(COMPACT_ENTRY_PREFIX):
+        payload = zlib.decompress(data[len(COMPACT_ENTRY_PREFIX):])
+        timestamp, agent_type, hit_count, result = json.loads(payload)
+        # Sized uncompressed, like _estimate_size (the local cache holds the decoded result)
+        return CacheEntry(key=key, result=result, timestamp=timestamp,
+                          hit_count=hit_count, agent_type=agent_type, size=len(payload))
+    if isinstance(data, dict) and "result" in data:
+        return CacheEntry(**data)
+    return None
+
+def _estimate_size(result: Any) -> int:
+    """Approximate memory footprint of a cached result in bytes"""
+    try:
+        return len(json.dumps(result, default=str))
+    except (TypeError, ValueError):
+        return len(str(result))
+
+def normalize_code(code: str) -> str:
+    """Normalize code for content addressing
+
+    Line endings, trailing whitespace and leading/trailing blank lines do not
+    change what an agent sees, so they should not change the cache key either.
+    """
+    lines = (code or "").replace("\r\n", "\n").replace("\r", "\n").split("\n")
+    return "\n".join(line.rstrip() for line in lines).strip("\n")
 
 class CacheManager:
-    """Manages caching for code review analysis results"""
+    """Manages caching for code review analysis results
+    
+    The local cache is an LRU kept in insertion/access order, so lookups,
+    stores and evictions are all O(1). It is bounded both by entry count and
+    by an approximate byte budget; expired entries are dropped lazily when
+    they are accessed or reach the LRU end.
+    """
     
-    def __init__(self, cache_name: str = "code-review-cache", ttl: int = 3600):
+    def __init__(self,
+                 cache_name: str = "code-review-cache",
+                 ttl: Optional[int] = 3600,
+                 max_entries: int = 1000,
+                 max_bytes: int = 64 * 1024 * 1024):
+        """Initialize the cache
+        
+        Args:
+            cache_name: Name of the distributed cache (Modal Dict)
+            ttl: Time to live in seconds (None or 0 disables expiry)
+            max_entries: Maximum number of entries in the local cache
+            max_bytes: Approximate memory budget of the local cache in bytes
+        """
         self.cache_name = cache_name
         self.ttl = ttl  # Time to live in seconds
-        self.local_cache = {}  # In-memory cache for same function instance
+        self.max_entries = max_entries
+        self.max_bytes = max_bytes
+        self.local_cache: "OrderedDict[str, CacheEntry]" = OrderedDict()  # In-memory LRU for same function instance
+        self.local_bytes = 0
         self.stats = {
             "hits": 0,
             "misses": 0,
@@ -53,29 +115,99 @@ class CacheManager:
         cache_str = json.dumps(cache_data, sort_keys=True)
         return hashlib.sha256(cache_str.encode()).hexdigest()
     
+    def generate_agent_cache_key(self,
+                                 code: str,
+                                 agent_type: str,
+                                 prompt_version: str,
+                                 model: str,
+                                 extra: Optional[Dict] = None) -> str:
+        """Generate a content-addressed key for a single agent call
+        
+        The key depends only on what determines the agent's answer: the
+        normalized code unit, the agent, its prompt version and the model.
+        PR-level context such as the description is deliberately excluded.
+        
+        Args:
+            code: Code unit sent to the agent (whole file or excerpt)
+            agent_type: Agent name, e.g. "security_checker"
+            prompt_version: Version of the agent's system message/prompt template
+            model: Model name used for the call
+            extra: Other prompt inputs that change the answer (e.g. language)
+        """
+        cache_data = {
+            "code_hash": hashlib.sha256(normalize_code(code).encode()).hexdigest(),
+            "agent_type": agent_type,
+            "prompt_version": prompt_version,
+            "model": model,
+            "extra": extra or {}
+        }
+        cache_str = json.dumps(cache_data, sort_keys=True)
+        return hashlib.sha256(cache_str.encode()).hexdigest()
+    
+    def _get_local(self, key: str) -> Optional[CacheEntry]:
+        """Return an unexpired local entry, dropping it if it has expired"""
+        entry = self.local_cache.get(key)
+        if entry is None:
+            return None
+        if entry.is_expired(self.ttl):
+            self._remove_local(key)
+            self.stats["evictions"] += 1
+            return None
+        self.local_cache.move_to_end(key)
+        return entry
+    
+    def _store_local(self, entry: CacheEntry):
+        """Insert an entry as most recently used and enforce the size bounds"""
+        if not entry.size:
+            entry.size = _estimate_size(entry.result)
+        # Drop the old value first, so it is not served after an oversized update
+        self._remove_local(entry.key)
+        if entry.size > self.max_bytes:
+            # Larger than the whole budget; caching it would evict everything else
+            return
+        
+        self.local_cache[entry.key] = entry
+        self.local_bytes += entry.size
+        
+        while self.local_cache and (len(self.local_cache) > self.max_entries or
+                                    self.local_bytes > self.max_bytes):
+            self._evict_oldest()
+    
+    def _remove_local(self, key: str):
+        """Remove an entry from the local cache if present"""
+        entry = self.local_cache.pop(key, None)
+        if entry is not None:
+            self.local_bytes -= entry.size
+    
+    def contains(self, key: str) -> bool:
+        """Whether an unexpired entry is held locally (no remote read, not counted in the stats)"""
+        return self._get_local(key) is not None
+    
     def get(self, code: str, agent_type: str, context: Optional[Dict] = None) -> Optional[Dict[str, Any]]:
         """Retrieve cached analysis result if available"""
-        key = self._generate_cache_key(code, agent_type, context)
-        
-        # Check local cache first
-        if key in self.local_cache:
-            entry = self.local_cache[key]
-            if not entry.is_expired(self.ttl):
-                entry.hit_count += 1
-                self.stats["hits"] += 1
-                return entry.result
-            else:
-                # Remove expired entry
-                del self.local_cache[key]
-                self.stats["evictions"] += 1
+        return self.get_by_key(self._generate_cache_key(code, agent_type, context))
+    
+    def get_by_key(self, key: str) -> Optional[Dict[str, Any]]:
+        """Retrieve a cached result by precomputed key"""
+        entry = self._get_local(key)
+        if entry:
+            entry.hit_count += 1
+            self.stats["hits"] += 1
+            return entry.result
         
         self.stats["misses"] += 1
         return None
     
+    async def get_by_key_async(self, key: str) -> Optional[Dict[str, Any]]:
+        """Async lookup by key (local only; overridden for distributed caches)"""
+        return self.get_by_key(key)
+    
     def set(self, code: str, agent_type: str, result: Dict[str, Any], context: Optional[Dict] = None):
         """Cache an analysis result"""
-        key = self._generate_cache_key(code, agent_type, context)
-        
+        self.set_by_key(self._generate_cache_key(code, agent_type, context), result, agent_type)
+    
+    def set_by_key(self, key: str, result: Dict[str, Any], agent_type: str = ""):
+        """Cache a result under a precomputed key"""
         entry = CacheEntry(
             key=key,
             result=result,
@@ -83,24 +215,42 @@ class CacheManager:
             agent_type=agent_type
         )
         
-        self.local_cache[key] = entry
+        self._store_local(entry)
+    
+    async def set_by_key_async(self, key: str, result: Dict[str, Any], agent_type: str = ""):
+        """Async store by key (local only; overridden for distributed caches)"""
+        self.set_by_key(key, result, agent_type)
+    
+    async def get_many_async(self, keys: List[str]) -> Dict[str, Dict[str, Any]]:
+        """Look up several keys at once; returns the results that were found"""
+        results = {}
+        for key in keys:
+            result = await self.get_by_key_async(key)
+            if result is not None:
+                results[key] = result
+        return results
+    
+    async def prefetch_async(self, keys: List[str]) -> int:
+        """Warm the local cache for keys that will be looked up soon
         
-        # Implement simple LRU eviction if cache gets too large
-        if len(self.local_cache) > 1000:
-            self._evict_oldest()
+        Does not count as hits or misses. Returns how many keys are now local.
+        """
+        return sum(1 for key in keys if self._get_local(key))
+    
+    async def set_many_async(self, results: Dict[str, Dict[str, Any]], agent_type: str = ""):
+        """Store several results at once"""
+        for key, result in results.items():
+            await self.set_by_key_async(key, result, agent_type)
+    
+    async def flush(self):
+        """Wait for pending writes (nothing is buffered locally)"""
+        return None
     
     def _evict_oldest(self):
-        """Evict oldest cache entries when cache is full"""
-        # Sort by timestamp and remove oldest 10%
-        sorted_entries = sorted(
-            self.local_cache.items(),
-            key=lambda x: x[1].timestamp
-        )
-        
-        to_evict = len(sorted_entries) // 10
-        for key, _ in sorted_entries[:to_evict]:
-            del self.local_cache[key]
-            self.stats["evictions"] += 1
+        """Evict the least recently used entry"""
+        _, entry = self.local_cache.popitem(last=False)
+        self.local_bytes -= entry.size
+        self.stats["evictions"] += 1
     
     def get_stats(self) -> Dict[str, Any]:
         """Get cache performance statistics"""
@@ -113,19 +263,57 @@ class CacheManager:
             "misses": self.stats["misses"],
             "evictions": self.stats["evictions"],
             "hit_rate": hit_rate,
-            "cache_size": len(self.local_cache)
+            "cache_size": len(self.local_cache),
+            "cache_bytes": self.local_bytes,
+            "max_bytes": self.max_bytes
         }
     
     def clear(self):
         """Clear all cached entries"""
-        self.local_cache.clear()
         self.stats["evictions"] += len(self.local_cache)
+        self.local_cache.clear()
+        self.local_bytes = 0
 
 class ModalCacheManager(CacheManager):
-    """Extended cache manager using Modal Dict for distributed caching"""
+    """Extended cache manager using Modal Dict for distributed caching
+    
+    Reads of several keys are pipelined, and writes go through a write-behind
+    buffer that is flushed to the Modal Dict in a single update per batch, off
+    the review's critical path. Call flush() before the container finishes.
+    """
     
-    def __init__(self, cache_name: str = "code-review-cache", ttl: int = 3600):
-        super().__init__(cache_name, ttl)
+    def __init__(self,
+                 cache_name: str = "code-review-cache",
+                 ttl: Optional[int] = 3600,
+                 write_behind: bool = True,
+                 flush_interval: float = 0.5,
+                 max_pending_writes: int = 100,
+                 max_retained_writes: int = 1000,
+                 max_concurrent_reads: int = 32,
+                 **kwargs):
+        """Initialize the distributed cache
+        
+        Args:
+            cache_name: Name of the Modal Dict
+            ttl: Time to live in seconds (None or 0 disables expiry)
+            write_behind: Buffer writes and flush them in the background
+            flush_interval: Seconds to collect writes before flushing a batch
+            max_pending_writes: Flush immediately once this many writes are buffered
+            max_retained_writes: Most writes kept for the next flush after a
+                failed update (the oldest are dropped beyond it)
+            max_concurrent_reads: Maximum in-flight Modal Dict reads for batch lookups
+            **kwargs: Local cache bounds (max_entries, max_bytes)
+        """
+        super().__init__(cache_name, ttl, **kwargs)
+        self.stats["dropped_writes"] = 0
+        self.write_behind = write_behind
+        self.flush_interval = flush_interval
+        self.max_pending_writes = max_pending_writes
+        self.max_retained_writes = max_retained_writes
+        self.max_concurrent_reads = max_concurrent_reads
+        self._pending_writes: Dict[str, bytes] = {}
+        self._flush_task: Optional[asyncio.Task] = None
+        self._flush_requested: Optional[asyncio.Event] = None
         self.modal_dict = None
         self._init_modal_dict()
     
@@ -147,44 +335,142 @@ class ModalCacheManager(CacheManager):
     
     async def get_async(self, code: str, agent_type: str, context: Optional[Dict] = None) -> Optional[Dict[str, Any]]:
         """Async version for Modal Dict access"""
-        # Check local cache first
-        result = self.get(code, agent_type, context)
-        if result:
-            return result
+        return await self.get_by_key_async(self._generate_cache_key(code, agent_type, context))
+    
+    async def get_by_key_async(self, key: str) -> Optional[Dict[str, Any]]:
+        """Look up a key in the local cache, then in the Modal Dict"""
+        results = await self.get_many_async([key])
+        return results.get(key)
+    
+    async def get_many_async(self, keys: List[str]) -> Dict[str, Dict[str, Any]]:
+        """Look up several keys, fetching all local misses from the Modal Dict concurrently"""
+        results = {}
+        remote_keys = []
+        unique_keys = list(dict.fromkeys(keys))
+        for key in unique_keys:
+            entry = self._get_local(key)
+            if entry:
+                entry.hit_count += 1
+                self.stats["hits"] += 1
+                results[key] = entry.result
+            else:
+                remote_keys.append(key)
         
-        # Check Modal Dict if available
-        if self.modal_dict:
-            key = self._generate_cache_key(code, agent_type, context)
-            try:
-                entry_data = await self.modal_dict.get(key)
-                if entry_data:
-                    entry = CacheEntry(**entry_data)
-                    if not entry.is_expired(self.ttl):
-                        # Update local cache
-                        self.local_cache[key] = entry
-                        self.stats["hits"] += 1
-                        return entry.result
-                    else:
-                        # Remove expired entry
-                        await self.modal_dict.delete(key)
-            except Exception as e:
-                print(f"Modal Dict access error: {e}")
+        for key, entry in (await self._fetch_remote(remote_keys)).items():
+            self._store_local(entry)
+            self.stats["hits"] += 1
+            results[key] = entry.result
         
-        return None
+        self.stats["misses"] += len(unique_keys) - len(results)
+        return results
+    
+    async def prefetch_async(self, keys: List[str]) -> int:
+        """Load the given keys from the Modal Dict into the local cache in one batch"""
+        missing = [key for key in dict.fromkeys(keys) if not self._get_local(key)]
+        for entry in (await self._fetch_remote(missing)).values():
+            self._store_local(entry)
+        return sum(1 for key in dict.fromkeys(keys) if key in self.local_cache)
+    
+    async def _fetch_remote(self, keys: List[str]) -> Dict[str, CacheEntry]:
+        """Read keys from the Modal Dict with pipelined requests
+        
+        Keys with pending (not yet flushed) writes are served from the buffer.
+        """
+        if not keys:
+            return {}
+        
+        entries = {}
+        semaphore = asyncio.Semaphore(self.max_concurrent_reads)
+        
+        async def fetch(key: str):
+            data = self._pending_writes.get(key)
+            if data is None and self.modal_dict:
+                async with semaphore:
+                    try:
+                        data = await self.modal_dict.get.aio(key)
+                    except Exception as e:
+                        print(f"Modal Dict access error: {e}")
+                        return
+            entry = deserialize_entry(key, data) if data is not None else None
+            if entry is None:
+                return
+            if entry.is_expired(self.ttl):
+                self.stats["evictions"] += 1
+                return
+            entries[key] = entry
+        
+        await asyncio.gather(*[fetch(key) for key in keys])
+        return entries
     
     async def set_async(self, code: str, agent_type: str, result: Dict[str, Any], context: Optional[Dict] = None):
         """Async version for Modal Dict storage"""
-        # Store in local cache
-        self.set(code, agent_type, result, context)
+        await self.set_by_key_async(self._generate_cache_key(code, agent_type, context), result, agent_type)
+    
+    async def set_by_key_async(self, key: str, result: Dict[str, Any], agent_type: str = ""):
+        """Store a result in the local cache and the Modal Dict"""
+        await self.set_many_async({key: result}, agent_type)
+    
+    async def set_many_async(self, results: Dict[str, Dict[str, Any]], agent_type: str = ""):
+        """Store results locally and queue (or write) them to the Modal Dict in one batch"""
+        now = time.time()
+        serialized = {}
+        for key, result in results.items():
+            entry = CacheEntry(key=key, result=result, timestamp=now, agent_type=agent_type)
+            self._store_local(entry)
+            serialized[key] = serialize_entry(entry)
         
-        # Store in Modal Dict if available
-        if self.modal_dict:
-            key = self._generate_cache_key(code, agent_type, context)
-            entry = self.local_cache[key]
+        if not self.modal_dict or not serialized:
+            return
+        
+        self._pending_writes.update(serialized)
+        if not self.write_behind:
+            await self._write_pending()
+            return
+        
+        self._schedule_flush()
+        if len(self._pending_writes) >= self.max_pending_writes:
+            self._flush_requested.set()
+    
+    def _schedule_flush(self):
+        """Start the background flush task if it is not already running"""
+        if self._flush_task is None or self._flush_task.done():
+            self._flush_requested = asyncio.Event()
+            self._flush_task = asyncio.get_running_loop().create_task(self._flush_later())
+    
+    async def _flush_later(self):
+        """Collect writes for flush_interval (or until asked), then write them"""
+        try:
+            await asyncio.wait_for(self._flush_requested.wait(), timeout=self.flush_interval)
+        except asyncio.TimeoutError:
+            pass
+        await self._write_pending()
+    
+    async def _write_pending(self):
+        """Write all buffered entries with one Modal Dict update per batch
+        
+        A failed batch is put back in the buffer (behind newer writes of the
+        same keys) and retried by the next flush.
+        """
+        while self._pending_writes:
+            batch, self._pending_writes = self._pending_writes, {}
             try:
-                await self.modal_dict.put(key, asdict(entry))
+                await self.modal_dict.update.aio(**batch)
             except Exception as e:
                 print(f"Modal Dict storage error: {e}")
+                batch.update(self._pending_writes)
+                self._pending_writes = batch
+                while len(self._pending_writes) > self.max_retained_writes:
+                    del self._pending_writes[next(iter(self._pending_writes))]
+                    self.stats["dropped_writes"] += 1
+                return
+    
+    async def flush(self):
+        """Write all pending entries to the Modal Dict and wait for completion"""
+        if self._flush_task is not None and not self._flush_task.done():
+            self._flush_requested.set()
+            await self._flush_task
+        if self.modal_dict:
+            await self._write_pending()
 
 # Singleton instance for easy access
 _cache_manager = None
@@ -0,0 +1,186 @@
+"""
+Code Units for function-level incremental reviews
+
+Splits a Python file into function, method and class units and hashes each one
+on its AST, so that formatting and comment changes do not count as changes.
+Findings are stored per unit with unit-relative line numbers, which lets the
+findings of unchanged units be reused after the code around them moved.
+"""
+
+import ast
+import hashlib
+from dataclasses import dataclass, field
+from typing import Dict, List, Any, Optional, Tuple
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.diff_scoper import LINE_REFERENCE_PATTERN, LINE_NUMBER_PATTERN, FINDING_TEXT_FIELDS, remap_finding_lines
+
+MODULE_UNIT = "<module>"
+
+FUNCTION_NODES = (ast.FunctionDef, ast.AsyncFunctionDef)
+
+
+@dataclass
+class CodeUnit:
+    """A reviewable part of a file"""
+    name: str
+    kind: str                                 # "function", "method", "class" or "module"
+    ranges: List[Tuple[int, int]]             # original (start, end) line ranges, 1-based
+    hash: str
+    has_code: bool = True                     # False for units without statements
+    lines: List[int] = field(default_factory=list)
+
+    def __post_init__(self):
+        if not self.lines:
+            self.lines = [line for start, end in self.ranges for line in range(start, end + 1)]
+        self._positions = {line: i + 1 for i, line in enumerate(self.lines)}
+
+    @property
+    def unit_id(self) -> str:
+        """Id of the unit within its file (names repeat, e.g. property getters and setters)"""
+        return f"{self.name}:{self.lines[0] if self.lines else 0}"
+
+    def contains(self, line: int) -> bool:
+        return line in self._positions
+
+    def to_relative(self, line: int) -> Optional[int]:
+        """Map a file line number to a 1-based position inside the unit"""
+        return self._positions.get(line)
+
+    def to_absolute(self, relative_line: int) -> Optional[int]:
+        """Map a unit-relative position back to a file line number"""
+        if 1 <= relative_line <= len(self.lines):
+            return self.lines[relative_line - 1]
+        return None
+
+
+def _hash_nodes(kind: str, name: str, nodes: List[ast.AST]) -> str:
+    """Hash AST nodes without positions (whitespace and comments are not in the AST)"""
+    digest = hashlib.sha256(f"{kind}:{name}".encode())
+    for node in nodes:
+        digest.update(ast.dump(node, include_attributes=False).encode())
+    return digest.hexdigest()
+
+
+def _node_span(node: ast.AST) -> Tuple[int, int]:
+    """Line span of a definition including its decorators"""
+    start = min([node.lineno] + [d.lineno for d in getattr(node, "decorator_list", [])])
+    return start, node.end_lineno
+
+
+def _subtract_spans(span: Tuple[int, int], holes: List[Tuple[int, int]]) -> List[Tuple[int, int]]:
+    """Ranges of `span` not covered by `holes`"""
+    ranges = []
+    current = span[0]
+    for start, end in sorted(holes):
+        if start > current:
+            ranges.append((current, start - 1))
+        current = max(current, end + 1)
+    if current <= span[1]:
+        ranges.append((current, span[1]))
+    return ranges
+
+
+def split_into_units(code: str, tree: Optional[ast.Module] = None,
+                     language: str = "python") -> Optional[List[CodeUnit]]:
+    """Split Python code into top-level functions, methods, class bodies and module code
+
+    Classes with methods are split into one unit per method plus a class unit
+    holding the class header and attributes. Everything else at module level
+    (imports, constants, scripts) forms the "<module>" unit.
+
+    Other languages are split the same way with tree-sitter, when available.
+
+    Args:
+        code: Source code
+        tree: The already parsed module, if available
+        language: Language of the code
+
+    Returns:
+        Units covering every line of the file, or None if the code does not parse
+        (or the language is not supported)
+    """
+    if language != "python":
+        from utils.treesitter_analyzer import parse_code, split_units
+        return split_units(tree or parse_code(code, language), code, language)
+
+    if tree is None:
+        try:
+            tree = ast.parse(code)
+        except SyntaxError:
+            return None
+
+    total_lines = len(code.split("\n"))
+    units = []
+    definition_spans = []
+    module_nodes = []
+
+    for node in tree.body:
+        if isinstance(node, FUNCTION_NODES):
+            span = _node_span(node)
+            definition_spans.append(span)
+            units.append(CodeUnit(node.name, "function", [span], _hash_nodes("function", node.name, [node])))
+        elif isinstance(node, ast.ClassDef):
+            span = _node_span(node)
+            definition_spans.append(span)
+            methods = [child for child in node.body if isinstance(child, FUNCTION_NODES)]
+            if not methods:
+                units.append(CodeUnit(node.name, "class", [span], _hash_nodes("class", node.name, [node])))
+                continue
+
+            method_spans = []
+            for method in methods:
+                method_span = _node_span(method)
+                method_spans.append(method_span)
+                name = f"{node.name}.{method.name}"
+                units.append(CodeUnit(name, "method", [method_span], _hash_nodes("method", name, [method])))
+
+            # Class header, decorators, bases and attributes
+            header_nodes = (node.decorator_list + node.bases + node.keywords +
+                            [child for child in node.body if not isinstance(child, FUNCTION_NODES)])
+            units.append(CodeUnit(node.name, "class", _subtract_spans(span, method_spans),
+                                  _hash_nodes("class", node.name, header_nodes)))
+        else:
+            module_nodes.append(node)
+
+    units.append(CodeUnit(MODULE_UNIT, "module", _subtract_spans((1, total_lines), definition_spans),
+                          _hash_nodes("module", MODULE_UNIT, module_nodes), has_code=bool(module_nodes)))
+    return units
+
+
+def finding_line(finding: Dict[str, Any]) -> Optional[int]:
+    """First line number a finding refers to, if any"""
+    if finding.get("line_numbers"):
+        return finding["line_numbers"][0]
+    for field_name in FINDING_TEXT_FIELDS:
+        match = LINE_REFERENCE_PATTERN.search(str(finding.get(field_name) or ""))
+        if match:
+            return int(LINE_NUMBER_PATTERN.search(match.group(2)).group(0))
+    return None
+
+
+def assign_findings_to_units(findings: List[Dict[str, Any]],
+                             units: List[CodeUnit],
+                             fallback: CodeUnit) -> Dict[str, List[Dict[str, Any]]]:
+    """Group findings (with file line numbers) by the id of the unit they point at
+
+    Findings without a line number, or pointing outside every unit, go to `fallback`.
+    """
+    grouped = {unit.unit_id: [] for unit in units}
+    grouped.setdefault(fallback.unit_id, [])
+    for finding in findings:
+        line = finding_line(finding)
+        owner = next((unit for unit in units if line is not None and unit.contains(line)), fallback)
+        grouped[owner.unit_id].append(finding)
+    return grouped
+
+
+def to_unit_relative(finding: Dict[str, Any], unit: CodeUnit) -> Dict[str, Any]:
+    """Convert a finding's line references to positions inside its unit"""
+    return remap_finding_lines(finding, unit.to_relative)
+
+
+def from_unit_relative(finding: Dict[str, Any], unit: CodeUnit) -> Dict[str, Any]:
+    """Convert unit-relative line references back to file line numbers"""
+    return remap_finding_lines(finding, unit.to_absolute)
@@ -7,6 +7,38 @@ Provides confidence scoring for individual agent findings based on various facto
 from typing import Dict, List, Any, Tuple
 import re
 
+# Patterns that show specific evidence for a finding, per agent type
+SPECIFIC_EVIDENCE_PATTERNS = {
+    agent_type: re.compile("|".join(patterns))
+    for agent_type, patterns in {
+        # Security-specific patterns
+        "security_checker": [
+            r"sql injection",
+            r"cross-site scripting",
+            r"hardcoded (password|secret|key)",
+            r"vulnerable to",
+            r"allows unauthorized"
+        ],
+        # Performance-specific patterns
+        "performance_analyzer": [
+            r"o\(n\^[2-9]\)",  # Quadratic or worse complexity
+            r"exponential",
+            r"memory leak",
+            r"infinite loop",
+            r"blocking operation"
+        ],
+        # Code quality specific patterns
+        "code_reviewer": [
+            r"violates \w+ principle",
+            r"anti-pattern",
+            r"code smell",
+            r"technical debt",
+            r"unmaintainable"
+        ]
+    }.items()
+}
+
+
 class ConfidenceScorer:
     """Calculate confidence scores for agent findings"""
     
@@ -99,46 +131,8 @@ class ConfidenceScorer:
         """Check for specific evidence patterns that increase confidence"""
         description = str(finding.get("description", "")).lower()
         
-        # Security-specific patterns
-        if agent_type == "security_checker":
-            security_patterns = [
-                r"sql injection",
-                r"cross-site scripting",
-                r"hardcoded (password|secret|key)",
-                r"vulnerable to",
-                r"allows unauthorized"
-            ]
-            for pattern in security_patterns:
-                if re.search(pattern, description):
-                    return True
-        
-        # Performance-specific patterns
-        elif agent_type == "performance_analyzer":
-            perf_patterns = [
-                r"o\(n\^[2-9]\)",  # Quadratic or worse complexity
-                r"exponential",
-                r"memory leak",
-                r"infinite loop",
-                r"blocking operation"
-            ]
-            for pattern in perf_patterns:
-                if re.search(pattern, description):
-                    return True
-        
-        # Code quality specific patterns
-        elif agent_type == "code_reviewer":
-            quality_patterns = [
-                r"violates \w+ principle",
-                r"anti-pattern",
-                r"code smell",
-                r"technical debt",
-                r"unmaintainable"
-            ]
-            for pattern in quality_patterns:
-                if re.search(pattern, description):
-                    return True
-        
-        return False
+        pattern = SPECIFIC_EVIDENCE_PATTERNS.get(agent_type)
+        return pattern is not None and pattern.search(description) is not None
     
     def calculate_aggregate_confidence(self, findings: List[Dict[str, Any]]) -> float:
         """Calculate aggregate confidence for a set of findings"""
@@ -1,21 +1,58 @@
 """
 Consensus Mechanism for resolving conflicts between agent recommendations
+
+Recommendations are grouped in two linear passes: an exact key (file, issue
+category or type, first line) and MinHash LSH clustering of near-duplicate
+descriptions within a file and a few lines of each other, so PRs with
+thousands of findings are grouped without comparing all pairs.
 """
 
-from typing import Dict, List, Any, Tuple
-from collections import defaultdict
+from typing import Dict, List, Any, Optional, Tuple
 import re
 import sys
 import os
 sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
 from utils.confidence_scorer import ConfidenceScorer
+from utils.minhash import MinHasher, LSHIndex, tokenize, jaccard
+
+# Issue categories recognized in descriptions, in priority order
+ISSUE_PATTERNS = [
+    (re.compile(pattern, re.IGNORECASE), key)
+    for pattern, key in (
+        (r"sql.{0,20}injection", "sql_injection"),
+        (r"command.{0,20}injection", "command_injection"),
+        (r"eval\(|exec\(", "eval_exec"),
+        (r"hardcoded.{0,20}(password|secret|key|api)", "hardcoded_secret"),
+        (r"plain.{0,20}text.{0,20}password", "plaintext_password"),
+        (r"md5|sha1", "weak_hashing"),
+        (r"pickle\.load", "unsafe_deserialization"),
+        (r"timing.{0,20}attack", "timing_attack"),
+        (r"n\+1|n\^2|n\^3|o\(n.{0,5}\)|complexity", "complexity"),
+        (r"error.{0,20}handling", "error_handling"),
+        (r"input.{0,20}validation", "input_validation"),
+        (r"information.{0,20}disclosure", "info_disclosure"),
+        (r"logging.{0,20}sensitive", "logging_sensitive")
+    )
+]
+
+# One search tells whether any category matches (most descriptions match none)
+ISSUE_PREFILTER = re.compile("|".join(f"(?:{pattern.pattern})" for pattern, _ in ISSUE_PATTERNS), re.IGNORECASE)
 
 
 class WeightedConsensus:
     """Implements weighted consensus for multi-agent recommendations"""
     
-    def __init__(self):
-        """Initialize consensus mechanism with agent weights"""
+    def __init__(self,
+                 similarity_threshold: float = 0.5,
+                 line_window: int = 3):
+        """Initialize consensus mechanism with agent weights
+        
+        Args:
+            similarity_threshold: Jaccard similarity of the description words
+                above which two findings are the same issue
+            line_window: Near-duplicate findings with lines must start at most
+                this many lines apart
+        """
         self.agent_weights = {
             "security_checker": 1.5,     # Highest priority
             "performance_analyzer": 1.2,  # Medium priority  
@@ -30,6 +67,10 @@ class WeightedConsensus:
         }
         
         self.confidence_scorer = ConfidenceScorer()
+        
+        self.similarity_threshold = similarity_threshold
+        self.line_window = max(1, line_window)
+        self.minhasher = MinHasher(num_perm=16)
     
     def resolve_conflicts(self, agent_findings: Dict[str, List[Dict[str, Any]]]) -> Dict[str, Any]:
         """Resolve conflicts between agent recommendations
@@ -76,51 +117,119 @@ class WeightedConsensus:
                         "solution": finding.get("solution", ""),
                         "location": finding.get("location", ""),
                         "line_numbers": finding.get("line_numbers", []),
-                        "category": finding.get("category", "other")
+                        "category": finding.get("category", "other"),
+                        "filename": finding.get("filename")
                     }
                     recommendations.append(rec)
         
         return recommendations
     
     def _group_similar_recommendations(self, recommendations: List[Dict[str, Any]]) -> Dict[str, List[Dict[str, Any]]]:
-        """Group recommendations that address the same issue"""
-        groups = defaultdict(list)
-        
-        for rec in recommendations:
-            # Create a key based on issue type and affected lines
+        """Group recommendations that address the same issue
+        
+        Findings with the same exact key are grouped, and so are findings in
+        the same file whose descriptions are near-duplicates (found through
+        LSH buckets of bounded size, so each finding is compared with a
+        constant number of others). A finding joins a group only if it is a
+        near-duplicate of the group's first finding, so chains of findings a
+        few lines apart cannot grow a group across a whole file. Groups keep
+        the order of their first finding and are keyed by its exact key.
+        """
+        parent = list(range(len(recommendations)))
+        
+        def find(i: int) -> int:
+            while parent[i] != i:
+                parent[i] = parent[parent[i]]
+                i = parent[i]
+            return i
+        
+        def union(i: int, j: int):
+            root_i, root_j = find(i), find(j)
+            if root_i != root_j:
+                # The earliest finding stays the root (and names the group)
+                parent[max(root_i, root_j)] = min(root_i, root_j)
+        
+        keys = []
+        first_by_key: Dict[str, int] = {}
+        token_sets = []
+        index = LSHIndex(bands=8, rows=2)
+        
+        for i, rec in enumerate(recommendations):
+            key = self._exact_key(rec)
+            keys.append(key)
+            if key in first_by_key:
+                union(i, first_by_key[key])
+            else:
+                first_by_key[key] = i
+            
+            tokens = tokenize(rec['description'])
+            token_sets.append(tokens)
+            signature = self.minhasher.signature(tokens)
+            if not signature:
+                continue
+            
+            # Findings with lines match within line_window; others only each other
+            filename = rec.get('filename') or ""
             if rec['line_numbers']:
-                key = f"{rec['type']}_{min(rec['line_numbers'])}"
+                block = min(rec['line_numbers']) // self.line_window
+                scope = (filename, block)
+                scopes = [(filename, block - 1), scope, (filename, block + 1)]
             else:
-                # Use description similarity for grouping when no line numbers
-                key = self._get_issue_key(rec['description'])
+                scope = (filename, None)
+                scopes = [scope]
             
-            groups[key].append(rec)
+            for j in index.candidates(signature, scopes):
+                # Compared with the roots (the groups' first findings), not the members
+                root_i, root_j = find(i), find(j)
+                if root_i != root_j and self._near_duplicates(recommendations[root_i], recommendations[root_j],
+                                                              token_sets[root_i], token_sets[root_j]):
+                    union(i, j)
+            index.add(i, signature, scope)
+        
+        groups: Dict[str, List[Dict[str, Any]]] = {}
+        for i, rec in enumerate(recommendations):
+            groups.setdefault(keys[find(i)], []).append(rec)
+        
+        return groups
+    
+    def _exact_key(self, rec: Dict[str, Any]) -> str:
+        """Grouping key: issue and first line, or the issue alone without lines"""
+        if rec['line_numbers']:
+            category = self._match_issue(rec['description'])
+            label = category or str(rec['type']).lower().replace(" ", "_")
+            key = f"{label}_{min(rec['line_numbers'])}"
+        else:
+            key = self._get_issue_key(rec['description'])
         
-        return dict(groups)
+        # Line numbers (and issues) are per file in PR-level consensus
+        filename = rec.get('filename')
+        return f"{filename}:{key}" if filename else key
+    
+    def _near_duplicates(self, a: Dict[str, Any], b: Dict[str, Any], tokens_a, tokens_b) -> bool:
+        if (a.get('filename') or "") != (b.get('filename') or ""):
+            return False
+        if a['line_numbers'] and b['line_numbers']:
+            if abs(min(a['line_numbers']) - min(b['line_numbers'])) > self.line_window:
+                return False
+        elif a['line_numbers'] or b['line_numbers']:
+            return False
+        return jaccard(tokens_a, tokens_b) >= self.similarity_threshold
+    
+    def _match_issue(self, description: str) -> Optional[str]:
+        """Issue category of a description (the first matching ISSUE_PATTERNS entry)"""
+        description = str(description or "")
+        if not ISSUE_PREFILTER.search(description):
+            return None
+        for pattern, key in ISSUE_PATTERNS:
+            if pattern.search(description):
+                return key
+        return None
     
     def _get_issue_key(self, description: str) -> str:
         """Generate a key for grouping similar issues"""
-        # Extract key patterns from description
-        patterns = [
-            (r"sql.{0,20}injection", "sql_injection"),
-            (r"command.{0,20}injection", "command_injection"),
-            (r"eval\(|exec\(", "eval_exec"),
-            (r"hardcoded.{0,20}(password|secret|key|api)", "hardcoded_secret"),
-            (r"plain.{0,20}text.{0,20}password", "plaintext_password"),
-            (r"md5|sha1", "weak_hashing"),
-            (r"pickle\.load", "unsafe_deserialization"),
-            (r"timing.{0,20}attack", "timing_attack"),
-            (r"n\+1|n\^2|n\^3|o\(n.{0,5}\)|complexity", "complexity"),
-            (r"error.{0,20}handling", "error_handling"),
-            (r"input.{0,20}validation", "input_validation"),
-            (r"information.{0,20}disclosure", "info_disclosure"),
-            (r"logging.{0,20}sensitive", "logging_sensitive")
-        ]
-        
-        description_lower = description.lower()
-        for pattern, key in patterns:
-            if re.search(pattern, description_lower, re.IGNORECASE):
-                return key
+        category = self._match_issue(description)
+        if category:
+            return category
         
         # For other issues, use a more specific key
         # Extract the main subject (often after "Issue:" or similar)
@@ -199,6 +308,7 @@ class WeightedConsensus:
                 "solution": self._merge_solutions(recs),
                 "location": self._merge_locations(recs),
                 "line_numbers": self._merge_line_numbers(recs),
+                "filename": recs[0].get("filename"),
                 "original_recommendations": recs
             }
             
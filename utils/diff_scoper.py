@@ -0,0 +1,296 @@
+"""
+Diff Scoper for reviewing only the changed parts of a file
+
+Builds an excerpt of a file from the hunks of its unified diff (plus context
+and, for Python, the enclosing function or class) and maps line numbers in the
+excerpt back to the full file.
+"""
+
+import re
+from typing import Dict, List, Any, Optional, Tuple, Callable
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.ast_analyzer import analyze_python_code
+
+HUNK_HEADER_PATTERN = re.compile(r"^@@ -(\d+)(?:,(\d+))? \+(\d+)(?:,(\d+))? @@")
+
+# "line 12", "Lines 10-14", "lines 3, 5 and 8"
+LINE_REFERENCE_PATTERN = re.compile(
+    r"\b(lines?\s+)(\d+(?:\s*(?:-|–|to|,|and)\s*\d+)*)",
+    re.IGNORECASE
+)
+LINE_NUMBER_PATTERN = re.compile(r"\d+")
+
+# Added to agent prompts when they receive an excerpt instead of the whole file
+SCOPED_REVIEW_NOTE = (
+    "Note: this is an excerpt containing only the changed parts of the file and their "
+    "enclosing code. Lines marked 'unchanged lines omitted' were left out. Review only "
+    "the code shown and report line numbers as they appear in the excerpt."
+)
+
+# Finding fields that may contain line references
+FINDING_TEXT_FIELDS = ("location", "description", "solution", "impact", "suggestion")
+
+COMMENT_PREFIXES = {
+    "python": "#",
+    "ruby": "#",
+    "text": "#"
+}
+
+
+def parse_changed_lines(patch: str) -> List[int]:
+    """Return the new-file line numbers touched by a unified diff patch
+
+    Added lines are reported as-is. Deleted lines are reported at the position
+    where they were removed, so that pure deletions still get context.
+    """
+    changed = set()
+    new_line = 0
+
+    for line in (patch or "").split("\n"):
+        header = HUNK_HEADER_PATTERN.match(line)
+        if header:
+            new_line = int(header.group(3))
+            continue
+
+        if not new_line:
+            continue
+
+        if line.startswith("+"):
+            changed.add(new_line)
+            new_line += 1
+        elif line.startswith("-"):
+            # Deletions do not advance the new-file line counter
+            changed.add(max(1, new_line))
+        elif not line.startswith("\\"):
+            # Context line ("\ No newline at end of file" is skipped)
+            new_line += 1
+
+    return sorted(changed)
+
+
+def commentable_lines(patch: str) -> List[int]:
+    """Return the new-file lines a review comment can be placed on
+
+    These are the added and context lines of the hunks (the RIGHT side of
+    the diff); GitHub rejects comments on any other line.
+    """
+    lines = set()
+    new_line = 0
+
+    for line in (patch or "").split("\n"):
+        header = HUNK_HEADER_PATTERN.match(line)
+        if header:
+            new_line = int(header.group(3))
+            continue
+
+        # Deleted lines are on the LEFT side; "" is the end of the patch
+        if not new_line or not line or line.startswith("-") or line.startswith("\\"):
+            continue
+
+        lines.add(new_line)
+        new_line += 1
+
+    return sorted(lines)
+
+
+def remap_line_references(text: str, mapper: Callable[[int], Optional[int]]) -> str:
+    """Rewrite "line N" references in text with `mapper` (unmapped numbers are kept)"""
+    if not text or not isinstance(text, str):
+        return text
+
+    def replace_numbers(match):
+        numbers = LINE_NUMBER_PATTERN.sub(
+            lambda n: str(mapper(int(n.group(0))) or n.group(0)),
+            match.group(2)
+        )
+        return match.group(1) + numbers
+
+    return LINE_REFERENCE_PATTERN.sub(replace_numbers, text)
+
+
+def remap_finding_lines(finding: Dict[str, Any], mapper: Callable[[int], Optional[int]]) -> Dict[str, Any]:
+    """Return a copy of a finding with its line references rewritten by `mapper`"""
+    remapped = dict(finding)
+    for field in FINDING_TEXT_FIELDS:
+        if field in remapped:
+            remapped[field] = remap_line_references(remapped[field], mapper)
+    if remapped.get("line_numbers"):
+        remapped["line_numbers"] = [mapper(line) or line for line in remapped["line_numbers"]]
+    return remapped
+
+
+def merge_ranges(ranges: List[Tuple[int, int]]) -> List[Tuple[int, int]]:
+    """Merge overlapping or adjacent (start, end) ranges"""
+    merged = []
+    for start, end in sorted(ranges):
+        if merged and start <= merged[-1][1] + 1:
+            merged[-1] = (merged[-1][0], max(merged[-1][1], end))
+        else:
+            merged.append((start, end))
+    return merged
+
+
+class ScopedCode:
+    """An excerpt of a file together with its mapping back to the full file"""
+
+    def __init__(self, code: str, line_map: List[Optional[int]], ranges: List[Tuple[int, int]],
+                 total_lines: int, full_code: str):
+        self.code = code
+        self.line_map = line_map          # excerpt line (1-based) -> original line, None for markers
+        self.ranges = ranges              # original (start, end) ranges included in the excerpt
+        self.total_lines = total_lines
+        self.full_code = full_code
+        self._reverse_map = {orig: i + 1 for i, orig in enumerate(line_map) if orig is not None}
+
+    @property
+    def scoped_lines(self) -> int:
+        return sum(end - start + 1 for start, end in self.ranges)
+
+    def to_original_line(self, excerpt_line: int) -> Optional[int]:
+        """Map an excerpt line number to the full file"""
+        if 1 <= excerpt_line <= len(self.line_map):
+            return self.line_map[excerpt_line - 1]
+        return None
+
+    def to_excerpt_line(self, original_line: int) -> Optional[int]:
+        """Map a full-file line number into the excerpt (None if not included)"""
+        return self._reverse_map.get(original_line)
+
+    def remap_text(self, text: str) -> str:
+        """Rewrite "line N" references in text from excerpt to full-file numbering"""
+        return remap_line_references(text, self.to_original_line)
+    
+    def remap_finding(self, finding: Dict[str, Any]) -> Dict[str, Any]:
+        """Return a copy of a finding with its line references mapped to the full file"""
+        return remap_finding_lines(finding, self.to_original_line)
+
+    def to_dict(self) -> Dict[str, Any]:
+        """Serializable summary (used in review results and for remapping later)"""
+        return {
+            "mode": "diff",
+            "ranges": self.ranges,
+            "line_map": self.line_map,
+            "scoped_lines": self.scoped_lines,
+            "total_lines": self.total_lines
+        }
+
+    @classmethod
+    def from_dict(cls, data: Dict[str, Any]) -> "ScopedCode":
+        """Rebuild a scope (without code) from to_dict() output for remapping"""
+        return cls("", data.get("line_map", []), [tuple(r) for r in data.get("ranges", [])],
+                   data.get("total_lines", 0), "")
+
+
+class DiffScoper:
+    """Builds diff-scoped excerpts of files for review"""
+
+    def __init__(self,
+                 context_lines: int = 5,
+                 use_enclosing_scope: bool = True,
+                 max_scope_lines: int = 200,
+                 max_scoped_ratio: float = 0.8):
+        """Initialize the diff scoper
+
+        Args:
+            context_lines: Lines of context to include around each change
+            use_enclosing_scope: Expand changes to the whole enclosing function
+                or class (found with ASTAnalyzer, or from the tree-sitter
+                results passed to scope() for other languages)
+            max_scope_lines: Enclosing scopes longer than this fall back to
+                plain context lines
+            max_scoped_ratio: If the excerpt would cover more than this share of
+                the file, review the whole file instead
+        """
+        self.context_lines = context_lines
+        self.use_enclosing_scope = use_enclosing_scope
+        self.max_scope_lines = max_scope_lines
+        self.max_scoped_ratio = max_scoped_ratio
+
+    def scope(self, code: str, patch: str, language: str = "python",
+              ast_results: Dict[str, Any] = None) -> Optional[ScopedCode]:
+        """Build an excerpt of `code` covering the changes in `patch`
+
+        Args:
+            code: Full file content
+            patch: Unified diff of the file
+            language: Language of the file
+            ast_results: analyze_code_structure() output for `code`, if already computed
+
+        Returns:
+            ScopedCode, or None when the whole file should be reviewed (no
+            usable patch, or the excerpt would not be meaningfully smaller)
+        """
+        changed = parse_changed_lines(patch)
+        lines = code.split("\n")
+        total_lines = len(lines)
+        if not changed or not total_lines:
+            return None
+
+        scopes = []
+        if self.use_enclosing_scope and (language == "python" or ast_results):
+            scopes = self._enclosing_scopes(code, ast_results)
+
+        ranges = []
+        for line in changed:
+            line = min(line, total_lines)
+            start = max(1, line - self.context_lines)
+            end = min(total_lines, line + self.context_lines)
+
+            enclosing = self._innermost_scope(scopes, line)
+            if enclosing:
+                start = min(start, enclosing[0])
+                end = max(end, enclosing[1])
+
+            ranges.append((start, end))
+
+        ranges = merge_ranges(ranges)
+        scoped_lines = sum(end - start + 1 for start, end in ranges)
+        if scoped_lines > total_lines * self.max_scoped_ratio:
+            return None
+
+        return self.build_excerpt(lines, ranges, language, code)
+
+    def _enclosing_scopes(self, code: str, ast_results: Dict[str, Any] = None) -> List[Tuple[int, int]]:
+        """Function and class spans of a Python file"""
+        ast_data = (ast_results or analyze_python_code(code)).get("ast_analysis", {})
+        if "error" in ast_data:
+            return []
+
+        scopes = []
+        for node in ast_data.get("functions", []) + ast_data.get("classes", []):
+            start, end = node.get("line"), node.get("end_line")
+            if start and end and end - start + 1 <= self.max_scope_lines:
+                scopes.append((start, end))
+        return scopes
+
+    def _innermost_scope(self, scopes: List[Tuple[int, int]], line: int) -> Optional[Tuple[int, int]]:
+        """Smallest scope containing the line"""
+        containing = [s for s in scopes if s[0] <= line <= s[1]]
+        if not containing:
+            return None
+        return min(containing, key=lambda s: s[1] - s[0])
+
+    def build_excerpt(self, lines: List[str], ranges: List[Tuple[int, int]],
+                      language: str, full_code: str) -> ScopedCode:
+        """Concatenate the ranges with marker lines for the skipped parts"""
+        comment = COMMENT_PREFIXES.get(language, "//")
+        excerpt = []
+        line_map = []
+        previous_end = 0
+
+        for start, end in ranges:
+            if start > previous_end + 1:
+                excerpt.append(f"{comment} ... unchanged lines omitted ...")
+                line_map.append(None)
+            for original in range(start, end + 1):
+                excerpt.append(lines[original - 1])
+                line_map.append(original)
+            previous_end = end
+
+        if previous_end < len(lines):
+            excerpt.append(f"{comment} ... unchanged lines omitted ...")
+            line_map.append(None)
+
+        return ScopedCode("\n".join(excerpt), line_map, ranges, len(lines), full_code)
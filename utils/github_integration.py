@@ -4,21 +4,168 @@ GitHub Integration for fetching PR files and posting reviews
 
 import os
 import json
+import asyncio
 import httpx
-from typing import Dict, List, Any, Optional
+from collections import OrderedDict
+from typing import Dict, List, Any, Optional, Tuple
 from datetime import datetime
 import base64
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.diff_scoper import commentable_lines
+from utils.review_scheduler import ReviewScheduler
+
+# Largest page size GitHub allows for list endpoints
+PAGE_SIZE = 100
+
+# The compare API lists at most this many files
+COMPARE_MAX_FILES = 300
+
+# Returns file contents as raw bytes instead of base64 encoded JSON
+RAW_MEDIA_TYPE = "application/vnd.github.raw+json"
+
+# How get_pr_files fetches file contents:
+#   rest    - one contents API call per file
+#   graphql - blob text for up to GRAPHQL_BATCH_SIZE files per GraphQL query
+#   git     - git blobs API by blob SHA, cached per process (blobs are immutable)
+#   auto    - pick one from the PR size and the remaining rate limits
+FETCH_BACKENDS = ("rest", "graphql", "git", "auto")
+GRAPHQL_BATCH_SIZE = 50
+
+# GitHub's limit on the body of a review or comment
+MAX_REVIEW_BODY_LENGTH = 65536
+
+# JSON bytes of inline comments per submitted review. GitHub documents no
+# limit on the number of comments, only the 65536 characters per body, so a
+# review is split only to keep each request well below 1 MB; further
+# comments follow in extra reviews
+MAX_REVIEW_PAYLOAD_BYTES = 512 * 1024
+
+SEVERITY_ORDER = ("critical", "high", "medium", "low")
+
+# Review language of a file by extension (anything else is "text")
+LANGUAGE_EXTENSIONS = {
+    '.py': 'python',
+    '.js': 'javascript',
+    '.ts': 'typescript',
+    '.tsx': 'tsx',
+    '.jsx': 'javascript',
+    '.java': 'java',
+    '.cpp': 'cpp',
+    '.c': 'c',
+    '.go': 'go',
+    '.rs': 'rust'
+}
+
+
+class ResponseCache:
+    """Process-wide LRU of GitHub response bodies, bounded by size
+    
+    Holds blob contents by blob SHA and ETags of conditional requests, so
+    repeated fetches in a warm container are free or answered with 304s
+    (which do not count against the rate limit).
+    """
+    
+    def __init__(self, max_bytes: int = 64 * 1024 * 1024):
+        self.max_bytes = max_bytes
+        self.total_bytes = 0
+        self.entries: "OrderedDict[str, Tuple[Optional[str], Any, int]]" = OrderedDict()
+    
+    def get(self, key: str) -> Optional[Tuple[Optional[str], Any]]:
+        """Return (etag, body) for a key, or None"""
+        entry = self.entries.get(key)
+        if entry is None:
+            return None
+        self.entries.move_to_end(key)
+        return entry[0], entry[1]
+    
+    def put(self, key: str, body: Any, etag: Optional[str] = None, size: int = 0):
+        """Store a body (and its ETag) as most recently used"""
+        size = size or len(str(body))
+        if size > self.max_bytes:
+            return
+        old = self.entries.pop(key, None)
+        if old is not None:
+            self.total_bytes -= old[2]
+        self.entries[key] = (etag, body, size)
+        self.total_bytes += size
+        while self.total_bytes > self.max_bytes:
+            _, (_, _, evicted_size) = self.entries.popitem(last=False)
+            self.total_bytes -= evicted_size
+
+
+_response_cache = ResponseCache()
+
+
+def review_comments(file_reviews: List[Dict[str, Any]],
+                    pr_files: List[Dict[str, Any]],
+                    min_severity: str = "low") -> List[Dict[str, Any]]:
+    """Inline comments for the consensus findings of a PR review
+    
+    Each finding is placed on the first of its lines that is part of the
+    file's diff; findings without such a line stay in the summary only.
+    
+    Args:
+        file_reviews: The file_reviews of a review_pull_request result
+        pr_files: The reviewed files (with their patch)
+        min_severity: Least severe finding that gets a comment
+    
+    Returns:
+        Comments with path, line and body for post_review_comment
+    """
+    patches = {file['filename']: file.get('patch', '') for file in pr_files}
+    allowed = SEVERITY_ORDER[:SEVERITY_ORDER.index(min_severity) + 1]
+    comments = []
+    
+    for review in file_reviews:
+        filename = review.get('filename')
+        if review.get('status') != 'success' or filename not in patches:
+            continue
+        diff_lines = set(commentable_lines(patches[filename]))
+        
+        for rec in review.get('consensus_results', {}).get('recommendations', []):
+            severity = rec.get('consensus_severity', 'medium')
+            lines = rec.get('line_numbers') or []
+            if severity not in allowed or not lines:
+                continue
+            anchors = [line for line in range(min(lines), max(lines) + 1) if line in diff_lines]
+            if not anchors:
+                continue
+            
+            body = f"**{severity.capitalize()}:** {rec.get('description', '')}"
+            if rec.get('solution'):
+                body += f"\n\n**Suggestion:** {rec['solution']}"
+            if rec.get('contributing_agents'):
+                body += f"\n\n_Reported by: {', '.join(rec['contributing_agents'])}_"
+            comments.append({"path": filename, "line": anchors[0], "body": body})
+    
+    return comments
 
 
 class GitHubIntegration:
     """Handles GitHub API interactions for PR reviews"""
     
-    def __init__(self, github_token: str = None):
+    def __init__(self,
+                 github_token: str = None,
+                 max_concurrent_fetches: int = 10,
+                 http2: bool = True,
+                 fetch_backend: str = "rest",
+                 small_pr_files: int = 10,
+                 scheduler: Optional[ReviewScheduler] = None):
         """Initialize GitHub integration
         
         Args:
             github_token: GitHub personal access token or app token
+            max_concurrent_fetches: Maximum number of file contents fetched at once
+            http2: Multiplex requests over HTTP/2 when the h2 package is installed
+            fetch_backend: How file contents are fetched (see FETCH_BACKENDS)
+            small_pr_files: In auto mode, PRs up to this many files use the git
+                backend and larger ones GraphQL batches
+            scheduler: Backoff for rate limited requests (secondary rate
+                limits come back as 403s); one gate pauses all requests
         """
+        if fetch_backend not in FETCH_BACKENDS:
+            raise ValueError(f"Unknown fetch backend: {fetch_backend}")
         self.token = github_token or os.getenv("GITHUB_TOKEN")
         if not self.token:
             raise ValueError("GitHub token is required")
@@ -29,6 +176,100 @@ class GitHubIntegration:
             "Accept": "application/vnd.github.v3+json",
             "X-GitHub-Api-Version": "2022-11-28"
         }
+        self.max_concurrent_fetches = max(1, max_concurrent_fetches)
+        self.http2 = http2
+        self.fetch_backend = fetch_backend
+        self.small_pr_files = small_pr_files
+        self.response_cache = _response_cache
+        # Head SHA, state and author of each PR fetched by get_pr_files /
+        # get_pr_info (and the patches of get_pr_files), so reviews are
+        # posted without fetching the PR again
+        self.head_shas: Dict[Tuple[str, str, int], str] = {}
+        self.pr_states: Dict[Tuple[str, str, int], Tuple[Optional[str], Optional[str]]] = {}
+        self.pr_patches: Dict[Tuple[str, str, int], Dict[str, str]] = {}
+        # Login of the token's user, looked up once per client
+        self._login: Optional[str] = None
+        self.scheduler = scheduler or ReviewScheduler()
+        self._client: Optional[httpx.AsyncClient] = None
+    
+    async def _get_client(self) -> httpx.AsyncClient:
+        """Shared HTTP client, so connections are reused across requests
+        
+        Falls back to HTTP/1.1 when the h2 package is not installed.
+        """
+        if self._client is None or self._client.is_closed:
+            limits = httpx.Limits(max_connections=self.max_concurrent_fetches * 2,
+                                  max_keepalive_connections=self.max_concurrent_fetches)
+            try:
+                self._client = httpx.AsyncClient(http2=self.http2, limits=limits, timeout=30.0)
+            except ImportError:
+                self._client = httpx.AsyncClient(limits=limits, timeout=30.0)
+        return self._client
+    
+    async def _request(self, client: httpx.AsyncClient, method: str, url: str, **kwargs) -> httpx.Response:
+        """Send a request, retrying with backoff while GitHub rate limits it"""
+        return await self.scheduler.call_with_backoff(
+            lambda: getattr(client, method)(url, **kwargs),
+            operation="github_api"
+        )
+    
+    async def aclose(self):
+        """Close the shared HTTP client"""
+        if self._client is not None:
+            await self._client.aclose()
+            self._client = None
+    
+    async def __aenter__(self) -> "GitHubIntegration":
+        return self
+    
+    async def __aexit__(self, exc_type, exc, tb):
+        await self.aclose()
+    
+    def _remember_pr(self, owner: str, repo: str, pr_number: int, pr_data: Dict[str, Any]):
+        """Keep the head SHA, state and author of a fetched PR for posting reviews"""
+        key = (owner, repo, pr_number)
+        self.head_shas[key] = pr_data['head']['sha']
+        self.pr_states[key] = (pr_data.get('state'), (pr_data.get('user') or {}).get('login'))
+    
+    async def _get_login(self, client: httpx.AsyncClient) -> Optional[str]:
+        """Login of the token's user (the bot), or None if it cannot be looked up"""
+        if self._login is None:
+            response = await self._request(client, "get", f"{self.base_url}/user", headers=self.headers)
+            if response.status_code == 200:
+                self._login = response.json().get('login')
+        return self._login
+    
+    async def _get_paginated(self, client: httpx.AsyncClient, url: str,
+                             conditional: bool = False) -> List[Dict[str, Any]]:
+        """Fetch every page of a GitHub list endpoint
+        
+        With conditional=True pages are requested with If-None-Match, and
+        unchanged pages (304) are served from the response cache.
+        """
+        items = []
+        params = {"per_page": PAGE_SIZE}
+        while url:
+            cache_key = f"{url}?per_page={PAGE_SIZE}" if params else url
+            cached = self.response_cache.get(cache_key) if conditional else None
+            headers = self.headers
+            if cached and cached[0]:
+                headers = {**self.headers, "If-None-Match": cached[0]}
+            
+            response = await self._request(client, "get", url, headers=headers, params=params)
+            if response.status_code == 304 and cached:
+                page, next_url = cached[1]
+            else:
+                response.raise_for_status()
+                page = response.json()
+                next_url = response.links.get("next", {}).get("url")
+                if conditional and response.headers.get("etag"):
+                    self.response_cache.put(cache_key, (page, next_url), response.headers["etag"])
+            
+            items.extend(page)
+            # The next link already carries the query parameters
+            url = next_url
+            params = None
+        return items
     
     async def get_pr_files(self, owner: str, repo: str, pr_number: int) -> List[Dict[str, Any]]:
         """Fetch all files changed in a pull request
@@ -41,52 +282,191 @@ class GitHubIntegration:
         Returns:
             List of file information including content
         """
-        async with httpx.AsyncClient() as client:
-            # Get PR details
-            pr_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}"
-            pr_response = await client.get(pr_url, headers=self.headers)
-            pr_response.raise_for_status()
-            pr_data = pr_response.json()
-            
-            # Get files changed in PR
-            files_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}/files"
-            files_response = await client.get(files_url, headers=self.headers)
-            files_response.raise_for_status()
-            files_data = files_response.json()
-            
-            # Process each file
-            pr_files = []
-            for file in files_data:
-                if file['status'] in ['added', 'modified']:
-                    file_info = {
-                        'filename': file['filename'],
-                        'status': file['status'],
-                        'additions': file['additions'],
-                        'deletions': file['deletions'],
-                        'changes': file['changes'],
-                        'patch': file.get('patch', ''),
-                        'content': await self._get_file_content(
-                            owner, repo, file['filename'], pr_data['head']['sha'], client
-                        )
-                    }
-                    
-                    # Determine language from extension
-                    extension = os.path.splitext(file['filename'])[1]
-                    language_map = {
-                        '.py': 'python',
-                        '.js': 'javascript',
-                        '.ts': 'typescript',
-                        '.java': 'java',
-                        '.cpp': 'cpp',
-                        '.c': 'c',
-                        '.go': 'go',
-                        '.rs': 'rust'
-                    }
-                    file_info['language'] = language_map.get(extension, 'text')
-                    
-                    pr_files.append(file_info)
-            
-            return pr_files
+        client = await self._get_client()
+        
+        # Get PR details
+        pr_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}"
+        pr_response = await self._request(client, "get", pr_url, headers=self.headers)
+        pr_response.raise_for_status()
+        pr_data = pr_response.json()
+        head_sha = pr_data['head']['sha']
+        self._remember_pr(owner, repo, pr_number, pr_data)
+        
+        # Get files changed in PR (all pages)
+        backend = self.fetch_backend
+        files_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}/files"
+        files_data = await self._get_paginated(client, files_url, conditional=backend in ("git", "auto"))
+        changed_files = [file for file in files_data if file['status'] in ['added', 'modified']]
+        self.pr_patches[(owner, repo, pr_number)] = {file['filename']: file.get('patch', '') for file in files_data}
+        
+        if backend == "auto":
+            backend = await self._choose_fetch_backend(len(changed_files))
+        contents = await self._fetch_contents(backend, owner, repo, head_sha, changed_files, client)
+        
+        # Process each file
+        pr_files = []
+        for file, content in zip(changed_files, contents):
+            file_info = {
+                'filename': file['filename'],
+                'status': file['status'],
+                'additions': file['additions'],
+                'deletions': file['deletions'],
+                'changes': file['changes'],
+                'patch': file.get('patch', ''),
+                'content': content
+            }
+            
+            # Determine language from extension
+            extension = os.path.splitext(file['filename'])[1]
+            file_info['language'] = LANGUAGE_EXTENSIONS.get(extension, 'text')
+            
+            pr_files.append(file_info)
+        
+        return pr_files
+    
+    async def get_changes_since(self, owner: str, repo: str,
+                                base_sha: str, head_sha: str) -> Optional[Dict[str, str]]:
+        """Files changed between two commits of a PR branch, with their patches
+        
+        Args:
+            owner: Repository owner
+            repo: Repository name
+            base_sha: Previously reviewed head commit
+            head_sha: Current head commit
+            
+        Returns:
+            Dict of filename to patch, or None if the changes cannot be
+            isolated (force push, too many files or API error); the
+            caller then reviews the whole PR
+        """
+        client = await self._get_client()
+        compare_url = f"{self.base_url}/repos/{owner}/{repo}/compare/{base_sha}...{head_sha}"
+        try:
+            response = await self._request(client, "get", compare_url, headers=self.headers)
+            response.raise_for_status()
+            comparison = response.json()
+        except Exception as e:
+            print(f"Could not compare {base_sha[:7]}...{head_sha[:7]}: {str(e)}")
+            return None
+        
+        # "diverged" means the reviewed commit is no longer in the branch (force push)
+        files = comparison.get('files', [])
+        if comparison.get('status') not in ('ahead', 'identical') or len(files) >= COMPARE_MAX_FILES:
+            return None
+        return {file['filename']: file.get('patch', '') for file in files if file['status'] != 'removed'}
+    
+    async def _choose_fetch_backend(self, file_count: int) -> str:
+        """Pick a fetch backend from the PR size and the remaining rate limits"""
+        try:
+            limits = await self.check_rate_limit()
+        except Exception as e:
+            print(f"Could not check rate limit, using REST: {str(e)}")
+            return "rest"
+        
+        graphql_available = limits.get('graphql_remaining', 0) > 100
+        rest_available = limits['remaining'] > file_count * 10
+        
+        # Big PRs cost one GraphQL query per GRAPHQL_BATCH_SIZE files; small
+        # ones mostly hit the blob cache on synchronize events
+        if graphql_available and (file_count > self.small_pr_files or not rest_available):
+            return "graphql"
+        return "git"
+    
+    async def _fetch_contents(self, backend: str, owner: str, repo: str, head_sha: str,
+                              files: List[Dict[str, Any]], client: httpx.AsyncClient) -> List[str]:
+        """Fetch the head contents of PR files with the given backend, in listing order"""
+        contents: List[Optional[str]] = [None] * len(files)
+        
+        if backend == "graphql":
+            try:
+                contents = await self._fetch_contents_graphql(owner, repo, head_sha, files, client)
+            except Exception as e:
+                print(f"GraphQL content fetch failed, falling back to REST: {str(e)}")
+        elif backend == "git":
+            contents = await self._fetch_contents_git(owner, repo, files, client)
+        
+        # REST for everything else, and for files the other backends could not
+        # return (binary, truncated or missing blob SHAs)
+        semaphore = asyncio.Semaphore(self.max_concurrent_fetches)
+        
+        async def fetch_content(index: int):
+            async with semaphore:
+                contents[index] = await self._get_file_content(
+                    owner, repo, files[index]['filename'], head_sha, client
+                )
+        
+        await asyncio.gather(*[fetch_content(i) for i, content in enumerate(contents) if content is None])
+        return contents
+    
+    async def _fetch_contents_graphql(self, owner: str, repo: str, head_sha: str,
+                                      files: List[Dict[str, Any]],
+                                      client: httpx.AsyncClient) -> List[Optional[str]]:
+        """Fetch blob texts with one GraphQL query per GRAPHQL_BATCH_SIZE files"""
+        batches = [files[i:i + GRAPHQL_BATCH_SIZE] for i in range(0, len(files), GRAPHQL_BATCH_SIZE)]
+        
+        async def fetch_batch(batch: List[Dict[str, Any]]) -> List[Optional[str]]:
+            variables = {"owner": owner, "name": repo}
+            declarations = []
+            fields = []
+            for i, file in enumerate(batch):
+                variables[f"e{i}"] = f"{head_sha}:{file['filename']}"
+                declarations.append(f"$e{i}: String!")
+                fields.append(f"f{i}: object(expression: $e{i}) {{ ... on Blob {{ text isBinary isTruncated }} }}")
+            
+            query = (f"query($owner: String!, $name: String!, {', '.join(declarations)}) "
+                     f"{{ repository(owner: $owner, name: $name) {{ {' '.join(fields)} }} }}")
+            response = await self._request(client, "post", f"{self.base_url}/graphql", headers=self.headers,
+                                           json={"query": query, "variables": variables})
+            response.raise_for_status()
+            data = response.json()
+            if data.get("errors") and not data.get("data"):
+                raise RuntimeError(data["errors"][0].get("message", "GraphQL error"))
+            
+            repository = (data.get("data") or {}).get("repository") or {}
+            texts = []
+            for i in range(len(batch)):
+                blob = repository.get(f"f{i}") or {}
+                # Binary and truncated blobs have no text; those go through REST
+                usable = blob.get("text") is not None and not blob.get("isTruncated")
+                texts.append(blob["text"] if usable else None)
+            return texts
+        
+        results = await asyncio.gather(*[fetch_batch(batch) for batch in batches])
+        return [text for batch_texts in results for text in batch_texts]
+    
+    async def _fetch_contents_git(self, owner: str, repo: str, files: List[Dict[str, Any]],
+                                  client: httpx.AsyncClient) -> List[Optional[str]]:
+        """Fetch file contents from the git blobs API by the blob SHAs in the file listing
+        
+        Blobs are content-addressed, so files that did not change since an
+        earlier fetch in this process cost no request at all.
+        """
+        semaphore = asyncio.Semaphore(self.max_concurrent_fetches)
+        
+        async def fetch_blob(file: Dict[str, Any]) -> Optional[str]:
+            blob_sha = file.get('sha')
+            if not blob_sha:
+                return None
+            cached = self.response_cache.get(f"blob:{blob_sha}")
+            if cached:
+                return cached[1]
+            
+            async with semaphore:
+                try:
+                    response = await self._request(
+                        client, "get", f"{self.base_url}/repos/{owner}/{repo}/git/blobs/{blob_sha}",
+                        headers={**self.headers, "Accept": RAW_MEDIA_TYPE}
+                    )
+                    response.raise_for_status()
+                except Exception as e:
+                    print(f"Error fetching blob for {file['filename']}: {str(e)}")
+                    return None
+            
+            content = response.content.decode('utf-8', errors='replace')
+            self.response_cache.put(f"blob:{blob_sha}", content, size=len(response.content))
+            return content
+        
+        return list(await asyncio.gather(*[fetch_blob(file) for file in files]))
     
     async def _get_file_content(self, owner: str, repo: str, path: str, ref: str, client: httpx.AsyncClient) -> str:
         """Get the content of a specific file
@@ -101,19 +481,25 @@ class GitHubIntegration:
         Returns:
             File content as string
         """
-        content_url = f"{self.base_url}/repos/{owner}/{repo}/contents/{path}?ref={ref}"
+        content_url = f"{self.base_url}/repos/{owner}/{repo}/contents/{path}"
         
         try:
-            response = await client.get(content_url, headers=self.headers)
+            # Ask for the raw file to skip the base64 JSON envelope
+            response = await self._request(
+                client, "get", content_url,
+                headers={**self.headers, "Accept": RAW_MEDIA_TYPE},
+                params={"ref": ref}
+            )
             response.raise_for_status()
-            data = response.json()
             
-            # GitHub returns content base64 encoded
-            if 'content' in data:
-                content_bytes = base64.b64decode(data['content'])
-                return content_bytes.decode('utf-8')
-            else:
+            if response.headers.get("content-type", "").startswith("application/json"):
+                # Directories and submodules still come back as JSON
+                data = response.json()
+                if isinstance(data, dict) and 'content' in data:
+                    return base64.b64decode(data['content']).decode('utf-8')
                 return "# File content not available"
+            
+            return response.content.decode('utf-8', errors='replace')
                 
         except Exception as e:
             print(f"Error fetching file content for {path}: {str(e)}")
@@ -124,113 +510,210 @@ class GitHubIntegration:
                                  repo: str, 
                                  pr_number: int, 
                                  review_body: str,
-                                 event: str = "COMMENT") -> Dict[str, Any]:
+                                 event: str = "COMMENT",
+                                 comments: Optional[List[Dict[str, Any]]] = None,
+                                 commit_id: Optional[str] = None) -> Dict[str, Any]:
         """Post a review comment on a pull request
         
+        With comments, the summary and all inline comments are submitted as
+        one review (one request and one notification); only reviews whose
+        comments exceed MAX_REVIEW_PAYLOAD_BYTES are split. Reviews of the
+        bot's own PRs are posted as COMMENT, and closed PRs get the summary
+        as an issue comment.
+        
         Args:
             owner: Repository owner
             repo: Repository name
             pr_number: Pull request number
             review_body: The review content in markdown
             event: Review event type (COMMENT, APPROVE, REQUEST_CHANGES)
+            comments: Inline comments with path, line and body (see review_comments)
+            commit_id: Commit the comments refer to; defaults to the head SHA
+                seen by get_pr_files
             
         Returns:
-            API response
+            API response of the (first) review
         """
-        async with httpx.AsyncClient() as client:
-            try:
-                # First check if PR exists and is open
+        client = await self._get_client()
+        key = (owner, repo, pr_number)
+        comments = comments or []
+        # The reviewed head, even if the PR moved on since
+        commit_id = commit_id or self.head_shas.get(key)
+        
+        try:
+            # State and author come from get_pr_files / get_pr_info; the PR
+            # is fetched only if neither ran
+            if key not in self.pr_states:
                 pr_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}"
-                pr_response = await client.get(pr_url, headers=self.headers)
+                pr_response = await self._request(client, "get", pr_url, headers=self.headers)
                 
                 if pr_response.status_code == 404:
                     print(f"PR #{pr_number} not found")
                     return {"error": "PR not found", "status": 404}
-                
-                pr_data = pr_response.json()
-                if pr_data.get('state') != 'open':
-                    print(f"PR #{pr_number} is {pr_data.get('state')}, not open")
-                    # For closed PRs, just post a comment instead of a review
-                    comment_url = f"{self.base_url}/repos/{owner}/{repo}/issues/{pr_number}/comments"
-                    comment_response = await client.post(
-                        comment_url,
+                pr_response.raise_for_status()
+                self._remember_pr(owner, repo, pr_number, pr_response.json())
+            state, author = self.pr_states[key]
+            
+            if state != 'open':
+                print(f"PR #{pr_number} is {state}, not open")
+                if comments:
+                    print(f"Dropping {len(comments)} inline comment(s) of the review")
+                # For closed PRs, just post a comment instead of a review
+                comment_url = f"{self.base_url}/repos/{owner}/{repo}/issues/{pr_number}/comments"
+                comment_response = await self._request(
+                    client, "post", comment_url,
+                    headers=self.headers,
+                    json={"body": review_body}
+                )
+                return comment_response.json()
+            
+            # The bot can't approve or request changes on its own PR, but it
+            # can leave a COMMENT review with the inline comments
+            if event != "COMMENT" and author is not None and author == await self._get_login(client):
+                print(f"Cannot {event} own PR, posting the review as COMMENT")
+                event = "COMMENT"
+            
+            # Truncate body if too long
+            review_body = self._truncate_body(review_body)
+            
+            # Try to post the review
+            review_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}/reviews"
+            commit_id = commit_id or self.head_shas[key]
+            payloads = self._review_payloads(review_body, event, comments, commit_id)
+            
+            response = await self._request(
+                client, "post", review_url,
+                headers=self.headers,
+                json=payloads[0]
+            )
+            
+            # A comment outside the diff fails the whole review: retry once
+            # without the comments off the PR's diff, then post the summary alone
+            if response.status_code == 422 and payloads[0].get("comments"):
+                print(f"Review with inline comments failed with 422: {response.text}")
+                in_diff = self._comments_in_diff(key, comments)
+                if in_diff and len(in_diff) < len(comments):
+                    print(f"Retrying the review without {len(comments) - len(in_diff)} comment(s) outside the diff")
+                    payloads = self._review_payloads(review_body, event, in_diff, commit_id)
+                    response = await self._request(
+                        client, "post", review_url,
                         headers=self.headers,
-                        json={"body": review_body}
+                        json=payloads[0]
                     )
-                    return comment_response.json()
-                
-                # Check if the bot is the PR author (can't review own PRs)
-                current_user_url = f"{self.base_url}/user"
-                user_response = await client.get(current_user_url, headers=self.headers)
-                if user_response.status_code == 200:
-                    current_user = user_response.json()
-                    if current_user.get('login') == pr_data.get('user', {}).get('login'):
-                        print(f"Cannot review own PR")
-                        # Post as comment instead
-                        comment_url = f"{self.base_url}/repos/{owner}/{repo}/issues/{pr_number}/comments"
-                        comment_response = await client.post(
-                            comment_url,
-                            headers=self.headers,
-                            json={"body": review_body}
-                        )
-                        return comment_response.json()
-                
-                # Truncate body if too long
-                max_body_length = 65536
-                if len(review_body) > max_body_length:
-                    review_body = review_body[:max_body_length - 100] + "\n\n... (truncated due to length)"
-                
-                # Try to post the review
-                review_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}/reviews"
-                payload = {
-                    "body": review_body,
-                    "event": event
-                }
-                
-                response = await client.post(
-                    review_url,
+            
+            if response.status_code == 422 and payloads[0].get("comments"):
+                print("Posting the review summary without inline comments")
+                payloads = [{"body": review_body, "event": event}]
+                response = await self._request(
+                    client, "post", review_url,
                     headers=self.headers,
-                    json=payload
+                    json=payloads[0]
                 )
+            
+            # Log response for debugging
+            if response.status_code not in [200, 201]:
+                print(f"GitHub API Response Status: {response.status_code}")
+                print(f"Response Body: {response.text}")
                 
-                # Log response for debugging
-                if response.status_code not in [200, 201]:
-                    print(f"GitHub API Response Status: {response.status_code}")
-                    print(f"Response Body: {response.text}")
-                    
-                    # If review fails, try posting as a regular comment
-                    if response.status_code == 422:
-                        print("Review failed with 422, posting as comment instead")
-                        comment_url = f"{self.base_url}/repos/{owner}/{repo}/issues/{pr_number}/comments"
-                        comment_response = await client.post(
-                            comment_url,
-                            headers=self.headers,
-                            json={"body": review_body}
-                        )
-                        return comment_response.json()
-                
-                response.raise_for_status()
-                return response.json()
-                
-            except Exception as e:
-                print(f"Error posting review: {str(e)}")
-                # Try to post as a simple comment as fallback
-                try:
+                # If review fails, try posting as a regular comment
+                if response.status_code == 422:
+                    print("Review failed with 422, posting as comment instead")
                     comment_url = f"{self.base_url}/repos/{owner}/{repo}/issues/{pr_number}/comments"
-                    comment_response = await client.post(
-                        comment_url,
+                    comment_response = await self._request(
+                        client, "post", comment_url,
                         headers=self.headers,
-                        json={"body": f"**Code Review Results**\n\n{review_body}"}
+                        json={"body": review_body}
                     )
                     return comment_response.json()
-                except:
-                    raise e
+            
+            response.raise_for_status()
+            review = response.json()
+            
+            # Comments beyond one review's limit
+            for payload in payloads[1:]:
+                try:
+                    extra_response = await self._request(
+                        client, "post", review_url,
+                        headers=self.headers,
+                        json=payload
+                    )
+                    extra_response.raise_for_status()
+                except Exception as e:
+                    print(f"Error posting further inline comments: {str(e)}")
+            
+            return review
+            
+        except Exception as e:
+            print(f"Error posting review: {str(e)}")
+            # Try to post as a simple comment as fallback
+            try:
+                comment_url = f"{self.base_url}/repos/{owner}/{repo}/issues/{pr_number}/comments"
+                comment_response = await self._request(
+                    client, "post", comment_url,
+                    headers=self.headers,
+                    json={"body": f"**Code Review Results**\n\n{review_body}"}
+                )
+                return comment_response.json()
+            except:
+                raise e
+    
+    @staticmethod
+    def _truncate_body(body: str) -> str:
+        if len(body) > MAX_REVIEW_BODY_LENGTH:
+            body = body[:MAX_REVIEW_BODY_LENGTH - 100] + "\n\n... (truncated due to length)"
+        return body
+    
+    def _comments_in_diff(self, key: Tuple[str, str, int], comments: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
+        """Comments on a line of their file's diff, by the patches seen by get_pr_files"""
+        patches = self.pr_patches.get(key, {})
+        diff_lines = {path: set(commentable_lines(patch)) for path, patch in patches.items()}
+        return [comment for comment in comments if comment.get('line', 1) in diff_lines.get(comment['path'], ())]
+    
+    def _review_payloads(self,
+                         review_body: str,
+                         event: str,
+                         comments: List[Dict[str, Any]],
+                         commit_id: Optional[str]) -> List[Dict[str, Any]]:
+        """Request bodies of a review: the first carries the summary and the event"""
+        payloads = [{"body": review_body, "event": event}]
+        if not comments:
+            return payloads
+        
+        review_comments = [
+            {
+                "path": comment['path'],
+                "line": comment.get('line', 1),
+                "side": "RIGHT",  # Comment on the new version
+                "body": self._truncate_body(comment['body'])
+            }
+            for comment in comments
+        ]
+        chunks = [[]]
+        chunk_bytes = 0
+        for comment in review_comments:
+            comment_bytes = len(json.dumps(comment).encode("utf-8"))
+            if chunks[-1] and chunk_bytes + comment_bytes > MAX_REVIEW_PAYLOAD_BYTES:
+                chunks.append([])
+                chunk_bytes = 0
+            chunks[-1].append(comment)
+            chunk_bytes += comment_bytes
+        payloads[0].update(commit_id=commit_id, comments=chunks[0])
+        for index, chunk in enumerate(chunks[1:], start=2):
+            payloads.append({
+                "body": f"Inline comments (part {index} of {len(chunks)})",
+                "event": "COMMENT",
+                "commit_id": commit_id,
+                "comments": chunk
+            })
+        return payloads
     
     async def post_inline_comments(self,
                                   owner: str,
                                   repo: str,
                                   pr_number: int,
-                                  comments: List[Dict[str, Any]]) -> List[Dict[str, Any]]:
+                                  comments: List[Dict[str, Any]],
+                                  commit_id: Optional[str] = None,
+                                  batched: bool = True) -> List[Dict[str, Any]]:
         """Post inline comments on specific lines
         
         Args:
@@ -238,44 +721,107 @@ class GitHubIntegration:
             repo: Repository name
             pr_number: Pull request number
             comments: List of comment objects with path, line, and body
+            commit_id: Commit the comments refer to; defaults to the head SHA
+                seen by get_pr_files (the PR is fetched only if unknown)
+            batched: Submit all comments as one review instead of one
+                request per comment
             
         Returns:
-            List of created comments
+            List of created comments (of the submitted review when batched)
         """
-        async with httpx.AsyncClient() as client:
-            # First need to get the latest commit SHA
+        client = await self._get_client()
+        
+        commit_sha = commit_id or self.head_shas.get((owner, repo, pr_number))
+        if not commit_sha:
             pr_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}"
-            pr_response = await client.get(pr_url, headers=self.headers)
+            pr_response = await self._request(client, "get", pr_url, headers=self.headers)
             pr_response.raise_for_status()
-            pr_data = pr_response.json()
-            commit_sha = pr_data['head']['sha']
-            
-            created_comments = []
-            
-            for comment in comments:
-                comment_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}/comments"
-                
-                payload = {
-                    "body": comment['body'],
-                    "commit_id": commit_sha,
-                    "path": comment['path'],
-                    "line": comment.get('line', 1),
-                    "side": "RIGHT"  # Comment on the new version
-                }
-                
+            self._remember_pr(owner, repo, pr_number, pr_response.json())
+            commit_sha = self.head_shas[(owner, repo, pr_number)]
+        
+        if not comments:
+            return []
+        
+        created_comments = []
+        
+        if batched:
+            review_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}/reviews"
+            summary = f"{len(comments)} inline comment(s) from the automated code review"
+            for payload in self._review_payloads(summary, "COMMENT", comments, commit_sha):
                 try:
-                    response = await client.post(
-                        comment_url,
+                    response = await self._request(
+                        client, "post", review_url,
                         headers=self.headers,
                         json=payload
                     )
                     response.raise_for_status()
                     created_comments.append(response.json())
                 except Exception as e:
-                    print(f"Error posting inline comment: {str(e)}")
-            
+                    print(f"Error posting inline comments: {str(e)}")
             return created_comments
+        
+        for comment in comments:
+            comment_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}/comments"
+            
+            payload = {
+                "body": comment['body'],
+                "commit_id": commit_sha,
+                "path": comment['path'],
+                "line": comment.get('line', 1),
+                "side": "RIGHT"  # Comment on the new version
+            }
+            
+            try:
+                response = await self._request(
+                    client, "post", comment_url,
+                    headers=self.headers,
+                    json=payload
+                )
+                response.raise_for_status()
+                created_comments.append(response.json())
+            except Exception as e:
+                print(f"Error posting inline comment: {str(e)}")
+        
+        return created_comments
     
+    async def create_issue_comment(self, owner: str, repo: str, pr_number: int, body: str) -> Dict[str, Any]:
+        """Post a (non-review) comment on a pull request
+        
+        Returns:
+            The created comment (with its id)
+        """
+        client = await self._get_client()
+        
+        response = await self._request(
+            client, "post", f"{self.base_url}/repos/{owner}/{repo}/issues/{pr_number}/comments",
+            headers=self.headers,
+            json={"body": self._truncate_body(body)}
+        )
+        response.raise_for_status()
+        return response.json()
+    
+    async def update_issue_comment(self, owner: str, repo: str, comment_id: int, body: str) -> Dict[str, Any]:
+        """Replace the body of a comment posted with create_issue_comment"""
+        client = await self._get_client()
+        
+        response = await self._request(
+            client, "patch", f"{self.base_url}/repos/{owner}/{repo}/issues/comments/{comment_id}",
+            headers=self.headers,
+            json={"body": self._truncate_body(body)}
+        )
+        response.raise_for_status()
+        return response.json()
+    
+    async def delete_issue_comment(self, owner: str, repo: str, comment_id: int):
+        """Delete a comment posted with create_issue_comment"""
+        client = await self._get_client()
+        
+        response = await self._request(
+            client, "delete", f"{self.base_url}/repos/{owner}/{repo}/issues/comments/{comment_id}",
+            headers=self.headers
+        )
+        response.raise_for_status()
+
     async def get_pr_info(self, owner: str, repo: str, pr_number: int) -> Dict[str, Any]:
         """Get detailed PR information
         
@@ -287,27 +833,30 @@ class GitHubIntegration:
         Returns:
             PR metadata
         """
-        async with httpx.AsyncClient() as client:
-            pr_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}"
-            response = await client.get(pr_url, headers=self.headers)
-            response.raise_for_status()
-            
-            pr_data = response.json()
-            
-            return {
-                'title': pr_data['title'],
-                'description': pr_data.get('body', ''),
-                'author': pr_data['user']['login'],
-                'state': pr_data['state'],
-                'created_at': pr_data['created_at'],
-                'updated_at': pr_data['updated_at'],
-                'base_branch': pr_data['base']['ref'],
-                'head_branch': pr_data['head']['ref'],
-                'mergeable': pr_data.get('mergeable'),
-                'additions': pr_data['additions'],
-                'deletions': pr_data['deletions'],
-                'changed_files': pr_data['changed_files']
-            }
+        client = await self._get_client()
+        
+        pr_url = f"{self.base_url}/repos/{owner}/{repo}/pulls/{pr_number}"
+        response = await self._request(client, "get", pr_url, headers=self.headers)
+        response.raise_for_status()
+        
+        pr_data = response.json()
+        self._remember_pr(owner, repo, pr_number, pr_data)
+        
+        return {
+            'title': pr_data['title'],
+            'description': pr_data.get('body', ''),
+            'author': pr_data['user']['login'],
+            'state': pr_data['state'],
+            'created_at': pr_data['created_at'],
+            'updated_at': pr_data['updated_at'],
+            'base_branch': pr_data['base']['ref'],
+            'head_branch': pr_data['head']['ref'],
+            'head_sha': pr_data['head']['sha'],
+            'mergeable': pr_data.get('mergeable'),
+            'additions': pr_data['additions'],
+            'deletions': pr_data['deletions'],
+            'changed_files': pr_data['changed_files']
+        }
     
     def format_review_comment(self, markdown_report: str, pr_info: Dict[str, Any]) -> str:
         """Format the review report for GitHub comment
@@ -352,19 +901,21 @@ This review was generated by the Multi-Agent Code Review System.
         Returns:
             Rate limit information
         """
-        async with httpx.AsyncClient() as client:
-            response = await client.get(
-                f"{self.base_url}/rate_limit",
-                headers=self.headers
-            )
-            response.raise_for_status()
-            
-            data = response.json()
-            core_limits = data['rate']
-            
-            return {
-                'limit': core_limits['limit'],
-                'remaining': core_limits['remaining'],
-                'reset': datetime.fromtimestamp(core_limits['reset']).isoformat(),
-                'used': core_limits['used']
-            }
\ No newline at end of file
+        client = await self._get_client()
+        
+        response = await self._request(
+            client, "get", f"{self.base_url}/rate_limit",
+            headers=self.headers
+        )
+        response.raise_for_status()
+        
+        data = response.json()
+        core_limits = data['rate']
+        
+        return {
+            'limit': core_limits['limit'],
+            'remaining': core_limits['remaining'],
+            'reset': datetime.fromtimestamp(core_limits['reset']).isoformat(),
+            'used': core_limits['used'],
+            'graphql_remaining': data.get('resources', {}).get('graphql', {}).get('remaining', 0)
+        }
\ No newline at end of file
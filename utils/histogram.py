@@ -0,0 +1,136 @@
+"""
+Streaming Histogram - Fixed-size latency distributions with percentiles
+
+Samples are counted in logarithmic buckets instead of being stored: bucket
+i holds the values in (gamma^(i-1), gamma^i], so every percentile is known
+within a relative error of RELATIVE_ACCURACY whatever the number of samples.
+Memory depends only on the range of the values (about 1400 buckets for six
+orders of magnitude), and is capped at max_buckets by merging the lowest
+buckets, which keeps the high percentiles exact to the accuracy.
+"""
+
+import math
+from typing import Dict, Any, Optional
+
+# Relative error of the percentiles
+RELATIVE_ACCURACY = 0.01
+
+# Largest number of buckets a histogram keeps
+MAX_BUCKETS = 2048
+
+_GAMMA = (1 + RELATIVE_ACCURACY) / (1 - RELATIVE_ACCURACY)
+_LOG_GAMMA = math.log(_GAMMA)
+
+
+class StreamingHistogram:
+    """Count, sum, min, max and log-bucketed distribution of a metric"""
+
+    __slots__ = ("buckets", "zero_count", "count", "total", "min", "max", "latest", "latest_at", "max_buckets")
+
+    def __init__(self, max_buckets: int = MAX_BUCKETS):
+        self.buckets: Dict[int, int] = {}
+        self.zero_count = 0
+        self.count = 0
+        self.total = 0.0
+        self.min = math.inf
+        self.max = -math.inf
+        self.latest = 0.0
+        self.latest_at = 0.0
+        self.max_buckets = max_buckets
+
+    def add(self, value: float, timestamp: float = 0.0):
+        """Record a sample (values <= 0 share one bucket)"""
+        self.count += 1
+        self.total += value
+        if value < self.min:
+            self.min = value
+        if value > self.max:
+            self.max = value
+        if timestamp >= self.latest_at:
+            self.latest, self.latest_at = value, timestamp
+
+        if value <= 0:
+            self.zero_count += 1
+            return
+        index = math.ceil(math.log(value) / _LOG_GAMMA)
+        self.buckets[index] = self.buckets.get(index, 0) + 1
+        if len(self.buckets) > self.max_buckets:
+            self._collapse()
+
+    def _collapse(self):
+        """Merge the two lowest buckets"""
+        lowest, second = sorted(self.buckets)[:2]
+        self.buckets[second] += self.buckets.pop(lowest)
+
+    def merge(self, other: "StreamingHistogram"):
+        """Add another histogram's samples to this one"""
+        if not other.count:
+            return
+        for index, count in other.buckets.items():
+            self.buckets[index] = self.buckets.get(index, 0) + count
+        self.zero_count += other.zero_count
+        self.count += other.count
+        self.total += other.total
+        self.min = min(self.min, other.min)
+        self.max = max(self.max, other.max)
+        if other.latest_at >= self.latest_at:
+            self.latest, self.latest_at = other.latest, other.latest_at
+        while len(self.buckets) > self.max_buckets:
+            self._collapse()
+
+    def copy(self) -> "StreamingHistogram":
+        clone = StreamingHistogram(self.max_buckets)
+        clone.merge(self)
+        return clone
+
+    def to_dict(self) -> Dict[str, Any]:
+        """Plain-data form (e.g. to publish to another process)"""
+        return {
+            "buckets": dict(self.buckets),
+            "zero_count": self.zero_count,
+            "count": self.count,
+            "total": self.total,
+            "min": self.min,
+            "max": self.max,
+            "latest": self.latest,
+            "latest_at": self.latest_at
+        }
+
+    @classmethod
+    def from_dict(cls, data: Dict[str, Any], max_buckets: int = MAX_BUCKETS) -> "StreamingHistogram":
+        histogram = cls(max_buckets)
+        histogram.buckets = dict(data["buckets"])
+        for field in ("zero_count", "count", "total", "min", "max", "latest", "latest_at"):
+            setattr(histogram, field, data[field])
+        return histogram
+
+    def quantile(self, q: float) -> Optional[float]:
+        """Value below which a fraction q of the samples fall (None without samples)"""
+        if not self.count:
+            return None
+        rank = q * (self.count - 1)
+        seen = self.zero_count
+        if rank < seen:
+            return min(max(0.0, self.min), self.max)
+        for index in sorted(self.buckets):
+            seen += self.buckets[index]
+            if rank < seen:
+                # Midpoint (in relative terms) of the bucket, within the observed range
+                value = 2 * _GAMMA ** index / (_GAMMA + 1)
+                return min(max(value, self.min), self.max)
+        return self.max
+
+    def stats(self) -> Dict[str, float]:
+        """Summary statistics with p50/p90/p99 (empty without samples)"""
+        if not self.count:
+            return {}
+        return {
+            "count": self.count,
+            "mean": self.total / self.count,
+            "min": self.min,
+            "max": self.max,
+            "latest": self.latest,
+            "p50": self.quantile(0.5),
+            "p90": self.quantile(0.9),
+            "p99": self.quantile(0.99)
+        }
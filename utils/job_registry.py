@@ -0,0 +1,190 @@
+"""
+PR Job Registry - One review per pull request at a time
+
+Every push to a PR sends a synchronize event, and a burst of pushes used to
+start a full review per event. The registry keeps one record per PR, keyed
+by "owner/repo#number" in a Modal Dict shared by all containers:
+
+- events within the debounce window are coalesced: each spawned review
+  waits until the PR has been quiet for the window and exits if a newer
+  head SHA has arrived in the meantime
+- the review in flight for an older head SHA is cancelled when a new event
+  arrives
+- the last reviewed head SHA is kept, so the next review can be limited to
+  the files changed since then; with it the event of the last posted
+  review, which such a delta review may not lower (it sees only part of
+  the PR)
+
+The Modal Dict has no transactions; concurrent events for the same PR are
+resolved by the last write, which at worst lets one extra review run.
+"""
+
+import asyncio
+import time
+from typing import Dict, Any, Optional, Callable, Awaitable
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.logger import get_logger, perf_monitor
+
+try:
+    import modal
+    MODAL_AVAILABLE = True
+except ImportError:
+    MODAL_AVAILABLE = False
+
+# Initialize logger
+logger = get_logger(__name__)
+
+
+# Review events from the least to the most severe
+REVIEW_EVENTS = ("APPROVE", "COMMENT", "REQUEST_CHANGES")
+
+
+def job_key(owner: str, repo: str, pr_number: int) -> str:
+    """Registry key of a pull request"""
+    return f"{owner}/{repo}#{pr_number}"
+
+
+def floor_review_event(event: str, previous: Optional[str]) -> str:
+    """The more severe of a delta review's event and the last posted one
+
+    A delta review sees only the files changed since the last review, so a
+    clean follow-up push must not APPROVE over an earlier REQUEST_CHANGES.
+    """
+    if previous not in REVIEW_EVENTS:
+        return event
+    return max(event, previous, key=REVIEW_EVENTS.index)
+
+
+class PRJobRegistry:
+    """Per-PR review state shared across containers"""
+
+    def __init__(self,
+                 store: Any = None,
+                 debounce_seconds: float = 30.0,
+                 registry_name: str = "pr-review-jobs"):
+        """Initialize the registry
+
+        Args:
+            store: Dict-like store with async get/put (.aio) methods; defaults
+                to the Modal Dict registry_name, or a process-local dict
+                when Modal is not available
+            debounce_seconds: Quiet time after the last event before a review starts
+            registry_name: Name of the Modal Dict
+        """
+        self.debounce_seconds = debounce_seconds
+        self.store = store
+        self._local: Optional[Dict[str, Dict[str, Any]]] = None
+        if self.store is None and MODAL_AVAILABLE:
+            try:
+                self.store = modal.Dict.from_name(registry_name, create_if_missing=True)
+            except Exception as e:
+                logger.warning("Job registry falling back to process-local state", error=str(e))
+        if self.store is None:
+            self._local = {}
+
+    async def get(self, key: str) -> Dict[str, Any]:
+        """Record of a PR (empty if it has none)"""
+        if self._local is not None:
+            return dict(self._local.get(key) or {})
+        return dict(await self.store.get.aio(key) or {})
+
+    async def _put(self, key: str, record: Dict[str, Any]):
+        if self._local is not None:
+            self._local[key] = dict(record)
+        else:
+            await self.store.put.aio(key, record)
+
+    async def record_event(self, key: str, head_sha: str, now: Optional[float] = None) -> Optional[str]:
+        """Register an event for a new head SHA
+
+        Returns:
+            ID of the in-flight review the event supersedes (to be cancelled),
+            or None
+        """
+        record = await self.get(key)
+        superseded = None
+        if record.get("call_id") and record.get("head_sha") != head_sha:
+            superseded = record["call_id"]
+            record["call_id"] = None
+        record.update(head_sha=head_sha, event_at=now if now is not None else time.time())
+        await self._put(key, record)
+        return superseded
+
+    async def set_call(self, key: str, head_sha: str, call_id: str):
+        """Remember the review spawned for a head SHA"""
+        record = await self.get(key)
+        if record.get("head_sha") == head_sha:
+            record["call_id"] = call_id
+            await self._put(key, record)
+
+    async def wait_for_quiet(self,
+                             key: str,
+                             head_sha: str,
+                             sleep: Callable[[float], Awaitable[Any]] = asyncio.sleep,
+                             clock: Callable[[], float] = time.time) -> bool:
+        """Wait until no event arrived for the debounce window
+
+        Args:
+            key: Registry key of the PR
+            head_sha: Head SHA the waiting review was spawned for
+            sleep: Sleep function (replaceable in tests)
+            clock: Clock function (replaceable in tests)
+
+        Returns:
+            True if head_sha is still the PR's head, False if it was superseded
+        """
+        while True:
+            record = await self.get(key)
+            if record.get("head_sha", head_sha) != head_sha:
+                logger.info("Review superseded while debouncing", pr=key, head_sha=head_sha)
+                perf_monitor.record_metric("review_superseded", 1, {"stage": "debounce"})
+                return False
+            remaining = record.get("event_at", 0) + self.debounce_seconds - clock()
+            if remaining <= 0:
+                return True
+            await sleep(remaining)
+
+    async def is_current(self, key: str, head_sha: str) -> bool:
+        """Whether head_sha is still the PR's latest head"""
+        return (await self.get(key)).get("head_sha", head_sha) == head_sha
+
+    async def mark_reviewed(self, key: str, head_sha: str, event: Optional[str] = None):
+        """Record a posted review of head_sha (and its event, if one was posted)"""
+        record = await self.get(key)
+        record["reviewed_sha"] = head_sha
+        if event is not None:
+            record["reviewed_event"] = event
+        if record.get("head_sha") == head_sha:
+            record["call_id"] = None
+        await self._put(key, record)
+
+    async def last_reviewed_sha(self, key: str) -> Optional[str]:
+        """Head SHA of the last posted review of a PR"""
+        return (await self.get(key)).get("reviewed_sha")
+
+    async def last_review_event(self, key: str) -> Optional[str]:
+        """Event (APPROVE, COMMENT, REQUEST_CHANGES) of the last posted review of a PR"""
+        return (await self.get(key)).get("reviewed_event")
+
+    async def heartbeat(self, name: str, now: Optional[float] = None):
+        """Record that a singleton worker (e.g. the review dispatcher) is alive"""
+        await self._put(f"__{name}__", {"alive_at": now if now is not None else time.time()})
+
+    async def stop_heartbeat(self, name: str):
+        """Record that a singleton worker is exiting (the next event starts a new one)"""
+        await self._put(f"__{name}__", {"alive_at": 0})
+
+    async def set_running(self, name: str, call_ids: Dict[str, str]):
+        """Record the calls a singleton worker has running, by PR key"""
+        await self._put(f"__{name}_running__", {"calls": call_ids})
+
+    async def running_calls(self, name: str) -> Dict[str, str]:
+        """Calls a singleton worker recorded as running, by PR key"""
+        return (await self.get(f"__{name}_running__")).get("calls", {})
+
+    async def is_alive(self, name: str, max_age: float, now: Optional[float] = None) -> bool:
+        """Whether a singleton worker sent a heartbeat within max_age seconds"""
+        alive_at = (await self.get(f"__{name}__")).get("alive_at", 0)
+        return (now if now is not None else time.time()) - alive_at < max_age
@@ -9,52 +9,99 @@ import time
 import json
 import traceback
 from datetime import datetime
-from typing import Dict, Any, Optional, Callable
+from typing import Dict, List, Any, Optional, Callable, Tuple
 from functools import wraps
 from contextlib import contextmanager
+from contextvars import ContextVar
+import itertools
 import threading
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.histogram import StreamingHistogram
+from utils.tracing import start_span
 
 class PerformanceMonitor:
-    """Tracks performance metrics for various operations"""
+    """Tracks performance metrics for various operations
     
-    def __init__(self):
-        self.metrics = {}
-        self._lock = threading.Lock()
+    Each metric and tag set is a StreamingHistogram, so memory stays bounded
+    in long-lived processes and percentiles are available. Samples go to a
+    per-thread shard with its own lock, so concurrent recorders do not
+    contend; reads merge the shards.
+    """
+    
+    def __init__(self, shards: int = 8, max_series: int = 1000):
+        """Initialize the monitor
+        
+        Args:
+            shards: Number of independently locked shards
+            max_series: Most tag sets per shard; samples of further tag sets
+                are recorded under the tag set {"overflow": "true"}
+        """
+        self._shards = [({}, threading.Lock()) for _ in range(max(1, shards))]
+        self._next_shard = itertools.count()
+        self._local = threading.local()
+        self.max_series = max_series
+    
+    def _shard(self):
+        """Shard of the calling thread (assigned round-robin on first use)"""
+        index = getattr(self._local, "shard", None)
+        if index is None:
+            index = self._local.shard = next(self._next_shard) % len(self._shards)
+        return self._shards[index]
     
     def record_metric(self, metric_name: str, value: float, tags: Optional[Dict[str, str]] = None):
         """Record a performance metric"""
-        with self._lock:
-            if metric_name not in self.metrics:
-                self.metrics[metric_name] = []
-            
-            entry = {
-                "value": value,
-                "timestamp": time.time(),
-                "tags": tags or {}
-            }
-            self.metrics[metric_name].append(entry)
+        key = (metric_name, tuple(sorted((k, str(v)) for k, v in tags.items())) if tags else ())
+        series, lock = self._shard()
+        with lock:
+            histogram = series.get(key)
+            if histogram is None:
+                if len(series) >= self.max_series:
+                    key = (metric_name, (("overflow", "true"),))
+                histogram = series.setdefault(key, StreamingHistogram())
+            histogram.add(value, time.time())
+    
+    def snapshot(self, metric_name: Optional[str] = None) -> Dict[Tuple[str, Tuple], StreamingHistogram]:
+        """Histograms by (metric name, tags), merged over the shards"""
+        merged = {}
+        for series, lock in self._shards:
+            with lock:
+                copies = [(key, histogram.copy()) for key, histogram in series.items()
+                          if metric_name is None or key[0] == metric_name]
+            for key, histogram in copies:
+                if key in merged:
+                    merged[key].merge(histogram)
+                else:
+                    merged[key] = histogram
+        return merged
+    
+    def reset(self):
+        """Drop all recorded samples"""
+        for series, lock in self._shards:
+            with lock:
+                series.clear()
     
     def get_stats(self, metric_name: str) -> Dict[str, float]:
-        """Get statistics for a specific metric"""
-        with self._lock:
-            if metric_name not in self.metrics:
-                return {}
-            
-            values = [m["value"] for m in self.metrics[metric_name]]
-            if not values:
-                return {}
-            
-            return {
-                "count": len(values),
-                "mean": sum(values) / len(values),
-                "min": min(values),
-                "max": max(values),
-                "latest": values[-1] if values else 0
-            }
+        """Get statistics for a specific metric (over all tag sets)"""
+        total = StreamingHistogram()
+        for histogram in self.snapshot(metric_name).values():
+            total.merge(histogram)
+        return total.stats()
+    
+    def get_tagged_stats(self, metric_name: str) -> List[Dict[str, Any]]:
+        """Get statistics of a metric per tag set"""
+        return [
+            {"tags": dict(tags), **histogram.stats()}
+            for (_, tags), histogram in sorted(self.snapshot(metric_name).items())
+        ]
     
     def get_all_stats(self) -> Dict[str, Dict[str, float]]:
         """Get statistics for all metrics"""
-        return {name: self.get_stats(name) for name in self.metrics.keys()}
+        totals: Dict[str, StreamingHistogram] = {}
+        for (name, _), histogram in self.snapshot().items():
+            totals.setdefault(name, StreamingHistogram()).merge(histogram)
+        return {name: histogram.stats() for name, histogram in totals.items()}
 
 # Global performance monitor instance
 perf_monitor = PerformanceMonitor()
@@ -141,38 +188,39 @@ def get_logger(name: str) -> StructuredLogger:
 
 @contextmanager
 def log_performance(operation_name: str, logger: Optional[StructuredLogger] = None, **tags):
-    """Context manager for logging operation performance"""
+    """Context manager for logging operation performance (traced as a span)"""
     start_time = time.time()
     
     if logger:
         logger.info(f"Starting {operation_name}", operation=operation_name, status="started")
     
-    try:
-        yield
-        duration = time.time() - start_time
-        
-        # Record metric
-        perf_monitor.record_metric(f"{operation_name}_duration", duration, tags)
-        
-        if logger:
-            logger.info(
-                f"Completed {operation_name}",
-                operation=operation_name,
-                status="completed",
-                duration_seconds=duration
-            )
-    except Exception as e:
-        duration = time.time() - start_time
-        
-        if logger:
-            logger.error(
-                f"Failed {operation_name}",
-                exception=e,
-                operation=operation_name,
-                status="failed",
-                duration_seconds=duration
-            )
-        raise
+    with start_span(operation_name, **tags):
+        try:
+            yield
+            duration = time.time() - start_time
+            
+            # Record metric
+            perf_monitor.record_metric(f"{operation_name}_duration", duration, tags)
+            
+            if logger:
+                logger.info(
+                    f"Completed {operation_name}",
+                    operation=operation_name,
+                    status="completed",
+                    duration_seconds=duration
+                )
+        except Exception as e:
+            duration = time.time() - start_time
+            
+            if logger:
+                logger.error(
+                    f"Failed {operation_name}",
+                    exception=e,
+                    operation=operation_name,
+                    status="failed",
+                    duration_seconds=duration
+                )
+            raise
 
 def track_performance(operation_name: Optional[str] = None):
     """Decorator for tracking function performance"""
@@ -199,11 +247,23 @@ def track_performance(operation_name: Optional[str] = None):
     
     return decorator
 
+# Batch API requests are billed at half the synchronous price
+BATCH_PRICE_FACTOR = 0.5
+
+# Usage totals of the open usage_scope blocks of the current task
+_usage_scopes: ContextVar[Tuple[Dict[str, Any], ...]] = ContextVar("api_usage_scopes", default=())
+
+
 class APICallTracker:
-    """Tracks API calls for cost monitoring"""
+    """Tracks API calls for cost monitoring
+    
+    Keeps running totals per model instead of a record per call, so its
+    memory does not grow with the number of calls.
+    """
     
     def __init__(self):
-        self.calls = []
+        self._by_model: Dict[str, Dict[str, Any]] = {}
+        self._durations = StreamingHistogram()
         self._lock = threading.Lock()
     
     def track_call(self, 
@@ -212,26 +272,61 @@ class APICallTracker:
                    input_tokens: int,
                    output_tokens: int,
                    duration: float,
-                   cost: Optional[float] = None):
-        """Track an API call"""
+                   cost: Optional[float] = None,
+                   cached_input_tokens: int = 0,
+                   batch: bool = False):
+        """Track an API call
+        
+        Args:
+            cached_input_tokens: Part of input_tokens served from the provider's
+                prompt cache (billed at the cached input rate)
+            batch: The call went through the Batch API (billed at its discount)
+        """
+        cost = cost or self._estimate_cost(model, input_tokens, output_tokens, cached_input_tokens, batch)
         with self._lock:
-            call_data = {
-                "api_name": api_name,
-                "model": model,
-                "input_tokens": input_tokens,
-                "output_tokens": output_tokens,
-                "duration": duration,
-                "cost": cost or self._estimate_cost(model, input_tokens, output_tokens),
-                "timestamp": time.time()
-            }
-            self.calls.append(call_data)
+            totals = self._by_model.get(model)
+            if totals is None:
+                totals = self._by_model[model] = {
+                    "calls": 0,
+                    "cost": 0.0,
+                    "input_tokens": 0,
+                    "cached_input_tokens": 0,
+                    "output_tokens": 0
+                }
+            totals["calls"] += 1
+            totals["cost"] += cost
+            totals["input_tokens"] += input_tokens
+            totals["cached_input_tokens"] += cached_input_tokens
+            totals["output_tokens"] += output_tokens
+            self._durations.add(duration, time.time())
+            for usage in _usage_scopes.get():
+                usage["calls"] += 1
+                usage["cost"] = round(usage["cost"] + cost, 6)
+                usage["input_tokens"] += input_tokens
+                usage["cached_input_tokens"] += cached_input_tokens
+                usage["output_tokens"] += output_tokens
+    
+    @contextmanager
+    def usage_scope(self):
+        """Collect the calls made inside the block into a usage dict
+        
+        Tasks started inside the block count towards it too (they inherit
+        the context), so concurrent file reviews each get their own totals.
+        """
+        usage = {"calls": 0, "cost": 0.0, "input_tokens": 0, "cached_input_tokens": 0, "output_tokens": 0}
+        token = _usage_scopes.set(_usage_scopes.get() + (usage,))
+        try:
+            yield usage
+        finally:
+            _usage_scopes.reset(token)
     
-    def _estimate_cost(self, model: str, input_tokens: int, output_tokens: int) -> float:
-        """Estimate cost based on model and tokens"""
+    def _estimate_cost(self, model: str, input_tokens: int, output_tokens: int,
+                       cached_input_tokens: int = 0, batch: bool = False) -> float:
+        """Estimate cost based on model and tokens (batch: Batch API pricing)"""
         # Pricing as of early 2025 (example rates)
         pricing = {
-            "gpt-4o": {"input": 0.0025, "output": 0.01},  # per 1k tokens
-            "gpt-4o-mini": {"input": 0.00015, "output": 0.0006},
+            "gpt-4o": {"input": 0.0025, "cached_input": 0.00125, "output": 0.01},  # per 1k tokens
+            "gpt-4o-mini": {"input": 0.00015, "cached_input": 0.000075, "output": 0.0006},
             "gpt-3.5-turbo": {"input": 0.0005, "output": 0.0015}
         }
         
@@ -239,48 +334,56 @@ class APICallTracker:
             return 0.0
         
         rates = pricing[model]
-        cost = (input_tokens * rates["input"] / 1000) + (output_tokens * rates["output"] / 1000)
+        cached_input_tokens = min(cached_input_tokens, input_tokens)
+        cost = ((input_tokens - cached_input_tokens) * rates["input"] / 1000 +
+                cached_input_tokens * rates.get("cached_input", rates["input"]) / 1000 +
+                output_tokens * rates["output"] / 1000)
+        if batch:
+            cost *= BATCH_PRICE_FACTOR
         return round(cost, 6)
     
     def get_summary(self) -> Dict[str, Any]:
         """Get summary of API usage"""
         with self._lock:
-            if not self.calls:
-                return {
-                    "total_calls": 0,
-                    "total_cost": 0.0,
-                    "total_tokens": 0
-                }
-            
-            total_calls = len(self.calls)
-            total_cost = sum(call["cost"] for call in self.calls)
-            total_input_tokens = sum(call["input_tokens"] for call in self.calls)
-            total_output_tokens = sum(call["output_tokens"] for call in self.calls)
-            
-            by_model = {}
-            for call in self.calls:
-                model = call["model"]
-                if model not in by_model:
-                    by_model[model] = {
-                        "calls": 0,
-                        "cost": 0.0,
-                        "input_tokens": 0,
-                        "output_tokens": 0
-                    }
-                by_model[model]["calls"] += 1
-                by_model[model]["cost"] += call["cost"]
-                by_model[model]["input_tokens"] += call["input_tokens"]
-                by_model[model]["output_tokens"] += call["output_tokens"]
-            
+            by_model = {model: dict(totals) for model, totals in self._by_model.items()}
+            durations = self._durations.copy()
+        
+        if not by_model:
             return {
-                "total_calls": total_calls,
-                "total_cost": round(total_cost, 4),
-                "total_input_tokens": total_input_tokens,
-                "total_output_tokens": total_output_tokens,
-                "total_tokens": total_input_tokens + total_output_tokens,
-                "by_model": by_model,
-                "average_cost_per_call": round(total_cost / total_calls, 6) if total_calls > 0 else 0
+                "total_calls": 0,
+                "total_cost": 0.0,
+                "total_tokens": 0
             }
+        
+        total_calls = sum(totals["calls"] for totals in by_model.values())
+        total_cost = sum(totals["cost"] for totals in by_model.values())
+        total_input_tokens = sum(totals["input_tokens"] for totals in by_model.values())
+        total_cached_input_tokens = sum(totals["cached_input_tokens"] for totals in by_model.values())
+        total_output_tokens = sum(totals["output_tokens"] for totals in by_model.values())
+        
+        return {
+            "total_calls": total_calls,
+            "total_cost": round(total_cost, 4),
+            "total_input_tokens": total_input_tokens,
+            "total_cached_input_tokens": total_cached_input_tokens,
+            "cached_input_ratio": round(total_cached_input_tokens / total_input_tokens, 4) if total_input_tokens else 0,
+            "total_output_tokens": total_output_tokens,
+            "total_tokens": total_input_tokens + total_output_tokens,
+            "by_model": by_model,
+            "average_cost_per_call": round(total_cost / total_calls, 6) if total_calls > 0 else 0,
+            "latency": {q: durations.stats()[q] for q in ("p50", "p90", "p99")}
+        }
+    
+    def model_totals(self) -> Dict[str, Dict[str, Any]]:
+        """Running totals (calls, cost, tokens) per model"""
+        with self._lock:
+            return {model: dict(totals) for model, totals in self._by_model.items()}
+    
+    def reset(self):
+        """Drop the recorded totals"""
+        with self._lock:
+            self._by_model = {}
+            self._durations = StreamingHistogram()
 
 # Global API tracker instance
 api_tracker = APICallTracker()
@@ -0,0 +1,186 @@
+"""
+Metrics Export - Prometheus exposition of the recorded metrics
+
+Every container records into its own perf_monitor and api_tracker. Review
+workers publish their (cumulative) histograms and API totals to a Modal Dict
+under their task ID; the webhook's /metrics endpoint merges them with its
+own and renders the Prometheus text format:
+
+- each perf_monitor metric as a summary (p50/p90/p99, _sum, _count) per tag set
+- API calls, tokens and cost per model as counters
+- gauges passed in by the caller, such as the review queue depth
+
+Published entries expire after max_age, after which Prometheus sees the
+totals of the stopped containers drop out as a counter reset.
+"""
+
+import os
+import re
+import socket
+import time
+from typing import Dict, List, Any, Optional, Tuple
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.histogram import StreamingHistogram
+from utils.logger import get_logger, perf_monitor, api_tracker, PerformanceMonitor, APICallTracker
+
+try:
+    import modal
+    MODAL_AVAILABLE = True
+except ImportError:
+    MODAL_AVAILABLE = False
+
+# Initialize logger
+logger = get_logger(__name__)
+
+METRIC_PREFIX = "code_review"
+
+SUMMARY_QUANTILES = (0.5, 0.9, 0.99)
+
+# Histogram key: (metric name, sorted tag tuple), as in PerformanceMonitor
+HistogramKey = Tuple[str, Tuple[Tuple[str, str], ...]]
+
+
+def _metric_name(name: str) -> str:
+    return f"{METRIC_PREFIX}_" + re.sub(r"[^a-zA-Z0-9_]", "_", name)
+
+
+def _labels(tags: Dict[str, Any]) -> str:
+    if not tags:
+        return ""
+    rendered = []
+    for key, value in sorted(tags.items()):
+        value = str(value).replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n")
+        rendered.append(f'{re.sub(r"[^a-zA-Z0-9_]", "_", key)}="{value}"')
+    return "{" + ",".join(rendered) + "}"
+
+
+def merge_api_totals(target: Dict[str, Dict[str, Any]], totals: Dict[str, Dict[str, Any]]):
+    """Add per-model API totals into target"""
+    for model, model_totals in totals.items():
+        merged = target.setdefault(model, {})
+        for field, value in model_totals.items():
+            merged[field] = merged.get(field, 0) + value
+
+
+def render_prometheus(histograms: Dict[HistogramKey, StreamingHistogram],
+                      api_totals: Dict[str, Dict[str, Any]],
+                      gauges: Optional[List[Tuple[str, Dict[str, Any], float]]] = None) -> str:
+    """Metrics in the Prometheus text exposition format
+
+    Args:
+        histograms: Histograms by (metric name, tags), e.g. PerformanceMonitor.snapshot()
+        api_totals: Per-model totals, e.g. APICallTracker.model_totals()
+        gauges: (name, labels, value) of current values
+
+    Returns:
+        Text for a /metrics endpoint
+    """
+    lines = []
+
+    by_name: Dict[str, List[Tuple[Dict[str, str], StreamingHistogram]]] = {}
+    for (name, tags), histogram in sorted(histograms.items()):
+        by_name.setdefault(name, []).append((dict(tags), histogram))
+    for name, series in by_name.items():
+        metric = _metric_name(name)
+        lines.append(f"# TYPE {metric} summary")
+        for tags, histogram in series:
+            if not histogram.count:
+                continue
+            for q in SUMMARY_QUANTILES:
+                lines.append(f"{metric}{_labels(dict(tags, quantile=q))} {histogram.quantile(q)}")
+            lines.append(f"{metric}_sum{_labels(tags)} {histogram.total}")
+            lines.append(f"{metric}_count{_labels(tags)} {histogram.count}")
+
+    counters = (
+        ("api_calls_total", "calls", {}),
+        ("api_cost_usd_total", "cost", {}),
+        ("api_tokens_total", "input_tokens", {"kind": "input"}),
+        ("api_tokens_total", "cached_input_tokens", {"kind": "cached_input"}),
+        ("api_tokens_total", "output_tokens", {"kind": "output"})
+    )
+    declared = set()
+    for name, field, extra in counters:
+        metric = _metric_name(name)
+        if metric not in declared:
+            lines.append(f"# TYPE {metric} counter")
+            declared.add(metric)
+        for model, totals in sorted(api_totals.items()):
+            lines.append(f"{metric}{_labels(dict(extra, model=model))} {totals.get(field, 0)}")
+
+    gauge_names = set()
+    for name, labels, value in gauges or []:
+        metric = _metric_name(name)
+        if metric not in gauge_names:
+            lines.append(f"# TYPE {metric} gauge")
+            gauge_names.add(metric)
+        lines.append(f"{metric}{_labels(labels)} {value}")
+
+    return "\n".join(lines) + "\n"
+
+
+def metrics_source() -> str:
+    """ID of this container's published metrics"""
+    return os.environ.get("MODAL_TASK_ID") or f"{socket.gethostname()}-{os.getpid()}"
+
+
+class MetricsStore:
+    """Metrics published by the containers of the app"""
+
+    def __init__(self,
+                 store: Any = None,
+                 store_name: str = "review-metrics",
+                 max_age: float = 24 * 3600):
+        """Initialize the store
+
+        Args:
+            store: Dict-like store with async put/items (.aio) methods;
+                defaults to the Modal Dict store_name
+            store_name: Name of the Modal Dict
+            max_age: Seconds after which a container's entry is ignored
+        """
+        self.store = store
+        if self.store is None and MODAL_AVAILABLE:
+            self.store = modal.Dict.from_name(store_name, create_if_missing=True)
+        if self.store is None:
+            raise RuntimeError("MetricsStore needs Modal or a store instance")
+        self.max_age = max_age
+
+    async def publish(self,
+                      monitor: PerformanceMonitor = perf_monitor,
+                      tracker: APICallTracker = api_tracker,
+                      source: Optional[str] = None):
+        """Publish this container's metrics (replacing its previous entry)"""
+        entry = {
+            "published_at": time.time(),
+            "histograms": [[name, [list(tag) for tag in tags], histogram.to_dict()]
+                           for (name, tags), histogram in monitor.snapshot().items()],
+            "api": tracker.model_totals()
+        }
+        try:
+            await self.store.put.aio(source or metrics_source(), entry)
+        except Exception as e:
+            logger.warning("Could not publish metrics", error=str(e))
+
+    async def collect(self, exclude: Optional[str] = None,
+                      now: Optional[float] = None) -> Tuple[Dict[HistogramKey, StreamingHistogram], Dict[str, Dict[str, Any]]]:
+        """Merged histograms and API totals of the published entries
+
+        Args:
+            exclude: Source to leave out (e.g. the caller, whose own metrics are local)
+            now: Current time (replaceable in tests)
+        """
+        now = now if now is not None else time.time()
+        histograms: Dict[HistogramKey, StreamingHistogram] = {}
+        api_totals: Dict[str, Dict[str, Any]] = {}
+        async for source, entry in self.store.items.aio():
+            if source == exclude or now - entry.get("published_at", 0) > self.max_age:
+                continue
+            for name, tags, data in entry.get("histograms", []):
+                key = (name, tuple(tuple(tag) for tag in tags))
+                if key in histograms:
+                    histograms[key].merge(StreamingHistogram.from_dict(data))
+                else:
+                    histograms[key] = StreamingHistogram.from_dict(data)
+            merge_api_totals(api_totals, entry.get("api", {}))
+        return histograms, api_totals
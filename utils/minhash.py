@@ -0,0 +1,98 @@
+"""
+MinHash - near-duplicate detection for short texts
+
+MinHash signatures of token sets agree in a position with probability equal
+to the sets' Jaccard similarity. LSHIndex buckets signatures by bands of
+positions, so similar texts meet in a bucket and dissimilar ones rarely do;
+with bounded buckets every lookup costs O(bands), and clustering n texts
+costs O(n) instead of comparing all pairs.
+"""
+
+import random
+import re
+import zlib
+from typing import Dict, List, Any, FrozenSet, Hashable, Iterable, Tuple
+
+TOKEN_PATTERN = re.compile(r"[a-z0-9_]+")
+
+STOPWORDS = frozenset((
+    "the", "and", "for", "this", "that", "with", "from", "are", "was", "can", "could", "should",
+    "would", "may", "might", "not", "but", "has", "have", "its", "into", "use", "using", "line",
+    "lines", "code", "function", "which", "when", "been", "also", "more", "than", "there"
+))
+
+# Prime modulus of the permutation hashes (a Mersenne prime above 2^32)
+_PRIME = (1 << 61) - 1
+
+
+def tokenize(text: str) -> FrozenSet[str]:
+    """Significant lowercase words of a text"""
+    return frozenset(
+        token for token in TOKEN_PATTERN.findall(str(text or "").lower())
+        if len(token) > 2 and token not in STOPWORDS
+    )
+
+
+def jaccard(a: FrozenSet[str], b: FrozenSet[str]) -> float:
+    """Jaccard similarity of two token sets"""
+    if not a or not b:
+        return 0.0
+    return len(a & b) / len(a | b)
+
+
+class MinHasher:
+    """MinHash signatures from seeded permutations (stable across processes)"""
+
+    def __init__(self, num_perm: int = 16, seed: int = 1):
+        rng = random.Random(seed)
+        self.num_perm = num_perm
+        self.permutations = [(rng.randrange(1, _PRIME), rng.randrange(0, _PRIME)) for _ in range(num_perm)]
+
+    def signature(self, tokens: Iterable[str]) -> Tuple[int, ...]:
+        """Signature of a token set (empty for an empty set)"""
+        hashes = [zlib.crc32(token.encode("utf-8")) for token in tokens]
+        if not hashes:
+            return ()
+        return tuple(min((a * h + b) % _PRIME for h in hashes) for a, b in self.permutations)
+
+
+class LSHIndex:
+    """Banded LSH buckets of MinHash signatures, partitioned by scope"""
+
+    def __init__(self, bands: int = 8, rows: int = 2, bucket_size: int = 4):
+        """Initialize the index
+
+        Args:
+            bands: Bands per signature (signatures need bands x rows positions)
+            rows: Signature positions per band; more rows make candidates
+                stricter (the similarity threshold is about (1/bands)^(1/rows))
+            bucket_size: Items kept per bucket, which bounds the candidates
+                of a lookup to bands x bucket_size
+        """
+        self.bands = bands
+        self.rows = rows
+        self.bucket_size = bucket_size
+        self.buckets: Dict[Tuple[Hashable, int, Tuple[int, ...]], List[Any]] = {}
+
+    def _keys(self, signature: Tuple[int, ...], scope: Hashable):
+        for band in range(self.bands):
+            yield scope, band, signature[band * self.rows:(band + 1) * self.rows]
+
+    def candidates(self, signature: Tuple[int, ...], scopes: Iterable[Hashable]) -> List[Any]:
+        """Items sharing a band with the signature in any of the scopes"""
+        found = []
+        seen = set()
+        for scope in scopes:
+            for key in self._keys(signature, scope):
+                for item in self.buckets.get(key, ()):
+                    if item not in seen:
+                        seen.add(item)
+                        found.append(item)
+        return found
+
+    def add(self, item: Any, signature: Tuple[int, ...], scope: Hashable):
+        """Index an item (full buckets keep their first members)"""
+        for key in self._keys(signature, scope):
+            bucket = self.buckets.setdefault(key, [])
+            if len(bucket) < self.bucket_size:
+                bucket.append(item)
@@ -0,0 +1,60 @@
+"""
+Prompt Templates with a stable prefix
+
+OpenAI caches prompt prefixes automatically: when a request starts with the
+same tokens as a recent one (at least 1024 of them), that part is billed at
+the cached input rate and processed faster. Only an identical prefix counts,
+so the templates always lay out a review prompt in the same order, from the
+most to the least shared content:
+
+1. the agent's system message (sent first by AssistantAgent; static)
+2. the agent's review instructions (static)
+3. PR-level context shared by every file of a PR, e.g. the PR description
+4. per-file content - file name, analysis summaries and the code - last
+"""
+
+from typing import Dict, List, Optional, Tuple
+
+
+class ReviewPromptTemplate:
+    """Review prompt layout of one agent"""
+
+    def __init__(self, instructions: str, shared_fields: Tuple[str, ...] = ()):
+        """Initialize the template
+
+        Args:
+            instructions: Static review instructions, identical for every call
+            shared_fields: Labels of the PR-level fields, rendered in this order
+        """
+        self.instructions = instructions.strip()
+        self.shared_fields = shared_fields
+
+    def render(self,
+               code: str,
+               filename: str,
+               language: str,
+               shared: Optional[Dict[str, str]] = None,
+               details: Optional[List[str]] = None) -> str:
+        """Assemble a prompt
+
+        Args:
+            code: Code to review
+            filename: Name of the file
+            language: Language of the code (for the code fence)
+            shared: Values of the shared fields ('Not provided' if missing)
+            details: Per-file sections (analysis summaries, notes); empty ones are left out
+
+        Returns:
+            Prompt with the static instructions first and the code last
+        """
+        parts = [self.static_prefix(shared), f"File: {filename}"]
+        parts.extend(detail.strip() for detail in details or [] if detail and detail.strip())
+        parts.append(f"```{language}\n{code}\n```")
+        return "\n\n".join(parts)
+
+    def static_prefix(self, shared: Optional[Dict[str, str]] = None) -> str:
+        """Part of the prompt that is the same for every file (of one PR, given its shared fields)"""
+        shared = shared or {}
+        parts = [self.instructions]
+        parts.extend(f"{label}: {shared.get(label) or 'Not provided'}" for label in self.shared_fields)
+        return "\n\n".join(parts)
@@ -44,6 +44,9 @@ class ReportGenerator:
         # Executive Summary
         report_lines.extend(self._generate_executive_summary(orchestrator_results, consensus_results))
         
+        # Files left out of the review
+        report_lines.extend(self._generate_skipped_files(orchestrator_results))
+        
         # Critical Issues
         report_lines.extend(self._generate_critical_issues(consensus_results))
         
@@ -129,6 +132,24 @@ class ReportGenerator:
         lines.append("---\n")
         return lines
     
+    def _generate_skipped_files(self, orchestrator_results: Dict[str, Any]) -> List[str]:
+        """Generate the note on files that were not reviewed (e.g. over the token budget)"""
+        skipped_files = orchestrator_results.get('skipped_files', [])
+        if not skipped_files:
+            return []
+        
+        lines = [
+            "## Files Not Reviewed\n",
+            "The following files were skipped and need a manual review:",
+            ""
+        ]
+        for entry in skipped_files:
+            tokens = entry.get('estimated_tokens')
+            size = f", ~{tokens:,} tokens" if tokens else ""
+            lines.append(f"- `{entry.get('filename', 'unknown')}` ({entry.get('reason', 'skipped')}{size})")
+        lines.extend(["", "---\n"])
+        return lines
+    
     def _generate_critical_issues(self, consensus_results: Dict[str, Any]) -> List[str]:
         """Generate critical issues section"""
         recommendations = consensus_results.get('recommendations', [])
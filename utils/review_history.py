@@ -0,0 +1,532 @@
+"""
+Review History - persistent store of past reviews on the cache Volume
+
+The review cache keeps agent responses for an hour; the history keeps what
+every review produced, so later reviews can reuse it and latency and cost
+can be followed over time. It is SQLite with indexed tables of:
+
+- reviews: one row per PR review (repo, PR, head SHA, files, tokens, cost, time)
+- file_reviews: the stored result of each file review by repo, PR, head SHA
+  and path, with its review key (hash of the content and the review
+  settings), tokens and time
+- unit_findings: findings of function/class units by unit cache key and unit hash
+- benchmark_runs: results of benchmarks/run_benchmarks.py
+
+A SQLite file on a Modal Volume must not be written from two containers
+(the last commit of a file wins), so each writer appends to its own segment
+database under segments/ and compact(), run by a single scheduled function,
+merges the segments into the main database. Reads query the main database
+and the segments that are not merged yet.
+"""
+
+import hashlib
+import json
+import os
+import socket
+import sqlite3
+import threading
+import time
+import uuid
+import zlib
+from typing import Dict, List, Any, Optional, Callable, Iterable, Tuple
+import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.logger import get_logger
+
+# Initialize logger
+logger = get_logger(__name__)
+
+MAIN_DATABASE = "reviews.db"
+SEGMENT_DIR = "segments"
+
+# Parts of a file review result not worth keeping (rebuilt by the PR report)
+OMITTED_REVIEW_FIELDS = ("markdown_report", "performance_metrics", "usage", "processing_time", "cache_stats")
+
+SCHEMA = """
+CREATE TABLE IF NOT EXISTS reviews (
+    review_id TEXT PRIMARY KEY,
+    repo TEXT NOT NULL,
+    pr_number INTEGER,
+    head_sha TEXT,
+    created_at REAL NOT NULL,
+    files INTEGER NOT NULL,
+    reused_files INTEGER NOT NULL,
+    recommendations INTEGER NOT NULL,
+    duration REAL,
+    calls INTEGER NOT NULL,
+    input_tokens INTEGER NOT NULL,
+    cached_input_tokens INTEGER NOT NULL,
+    output_tokens INTEGER NOT NULL,
+    cost REAL NOT NULL
+);
+CREATE INDEX IF NOT EXISTS reviews_by_pr ON reviews (repo, pr_number, created_at);
+CREATE INDEX IF NOT EXISTS reviews_by_time ON reviews (created_at);
+
+CREATE TABLE IF NOT EXISTS file_reviews (
+    review_id TEXT NOT NULL,
+    repo TEXT NOT NULL,
+    pr_number INTEGER,
+    head_sha TEXT,
+    filename TEXT NOT NULL,
+    review_key TEXT NOT NULL,
+    created_at REAL NOT NULL,
+    status TEXT,
+    reused INTEGER NOT NULL,
+    duration REAL,
+    calls INTEGER NOT NULL,
+    input_tokens INTEGER NOT NULL,
+    output_tokens INTEGER NOT NULL,
+    cost REAL NOT NULL,
+    result BLOB,
+    PRIMARY KEY (review_id, filename)
+);
+CREATE INDEX IF NOT EXISTS file_reviews_by_path ON file_reviews (repo, filename, review_key);
+CREATE INDEX IF NOT EXISTS file_reviews_by_head ON file_reviews (repo, pr_number, head_sha);
+
+CREATE TABLE IF NOT EXISTS unit_findings (
+    unit_key TEXT PRIMARY KEY,
+    unit_hash TEXT NOT NULL,
+    unit_name TEXT,
+    created_at REAL NOT NULL,
+    findings BLOB NOT NULL
+);
+CREATE INDEX IF NOT EXISTS unit_findings_by_hash ON unit_findings (unit_hash);
+
+CREATE TABLE IF NOT EXISTS benchmark_runs (
+    run_id TEXT NOT NULL,
+    created_at REAL NOT NULL,
+    git_commit TEXT,
+    corpus TEXT,
+    scenario TEXT NOT NULL,
+    concurrency INTEGER NOT NULL,
+    result TEXT NOT NULL,
+    PRIMARY KEY (run_id, scenario, concurrency)
+);
+CREATE INDEX IF NOT EXISTS benchmark_runs_by_level ON benchmark_runs (scenario, concurrency, created_at);
+"""
+
+TABLES = ("reviews", "file_reviews", "unit_findings", "benchmark_runs")
+
+# Most parameters in one IN (...) lookup (SQLite allows 999 by default)
+LOOKUP_CHUNK = 500
+
+
+def file_review_key(code: str, settings: Dict[str, Any], patch: str = "") -> str:
+    """Key of a file review: same content, patch and settings give the same review"""
+    payload = json.dumps({
+        "code": hashlib.sha256(code.encode("utf-8")).hexdigest(),
+        "patch": hashlib.sha256(patch.encode("utf-8")).hexdigest() if patch else "",
+        "settings": settings
+    }, sort_keys=True)
+    return hashlib.sha256(payload.encode("utf-8")).hexdigest()
+
+
+def _pack(value: Any) -> bytes:
+    return zlib.compress(json.dumps(value, separators=(",", ":"), default=str).encode("utf-8"))
+
+
+def _unpack(blob: bytes) -> Any:
+    return json.loads(zlib.decompress(blob).decode("utf-8"))
+
+
+def _usage(review: Dict[str, Any]) -> Dict[str, Any]:
+    usage = review.get("usage") or {}
+    return {
+        "calls": usage.get("calls", 0),
+        "input_tokens": usage.get("input_tokens", 0),
+        "cached_input_tokens": usage.get("cached_input_tokens", 0),
+        "output_tokens": usage.get("output_tokens", 0),
+        "cost": usage.get("cost", 0.0)
+    }
+
+
+def _is_complete(review: Dict[str, Any]) -> bool:
+    """Whether every agent of a file review succeeded with its findings at hand
+
+    Reviews with a failed or deferred agent are recorded but not reused,
+    otherwise that agent's findings would be missing until the file changes.
+    """
+    if review.get("status") != "success":
+        return False
+    agent_results = review.get("orchestrator_results", {}).get("agent_results", {})
+    return all(result.get("status") == "success" and not result.get("deferred")
+               for result in agent_results.values())
+
+
+def _percentile(values: List[float], q: float) -> Optional[float]:
+    if not values:
+        return None
+    ordered = sorted(values)
+    return round(ordered[min(len(ordered) - 1, int(q * len(ordered)))], 4)
+
+
+class ReviewHistory:
+    """Review history in a directory (e.g. /cache/history on the Volume)"""
+
+    def __init__(self,
+                 directory: str,
+                 commit: Optional[Callable[[], Any]] = None,
+                 reload: Optional[Callable[[], Any]] = None):
+        """Initialize the history
+
+        Args:
+            directory: Directory of the main database and the segments
+            commit: Called after recording a review (e.g. volume.commit), so
+                other containers see it
+            reload: Called by refresh() to see what other containers
+                committed (e.g. volume.reload)
+        """
+        self.directory = directory
+        self.main_path = os.path.join(directory, MAIN_DATABASE)
+        self.segment_dir = os.path.join(directory, SEGMENT_DIR)
+        self.commit = commit
+        self.reload = reload
+        self._segment_path: Optional[str] = None
+        self._uncommitted = False
+        self._lock = threading.Lock()
+
+    @property
+    def segment_path(self) -> str:
+        """This writer's segment (named on first use, after any memory snapshot)"""
+        if self._segment_path is None:
+            writer_id = f"{socket.gethostname()}-{os.getpid()}-{uuid.uuid4().hex[:8]}"
+            self._segment_path = os.path.join(self.segment_dir, f"{writer_id}.db")
+        return self._segment_path
+
+    @staticmethod
+    def _open(path: str) -> sqlite3.Connection:
+        connection = sqlite3.connect(path)
+        connection.executescript(SCHEMA)
+        return connection
+
+    def _databases(self) -> List[str]:
+        paths = [self.main_path] if os.path.exists(self.main_path) else []
+        if os.path.isdir(self.segment_dir):
+            paths.extend(
+                os.path.join(self.segment_dir, name)
+                for name in sorted(os.listdir(self.segment_dir)) if name.endswith(".db")
+            )
+        return paths
+
+    def _write(self, write: Callable[[sqlite3.Connection], Any], commit: bool = True) -> Any:
+        """Run write in a transaction on this writer's segment"""
+        with self._lock:
+            os.makedirs(self.segment_dir, exist_ok=True)
+            connection = self._open(self.segment_path)
+            try:
+                with connection:
+                    result = write(connection)
+            finally:
+                connection.close()
+            self._uncommitted = True
+        if commit:
+            self.sync()
+        return result
+
+    def _query(self, sql: str, parameters: Iterable[Tuple[Any, ...]]) -> List[sqlite3.Row]:
+        """Rows of a query, run once per parameter tuple, from every database"""
+        parameters = list(parameters)
+        rows = []
+        for path in self._databases():
+            try:
+                connection = sqlite3.connect(f"file:{path}?mode=ro", uri=True)
+            except sqlite3.Error as e:
+                logger.warning("Skipping unreadable review history database", path=path, error=str(e))
+                continue
+            connection.row_factory = sqlite3.Row
+            try:
+                for params in parameters:
+                    rows.extend(connection.execute(sql, params).fetchall())
+            except sqlite3.Error as e:
+                # e.g. a segment whose schema was not committed yet
+                logger.warning("Skipping unreadable review history database", path=path, error=str(e))
+            finally:
+                connection.close()
+        return rows
+
+    def sync(self):
+        """Commit this writer's changes (no-op without a commit callback or changes)"""
+        if self.commit is None or not self._uncommitted:
+            return
+        self._uncommitted = False
+        try:
+            self.commit()
+        except Exception as e:
+            self._uncommitted = True
+            logger.warning("Could not commit the review history", error=str(e))
+
+    def refresh(self):
+        """Pick up what other containers committed"""
+        if self.reload is None:
+            return
+        try:
+            self.reload()
+        except Exception as e:
+            logger.warning("Could not reload the review history", error=str(e))
+
+    def record_review(self,
+                      repo: str,
+                      pr_number: Optional[int],
+                      head_sha: Optional[str],
+                      result: Dict[str, Any],
+                      review_keys: Dict[str, str],
+                      reused: Iterable[str] = ()) -> str:
+        """Record a PR review and its file reviews
+
+        Args:
+            repo: Repository as 'owner/name'
+            pr_number: Pull request number
+            head_sha: Reviewed head commit
+            result: Result of review_pull_request (or aggregate_pr_reviews)
+            review_keys: Review key of each file by filename
+            reused: Files whose review was taken from the history (recorded
+                for the PR without storing their result again)
+
+        Returns:
+            Id of the recorded review
+        """
+        review_id = uuid.uuid4().hex
+        now = time.time()
+        reused = set(reused)
+        totals = _usage({})
+        rows = []
+        for review in result.get("file_reviews", []):
+            filename = review.get("filename")
+            if filename not in review_keys:
+                continue
+            usage = _usage(review)
+            for key in totals:
+                totals[key] += usage[key]
+            stored = None
+            if _is_complete(review) and filename not in reused:
+                stored = _pack({key: value for key, value in review.items() if key not in OMITTED_REVIEW_FIELDS})
+            duration = review.get("processing_time", review.get("performance_metrics", {}).get("total_time"))
+            rows.append((
+                review_id, repo, pr_number, head_sha, filename, review_keys[filename], now,
+                review.get("status"), int(filename in reused), duration, usage["calls"],
+                usage["input_tokens"], usage["output_tokens"], usage["cost"], stored
+            ))
+        reused_files = sum(1 for row in rows if row[4] in reused)
+
+        def write(connection: sqlite3.Connection):
+            connection.execute(
+                "INSERT INTO reviews VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                (review_id, repo, pr_number, head_sha, now, len(rows), reused_files,
+                 len(result.get("pr_consensus", {}).get("recommendations", [])),
+                 result.get("total_duration_seconds"), totals["calls"], totals["input_tokens"],
+                 totals["cached_input_tokens"], totals["output_tokens"], round(totals["cost"], 6))
+            )
+            connection.executemany(
+                "INSERT INTO file_reviews VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)", rows
+            )
+
+        self._write(write)
+        logger.info("Recorded review in the history", repo=repo, pr_number=pr_number,
+                    files=len(rows), reused_files=reused_files)
+        return review_id
+
+    def find_file_reviews(self, repo: str, review_keys: Dict[str, str]) -> Dict[str, Dict[str, Any]]:
+        """Stored reviews of files reviewed before with the same review key
+
+        Args:
+            repo: Repository as 'owner/name'
+            review_keys: Review key of each file by filename
+
+        Returns:
+            Latest stored review result by filename (marked 'from_history')
+        """
+        if not review_keys:
+            return {}
+        rows = self._query(
+            "SELECT filename, created_at, result FROM file_reviews "
+            "WHERE repo = ? AND filename = ? AND review_key = ? AND result IS NOT NULL "
+            "ORDER BY created_at DESC LIMIT 1",
+            [(repo, filename, key) for filename, key in review_keys.items()]
+        )
+        latest: Dict[str, sqlite3.Row] = {}
+        for row in rows:
+            if row["filename"] not in latest or row["created_at"] > latest[row["filename"]]["created_at"]:
+                latest[row["filename"]] = row
+
+        found = {}
+        for filename, row in latest.items():
+            review = _unpack(row["result"])
+            review["from_history"] = True
+            review["cached_agents"] = list(review.get("orchestrator_results", {}).get("agent_results", {}))
+            found[filename] = review
+        return found
+
+    def record_unit_findings(self, entries: Dict[str, Dict[str, Any]], unit_hashes: Dict[str, str]):
+        """Store unit findings (the entries of the orchestrator's unit cache)
+
+        Committed with the next recorded review or sync().
+
+        Args:
+            entries: {"unit": name, "findings": ...} by unit cache key
+            unit_hashes: Syntax tree hash of each unit by unit cache key
+        """
+        now = time.time()
+        rows = [
+            (key, unit_hashes.get(key, ""), entry.get("unit"), now, _pack(entry.get("findings", {})))
+            for key, entry in entries.items()
+        ]
+        if rows:
+            self._write(lambda connection: connection.executemany(
+                "INSERT OR REPLACE INTO unit_findings VALUES (?, ?, ?, ?, ?)", rows
+            ), commit=False)
+
+    def find_unit_findings(self, unit_keys: List[str]) -> Dict[str, Dict[str, Any]]:
+        """Stored unit findings by unit cache key (in the unit cache's entry format)"""
+        chunks = [tuple(unit_keys[i:i + LOOKUP_CHUNK]) for i in range(0, len(unit_keys), LOOKUP_CHUNK)]
+        found = {}
+        for chunk in chunks:
+            rows = self._query(
+                f"SELECT unit_key, unit_name, findings FROM unit_findings "
+                f"WHERE unit_key IN ({', '.join('?' * len(chunk))})",
+                [chunk]
+            )
+            for row in rows:
+                found[row["unit_key"]] = {"unit": row["unit_name"], "findings": _unpack(row["findings"])}
+        return found
+
+    def pr_reviews(self, repo: str, pr_number: int) -> List[Dict[str, Any]]:
+        """Recorded reviews of a PR, oldest first"""
+        rows = self._query("SELECT * FROM reviews WHERE repo = ? AND pr_number = ?", [(repo, pr_number)])
+        return sorted((dict(row) for row in rows), key=lambda row: row["created_at"])
+
+    def review_trends(self, repo: Optional[str] = None, days: int = 30) -> List[Dict[str, Any]]:
+        """Daily review counts, reuse, latency percentiles and cost
+
+        Args:
+            repo: Only reviews of this repository ('owner/name')
+            days: Days to look back
+        """
+        sql = "SELECT * FROM reviews WHERE created_at >= ?"
+        params: Tuple[Any, ...] = (time.time() - days * 86400,)
+        if repo:
+            sql += " AND repo = ?"
+            params += (repo,)
+
+        by_day: Dict[str, List[sqlite3.Row]] = {}
+        for row in self._query(sql, [params]):
+            by_day.setdefault(time.strftime("%Y-%m-%d", time.gmtime(row["created_at"])), []).append(row)
+
+        trends = []
+        for day, rows in sorted(by_day.items()):
+            files = sum(row["files"] for row in rows)
+            durations = [row["duration"] for row in rows if row["duration"] is not None]
+            trends.append({
+                "day": day,
+                "reviews": len(rows),
+                "files": files,
+                "reuse_rate": round(sum(row["reused_files"] for row in rows) / files, 3) if files else 0.0,
+                "duration_p50": _percentile(durations, 0.5),
+                "duration_p90": _percentile(durations, 0.9),
+                "input_tokens": sum(row["input_tokens"] for row in rows),
+                "output_tokens": sum(row["output_tokens"] for row in rows),
+                "cost": round(sum(row["cost"] for row in rows), 4),
+                "cost_per_review": round(sum(row["cost"] for row in rows) / len(rows), 6)
+            })
+        return trends
+
+    def record_benchmark(self, report: Dict[str, Any]) -> str:
+        """Record a benchmark report (the JSON of benchmarks/run_benchmarks.py)
+
+        Returns:
+            Id of the recorded run
+        """
+        run_id = uuid.uuid4().hex
+        now = time.time()
+        corpus = report.get("config", {}).get("corpus")
+        rows = [
+            (run_id, now, report.get("git_commit"), corpus, result["scenario"], result["concurrency"],
+             json.dumps(result))
+            for result in report.get("results", [])
+        ]
+        self._write(lambda connection: connection.executemany(
+            "INSERT INTO benchmark_runs VALUES (?, ?, ?, ?, ?, ?, ?)", rows
+        ))
+        return run_id
+
+    def benchmark_trends(self,
+                         scenario: Optional[str] = None,
+                         concurrency: Optional[int] = None,
+                         corpus: Optional[str] = None,
+                         limit: int = 20) -> List[Dict[str, Any]]:
+        """Recorded benchmark results, oldest first, at most limit per level
+
+        Returns:
+            Entries with 'created_at', 'git_commit', 'corpus' and the 'result'
+            entry of the level
+        """
+        sql = "SELECT * FROM benchmark_runs WHERE 1 = 1"
+        params: Tuple[Any, ...] = ()
+        for column, value in (("scenario", scenario), ("concurrency", concurrency), ("corpus", corpus)):
+            if value is not None:
+                sql += f" AND {column} = ?"
+                params += (value,)
+
+        by_level: Dict[Tuple[str, int], List[Dict[str, Any]]] = {}
+        for row in sorted(self._query(sql, [params]), key=lambda row: row["created_at"]):
+            by_level.setdefault((row["scenario"], row["concurrency"]), []).append({
+                "created_at": row["created_at"],
+                "git_commit": row["git_commit"],
+                "corpus": row["corpus"],
+                "result": json.loads(row["result"])
+            })
+        return [entry for level in sorted(by_level) for entry in by_level[level][-limit:]]
+
+    def compact(self, max_age_days: Optional[float] = None) -> int:
+        """Merge the segments into the main database (run from one process only)
+
+        Args:
+            max_age_days: Also delete reviews, file reviews and unit findings
+                older than this many days
+
+        Returns:
+            Number of segments merged
+        """
+        segments = [path for path in self._databases() if path != self.main_path]
+        os.makedirs(self.directory, exist_ok=True)
+        connection = self._open(self.main_path)
+        merged = 0
+        try:
+            for path in segments:
+                try:
+                    connection.execute("ATTACH DATABASE ? AS segment", (path,))
+                    try:
+                        with connection:
+                            for table in TABLES:
+                                connection.execute(f"INSERT OR REPLACE INTO main.{table} SELECT * FROM segment.{table}")
+                    finally:
+                        connection.execute("DETACH DATABASE segment")
+                except sqlite3.Error as e:
+                    # Left for the next compaction (e.g. committed while being written)
+                    logger.warning("Could not merge review history segment", path=path, error=str(e))
+                    continue
+                os.remove(path)
+                merged += 1
+
+            if max_age_days is not None:
+                cutoff = time.time() - max_age_days * 86400
+                with connection:
+                    for table in ("reviews", "file_reviews", "unit_findings"):
+                        connection.execute(f"DELETE FROM {table} WHERE created_at < ?", (cutoff,))
+                connection.execute("VACUUM")
+        finally:
+            connection.close()
+
+        if self.commit is not None:
+            self.commit()
+        logger.info("Compacted review history", segments=merged)
+        return merged
+
+
+_review_history: Dict[str, ReviewHistory] = {}
+
+
+def get_review_history(directory: str, **options) -> ReviewHistory:
+    """Get the history of a directory (one instance, and so one segment, per process)"""
+    if directory not in _review_history:
+        _review_history[directory] = ReviewHistory(directory, **options)
+    return _review_history[directory]
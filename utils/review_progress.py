@@ -0,0 +1,229 @@
+"""
+Review Progress - a PR comment showing a review while it runs
+
+A review of a large PR takes minutes before the consensus report is
+posted. ReviewProgress posts a comment as soon as the local checks are
+done (dangerous calls found by the AST pass, high-severity bandit hits),
+edits it as each file's agent results come in, and deletes it once the
+final review has been posted in its place.
+
+Edits are throttled to one per min_interval seconds; file completions in
+between are shown by the next edit. Progress errors are logged and never
+fail the review.
+"""
+
+import asyncio
+import time
+from typing import Dict, List, Any, Optional
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.analysis_context import AnalysisContext
+from utils.logger import get_logger
+
+# Initialize logger
+logger = get_logger(__name__)
+
+# Identifies the progress comment among the PR's comments
+PROGRESS_MARKER = "<!-- code-review-progress -->"
+
+MAX_LISTED_FINDINGS = 20
+MAX_LISTED_FILES = 50
+
+SEVERITY_ICONS = {"critical": "🔴", "high": "🟠", "medium": "🟡", "low": "🔵"}
+
+
+def ast_findings(analysis: AnalysisContext) -> List[Dict[str, Any]]:
+    """Dangerous calls found by the AST pass of a file"""
+    patterns = analysis.ast_results().get("ast_analysis", {}).get("security_patterns", [])
+    return [
+        {
+            "line": pattern.get("line"),
+            "severity": "high",
+            "message": f"`{pattern.get('function')}`: {pattern.get('risk')}",
+            "source": "ast"
+        }
+        for pattern in patterns
+    ]
+
+
+def bandit_findings(static_results: Dict[str, Any]) -> List[Dict[str, Any]]:
+    """High-severity bandit hits of a file's static analysis results"""
+    bandit = static_results.get("analyses", {}).get("bandit", {})
+    return [
+        {
+            "line": issue.get("line"),
+            "severity": "high",
+            "message": f"{issue.get('test_id', '')} {issue.get('text', '')}".strip(),
+            "source": "bandit"
+        }
+        for issue in bandit.get("security_issues", [])
+        if issue.get("severity") == "HIGH"
+    ]
+
+
+class ReviewProgress:
+    """Progress comment of one PR review"""
+
+    def __init__(self,
+                 github: Any,
+                 owner: str,
+                 repo: str,
+                 pr_number: int,
+                 min_interval: float = 5.0):
+        """Initialize the progress comment
+
+        Args:
+            github: GitHubIntegration used to post, edit and delete the comment
+            owner: Repository owner
+            repo: Repository name
+            pr_number: Pull request number
+            min_interval: Least seconds between two edits of the comment
+        """
+        self.github = github
+        self.owner = owner
+        self.repo = repo
+        self.pr_number = pr_number
+        self.min_interval = min_interval
+        self.comment_id: Optional[int] = None
+        self.files: Dict[str, Optional[Dict[str, Any]]] = {}
+        self.findings: List[Dict[str, Any]] = []
+        self.started_at = time.monotonic()
+        self.first_feedback_seconds: Optional[float] = None
+        self.closed = False
+        self._last_update = 0.0
+        self._pending: Optional[asyncio.Task] = None
+        self._lock = asyncio.Lock()
+
+    @property
+    def reviewed(self) -> int:
+        return sum(1 for status in self.files.values() if status is not None)
+
+    def add_findings(self, filename: str, findings: List[Dict[str, Any]]):
+        """Add early findings of the local checks"""
+        self.findings.extend(dict(finding, filename=filename) for finding in findings)
+
+    async def start(self, filenames: List[str]):
+        """Post the comment with the files to review and the early findings"""
+        self.files = {filename: None for filename in filenames}
+        try:
+            comment = await self.github.create_issue_comment(self.owner, self.repo, self.pr_number, self.render())
+            self.comment_id = comment.get("id")
+            self.first_feedback_seconds = time.monotonic() - self.started_at
+            self._last_update = time.monotonic()
+        except Exception as e:
+            logger.warning("Could not post the progress comment", pr_number=self.pr_number, error=str(e))
+
+    def file_reviewed(self, filename: str, review: Dict[str, Any]):
+        """Record a finished file and schedule an edit of the comment"""
+        recommendations = review.get("consensus_results", {}).get("recommendations", [])
+        self.files[filename] = {
+            "status": review.get("status", "unknown"),
+            "severities": [rec.get("consensus_severity", "medium") for rec in recommendations]
+        }
+        self.schedule_update()
+
+    def schedule_update(self):
+        """Edit the comment now, or after min_interval if it was just edited"""
+        if self.comment_id is None or self.closed or (self._pending and not self._pending.done()):
+            return
+        delay = max(0.0, self._last_update + self.min_interval - time.monotonic())
+        self._pending = asyncio.create_task(self._update_after(delay))
+
+    async def _update_after(self, delay: float):
+        if delay:
+            await asyncio.sleep(delay)
+        await self.update()
+
+    async def update(self):
+        """Edit the comment to the current progress"""
+        async with self._lock:
+            if self.comment_id is None or self.closed:
+                return
+            self._last_update = time.monotonic()
+            try:
+                await self.github.update_issue_comment(self.owner, self.repo, self.comment_id, self.render())
+            except Exception as e:
+                logger.warning("Could not update the progress comment", pr_number=self.pr_number, error=str(e))
+
+    async def _stop(self):
+        self.closed = True
+        if self._pending and not self._pending.done():
+            self._pending.cancel()
+            try:
+                await self._pending
+            except asyncio.CancelledError:
+                pass
+
+    async def finish(self):
+        """Delete the comment (once the final review has been posted)"""
+        if self.closed:
+            return
+        await self._stop()
+        if self.comment_id is None:
+            return
+        async with self._lock:
+            try:
+                await self.github.delete_issue_comment(self.owner, self.repo, self.comment_id)
+            except Exception as e:
+                logger.warning("Could not delete the progress comment", pr_number=self.pr_number, error=str(e))
+
+    async def fail(self, message: str) -> bool:
+        """Replace the comment with an error message
+
+        Returns:
+            False if there is no comment to replace
+        """
+        if self.closed or self.comment_id is None:
+            return False
+        await self._stop()
+        async with self._lock:
+            try:
+                await self.github.update_issue_comment(self.owner, self.repo, self.comment_id, message)
+                return True
+            except Exception as e:
+                logger.warning("Could not update the progress comment", pr_number=self.pr_number, error=str(e))
+                return False
+
+    def render(self) -> str:
+        """Markdown of the progress comment"""
+        lines = [
+            PROGRESS_MARKER,
+            "## 🤖 Automated Code Review (in progress)",
+            "",
+            f"Reviewed **{self.reviewed} of {len(self.files)}** files. "
+            "This comment is replaced by the full review when it is done.",
+            ""
+        ]
+
+        if self.findings:
+            lines.extend(["### Early findings (static checks)", ""])
+            for finding in self.findings[:MAX_LISTED_FINDINGS]:
+                location = f"`{finding['filename']}`"
+                if finding.get("line"):
+                    location += f" line {finding['line']}"
+                lines.append(f"- {SEVERITY_ICONS.get(finding['severity'], '')} {location}: "
+                             f"{finding['message']} ({finding['source']})")
+            if len(self.findings) > MAX_LISTED_FINDINGS:
+                lines.append(f"- ... and {len(self.findings) - MAX_LISTED_FINDINGS} more")
+            lines.append("")
+
+        lines.extend(["### Files", "", "| File | Status | Issues |", "|------|--------|--------|"])
+        # Reviewed files first, so the table shows the results so far
+        ordered = sorted(self.files.items(), key=lambda item: item[1] is None)
+        for filename, status in ordered[:MAX_LISTED_FILES]:
+            if status is None:
+                lines.append(f"| `{filename}` | ⏳ pending | |")
+            elif status["status"] != "success":
+                lines.append(f"| `{filename}` | ❌ failed | |")
+            else:
+                severities = status["severities"]
+                counts = ", ".join(
+                    f"{severities.count(severity)} {severity}"
+                    for severity in SEVERITY_ICONS if severity in severities
+                )
+                lines.append(f"| `{filename}` | ✅ reviewed | {len(severities)}{f' ({counts})' if counts else ''} |")
+        if len(ordered) > MAX_LISTED_FILES:
+            lines.append(f"| ... and {len(ordered) - MAX_LISTED_FILES} more | | |")
+
+        return "\n".join(lines) + "\n"
@@ -0,0 +1,346 @@
+"""
+Review Queue - Admission control between the webhook and the review workers
+
+Webhook events become jobs in a queue instead of immediately spawned
+reviews. A single dispatcher takes them from the queue and starts reviews:
+
+- in priority lanes: small PRs and draft-to-ready transitions first, huge
+  PRs last
+- round-robin across repositories within a lane, so a bulk rebase of one
+  monorepo cannot starve everyone else
+- with at most max_concurrency reviews running, sized to the OpenAI quota
+- once the PR has been quiet for the debounce window, dropping jobs whose
+  head SHA has been superseded in the meantime
+
+Jobs taken from the queue but not started go back to it when the dispatcher
+exits (also on errors), and the running reviews are kept in the registry, so
+the next dispatcher still counts them against the cap.
+
+Queue depth per lane and the time jobs waited are recorded as metrics.
+"""
+
+import asyncio
+import time
+from collections import OrderedDict, deque
+from typing import Dict, List, Any, Optional, Callable, Awaitable
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.logger import get_logger, perf_monitor
+from utils.tracing import start_span
+
+try:
+    import modal
+    MODAL_AVAILABLE = True
+except ImportError:
+    MODAL_AVAILABLE = False
+
+# Initialize logger
+logger = get_logger(__name__)
+
+# Lanes in dispatch order
+HIGH_LANE = "high"
+NORMAL_LANE = "normal"
+LOW_LANE = "low"
+PRIORITY_LANES = (HIGH_LANE, NORMAL_LANE, LOW_LANE)
+
+# Jobs moved from the queue to the dispatcher per request
+DRAIN_BATCH_SIZE = 100
+
+# Heartbeat name of the dispatcher in the job registry
+DISPATCHER_NAME = "review_dispatcher"
+
+
+def classify_priority(payload: Dict[str, Any],
+                      small_pr_files: int = 10,
+                      huge_pr_files: int = 100,
+                      huge_pr_lines: int = 5000) -> str:
+    """Priority lane of a pull_request webhook event
+
+    Args:
+        payload: Webhook payload
+        small_pr_files: PRs with at most this many changed files are high priority
+        huge_pr_files: PRs with at least this many changed files are low priority
+        huge_pr_lines: PRs with at least this many changed lines are low priority
+
+    Returns:
+        "high", "normal" or "low"
+    """
+    pr_data = payload.get("pull_request", {})
+    changed_files = pr_data.get("changed_files", 0)
+    changed_lines = pr_data.get("additions", 0) + pr_data.get("deletions", 0)
+
+    if changed_files >= huge_pr_files or changed_lines >= huge_pr_lines:
+        return LOW_LANE
+    if payload.get("action") == "ready_for_review" or changed_files <= small_pr_files:
+        return HIGH_LANE
+    return NORMAL_LANE
+
+
+def make_job(payload: Dict[str, Any], key: str, lane: str, enqueued_at: Optional[float] = None,
+             trace_context: Optional[Dict[str, str]] = None) -> Dict[str, Any]:
+    """Queue entry for a webhook event (trace_context: the webhook's span, see utils.tracing)"""
+    return {
+        "key": key,
+        "repo": payload["repository"]["full_name"],
+        "head_sha": payload["pull_request"]["head"]["sha"],
+        "lane": lane,
+        "enqueued_at": enqueued_at if enqueued_at is not None else time.time(),
+        "trace_context": trace_context or {},
+        "payload": payload
+    }
+
+
+class FairScheduler:
+    """Jobs waiting for dispatch, ordered by lane and round-robin by repository"""
+
+    def __init__(self):
+        # lane -> repo -> jobs; a repo moves to the end of its lane when it got a turn
+        self.lanes: Dict[str, "OrderedDict[str, deque]"] = {lane: OrderedDict() for lane in PRIORITY_LANES}
+        self._jobs: Dict[str, Dict[str, Any]] = {}
+
+    def __len__(self) -> int:
+        return len(self._jobs)
+
+    def add(self, job: Dict[str, Any]):
+        """Add a job; a newer event for a waiting PR replaces its job"""
+        previous = self._jobs.get(job["key"])
+        if previous is not None:
+            self.remove(previous)
+            job = dict(job, enqueued_at=min(job["enqueued_at"], previous["enqueued_at"]))
+        self._jobs[job["key"]] = job
+        self.lanes[job["lane"]].setdefault(job["repo"], deque()).append(job)
+
+    def remove(self, job: Dict[str, Any], took_turn: bool = False):
+        """Remove a job (took_turn rotates its repository to the back of the lane)"""
+        self._jobs.pop(job["key"], None)
+        repos = self.lanes[job["lane"]]
+        jobs = repos.get(job["repo"])
+        if jobs is None:
+            return
+        jobs.remove(job)
+        if not jobs:
+            del repos[job["repo"]]
+        elif took_turn:
+            repos.move_to_end(job["repo"])
+
+    def ordered(self) -> List[Dict[str, Any]]:
+        """Waiting jobs in dispatch order"""
+        ordered = []
+        for lane in PRIORITY_LANES:
+            queues = [list(jobs) for jobs in self.lanes[lane].values()]
+            depth = max((len(jobs) for jobs in queues), default=0)
+            for position in range(depth):
+                ordered.extend(jobs[position] for jobs in queues if position < len(jobs))
+        return ordered
+
+    def depths(self) -> Dict[str, int]:
+        """Waiting jobs per lane"""
+        return {lane: sum(len(jobs) for jobs in repos.values()) for lane, repos in self.lanes.items()}
+
+
+class ReviewQueue:
+    """Queue of review jobs with one partition per priority lane"""
+
+    def __init__(self, queue: Any = None, queue_name: str = "pr-review-queue"):
+        """Initialize the queue
+
+        Args:
+            queue: Queue with modal.Queue's async put/get_many/len (.aio)
+                methods; defaults to the Modal Queue queue_name
+            queue_name: Name of the Modal Queue
+        """
+        self.queue = queue
+        if self.queue is None and MODAL_AVAILABLE:
+            self.queue = modal.Queue.from_name(queue_name, create_if_missing=True)
+        if self.queue is None:
+            raise RuntimeError("ReviewQueue needs Modal or a queue instance")
+
+    async def put(self, job: Dict[str, Any]):
+        """Enqueue a job in its lane"""
+        await self.queue.put.aio(job, partition=job["lane"])
+        perf_monitor.record_metric("review_queue_enqueued", 1, {"lane": job["lane"]})
+
+    async def drain(self) -> List[Dict[str, Any]]:
+        """All jobs currently in the queue, highest lane first"""
+        jobs = []
+        for lane in PRIORITY_LANES:
+            while True:
+                batch = await self.queue.get_many.aio(DRAIN_BATCH_SIZE, block=False, partition=lane)
+                jobs.extend(batch)
+                if len(batch) < DRAIN_BATCH_SIZE:
+                    break
+        return jobs
+
+    async def depths(self) -> Dict[str, int]:
+        """Jobs in the queue per lane"""
+        return {lane: await self.queue.len.aio(partition=lane) for lane in PRIORITY_LANES}
+
+
+class ReviewDispatcher:
+    """Starts queued reviews under a global concurrency cap"""
+
+    def __init__(self,
+                 queue: ReviewQueue,
+                 registry: Any,
+                 spawn: Callable[[Dict[str, Any]], Awaitable[Any]],
+                 is_done: Callable[[Any], Awaitable[bool]],
+                 max_concurrency: int = 8,
+                 poll_interval: float = 2.0,
+                 load_call: Optional[Callable[[str], Any]] = None,
+                 sleep: Callable[[float], Awaitable[Any]] = asyncio.sleep,
+                 clock: Callable[[], float] = time.time):
+        """Initialize the dispatcher
+
+        Args:
+            queue: Queue the webhook puts jobs into
+            registry: PRJobRegistry with the PRs' latest heads and event times
+            spawn: Starts the review of a webhook payload, returns its call
+            is_done: Whether a call has finished (successfully or not)
+            max_concurrency: Most reviews running at once
+            poll_interval: Seconds between polls of the queue and running reviews
+            load_call: Rebuilds a call from its id, to take over the running
+                reviews recorded by a previous dispatcher (none are taken over
+                without it)
+            sleep: Sleep function (replaceable in tests)
+            clock: Clock function (replaceable in tests)
+        """
+        self.queue = queue
+        self.registry = registry
+        self.spawn = spawn
+        self.is_done = is_done
+        self.max_concurrency = max(1, max_concurrency)
+        self.poll_interval = poll_interval
+        self.load_call = load_call
+        self.sleep = sleep
+        self.clock = clock
+        self.scheduler = FairScheduler()
+        self.running: Dict[str, Any] = {}
+        self.stats = {"dispatched": 0, "superseded": 0}
+
+    async def _job_state(self, job: Dict[str, Any]) -> str:
+        """'ready', 'waiting' (debounce window open) or 'superseded'"""
+        record = await self.registry.get(job["key"])
+        if record.get("head_sha", job["head_sha"]) != job["head_sha"]:
+            return "superseded"
+        if record.get("event_at", 0) + self.registry.debounce_seconds > self.clock():
+            return "waiting"
+        return "ready"
+
+    async def _reap(self) -> bool:
+        """Forget finished reviews; returns whether any finished"""
+        finished = False
+        for key, call in list(self.running.items()):
+            if await self.is_done(call):
+                del self.running[key]
+                finished = True
+        return finished
+
+    async def _restore_running(self):
+        """Take over the running reviews recorded by a previous dispatcher"""
+        if self.load_call is None:
+            return
+        for key, call_id in (await self.registry.running_calls(DISPATCHER_NAME)).items():
+            if key not in self.running and call_id:
+                self.running[key] = self.load_call(call_id)
+
+    async def _save_running(self):
+        await self.registry.set_running(DISPATCHER_NAME, {
+            key: getattr(call, "object_id", None) for key, call in self.running.items()
+        })
+
+    async def dispatch_once(self) -> int:
+        """Move queued jobs to the scheduler and start reviews up to the cap
+
+        Returns:
+            Number of reviews started
+        """
+        for job in await self.queue.drain():
+            self.scheduler.add(job)
+        if await self._reap():
+            await self._save_running()
+
+        started = 0
+        for job in self.scheduler.ordered():
+            if len(self.running) >= self.max_concurrency:
+                break
+            # One review per PR at a time; a newer head cancels the running one
+            if job["key"] in self.running:
+                continue
+            state = await self._job_state(job)
+            if state == "superseded":
+                self.scheduler.remove(job)
+                self.stats["superseded"] += 1
+                continue
+            if state == "waiting":
+                continue
+
+            wait_seconds = self.clock() - job["enqueued_at"]
+            # Continues the webhook's trace; spawn passes this span on to the review
+            with start_span("review_dispatch", parent=job.get("trace_context"),
+                            pr=job["key"], lane=job["lane"], wait_seconds=wait_seconds):
+                call = await self.spawn(job["payload"])
+            # Removed once started, so a failed spawn leaves the job to be requeued
+            self.scheduler.remove(job, took_turn=True)
+            self.running[job["key"]] = call
+            await self._save_running()
+            await self.registry.set_call(job["key"], job["head_sha"], getattr(call, "object_id", None))
+
+            perf_monitor.record_metric("review_queue_wait", wait_seconds, {"lane": job["lane"]})
+            logger.info("Review dispatched",
+                       pr=job["key"],
+                       lane=job["lane"],
+                       wait_seconds=round(wait_seconds, 2),
+                       running=len(self.running))
+            self.stats["dispatched"] += 1
+            started += 1
+
+        for lane, depth in self.scheduler.depths().items():
+            perf_monitor.record_metric("review_queue_depth", depth, {"lane": lane})
+        return started
+
+    async def run(self, idle_exit_seconds: float = 30.0, max_runtime: Optional[float] = None) -> Dict[str, Any]:
+        """Dispatch until nothing was queued, waiting or running for idle_exit_seconds
+
+        Args:
+            idle_exit_seconds: Idle time after which the dispatcher returns
+            max_runtime: Seconds after which it returns regardless, leaving
+                undispatched jobs in the queue for the next run
+
+        Returns:
+            Dispatch statistics
+        """
+        start = self.clock()
+        await self._restore_running()
+        try:
+            while True:
+                timed_out = await self._dispatch_until_idle(start, idle_exit_seconds, max_runtime)
+                # A job queued while the heartbeat still looked alive spawned no
+                # dispatcher; pick it up now that new events start their own
+                await self.registry.stop_heartbeat(DISPATCHER_NAME)
+                late_jobs = await self.queue.drain()
+                for job in late_jobs:
+                    self.scheduler.add(job)
+                if timed_out or not late_jobs:
+                    break
+        finally:
+            # Jobs that were not started go back to the queue
+            for job in self.scheduler.ordered():
+                await self.queue.put(job)
+        return dict(self.stats, requeued=len(self.scheduler), running=len(self.running))
+
+    async def _dispatch_until_idle(self, start: float, idle_exit_seconds: float,
+                                   max_runtime: Optional[float]) -> bool:
+        """Dispatch until idle for idle_exit_seconds; returns True if max_runtime ran out first"""
+        idle_since = None
+        while max_runtime is None or self.clock() - start < max_runtime:
+            await self.registry.heartbeat(DISPATCHER_NAME, self.clock())
+            await self.dispatch_once()
+            if self.scheduler or self.running:
+                idle_since = None
+            elif idle_since is None:
+                idle_since = self.clock()
+            elif self.clock() - idle_since >= idle_exit_seconds:
+                return False
+            await self.sleep(self.poll_interval)
+        return True
@@ -0,0 +1,201 @@
+"""
+Review Router for tiered model routing
+
+Decides per review input (a whole file, a diff excerpt or the changed units)
+whether it needs a deep review with the expensive model, a light review with
+the cheap model, or no model review at all. Local signals decide the clear
+cases for free: inputs without code are skipped, and security findings or
+high complexity force a deep review. Everything else is classified by a
+triage call to the cheap model.
+"""
+
+import re
+from typing import Dict, List, Any, Optional
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.analysis_context import AnalysisContext
+from utils.logger import get_logger, api_tracker, perf_monitor
+from utils.token_budget import count_tokens
+
+# Initialize logger
+logger = get_logger(__name__)
+
+SKIP_TIER = "skip"
+LIGHT_TIER = "light"
+DEEP_TIER = "deep"
+
+# Lines that are blank or only a comment / brace do not count as code
+NON_CODE_LINE = re.compile(r"^\s*(//.*|/\*.*|\*.*|[{}();,\[\]]*)$")
+
+# Languages whose comments start with "#" (in C and C++ it starts a preprocessor line)
+HASH_COMMENT_LANGUAGES = frozenset(("python", "py", "auto-detect", "shell", "bash", "sh", "ruby", "rb",
+                                    "yaml", "yml"))
+HASH_COMMENT_LINE = re.compile(r"^\s*#")
+
+# Estimated response size of one review call
+REVIEW_OUTPUT_TOKENS = 500
+
+
+def count_code_lines(code: str, language: str) -> int:
+    """Lines of code that are not blank, a comment or a lone brace"""
+    hash_comments = (language or "").lower() in HASH_COMMENT_LANGUAGES
+    return sum(
+        1 for line in code.split("\n")
+        if not NON_CODE_LINE.match(line) and not (hash_comments and HASH_COMMENT_LINE.match(line))
+    )
+
+
+class ReviewRouter:
+    """Routes review inputs to a review tier"""
+
+    def __init__(self,
+                 triage_agent: Optional[Any] = None,
+                 deep_model: str = "gpt-4o",
+                 light_model: str = "gpt-4o-mini",
+                 deep_complexity: int = 10):
+        """Initialize the router
+
+        Args:
+            triage_agent: TriageAgent for inputs the local signals do not
+                decide (without one they get a deep review)
+            deep_model: Model of deep reviews
+            light_model: Model of light reviews
+            deep_complexity: Cyclomatic complexity at which a function always
+                gets a deep review
+        """
+        self.triage_agent = triage_agent
+        self.deep_model = deep_model
+        self.light_model = light_model
+        self.deep_complexity = deep_complexity
+        self.decisions = {SKIP_TIER: 0, LIGHT_TIER: 0, DEEP_TIER: 0}
+        self.triage_calls = 0
+        self.estimated_savings = 0.0
+
+    def local_signals(self, analysis: AnalysisContext, code: str) -> Dict[str, Any]:
+        """Local (non-LLM) facts about a review input"""
+        signals = {
+            "code_lines": count_code_lines(code, analysis.language),
+            "security_issues": 0,
+            "max_complexity": 0,
+            "functions": 0
+        }
+
+        if analysis.supports_structure:
+            ast_data = analysis.ast_results().get("ast_analysis", {})
+            if "error" not in ast_data:
+                metrics = ast_data.get("metrics", {})
+                signals["security_issues"] = metrics.get("security_issues", 0)
+                signals["max_complexity"] = metrics.get("max_complexity", 0)
+                signals["functions"] = metrics.get("total_functions", 0)
+
+        # Bandit results are used when already computed (e.g. by the PR-wide
+        # batch); the router does not wait for them
+        static_results = analysis.static_analysis_if_ready() or {}
+        bandit_data = static_results.get("analyses", {}).get("bandit", {})
+        if bandit_data.get("status") == "success":
+            signals["security_issues"] += len(bandit_data.get("security_issues", []))
+
+        return signals
+
+    def local_tier(self, signals: Dict[str, Any]) -> Optional[Dict[str, str]]:
+        """Tier decided by local signals alone, or None if triage is needed"""
+        if signals["code_lines"] == 0:
+            return {"tier": SKIP_TIER, "reason": "no code"}
+        if signals["security_issues"]:
+            return {"tier": DEEP_TIER, "reason": "security signals"}
+        if signals["max_complexity"] >= self.deep_complexity:
+            return {"tier": DEEP_TIER, "reason": "high complexity"}
+        return None
+
+    async def route(self,
+                    analysis: AnalysisContext,
+                    code: str,
+                    context: Dict[str, Any] = None,
+                    review_calls: int = 3) -> Dict[str, Any]:
+        """Decide the review tier of a review input
+
+        Args:
+            analysis: Analysis context of the file
+            code: Review input (file, excerpt or changed units)
+            context: Review context
+            review_calls: Model calls a review of this input makes (used for
+                the savings estimate)
+
+        Returns:
+            Dict with 'tier', 'reason', 'model' (None for skipped inputs) and
+            'estimated_savings' in USD compared to a deep review
+        """
+        signals = self.local_signals(analysis, code)
+        decision = self.local_tier(signals)
+
+        if decision is None and self.triage_agent is None:
+            decision = {"tier": DEEP_TIER, "reason": "no triage model"}
+        elif decision is None:
+            self.triage_calls += 1
+            try:
+                tier = await self.triage_agent.classify(
+                    code, analysis.filename, self._format_signals(signals), context
+                )
+                decision = {"tier": tier, "reason": "triage"}
+            except Exception as e:
+                logger.warning("Triage failed, using deep review",
+                              filename=analysis.filename,
+                              error=str(e))
+                decision = {"tier": DEEP_TIER, "reason": "triage failed"}
+
+        tier = decision["tier"]
+        savings = self.estimate_savings(tier, code, review_calls)
+        self.decisions[tier] += 1
+        self.estimated_savings += savings
+        perf_monitor.record_metric("review_route", 1, {"tier": tier, "reason": decision["reason"]})
+
+        logger.info("Review routed",
+                   filename=analysis.filename,
+                   tier=tier,
+                   reason=decision["reason"],
+                   code_lines=signals["code_lines"])
+
+        return {
+            "tier": tier,
+            "reason": decision["reason"],
+            "model": None if tier == SKIP_TIER else (self.light_model if tier == LIGHT_TIER else self.deep_model),
+            "estimated_savings": savings
+        }
+
+    def estimate_savings(self, tier: str, code: str, review_calls: int = 3) -> float:
+        """Estimated cost avoided by a tier compared to a deep review, in USD"""
+        if tier == DEEP_TIER:
+            return 0.0
+        input_tokens = count_tokens(code, self.deep_model)
+        deep_cost = api_tracker._estimate_cost(self.deep_model, input_tokens, REVIEW_OUTPUT_TOKENS)
+        tier_cost = 0.0
+        if tier == LIGHT_TIER:
+            tier_cost = api_tracker._estimate_cost(self.light_model, input_tokens, REVIEW_OUTPUT_TOKENS)
+        return round((deep_cost - tier_cost) * review_calls, 6)
+
+    @staticmethod
+    def _format_signals(signals: Dict[str, Any]) -> str:
+        """Local signals as shown to the triage model"""
+        return (f"Local analysis: {signals['code_lines']} lines of code, "
+                f"{signals['functions']} functions, max complexity {signals['max_complexity']}, "
+                f"no security patterns found")
+
+    def get_stats(self) -> Dict[str, Any]:
+        """Routing decisions and estimated savings since the router was created"""
+        return {
+            "decisions": dict(self.decisions),
+            "triage_calls": self.triage_calls,
+            "estimated_savings_usd": round(self.estimated_savings, 4)
+        }
+
+
+def summarize_routes(routes: List[Dict[str, Any]]) -> Dict[str, Any]:
+    """Routing summary of a set of reviews (e.g. the files of one PR)"""
+    decisions = {SKIP_TIER: 0, LIGHT_TIER: 0, DEEP_TIER: 0}
+    for route in routes:
+        decisions[route["tier"]] += 1
+    return {
+        "decisions": decisions,
+        "estimated_savings_usd": round(sum(route.get("estimated_savings", 0.0) for route in routes), 4)
+    }
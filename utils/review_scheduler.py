@@ -0,0 +1,247 @@
+"""
+Review Scheduler for bounded-parallel pull request reviews
+
+Reviews files concurrently under a concurrency limit, starts the largest files
+first and backs off when OpenAI or GitHub report rate limiting.
+"""
+
+import asyncio
+import random
+import re
+import time
+from typing import Dict, List, Any, Optional, Callable, Awaitable
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.logger import get_logger, perf_monitor
+
+# Initialize logger
+logger = get_logger(__name__)
+
+# OpenAI rate limit errors look like:
+#   "Rate limit reached for gpt-4o ... on tokens per min (TPM): ... Please try again in 1.335s."
+#   "Rate limit reached for gpt-4o ... on requests per min (RPM): ... Please try again in 20ms."
+RATE_LIMIT_PATTERN = re.compile(
+    r"rate limit|rate_limit|too many requests|\b429\b|tokens per min|requests per min|\btpm\b|\brpm\b",
+    re.IGNORECASE
+)
+RETRY_IN_PATTERN = re.compile(r"try again in\s+([\d.]+)\s*(ms|s)\b", re.IGNORECASE)
+SECONDARY_LIMIT_PATTERN = re.compile(r"secondary rate limit|abuse detection", re.IGNORECASE)
+
+
+def _retry_after_from_headers(headers: Any) -> Optional[float]:
+    """Extract a retry delay from HTTP response headers (GitHub and OpenAI)"""
+    if not headers:
+        return None
+
+    retry_after = headers.get("retry-after")
+    if retry_after:
+        try:
+            return float(retry_after)
+        except ValueError:
+            pass
+
+    # GitHub primary rate limit: remaining hits zero until the reset epoch
+    if headers.get("x-ratelimit-remaining") == "0" and headers.get("x-ratelimit-reset"):
+        try:
+            return max(0.0, float(headers["x-ratelimit-reset"]) - time.time())
+        except ValueError:
+            pass
+
+    return None
+
+
+def get_rate_limit_delay(outcome: Any, default_delay: float = 5.0) -> Optional[float]:
+    """Classify an exception or error result as rate limiting
+
+    Args:
+        outcome: An exception, an HTTP response or a result dictionary with
+            "status"/"error" keys
+        default_delay: Delay to use when the error does not say how long to wait
+
+    Returns:
+        Seconds to wait before retrying, or None if the outcome is not a rate limit
+    """
+    if isinstance(outcome, BaseException):
+        response = getattr(outcome, "response", None)
+        status_code = getattr(outcome, "status_code", None) or getattr(response, "status_code", None)
+        headers = getattr(response, "headers", None)
+        message = str(outcome)
+
+        # GitHub secondary rate limits come back as 403 with an explanatory body
+        if status_code == 403:
+            body = getattr(response, "text", "") or ""
+            return _secondary_limit_delay(headers, f"{message} {body}", default_delay)
+
+        if status_code == 429 or RATE_LIMIT_PATTERN.search(message):
+            delay = _retry_after_from_headers(headers)
+            return delay if delay is not None else _retry_after_from_message(message) or default_delay
+
+        return None
+
+    # HTTP responses that were not raised, e.g. of GitHub API requests
+    status_code = getattr(outcome, "status_code", None)
+    if isinstance(status_code, int):
+        headers = getattr(outcome, "headers", None)
+        if status_code == 403:
+            return _secondary_limit_delay(headers, getattr(outcome, "text", "") or "", default_delay)
+        if status_code == 429:
+            delay = _retry_after_from_headers(headers)
+            return delay if delay is not None else default_delay
+        return None
+
+    if isinstance(outcome, dict) and outcome.get("status") == "error":
+        message = str(outcome.get("error", ""))
+        if SECONDARY_LIMIT_PATTERN.search(message):
+            return max(default_delay, 60.0)
+        if RATE_LIMIT_PATTERN.search(message):
+            return _retry_after_from_message(message) or default_delay
+
+    return None
+
+
+def _secondary_limit_delay(headers: Any, text: str, default_delay: float) -> Optional[float]:
+    """Delay of a GitHub 403 response that is a secondary rate limit, else None"""
+    if not SECONDARY_LIMIT_PATTERN.search(text):
+        return None
+    delay = _retry_after_from_headers(headers)
+    return delay if delay is not None else max(default_delay, 60.0)
+
+
+def _retry_after_from_message(message: str) -> Optional[float]:
+    """Parse OpenAI's "Please try again in 1.3s" hint"""
+    match = RETRY_IN_PATTERN.search(message)
+    if not match:
+        return None
+    value = float(match.group(1))
+    return value / 1000 if match.group(2).lower() == "ms" else value
+
+
+class RateLimitGate:
+    """Shared cooldown so that one rate-limited call pauses every worker"""
+
+    def __init__(self):
+        self._resume_at = 0.0
+
+    def trip(self, delay: float):
+        """Block new calls for at least `delay` seconds"""
+        self._resume_at = max(self._resume_at, time.monotonic() + delay)
+
+    async def wait(self):
+        """Wait until the cooldown (if any) has elapsed"""
+        while True:
+            remaining = self._resume_at - time.monotonic()
+            if remaining <= 0:
+                return
+            await asyncio.sleep(remaining)
+
+
+class ReviewScheduler:
+    """Runs file reviews concurrently with a concurrency limit and rate limit backoff"""
+
+    def __init__(self,
+                 max_concurrency: int = 4,
+                 max_retries: int = 3,
+                 base_delay: float = 2.0,
+                 max_delay: float = 60.0):
+        """Initialize the scheduler
+
+        Args:
+            max_concurrency: Maximum number of files reviewed at the same time
+            max_retries: Retries per call after a rate limit response
+            base_delay: Initial backoff delay in seconds
+            max_delay: Upper bound for a single backoff delay in seconds
+        """
+        self.max_concurrency = max(1, max_concurrency)
+        self.max_retries = max_retries
+        self.base_delay = base_delay
+        self.max_delay = max_delay
+        self.gate = RateLimitGate()
+
+    @staticmethod
+    def order_by_size(files: List[Dict[str, Any]]) -> List[int]:
+        """Return file indices ordered largest-first so long reviews start early"""
+        return sorted(
+            range(len(files)),
+            key=lambda i: (-len(files[i].get("content") or ""), i)
+        )
+
+    async def call_with_backoff(self,
+                                call: Callable[[], Awaitable[Any]],
+                                operation: str = "call") -> Any:
+        """Run a call, retrying with exponential backoff while it is rate limited
+
+        The call may raise, return an error result or return an HTTP
+        response; all are checked with get_rate_limit_delay. The last outcome is returned (or re-raised)
+        once retries are exhausted.
+        """
+        attempt = 0
+        while True:
+            await self.gate.wait()
+
+            try:
+                outcome = await call()
+                error = None
+            except Exception as e:
+                outcome = None
+                error = e
+
+            delay = get_rate_limit_delay(error if error is not None else outcome, self.base_delay)
+            if delay is None or attempt >= self.max_retries:
+                if error is not None:
+                    raise error
+                return outcome
+
+            # Exponential backoff with jitter, never shorter than the server's hint
+            backoff = min(self.max_delay, max(delay, self.base_delay * (2 ** attempt)))
+            backoff += random.uniform(0, backoff * 0.1)
+            attempt += 1
+
+            self.gate.trip(backoff)
+            perf_monitor.record_metric("rate_limit_backoff", backoff, {"operation": operation})
+            logger.warning("Rate limited, backing off",
+                          operation=operation,
+                          attempt=attempt,
+                          backoff_seconds=round(backoff, 2))
+
+    async def run(self,
+                  files: List[Dict[str, Any]],
+                  review_file: Callable[[Dict[str, Any]], Awaitable[Dict[str, Any]]],
+                  on_complete: Optional[Callable[[int, Dict[str, Any]], Any]] = None) -> List[Dict[str, Any]]:
+        """Review all files concurrently
+
+        Args:
+            files: File dicts (with at least 'filename' and 'content')
+            review_file: Coroutine function reviewing a single file
+            on_complete: Optional callback invoked with (index, result) as files finish
+
+        Returns:
+            Results in the same order as `files`, regardless of completion order
+        """
+        results: List[Optional[Dict[str, Any]]] = [None] * len(files)
+        semaphore = asyncio.Semaphore(self.max_concurrency)
+
+        async def worker(index: int):
+            file_info = files[index]
+            async with semaphore:
+                try:
+                    result = await self.call_with_backoff(
+                        lambda: review_file(file_info),
+                        operation=f"review:{file_info.get('filename', 'unknown')}"
+                    )
+                except Exception as e:
+                    logger.error("File review failed",
+                                exception=e,
+                                filename=file_info.get("filename", "unknown"))
+                    result = {
+                        "status": "error",
+                        "filename": file_info.get("filename", "unknown"),
+                        "error": str(e)
+                    }
+
+            results[index] = result
+            if on_complete:
+                on_complete(index, result)
+
+        await asyncio.gather(*[worker(i) for i in self.order_by_size(files)])
+        return results
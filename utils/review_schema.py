@@ -0,0 +1,146 @@
+"""
+Review Schema for structured agent responses
+
+In structured-output mode the agents ask the model for a ReviewFindings
+object (OpenAI structured outputs), so a response is decoded with a single
+JSON parse instead of being scraped from free text.
+"""
+
+from typing import Dict, List, Any, Optional, Literal, Type
+from pydantic import BaseModel, ValidationError
+
+Severity = Literal["critical", "high", "medium", "low"]
+
+# Appended to the system message in structured-output mode
+STRUCTURED_OUTPUT_INSTRUCTIONS = """Respond with JSON matching the response schema instead of the text format above:
+a one or two sentence summary and one entry per issue. Report line numbers as they
+appear in the code shown (null if an issue has no specific line). Only report issues
+that are actually present in the code; return an empty list if there are none."""
+
+
+class ReviewFinding(BaseModel):
+    """One issue reported by an agent"""
+    title: str
+    severity: Severity
+    location: str                  # Function or class name
+    line_start: Optional[int]
+    line_end: Optional[int]
+    description: str
+    solution: str
+    complexity: Optional[str]      # Big-O notation, for performance issues
+
+
+class ReviewFindings(BaseModel):
+    """A complete agent response"""
+    summary: str
+    findings: List[ReviewFinding]
+
+
+class FusedReviewFindings(BaseModel):
+    """Response of a fused review: one section per agent role"""
+    code_quality: ReviewFindings
+    security: ReviewFindings
+    performance: ReviewFindings
+
+
+# Section of a fused response holding each agent's findings
+FUSED_SECTIONS = {
+    "code_reviewer": "code_quality",
+    "security_checker": "security",
+    "performance_analyzer": "performance"
+}
+
+
+def parse_review_findings(content: Any, model: Type[BaseModel] = ReviewFindings) -> Optional[BaseModel]:
+    """Decode a structured response (a model instance, dict or JSON text)"""
+    if isinstance(content, model):
+        return content
+    try:
+        if isinstance(content, dict):
+            return model.model_validate(content)
+        return model.model_validate_json(str(content))
+    except (ValidationError, ValueError):
+        return None
+
+
+def empty_response(model: Type[BaseModel] = ReviewFindings) -> BaseModel:
+    """A response without findings (the answer to a deferred request)"""
+    if model is FusedReviewFindings:
+        return FusedReviewFindings(**{section: empty_response() for section in FUSED_SECTIONS.values()})
+    return model(summary="", findings=[])
+
+
+def response_format(model: Type[BaseModel] = ReviewFindings) -> Dict[str, Any]:
+    """OpenAI response_format for strict JSON answers matching a schema
+
+    The model client builds this from output_content_type; requests sent
+    without it (e.g. through the Batch API) use this instead.
+    """
+    schema = model.model_json_schema()
+
+    def close(node: Any):
+        # Strict mode needs every object closed and all of its fields required
+        if isinstance(node, dict):
+            if node.get("type") == "object":
+                node["additionalProperties"] = False
+                node["required"] = list(node.get("properties", {}))
+            for value in node.values():
+                close(value)
+        elif isinstance(node, list):
+            for value in node:
+                close(value)
+
+    close(schema)
+    return {"type": "json_schema", "json_schema": {"name": model.__name__, "schema": schema, "strict": True}}
+
+
+def finding_to_issue(finding: Dict[str, Any], agent_name: str, finding_type: str) -> Dict[str, Any]:
+    """Convert a ReviewFinding dump to the finding format used by the consensus"""
+    line_start, line_end = finding.get("line_start"), finding.get("line_end")
+    location = finding.get("location") or ""
+    line_numbers = []
+    if line_start:
+        line_numbers = [line_start] if not line_end or line_end == line_start else [line_start, line_end]
+        lines_text = "-".join(str(line) for line in line_numbers)
+        location = f"{location} (line{'s' if len(line_numbers) > 1 else ''} {lines_text})".strip()
+
+    issue = {
+        "type": finding_type,
+        "agent": agent_name,
+        "severity": finding.get("severity", "medium"),
+        "description": finding.get("title", ""),
+        "impact": finding.get("description", ""),
+        "solution": finding.get("solution", ""),
+        "location": location,
+        "line_numbers": line_numbers
+    }
+    if finding.get("complexity"):
+        issue["complexity"] = finding["complexity"]
+    return issue
+
+
+def render_findings(parsed: ReviewFindings) -> str:
+    """Readable text of a structured response (used where the analysis text is shown)"""
+    parts = [parsed.summary.strip()]
+    for finding in parsed.findings:
+        lines = ""
+        if finding.line_start:
+            lines = f", line {finding.line_start}"
+            if finding.line_end and finding.line_end != finding.line_start:
+                lines = f", lines {finding.line_start}-{finding.line_end}"
+        parts.append(
+            f"**{finding.title}** ({finding.severity.capitalize()} severity; {finding.location}{lines})\n"
+            f"{finding.description}\n"
+            f"Fix: {finding.solution}"
+        )
+    return "\n\n".join(part for part in parts if part) or "No issues found."
+
+
+def severity_counts(issues: List[Dict[str, Any]]) -> Dict[str, int]:
+    """Number of issues per severity"""
+    counts = {"critical": 0, "high": 0, "medium": 0, "low": 0}
+    for issue in issues:
+        severity = str(issue.get("severity", "")).lower()
+        if severity in counts:
+            counts[severity] += 1
+    return counts
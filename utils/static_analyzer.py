@@ -5,11 +5,32 @@ Integrates popular static analysis tools like pylint and bandit for enhanced cod
 """
 
 import os
+import shutil
 import subprocess
 import tempfile
+import time
 import json
 from typing import Dict, List, Any, Optional
 import sys
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.tracing import start_span
+
+SUPPORTED_TOOLS = ("pylint", "bandit", "flake8", "mypy", "black")
+
+# Pylint exit status bits per message type
+PYLINT_STATUS_BITS = {"fatal": 1, "error": 2, "warning": 4, "refactor": 8, "convention": 16}
+
+# Tool availability is probed once per process
+_available_tools: Optional[Dict[str, bool]] = None
+
+
+def detect_available_tools() -> Dict[str, bool]:
+    """Which static analysis tools are on PATH (probed once per process)"""
+    global _available_tools
+    if _available_tools is None:
+        _available_tools = {tool: shutil.which(tool) is not None for tool in SUPPORTED_TOOLS}
+    return dict(_available_tools)
+
 
 class StaticAnalyzer:
     """Integrates various static analysis tools"""
@@ -19,25 +40,7 @@ class StaticAnalyzer:
     
     def _check_available_tools(self) -> Dict[str, bool]:
         """Check which static analysis tools are available"""
-        tools = {
-            "pylint": False,
-            "bandit": False,
-            "flake8": False,
-            "mypy": False,
-            "black": False
-        }
-        
-        for tool in tools:
-            try:
-                subprocess.run([tool, "--version"], 
-                             capture_output=True, 
-                             check=False,
-                             timeout=5)
-                tools[tool] = True
-            except (subprocess.TimeoutExpired, FileNotFoundError):
-                tools[tool] = False
-        
-        return tools
+        return detect_available_tools()
     
     def analyze_with_pylint(self, code: str, filename: str = "temp.py") -> Dict[str, Any]:
         """Run pylint analysis on code
@@ -69,30 +72,8 @@ class StaticAnalyzer:
                 timeout=30
             )
             
-            # Parse results
-            issues = []
-            if result.stdout:
-                try:
-                    issues = json.loads(result.stdout)
-                except json.JSONDecodeError:
-                    # Fallback to text parsing if JSON fails
-                    issues = self._parse_pylint_text(result.stdout)
-            
-            # Calculate score (pylint exit code indicates score)
-            # Exit codes: 0=no error, 1=fatal, 2=error, 4=warning, 8=refactor, 16=convention
-            score = 10.0  # Default perfect score
-            if result.returncode > 0:
-                # Rough score calculation based on exit code
-                score = max(0, 10 - (result.returncode * 0.5))
-            
-            return {
-                "tool": "pylint",
-                "status": "success",
-                "score": score,
-                "issues": self._categorize_pylint_issues(issues),
-                "total_issues": len(issues),
-                "filename": filename
-            }
+            issues = self._parse_pylint_output(result.stdout)
+            return self._pylint_result(issues, result.returncode, filename)
             
         except subprocess.TimeoutExpired:
             return {
@@ -141,33 +122,14 @@ class StaticAnalyzer:
                 timeout=30
             )
             
-            # Parse results
             security_issues = []
-            metrics = {}
-            
             if result.stdout:
                 try:
-                    bandit_output = json.loads(result.stdout)
-                    security_issues = bandit_output.get("results", [])
-                    metrics = bandit_output.get("metrics", {})
+                    security_issues = json.loads(result.stdout).get("results", [])
                 except json.JSONDecodeError:
                     pass
             
-            return {
-                "tool": "bandit",
-                "status": "success",
-                "security_issues": self._categorize_bandit_issues(security_issues),
-                "metrics": {
-                    "total_issues": len(security_issues),
-                    "severity_high": sum(1 for issue in security_issues if issue.get("issue_severity") == "HIGH"),
-                    "severity_medium": sum(1 for issue in security_issues if issue.get("issue_severity") == "MEDIUM"),
-                    "severity_low": sum(1 for issue in security_issues if issue.get("issue_severity") == "LOW"),
-                    "confidence_high": sum(1 for issue in security_issues if issue.get("issue_confidence") == "HIGH"),
-                    "confidence_medium": sum(1 for issue in security_issues if issue.get("issue_confidence") == "MEDIUM"),
-                    "confidence_low": sum(1 for issue in security_issues if issue.get("issue_confidence") == "LOW")
-                },
-                "filename": filename
-            }
+            return self._bandit_result(security_issues, filename)
             
         except subprocess.TimeoutExpired:
             return {
@@ -215,6 +177,152 @@ class StaticAnalyzer:
         
         return results
     
+    def analyze_batch(self, files: List[Dict[str, str]], timeout: int = 120) -> Dict[str, Dict[str, Any]]:
+        """Run all available tools over many files with one process per tool
+        
+        The files are written once to a temporary tree and pylint and bandit
+        run over the whole set in parallel, so interpreter and plugin startup
+        is paid once per PR instead of once per file and tool.
+        
+        Args:
+            files: Dicts with 'filename' and 'content'
+            timeout: Seconds each tool may take for the whole batch
+            
+        Returns:
+            analyze_all() style results keyed by filename
+        """
+        tools = [tool for tool in ("pylint", "bandit") if self.available_tools.get(tool)]
+        analyses = {file["filename"]: {} for file in files}
+        if not files:
+            return {}
+        
+        with tempfile.TemporaryDirectory() as temp_dir:
+            # One directory per file keeps base names (which pylint checks)
+            # while avoiding collisions between files with the same name
+            paths = {}
+            for index, file in enumerate(files):
+                relative_path = os.path.join(str(index), os.path.basename(file["filename"]) or "file.py")
+                os.makedirs(os.path.join(temp_dir, str(index)), exist_ok=True)
+                with open(os.path.join(temp_dir, relative_path), "w") as f:
+                    f.write(file["content"])
+                paths[relative_path] = file["filename"]
+            
+            commands = {
+                "pylint": ["pylint", *paths, "--output-format=json", "--reports=n"],
+                "bandit": ["bandit", *paths, "-f", "json", "-ll"]
+            }
+            processes = {}
+            deadline = time.time() + timeout
+            for tool in tools:
+                try:
+                    processes[tool] = subprocess.Popen(
+                        commands[tool], cwd=temp_dir, text=True,
+                        stdout=subprocess.PIPE, stderr=subprocess.PIPE
+                    )
+                except Exception as e:
+                    for filename in analyses:
+                        analyses[filename][tool] = {"tool": tool, "status": "error", "error": str(e)}
+            
+            for tool, process in processes.items():
+                try:
+                    stdout, _ = process.communicate(timeout=max(1, deadline - time.time()))
+                except subprocess.TimeoutExpired:
+                    process.kill()
+                    process.communicate()
+                    for filename in analyses:
+                        analyses[filename][tool] = {
+                            "tool": tool, "status": "timeout", "error": f"{tool.capitalize()} analysis timed out"
+                        }
+                    continue
+                
+                if tool == "pylint":
+                    by_file = self._split_by_path(self._parse_pylint_output(stdout), "path", paths)
+                    for path, filename in paths.items():
+                        issues = by_file.get(path, [])
+                        analyses[filename][tool] = self._pylint_result(
+                            issues, self._pylint_status(issues), filename
+                        )
+                else:
+                    try:
+                        security_issues = json.loads(stdout).get("results", []) if stdout else []
+                    except json.JSONDecodeError:
+                        security_issues = []
+                    by_file = self._split_by_path(security_issues, "filename", paths)
+                    for path, filename in paths.items():
+                        analyses[filename][tool] = self._bandit_result(by_file.get(path, []), filename)
+        
+        return {
+            filename: {
+                "filename": filename,
+                "tools_available": self.available_tools,
+                "analyses": file_analyses,
+                "summary": self._create_summary(file_analyses)
+            }
+            for filename, file_analyses in analyses.items()
+        }
+    
+    def _split_by_path(self, issues: List[Dict[str, Any]], path_field: str,
+                       paths: Dict[str, str]) -> Dict[str, List[Dict[str, Any]]]:
+        """Group tool output by the temp-tree path it reports"""
+        by_file = {}
+        for issue in issues:
+            path = os.path.normpath(str(issue.get(path_field, "")))
+            if path in paths:
+                by_file.setdefault(path, []).append(issue)
+        return by_file
+    
+    def _pylint_status(self, issues: List[Dict[str, Any]]) -> int:
+        """Exit status pylint would have returned for these issues alone"""
+        status = 0
+        for issue in issues:
+            status |= PYLINT_STATUS_BITS.get(str(issue.get("type", "")).lower(), 0)
+        return status
+    
+    def _parse_pylint_output(self, stdout: str) -> List[Dict[str, Any]]:
+        """Parse pylint JSON output, falling back to the text format"""
+        if not stdout:
+            return []
+        try:
+            return json.loads(stdout)
+        except json.JSONDecodeError:
+            return self._parse_pylint_text(stdout)
+    
+    def _pylint_result(self, issues: List[Dict[str, Any]], returncode: int, filename: str) -> Dict[str, Any]:
+        """Build the pylint result for one file"""
+        # Calculate score (pylint exit code indicates score)
+        # Exit codes: 0=no error, 1=fatal, 2=error, 4=warning, 8=refactor, 16=convention
+        score = 10.0  # Default perfect score
+        if returncode > 0:
+            # Rough score calculation based on exit code
+            score = max(0, 10 - (returncode * 0.5))
+        
+        return {
+            "tool": "pylint",
+            "status": "success",
+            "score": score,
+            "issues": self._categorize_pylint_issues(issues),
+            "total_issues": len(issues),
+            "filename": filename
+        }
+    
+    def _bandit_result(self, security_issues: List[Dict[str, Any]], filename: str) -> Dict[str, Any]:
+        """Build the bandit result for one file"""
+        return {
+            "tool": "bandit",
+            "status": "success",
+            "security_issues": self._categorize_bandit_issues(security_issues),
+            "metrics": {
+                "total_issues": len(security_issues),
+                "severity_high": sum(1 for issue in security_issues if issue.get("issue_severity") == "HIGH"),
+                "severity_medium": sum(1 for issue in security_issues if issue.get("issue_severity") == "MEDIUM"),
+                "severity_low": sum(1 for issue in security_issues if issue.get("issue_severity") == "LOW"),
+                "confidence_high": sum(1 for issue in security_issues if issue.get("issue_confidence") == "HIGH"),
+                "confidence_medium": sum(1 for issue in security_issues if issue.get("issue_confidence") == "MEDIUM"),
+                "confidence_low": sum(1 for issue in security_issues if issue.get("issue_confidence") == "LOW")
+            },
+            "filename": filename
+        }
+    
     def _categorize_pylint_issues(self, issues: List[Dict[str, Any]]) -> Dict[str, List[Dict[str, Any]]]:
         """Categorize pylint issues by type"""
         categories = {
@@ -316,5 +424,12 @@ class StaticAnalyzer:
 # Convenience function
 def run_static_analysis(code: str, filename: str = "temp.py") -> Dict[str, Any]:
     """Run static analysis on code"""
+    with start_span("static_analysis", filename=filename):
+        analyzer = StaticAnalyzer()
+        return analyzer.analyze_all(code, filename)
+
+
+def run_static_analysis_batch(files: List[Dict[str, str]]) -> Dict[str, Dict[str, Any]]:
+    """Run static analysis on many files at once (see StaticAnalyzer.analyze_batch)"""
     analyzer = StaticAnalyzer()
-    return analyzer.analyze_all(code, filename)
\ No newline at end of file
+    return analyzer.analyze_batch(files)
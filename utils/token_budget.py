@@ -0,0 +1,146 @@
+"""
+Token Budget - Token counting with the model's tokenizer and prompt budgets
+
+Tokens are counted with tiktoken when it is installed (the encoding of the
+model, o200k_base for unknown models) and estimated from the text length
+otherwise. Budgets bound the code sent per model request, which is split
+into chunks when it does not fit, and the tokens spent on one PR, beyond
+which files are skipped with a note in the report.
+"""
+
+from typing import Dict, List, Tuple, Optional, Iterable
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.logger import get_logger
+
+try:
+    import tiktoken
+except ImportError:  # Token counts are estimated without it
+    tiktoken = None
+
+# Initialize logger
+logger = get_logger(__name__)
+
+# Context window of each model, in tokens
+MODEL_CONTEXT_WINDOWS = {
+    "gpt-4o": 128000,
+    "gpt-4o-mini": 128000,
+    "gpt-3.5-turbo": 16385
+}
+
+# Average characters per token of code, used when tiktoken is not installed
+CHARS_PER_TOKEN = 3.5
+
+_encodings: Dict[str, object] = {}
+
+
+def get_encoding(model: str):
+    """tiktoken encoding of a model (loaded once per process), or None without tiktoken"""
+    if tiktoken is None:
+        return None
+    if model not in _encodings:
+        try:
+            _encodings[model] = tiktoken.encoding_for_model(model)
+        except KeyError:
+            _encodings[model] = tiktoken.get_encoding("o200k_base")
+    return _encodings[model]
+
+
+def count_tokens(text: str, model: str = "gpt-4o") -> int:
+    """Number of tokens of a text for a model"""
+    if not text:
+        return 0
+    encoding = get_encoding(model)
+    if encoding is None:
+        return int(len(text) / CHARS_PER_TOKEN) + 1
+    return len(encoding.encode(text, disallowed_special=()))
+
+
+class TokenBudget:
+    """Tokens left for the model requests of one PR"""
+
+    def __init__(self, max_tokens: int):
+        """Initialize the budget
+
+        Args:
+            max_tokens: Input tokens all requests together may use
+        """
+        self.max_tokens = max_tokens
+        self.used = 0
+
+    @property
+    def remaining(self) -> int:
+        return max(self.max_tokens - self.used, 0)
+
+    def try_reserve(self, tokens: int) -> bool:
+        """Reserve tokens if they fit into the remaining budget"""
+        if tokens > self.remaining:
+            return False
+        self.used += tokens
+        return True
+
+
+def chunk_ranges(lines: List[str],
+                 ranges: List[Tuple[int, int]],
+                 max_tokens: int,
+                 model: str = "gpt-4o",
+                 boundaries: Iterable[int] = ()) -> List[List[Tuple[int, int]]]:
+    """Split line ranges into chunks of at most max_tokens tokens
+
+    Chunks are cut at the last boundary line (e.g. the start of a function)
+    inside the chunk where there is one, so units are not split needlessly.
+    A single line longer than the budget becomes a chunk of its own.
+
+    Args:
+        lines: Lines of the file (index 0 is line 1)
+        ranges: Sorted (start, end) line ranges to split, 1-based and inclusive
+        max_tokens: Token budget of one chunk
+        model: Model whose tokenizer is used
+        boundaries: Line numbers where a chunk preferably starts
+
+    Returns:
+        List of chunks, each a list of (start, end) ranges
+    """
+    boundaries = set(boundaries)
+    chunks: List[List[int]] = []
+    current: List[int] = []
+    current_tokens: List[int] = []
+    current_total = 0
+
+    for start, end in ranges:
+        for number in range(start, end + 1):
+            tokens = count_tokens(lines[number - 1] + "\n", model)
+            if current and current_total + tokens > max_tokens:
+                # Move the lines from the last boundary on into the next chunk
+                cut = next((i for i in range(len(current) - 1, 0, -1) if current[i] in boundaries), len(current))
+                chunks.append(current[:cut])
+                current, current_tokens = current[cut:], current_tokens[cut:]
+                # Summed once per chunk, so splitting stays linear in the lines
+                current_total = sum(current_tokens)
+                if current and current_total + tokens > max_tokens:
+                    chunks.append(current)
+                    current, current_tokens, current_total = [], [], 0
+            current.append(number)
+            current_tokens.append(tokens)
+            current_total += tokens
+
+    if current:
+        chunks.append(current)
+    return [_to_ranges(chunk) for chunk in chunks]
+
+
+def _to_ranges(numbers: List[int]) -> List[Tuple[int, int]]:
+    """Sorted line numbers as contiguous (start, end) ranges"""
+    ranges: List[Tuple[int, int]] = []
+    for number in numbers:
+        if ranges and ranges[-1][1] == number - 1:
+            ranges[-1] = (ranges[-1][0], number)
+        else:
+            ranges.append((number, number))
+    return ranges
+
+
+def context_window(model: str, default: Optional[int] = None) -> int:
+    """Context window of a model (the smallest known window if unknown)"""
+    return MODEL_CONTEXT_WINDOWS.get(model, default or min(MODEL_CONTEXT_WINDOWS.values()))
@@ -0,0 +1,130 @@
+"""
+Tracing - OpenTelemetry spans for the review pipeline
+
+Stages open spans with start_span; log_performance opens one for every
+operation it measures, so the orchestrator, agent, static analysis and
+consensus stages are traced without further changes. Spans are exported
+over OTLP when the OpenTelemetry SDK is installed and
+OTEL_EXPORTER_OTLP_ENDPOINT is set (headers and protocol settings use the
+standard OTEL_* variables); otherwise start_span is a no-op.
+
+The trace continues across Modal function calls by passing the W3C trace
+context (inject_context) as an argument and using it as the parent span
+on the other side (start_span(parent=...)).
+"""
+
+import os
+import threading
+from contextlib import contextmanager
+from typing import Dict, Any, Optional
+
+try:
+    from opentelemetry import trace, propagate
+    from opentelemetry.trace import Status, StatusCode
+    OTEL_AVAILABLE = True
+except ImportError:
+    OTEL_AVAILABLE = False
+
+_configured = False
+_configure_lock = threading.Lock()
+
+
+class _NoopSpan:
+    """Stand-in for a span while tracing is disabled"""
+
+    def set_attribute(self, key: str, value: Any):
+        pass
+
+    def record_exception(self, exception: BaseException):
+        pass
+
+
+_NOOP_SPAN = _NoopSpan()
+
+
+def configure_tracing(service_name: str) -> bool:
+    """Install the OTLP span exporter once per process
+
+    Args:
+        service_name: service.name of the spans (OTEL_SERVICE_NAME takes precedence)
+
+    Returns:
+        True if spans are exported
+    """
+    global _configured
+    if not OTEL_AVAILABLE or not os.environ.get("OTEL_EXPORTER_OTLP_ENDPOINT"):
+        return False
+    with _configure_lock:
+        if _configured:
+            return True
+        try:
+            from opentelemetry.sdk.resources import Resource
+            from opentelemetry.sdk.trace import TracerProvider
+            from opentelemetry.sdk.trace.export import BatchSpanProcessor
+            from opentelemetry.exporter.otlp.proto.http.trace_exporter import OTLPSpanExporter
+        except ImportError:
+            return False
+
+        provider = TracerProvider(resource=Resource.create({
+            "service.name": os.environ.get("OTEL_SERVICE_NAME", service_name)
+        }))
+        provider.add_span_processor(BatchSpanProcessor(OTLPSpanExporter()))
+        trace.set_tracer_provider(provider)
+        _configured = True
+        return True
+
+
+def tracing_enabled() -> bool:
+    """Whether spans are being exported"""
+    return _configured
+
+
+def flush_tracing(timeout_millis: int = 5000):
+    """Export buffered spans (before a container may be stopped)"""
+    if _configured:
+        trace.get_tracer_provider().force_flush(timeout_millis)
+
+
+def _attribute(value: Any) -> Any:
+    """Span attributes are primitives; other values are recorded as text"""
+    return value if isinstance(value, (str, bool, int, float)) else str(value)
+
+
+@contextmanager
+def start_span(name: str, parent: Optional[Dict[str, str]] = None, **attributes):
+    """Trace a block as a span
+
+    Args:
+        name: Span name (the pipeline stage)
+        parent: Trace context from inject_context in another process; by
+            default the span is a child of the current span
+        **attributes: Span attributes (None values are left out)
+
+    Yields:
+        The span, for attributes known only at the end (e.g. token counts)
+    """
+    if not _configured:
+        yield _NOOP_SPAN
+        return
+
+    tracer = trace.get_tracer("multi-agent-code-review")
+    context = propagate.extract(parent) if parent else None
+    with tracer.start_as_current_span(name, context=context, record_exception=False,
+                                      set_status_on_exception=False) as span:
+        for key, value in attributes.items():
+            if value is not None:
+                span.set_attribute(key, _attribute(value))
+        try:
+            yield span
+        except BaseException as e:
+            span.record_exception(e)
+            span.set_status(Status(StatusCode.ERROR, str(e)))
+            raise
+
+
+def inject_context() -> Dict[str, str]:
+    """W3C trace context (traceparent) of the current span, to pass to another process"""
+    carrier: Dict[str, str] = {}
+    if _configured:
+        propagate.inject(carrier)
+    return carrier
@@ -0,0 +1,598 @@
+"""
+Tree-sitter Analyzer for non-Python code
+
+Structural pre-analysis for JavaScript, TypeScript, Go, Java, C, C++ and Rust
+with the same output schema as ASTAnalyzer.analyze (functions, classes,
+imports, call counts, complexity, metrics), plus function-level code units so
+these files get the same incremental reviews as Python.
+
+tree-sitter is optional. Grammars are loaded from tree-sitter-language-pack
+or from the per-language tree-sitter-<language> packages; languages without a
+grammar are reviewed from the raw text as before.
+"""
+
+import hashlib
+import importlib
+import re
+from collections import defaultdict
+from typing import Dict, List, Any, Optional, Tuple
+import sys
+import os
+sys.path.append(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from utils.ast_analyzer import ASTAnalyzer
+from utils.code_units import CodeUnit, MODULE_UNIT, _subtract_spans
+
+try:
+    import tree_sitter
+except ImportError:
+    tree_sitter = None
+
+COMMENT_TYPES = {"comment", "line_comment", "block_comment"}
+IMPORT_KEYWORD_PATTERN = re.compile(r"^(?:import|use|#include)\s+(?:static\s+)?")
+BOOLEAN_OPERATORS = {"&&", "||", "??"}
+
+_JS_SPEC = {
+    "grammar": "javascript",
+    "module": "tree_sitter_javascript",
+    "functions": {"function_declaration", "generator_function_declaration", "function_expression",
+                  "function", "arrow_function", "method_definition"},
+    "classes": {"class_declaration", "class"},
+    "calls": {"call_expression", "new_expression"},
+    "decisions": {"if_statement", "for_statement", "for_in_statement", "while_statement", "do_statement",
+                  "switch_case", "catch_clause", "ternary_expression"},
+    "imports": {"import_statement"},
+    "wrappers": {"export_statement": "declaration"},
+    "dangerous": {
+        "eval": "Code injection risk",
+        "Function": "Code injection risk",
+        "exec": "Command injection risk",
+        "execSync": "Command injection risk",
+        "child_process.exec": "Command injection risk",
+        "document.write": "Cross-site scripting risk"
+    }
+}
+
+_TS_EXTRA = {
+    "functions": _JS_SPEC["functions"] | {"function_signature"},
+    "classes": _JS_SPEC["classes"] | {"abstract_class_declaration"},
+    "wrappers": {"export_statement": "declaration", "internal_module": "body"}
+}
+
+LANGUAGE_SPECS: Dict[str, Dict[str, Any]] = {
+    "javascript": _JS_SPEC,
+    "typescript": {**_JS_SPEC, **_TS_EXTRA, "grammar": "typescript",
+                   "module": "tree_sitter_typescript", "entry": "language_typescript"},
+    "tsx": {**_JS_SPEC, **_TS_EXTRA, "grammar": "tsx",
+            "module": "tree_sitter_typescript", "entry": "language_tsx"},
+    "go": {
+        "grammar": "go",
+        "module": "tree_sitter_go",
+        "functions": {"function_declaration", "method_declaration", "func_literal"},
+        "classes": {"type_declaration"},
+        "calls": {"call_expression"},
+        "decisions": {"if_statement", "for_statement", "expression_case", "type_case", "communication_case"},
+        "imports": {"import_spec"},
+        "wrappers": {},
+        "dangerous": {
+            "exec.Command": "Command injection risk",
+            "template.HTML": "Cross-site scripting risk",
+            "unsafe.Pointer": "Memory safety risk"
+        }
+    },
+    "java": {
+        "grammar": "java",
+        "module": "tree_sitter_java",
+        "functions": {"method_declaration", "constructor_declaration", "lambda_expression"},
+        "classes": {"class_declaration", "interface_declaration", "enum_declaration", "record_declaration"},
+        "calls": {"method_invocation", "object_creation_expression"},
+        "decisions": {"if_statement", "for_statement", "enhanced_for_statement", "while_statement",
+                      "do_statement", "switch_label", "catch_clause", "ternary_expression"},
+        "imports": {"import_declaration"},
+        "wrappers": {},
+        "dangerous": {
+            "Runtime.getRuntime().exec": "Command injection risk",
+            "ProcessBuilder": "Command injection risk",
+            "readObject": "Deserialization vulnerability"
+        }
+    },
+    "c": {
+        "grammar": "c",
+        "module": "tree_sitter_c",
+        "functions": {"function_definition"},
+        "classes": {"struct_specifier"},
+        "calls": {"call_expression"},
+        "decisions": {"if_statement", "for_statement", "while_statement", "do_statement",
+                      "case_statement", "conditional_expression"},
+        "imports": {"preproc_include"},
+        "wrappers": {},
+        "dangerous": {
+            "gets": "Buffer overflow risk",
+            "strcpy": "Buffer overflow risk",
+            "strcat": "Buffer overflow risk",
+            "sprintf": "Buffer overflow risk",
+            "system": "Command injection risk"
+        }
+    },
+    "rust": {
+        "grammar": "rust",
+        "module": "tree_sitter_rust",
+        "functions": {"function_item", "closure_expression"},
+        "classes": {"struct_item", "enum_item", "trait_item", "impl_item"},
+        "calls": {"call_expression", "macro_invocation"},
+        "decisions": {"if_expression", "for_expression", "while_expression", "loop_expression", "match_arm"},
+        "imports": {"use_declaration"},
+        "wrappers": {"mod_item": "body"},
+        "dangerous": {
+            "Command::new": "Command injection risk",
+            "std::process::Command::new": "Command injection risk",
+            "std::mem::transmute": "Memory safety risk"
+        }
+    }
+}
+
+LANGUAGE_SPECS["cpp"] = {
+    **LANGUAGE_SPECS["c"],
+    "grammar": "cpp",
+    "module": "tree_sitter_cpp",
+    "functions": {"function_definition", "lambda_expression"},
+    "classes": {"struct_specifier", "class_specifier"},
+    "calls": {"call_expression", "new_expression"},
+    "decisions": LANGUAGE_SPECS["c"]["decisions"] | {"catch_clause", "for_range_loop"},
+    "wrappers": {"namespace_definition": "body"}
+}
+
+# Grammars are loaded once per process (None when unavailable)
+_parsers: Dict[str, Any] = {}
+
+
+def _load_language(spec: Dict[str, Any]):
+    """Load a grammar from tree-sitter-language-pack or its own package"""
+    try:
+        from tree_sitter_language_pack import get_language
+        return get_language(spec["grammar"])
+    except Exception:
+        pass
+    try:
+        module = importlib.import_module(spec["module"])
+        return tree_sitter.Language(getattr(module, spec.get("entry", "language"))())
+    except Exception:
+        return None
+
+
+def get_parser(language: str):
+    """tree-sitter parser for a language, or None if it is not available"""
+    language = (language or "").lower()
+    if language not in _parsers:
+        parser = None
+        spec = LANGUAGE_SPECS.get(language)
+        grammar = _load_language(spec) if spec and tree_sitter is not None else None
+        if grammar is not None:
+            try:
+                parser = tree_sitter.Parser(grammar)
+            except TypeError:
+                # py-tree-sitter < 0.22
+                parser = tree_sitter.Parser()
+                parser.set_language(grammar)
+        _parsers[language] = parser
+    return _parsers[language]
+
+
+def supports_language(language: str) -> bool:
+    """Whether structural analysis is available for a language"""
+    return get_parser(language) is not None
+
+
+def parse_code(code: str, language: str):
+    """Parse code with tree-sitter (None if the language is not available)"""
+    parser = get_parser(language)
+    if parser is None:
+        return None
+    return parser.parse(code.encode("utf-8"))
+
+
+def _text(node) -> str:
+    return node.text.decode("utf-8", errors="replace") if node is not None else ""
+
+
+def _start_line(node) -> int:
+    return node.start_point[0] + 1
+
+
+def _end_line(node) -> int:
+    return node.end_point[0] + 1
+
+
+def _is_identifier(node) -> bool:
+    return node.type.endswith("identifier") or node.type in ("destructor_name", "operator_name")
+
+
+def _node_name(node) -> Optional[str]:
+    """Name of a function, class or parameter node"""
+    if _is_identifier(node):
+        return _text(node)
+
+    for field in ("name", "declarator", "pattern", "type"):
+        child = node.child_by_field_name(field)
+        # C declarators nest (pointer_declarator -> function_declarator -> identifier)
+        while child is not None and not _is_identifier(child):
+            child = child.child_by_field_name("declarator") or child.child_by_field_name("name")
+        if child is not None:
+            return _text(child)
+
+    # Go type declarations hold their name in a type_spec
+    for child in node.named_children:
+        if child.type == "type_spec":
+            return _node_name(child)
+
+    # Anonymous functions take the name of what they are assigned to
+    parent = node.parent
+    if parent is not None and parent.type in ("variable_declarator", "pair", "assignment_expression",
+                                              "public_field_definition", "field_definition"):
+        target = (parent.child_by_field_name("name") or parent.child_by_field_name("key") or
+                  parent.child_by_field_name("left"))
+        if target is not None and target.id != node.id:
+            return _text(target)
+    return None
+
+
+def _first_of_type(node, node_type: str):
+    """First descendant of a given type"""
+    stack = [node]
+    while stack:
+        current = stack.pop()
+        if current.type == node_type:
+            return current
+        stack.extend(reversed(current.named_children))
+    return None
+
+
+def _compact_name(text: str) -> str:
+    """Call target text without whitespace; long expressions keep their last segment"""
+    compact = "".join(text.split())
+    if len(compact) > 80:
+        compact = compact.replace("::", ".").rsplit(".", 1)[-1]
+    return compact
+
+
+def _hash_tokens(kind: str, name: str, nodes: List[Any]) -> str:
+    """Hash the tokens of nodes, ignoring whitespace and comments"""
+    digest = hashlib.sha256(f"{kind}:{name}".encode())
+    stack = list(reversed(nodes))
+    while stack:
+        node = stack.pop()
+        if node.type in COMMENT_TYPES:
+            continue
+        if node.child_count == 0:
+            digest.update(node.type.encode() + b"\0" + node.text + b"\0")
+        else:
+            stack.extend(reversed(node.children))
+    return digest.hexdigest()
+
+
+class TreeSitterAnalyzer:
+    """Structural analysis of one file with a tree-sitter grammar"""
+
+    # Metrics are computed exactly like ASTAnalyzer's, from the same attributes
+    _calculate_metrics = ASTAnalyzer._calculate_metrics
+
+    def __init__(self, language: str):
+        self.language = language.lower()
+        self.spec = LANGUAGE_SPECS[self.language]
+        self.functions = []
+        self.classes = []
+        self.imports = []
+        self.global_vars = []
+        self.function_calls = defaultdict(int)
+        self.complexity_scores = {}
+        self.security_patterns = []
+        self.code_smells = []
+        self._receiver_methods = defaultdict(list)
+
+    def analyze(self, code: str) -> Dict[str, Any]:
+        """Analyze code and extract metrics (see ASTAnalyzer.analyze)"""
+        tree = parse_code(code, self.language)
+        if tree is None:
+            return unsupported_result(self.language)
+        return self.analyze_tree(tree)
+
+    def analyze_tree(self, tree) -> Dict[str, Any]:
+        """Analyze an already parsed tree"""
+        try:
+            self._walk(tree.root_node)
+            for cls in self.classes:
+                cls["methods"].extend(self._receiver_methods.get(cls["name"], []))
+
+            return {
+                "ast_analysis": {
+                    "functions": self.functions,
+                    "classes": self.classes,
+                    "imports": self.imports,
+                    "global_variables": self.global_vars,
+                    "function_calls": dict(self.function_calls),
+                    "complexity": self.complexity_scores,
+                    "metrics": self._calculate_metrics(),
+                    "security_patterns": self.security_patterns,
+                    "code_smells": self.code_smells,
+                    "parser": "tree-sitter",
+                    "has_syntax_errors": tree.root_node.has_error
+                }
+            }
+        except Exception as e:
+            return {
+                "ast_analysis": {
+                    "error": f"Structural analysis failed: {str(e)}"
+                }
+            }
+
+    def _walk(self, root):
+        """Visit every node once, tracking the enclosing named function"""
+        stack = [(root, None)]
+        while stack:
+            node, current_function = stack.pop()
+            node_type = node.type
+
+            if node_type in self.spec["functions"]:
+                name = self._visit_function(node)
+                current_function = name or current_function
+            elif node_type in self.spec["classes"]:
+                self._visit_class(node)
+            elif node_type in self.spec["calls"]:
+                self._visit_call(node)
+            elif node_type in self.spec["imports"]:
+                self._visit_import(node)
+
+            stack.extend((child, current_function) for child in reversed(node.named_children))
+
+    def _visit_function(self, node) -> Optional[str]:
+        """Record a named function; anonymous ones count towards their parent"""
+        name = _node_name(node)
+        if not name:
+            return None
+
+        complexity = self._complexity(node)
+        self.complexity_scores[name] = complexity
+        parameters = self._parameter_names(node)
+
+        if len(parameters) > 5:
+            self.code_smells.append({
+                "type": "too_many_parameters",
+                "function": name,
+                "line": _start_line(node),
+                "parameter_count": len(parameters)
+            })
+
+        function_lines = _end_line(node) - _start_line(node)
+        if function_lines > 50:
+            self.code_smells.append({
+                "type": "long_function",
+                "function": name,
+                "line": _start_line(node),
+                "lines": function_lines
+            })
+
+        previous = node.prev_named_sibling
+        if previous is None and node.parent is not None and node.parent.type in self.spec["wrappers"]:
+            previous = node.parent.prev_named_sibling
+
+        self.functions.append({
+            "name": name,
+            "line": _start_line(node),
+            "end_line": _end_line(node),
+            "parameters": parameters,
+            "complexity": complexity,
+            "decorators": [_text(child) for child in node.named_children if child.type == "decorator"],
+            "is_async": any(child.type == "async" for child in node.children) or
+                        any(c.type == "function_modifiers" and "async" in _text(c) for c in node.children),
+            "docstring": previous is not None and previous.type in COMMENT_TYPES
+        })
+
+        receiver = node.child_by_field_name("receiver")
+        if receiver is not None:
+            receiver_type = _first_of_type(receiver, "type_identifier")
+            if receiver_type is not None:
+                self._receiver_methods[_text(receiver_type)].append(name)
+        return name
+
+    def _visit_class(self, node):
+        """Record a class-like definition and its methods"""
+        name = _node_name(node)
+        body = node.child_by_field_name("body")
+        if not name or (body is None and node.type not in ("type_declaration",)):
+            # Forward declarations and references such as "struct foo *p"
+            return
+
+        methods = []
+        if body is not None:
+            methods = [
+                _node_name(child) for child in body.named_children
+                if child.type in self.spec["functions"] and _node_name(child)
+            ]
+
+        self.classes.append({
+            "name": name,
+            "line": _start_line(node),
+            "end_line": _end_line(node),
+            "methods": methods,
+            "bases": [],
+            "decorators": [_text(child) for child in node.named_children if child.type == "decorator"],
+            "docstring": node.prev_named_sibling is not None and node.prev_named_sibling.type in COMMENT_TYPES
+        })
+
+    def _visit_call(self, node):
+        """Count a call site and flag dangerous calls"""
+        target = (node.child_by_field_name("function") or node.child_by_field_name("constructor") or
+                  node.child_by_field_name("macro") or node.child_by_field_name("type"))
+        if node.type == "method_invocation":
+            obj = node.child_by_field_name("object")
+            func_name = _compact_name((_text(obj) + "." if obj is not None else "") +
+                                      _text(node.child_by_field_name("name")))
+        elif target is not None:
+            func_name = _compact_name(_text(target))
+        else:
+            return
+
+        self.function_calls[func_name] += 1
+
+        dangerous = self.spec["dangerous"]
+        risk = dangerous.get(func_name) or dangerous.get(func_name.replace("::", ".").rsplit(".", 1)[-1])
+        if risk:
+            self.security_patterns.append({
+                "type": "dangerous_function",
+                "function": func_name,
+                "line": _start_line(node),
+                "risk": risk
+            })
+
+    def _visit_import(self, node):
+        """Track imports"""
+        source = node.child_by_field_name("source") or node.child_by_field_name("path")
+        if source is not None:
+            module = _text(source)
+        else:
+            module = IMPORT_KEYWORD_PATTERN.sub("", " ".join(_text(node).split())).rstrip(";")
+        self.imports.append({
+            "module": module.strip("\"'<> "),
+            "line": _start_line(node),
+            "type": "import"
+        })
+
+    def _complexity(self, function_node) -> int:
+        """Cyclomatic complexity of a function, excluding nested named functions"""
+        complexity = 1
+        stack = list(function_node.named_children)
+        while stack:
+            node = stack.pop()
+            if node.type in self.spec["functions"] and _node_name(node):
+                continue
+            if node.type in self.spec["decisions"]:
+                complexity += 1
+            elif node.type == "binary_expression" and any(c.type in BOOLEAN_OPERATORS for c in node.children):
+                complexity += 1
+            stack.extend(node.named_children)
+        return complexity
+
+    def _parameter_names(self, function_node) -> List[str]:
+        """Names of a function's parameters"""
+        parameters = (function_node.child_by_field_name("parameters") or
+                      function_node.child_by_field_name("parameter"))
+        if parameters is None:
+            return []
+        if _is_identifier(parameters):
+            return [_text(parameters)]
+
+        names = []
+        for child in parameters.named_children:
+            if child.type in COMMENT_TYPES:
+                continue
+            names.append(_node_name(child) or _text(child))
+        return names
+
+def unsupported_result(language: str) -> Dict[str, Any]:
+    """Analysis result for languages without an available grammar"""
+    return {
+        "ast_analysis": {
+            "error": f"Structural analysis is not available for {language}"
+        }
+    }
+
+
+def analyze_with_treesitter(code: str, language: str) -> Dict[str, Any]:
+    """Convenience function to analyze code with tree-sitter"""
+    if (language or "").lower() not in LANGUAGE_SPECS:
+        return unsupported_result(language)
+    return TreeSitterAnalyzer(language).analyze(code)
+
+
+def _unwrap(node, spec: Dict[str, Any]) -> List[Any]:
+    """Top-level definitions inside export statements, namespaces and modules"""
+    field = spec["wrappers"].get(node.type)
+    if field is None:
+        return [node]
+    inner = node.child_by_field_name(field)
+    if inner is None:
+        return [node]
+    if inner.type in spec["functions"] or inner.type in spec["classes"]:
+        return [inner]
+    return [child for nested in inner.named_children for child in _unwrap(nested, spec)]
+
+
+def _declared_function(node, spec: Dict[str, Any]) -> Optional[Tuple[str, Any]]:
+    """(name, function) for declarations like `const handler = async () => {}`"""
+    if node.type not in ("lexical_declaration", "variable_declaration"):
+        return None
+    declarators = [child for child in node.named_children if child.type == "variable_declarator"]
+    if len(declarators) != 1:
+        return None
+    value = declarators[0].child_by_field_name("value")
+    name = declarators[0].child_by_field_name("name")
+    if value is not None and name is not None and value.type in spec["functions"]:
+        return _text(name), value
+    return None
+
+
+def split_units(tree, code: str, language: str) -> Optional[List[CodeUnit]]:
+    """Split a parsed file into function, method and class units (see split_into_units)"""
+    spec = LANGUAGE_SPECS.get((language or "").lower())
+    if tree is None or spec is None:
+        return None
+
+    def span(node) -> Tuple[int, int]:
+        return _start_line(node), _end_line(node)
+
+    total_lines = len(code.split("\n"))
+    units = []
+    definition_spans = []
+    module_nodes = []
+
+    top_level = [child for node in tree.root_node.named_children for child in _unwrap(node, spec)]
+    for node in top_level:
+        if node.type in COMMENT_TYPES:
+            continue
+
+        declared = _declared_function(node, spec)
+        if node.type in spec["functions"] or declared:
+            name = declared[0] if declared else _node_name(node)
+            if name:
+                receiver = node.child_by_field_name("receiver")
+                kind = "function"
+                if receiver is not None:
+                    # Go methods are declared at the top level with a receiver
+                    receiver_type = _first_of_type(receiver, "type_identifier")
+                    if receiver_type is not None:
+                        name, kind = f"{_text(receiver_type)}.{name}", "method"
+                definition_spans.append(span(node))
+                units.append(CodeUnit(name, kind, [span(node)], _hash_tokens(kind, name, [node])))
+                continue
+
+        if node.type in spec["classes"] and _node_name(node):
+            class_name = _node_name(node)
+            class_span = span(node)
+            definition_spans.append(class_span)
+            body = node.child_by_field_name("body")
+            methods = [
+                child for child in (body.named_children if body is not None else [])
+                if child.type in spec["functions"] and _node_name(child)
+            ]
+            if not methods:
+                units.append(CodeUnit(class_name, "class", [class_span], _hash_tokens("class", class_name, [node])))
+                continue
+
+            method_spans = []
+            for method in methods:
+                method_span = span(method)
+                method_spans.append(method_span)
+                name = f"{class_name}.{_node_name(method)}"
+                units.append(CodeUnit(name, "method", [method_span], _hash_tokens("method", name, [method])))
+
+            # Class header and fields; methods are hashed separately
+            header_nodes = [child for child in node.children if child.id != (body.id if body else None)]
+            header_nodes += [child for child in body.children if child.id not in {m.id for m in methods}]
+            units.append(CodeUnit(class_name, "class", _subtract_spans(class_span, method_spans),
+                                  _hash_tokens("class", class_name, header_nodes)))
+            continue
+
+        module_nodes.append(node)
+
+    units.append(CodeUnit(MODULE_UNIT, "module", _subtract_spans((1, total_lines), definition_spans),
+                          _hash_tokens("module", MODULE_UNIT, module_nodes), has_code=bool(module_nodes)))
+    return units